@@ -17,7 +17,7 @@
 #include "core/engine.h"
 #include "core/misc.h"
 #include "core/rt-object.h"
-#include "core/import-obj.h"
+#include "core/model-manager.h"
 #include "shader/tex2d-visual/tex-visual.h"
 
 
@@ -43,6 +43,12 @@ struct RSMFrameBuffer {
 
     RSMFrameBuffer();
 
+    /**
+     * 设置 shader 的固定参数
+     * @note 不在构造函数中设置，是为了让 shader 的编译和其他 shader 并行
+     */
+    void init_shader();
+
     /// 创建一张 4 通道的 2D 纹理，精度为 32f
     static GLuint create_tex_2d(GLsizei size);
 
@@ -59,7 +65,7 @@ class RSM : public Engine
 {
     RSMFrameBuffer  fbo;
     ShaderTexVisual tex_visual;
-    RTObject        model_square = ImportObj::load_obj(MODEL_SQUARE)[0];
+    RTObject        model_square = ModelManager::load(MODEL_SQUARE)[0];
 
     /// light 固定朝向原点
     struct {
@@ -67,14 +73,16 @@ class RSM : public Engine
         glm::vec3 indensity = glm::vec3{1.f, 1.f, 1.f} * 0.004f;
     } light;
 
-    std::vector<RTObject> model_bunny  = ImportObj::load_obj(MODEL_BUNNY);
-    std::vector<RTObject> model_cornel = ImportObj::load_obj(MODEL_CORNER);
+    std::vector<RTObject> model_bunny  = ModelManager::load(MODEL_BUNNY);
+    std::vector<RTObject> model_cornel = ModelManager::load(MODEL_CORNER);
     std::vector<RTObject> models;
 
     Shader2 shader_gi = {cur_shader + "gi.vert", cur_shader + "gi.frag"};
 
     void init() override
     {
+        fbo.init_shader();
+
         model_bunny[0].set_pos({0.05f, -0.2f, -0.25f});
         models.insert(models.end(), model_bunny.begin(), model_bunny.end());
         models.insert(models.end(), model_cornel.begin(), model_cornel.end());
@@ -104,12 +112,12 @@ class RSM : public Engine
         auto light_V = glm::lookAt(light.pos, glm::vec3(0.f), POSITIVE_Y);
         auto light_P = glm::perspective(fbo.fov, 1.f, fbo.near, fbo.far);
 
-        // TODO 随机数种子
+        /// 静止时每帧使用不同的采样点，累积之后噪声逐渐消失
         shader_gi.set_uniform({
                 {"m_view", camera.view_matrix()},
                 {"light_VP", light_P * light_V},
                 {"light_pos", light.pos},
-                {"random_seed", glm::vec3(0.5f)},
+                {"random_seed", sample_seed()},
                 {"RSM_pos", 1},
                 {"RSM_normal", 2},
                 {"RSM_flux", 3},
@@ -149,8 +157,9 @@ class RSM : public Engine
 };
 
 
-int main()
+int main(int argc, char **argv)
 {
+    Engine::parse_args(argc, argv);
     auto engine = RSM();
     engine.engine_main();
 }
@@ -205,8 +214,9 @@ RSMFrameBuffer::RSMFrameBuffer()
         SPDLOG_ERROR("frame buffer uncomplete.");
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    /// init shader
+}
+void RSMFrameBuffer::init_shader()
+{
     shader.set_uniform({
             {"fov_deg", fov},
             {"viewport_size", near},
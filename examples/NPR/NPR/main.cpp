@@ -10,7 +10,7 @@
 #include "core/mesh.h"
 #include "core/misc.h"
 #include "core/shader.h"
-#include "core/import-obj.h"
+#include "core/model-manager.h"
 
 
 const std::string CUR_SHADER = EXAMPLE_CUR_PATH + "shader/";
@@ -20,7 +20,7 @@ class TestEngine : public Engine
 {
     Shader2               shader{CUR_SHADER + "npr.vert", CUR_SHADER + "npr.frag"};
     glm::vec3             light_pos{-3, 4, 4};
-    std::vector<RTObject> model_diona = ImportObj::load_obj(MODEL_DIONA);
+    std::vector<RTObject> model_diona = ModelManager::load(MODEL_DIONA);
     std::vector<RTObject> scene;
     float                 outline_threshold = 0.2f;
 
@@ -79,8 +79,9 @@ class TestEngine : public Engine
 };
 
 
-int main(int args, char **argv)
+int main(int argc, char **argv)
 {
+    Engine::parse_args(argc, argv);
     try
     {
         auto engine = TestEngine();
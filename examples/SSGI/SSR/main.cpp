@@ -11,6 +11,8 @@
 #include "core/light.h"
 #include "core/misc.h"
 #include "core/shader.h"
+#include "core/model-manager.h"
+#include "core/culling.h"
 #include "shader/tex2d-visual/tex-visual.h"
 #include "shader/diffuse/diffuse.h"
 #include "functions/axis.h"
@@ -104,11 +106,11 @@ class SSR : public Engine
 
     /// 场景中的模型信息
     std::vector<RTObject> scene;
-    std::vector<RTObject> model_three   = ImportObj::load_obj(MODEL_THREE_OBJS);
-    std::vector<RTObject> model_cornell = ImportObj::load_obj(MODEL_CORNELL_BOX);
+    std::vector<RTObject> model_three   = ModelManager::load(MODEL_THREE_OBJS);
+    std::vector<RTObject> model_cornell = ModelManager::load(MODEL_CORNELL_BOX);
 
-    RTObject model_square = ImportObj::load_obj(MODEL_SQUARE)[0];
-    RTObject model_cube   = ImportObj::load_obj(MODEL_CUBE)[0];
+    RTObject model_square = ModelManager::load(MODEL_SQUARE)[0];
+    RTObject model_cube   = ModelManager::load(MODEL_CUBE)[0];
 
     Shader2 shader = Shader2(CUR_SHADER + "color-pass.vert", CUR_SHADER + "color-pass.frag");
 
@@ -121,6 +123,12 @@ class SSR : public Engine
     /// 坐标轴
     Axis axis;
 
+    /// 视锥体剔除：light pass 使用正交投影，geometry pass 使用摄像机
+    CullingBatch          culling;
+    std::vector<uint32_t> visible;
+    CullStats             light_stats;
+    CullStats             camera_stats;
+
 
 public:
     void init() override
@@ -134,6 +142,7 @@ public:
     {
         glClearColor(0.f, 0.f, 0.f, 0.f);
 
+        culling.update(scene);
         light_pass();
         geometry_pass();
         ssr_pass();
@@ -168,13 +177,19 @@ public:
         ImGui::SliderFloat("light target y", &light.target.y, -10, 10);
         ImGui::SliderFloat("light target z", &light.target.z, -10, 10);
 
+        ImGui::Text("light pass: visible %zu, culled %zu", light_stats.visible,
+                    light_stats.culled);
+        ImGui::Text("geometry pass: visible %zu, culled %zu", camera_stats.visible,
+                    camera_stats.culled);
+
         ImGui::End();
     }
 };
 
 
-int main()
+int main(int argc, char **argv)
 {
+    Engine::parse_args(argc, argv);
     try
     {
         auto a = SSR();
@@ -192,6 +207,8 @@ int main()
 
 void SSR::debug_pass()
 {
+    PROFILE_SCOPE("debug pass");
+
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     ViewPortInfo viewport_info = {
@@ -225,6 +242,8 @@ void SSR::debug_pass()
 
 void SSR::ssr_pass()
 {
+    PROFILE_SCOPE("ssr pass");
+
     glBindFramebuffer(GL_FRAMEBUFFER, ssr_pass_data.framebuffer);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glViewport(0, 0, ssr_pass_data.size, ssr_pass_data.size);
@@ -244,6 +263,8 @@ void SSR::ssr_pass()
 
 void SSR::color_pass()
 {
+    PROFILE_SCOPE("color pass");
+
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glViewport_({.width  = Window::framebuffer_width(),
@@ -281,8 +302,7 @@ void SSR::color_pass()
         glm::mat4 m2    = glm::scale(glm::translate(glm::one<glm::mat4>(), light.target), scale);
 
         auto draw = [&](const glm::mat4 &mat) {
-            shader_diffuse.shader.set_uniform({
-                    {"has_diffuse", 0},
+            shader_diffuse.shader().set_uniform({
                     {"kd", {0.9f, 0.9f, 0.9f}},
                     {"m_model", mat},
             });
@@ -301,6 +321,8 @@ void SSR::color_pass()
 
 void SSR::geometry_pass()
 {
+    PROFILE_SCOPE("geometry pass");
+
     glBindFramebuffer(GL_FRAMEBUFFER, geometry_pass_data.framebuffer);
     glViewport(0, 0, geometry_pass_data.size, geometry_pass_data.size);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -310,8 +332,10 @@ void SSR::geometry_pass()
             {"u_proj", MAT4, {._mat4 = camera.proj_matrix()}},
     });
 
-    for (auto &m: scene)
+    camera_stats = culling.cull(camera.proj_matrix() * camera.view_matrix(), visible);
+    for (uint32_t idx: visible)
     {
+        const RTObject &m   = scene[idx];
         const Material &mat = m.mesh.mat;
         if (mat.has_tex_basecolor())
             glBindTexture_(GL_TEXTURE_2D, 0, mat.metallic_roughness.tex_base_color);
@@ -328,12 +352,16 @@ void SSR::geometry_pass()
 
 void SSR::light_pass()
 {
+    PROFILE_SCOPE("light pass");
+
     glBindFramebuffer(GL_FRAMEBUFFER, light_pass_cfg.framebuffer);
     glViewport(0, 0, light_pass_cfg.size, light_pass_cfg.size);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    for (auto &m: scene)
+    light_stats = culling.cull(light.proj_matrix * light.view_matrix_get(), visible);
+    for (uint32_t idx: visible)
     {
+        const RTObject &m = scene[idx];
         light_pass_cfg.shader.set_uniform({
                 {"u_light_mvp",
                  MAT4,
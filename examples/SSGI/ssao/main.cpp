@@ -7,6 +7,7 @@
 #include "core/engine.h"
 #include "core/mesh.h"
 #include "core/shader.h"
+#include "core/model-manager.h"
 #include "shader/tex2d-visual/tex-visual.h"
 
 
@@ -29,9 +30,9 @@ class SSAO : public Engine
                                        EXAMPLE_CUR_PATH + "shader/ssao.frag"};
     ShaderTexVisual shader_texvisual;
 
-    std::vector<RTObject> model_three  = ImportObj::load_obj(MODEL_THREE_OBJS);
-    RTObject              model_square = ImportObj::load_obj(MODEL_SQUARE)[0];
-    std::vector<RTObject> model_lucy   = ImportObj::load_obj(MODEL_LUCY);
+    std::vector<RTObject> model_three  = ModelManager::load(MODEL_THREE_OBJS);
+    RTObject              model_square = ModelManager::load(MODEL_SQUARE)[0];
+    std::vector<RTObject> model_lucy   = ModelManager::load(MODEL_LUCY);
 
 
     void init() override
@@ -138,8 +139,9 @@ class SSAO : public Engine
 };
 
 
-int main()
+int main(int argc, char **argv)
 {
+    Engine::parse_args(argc, argv);
     auto engine = SSAO();
     engine.engine_main();
 }
\ No newline at end of file
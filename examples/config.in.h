@@ -25,6 +25,7 @@ const char *MODEL_BUNNY         = "${RT_MODEL_DIR}/bunny/bunny.obj";
 const char *MODEL_CORNER        = "${RT_MODEL_DIR}/corner/corner.obj";
 const char *MODEL_LUCY          = "${RT_MODEL_DIR}/lucy/lucy.obj";
 const char *MODEL_CORNELL_BOX   = "${RT_MODEL_DIR}/cornel-box/cornel-box.obj";
+const char *MODEL_HUTAO         = "${RT_MODEL_DIR}/hutao/hutao.obj";
 
 
 // texture
@@ -132,8 +132,9 @@ class EngineTest : public Engine
     }
 };
 
-int main()
+int main(int argc, char **argv)
 {
+    Engine::parse_args(argc, argv);
     auto engine = EngineTest();
     engine.engine_main();
 }
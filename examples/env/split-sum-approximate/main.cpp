@@ -11,6 +11,7 @@
 #include "config.hpp"
 #include "core/engine.h"
 #include "core/misc.h"
+#include "core/model-manager.h"
 
 #include "shader/skybox/skybox.h"
 #include "shader/diffuse/diffuse.h"
@@ -28,11 +29,11 @@ struct SplitSumApproximate {
     const GLint   TOTAL_CUBE_MIP_LEVELS = 6;
     Shader2       shader_envmap         = {cur_shader + "cube-map-common.vert",
                                            cur_shader + "prefilter-env-map.frag"};
-    RTObject      model_cube            = ImportObj::load_obj(MODEL_CUBE)[0];
+    RTObject      model_cube            = ModelManager::load(MODEL_CUBE)[0];
 
     GLuint        brdf_lut{};
     const GLsizei LUT_SIZE     = 512;
-    RTObject      model_square = ImportObj::load_obj(MODEL_SQUARE)[0];
+    RTObject      model_square = ModelManager::load(MODEL_SQUARE)[0];
     Shader2 shader_int_brdf    = {cur_shader + "square-common.vert", cur_shader + "int-brdf.frag"};
 
     SplitSumApproximate()
@@ -65,6 +66,7 @@ struct SplitSumApproximate {
     void pre_filter_env_map(GLuint env_map)
     {
         SPDLOG_INFO("pre filter env map...");
+        PROFILE_SCOPE("prefilter env map");
 
         auto                   capture_proj = glm::perspective(glm::radians(90.f), 1.f, 0.1f, 10.f);
         std::vector<glm::mat4> capture_views = {
@@ -112,6 +114,7 @@ struct SplitSumApproximate {
     void intgrate_brdf() const
     {
         SPDLOG_INFO("integrate BRDF...");
+        PROFILE_SCOPE("integrate brdf");
 
         glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
         glBindRenderbuffer(GL_RENDERBUFFER, depth_render_buffer);
@@ -143,10 +146,10 @@ class TestEngine : public Engine
 
     SplitSumApproximate split_sum;
 
-    RTObject              model_square        = ImportObj::load_obj(MODEL_SQUARE)[0];
-    RTObject              model_cube          = ImportObj::load_obj(MODEL_CUBE)[0];
-    RTObject              model_spere         = ImportObj::load_obj(MODEL_SPHERE)[0];
-    std::vector<RTObject> model_sphere_matrix = ImportObj::load_obj(MODEL_SPHERE_MATRIX);
+    RTObject              model_square        = ModelManager::load(MODEL_SQUARE)[0];
+    RTObject              model_cube          = ModelManager::load(MODEL_CUBE)[0];
+    RTObject              model_spere         = ModelManager::load(MODEL_SPHERE)[0];
+    std::vector<RTObject> model_sphere_matrix = ModelManager::load(MODEL_SPHERE_MATRIX);
 
     float     roughness = 0.2f;
     glm::vec3 F0        = glm::vec3(0.7, 0.7, 0.6);
@@ -171,6 +174,7 @@ class TestEngine : public Engine
         split_sum.intgrate_brdf();
 
         model_square.mesh.mat.metallic_roughness.tex_base_color = (int) split_sum.brdf_lut;
+        model_square.mesh.mat.update_features();
 
         shader_ibl.set_uniform({
                 {"total_cube_mip_level", (float) split_sum.TOTAL_CUBE_MIP_LEVELS},
@@ -237,8 +241,9 @@ class TestEngine : public Engine
     }
 };
 
-int main()
+int main(int argc, char **argv)
 {
+    Engine::parse_args(argc, argv);
     auto engine = TestEngine();
     engine.engine_main();
     return 0;
@@ -3,7 +3,7 @@
 const float PI = 3.141592653589793;
 const float DELTA = 0.00000000000000001;
 
-include(GGX-BRDF.glsl)
+#include "GGX-BRDF.glsl"
 
 in VS_FS
 {
@@ -10,13 +10,14 @@
 #include "core/engine.h"
 #include "core/light.h"
 #include "core/misc.h"
+#include "core/model-manager.h"
 
 
 class AnisotropicBRDF : public Engine
 {
-    RTObject model_sphere = ImportObj::load_obj(MODEL_SPHERE)[0];
-    RTObject model_floor  = ImportObj::load_obj(MODEL_GRAY_FLOOR)[0];
-    RTObject model_cube   = ImportObj::load_obj(MODEL_CUBE)[0];
+    RTObject model_sphere = ModelManager::load(MODEL_SPHERE)[0];
+    RTObject model_floor  = ModelManager::load(MODEL_GRAY_FLOOR)[0];
+    RTObject model_cube   = ModelManager::load(MODEL_CUBE)[0];
 
     GLuint tex_albedo =
             TextureManager::load_texture_(fmt::format("{}{}", TEXTURE_PBR_BALL, "basecolor.png"));
@@ -71,8 +72,9 @@ class AnisotropicBRDF : public Engine
 };
 
 
-int main()
+int main(int argc, char **argv)
 {
+    Engine::parse_args(argc, argv);
     auto a = AnisotropicBRDF();
     a.engine_main();
 }
\ No newline at end of file
@@ -0,0 +1,106 @@
+/**
+ * BVH 的性能测试：比较单线程和并行构建的耗时，以及随机光线的遍历速度\n
+ * 只使用 CPU 上的模型数据，不需要创建窗口
+ */
+#include <chrono>
+#include <filesystem>
+#include <random>
+
+#include <spdlog/spdlog.h>
+
+#include "config.hpp"
+#include "core/bvh.h"
+#include "core/import-obj.h"
+
+
+/// 把 .obj 中的所有 mesh 合并成一组顶点和索引
+static void load_triangles(const char *path, std::vector<glm::vec3> &positions,
+                           std::vector<uint32_t> &indices)
+{
+    constexpr size_t STRIDE = 8;    // pos, normal, uv
+    for (const auto &data: read_obj(path))
+    {
+        const auto base = (uint32_t) positions.size();
+        for (size_t i = 0; i + STRIDE <= data.vertices.size(); i += STRIDE)
+            positions.emplace_back(data.vertices[i], data.vertices[i + 1], data.vertices[i + 2]);
+        for (auto idx: data.faces)
+            indices.push_back(base + idx);
+    }
+}
+
+
+template<typename Func>
+static double time_ms(Func &&func)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin)
+            .count();
+}
+
+
+static void bench_model(const char *path)
+{
+    if (!std::filesystem::exists(path))
+    {
+        SPDLOG_WARN("model not found, skip: {}", path);
+        return;
+    }
+
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t>  indices;
+    load_triangles(path, positions, indices);
+    const size_t tri_cnt = indices.size() / 3;
+
+    /// 构建：单线程和并行各测试几次，取最小值
+    constexpr int REPEAT = 5;
+    MeshBVH       bvh;
+    double        single_ms = DBL_MAX, parallel_ms = DBL_MAX;
+    for (int i = 0; i < REPEAT; ++i)
+    {
+        single_ms   = std::min(single_ms, time_ms([&] {
+            bvh.build(positions, indices, {.parallel = false});
+        }));
+        parallel_ms = std::min(parallel_ms, time_ms([&] {
+            bvh.build(positions, indices, {.parallel = true});
+        }));
+    }
+
+    /// 遍历：从包围球外朝向模型中心附近发射随机光线
+    const auto &root = bvh.bvh().nodes()[0];
+    const AABB  bounds{.min = root.bb_min, .max = root.bb_max};
+    const float radius = glm::length(bounds.extent());
+
+    constexpr size_t                      RAY_CNT = 1'000'000;
+    std::mt19937                          rng(42);    // NOLINT
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    std::vector<Ray>                      rays(RAY_CNT);
+    for (auto &ray: rays)
+    {
+        const glm::vec3 dir    = glm::normalize(glm::vec3(dist(rng), dist(rng), dist(rng) + 1e-3f));
+        const glm::vec3 origin = bounds.center() + 2.f * radius * dir;
+        const glm::vec3 target =
+                bounds.center() + bounds.extent() * glm::vec3(dist(rng), dist(rng), dist(rng));
+        ray = {.origin = origin, .dir = glm::normalize(target - origin)};
+    }
+
+    size_t       hit_cnt = 0;
+    const double ray_ms  = time_ms([&] {
+        for (auto ray: rays)
+            hit_cnt += bvh.intersect(ray).hit();
+    });
+
+    SPDLOG_INFO("{}: {} triangles, {} nodes", std::filesystem::path(path).filename().string(),
+                tri_cnt, bvh.bvh().nodes().size());
+    SPDLOG_INFO("    build: single thread {:.2f} ms, parallel {:.2f} ms ({:.2f}x)", single_ms,
+                parallel_ms, single_ms / parallel_ms);
+    SPDLOG_INFO("    traverse: {:.2f} Mrays/s, hit rate {:.1f}%",
+                (double) RAY_CNT / ray_ms / 1000.0, 100.0 * (double) hit_cnt / RAY_CNT);
+}
+
+
+int main()
+{
+    for (const char *path: {MODEL_BUNNY, MODEL_DIONA, MODEL_LUCY})
+        bench_model(path);
+}
@@ -0,0 +1,78 @@
+/**
+ * 实例化绘制：10000 个相同的小球，几何和纹理相同，只需要一次 draw call
+ */
+#include "core/misc.h"
+#include "core/engine.h"
+#include "core/shader.h"
+#include "core/model-manager.h"
+#include "shader/blinn-phong/blinn-phong.h"
+#include "config.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+
+class Instancing : public Engine
+{
+    static constexpr int GRID_SIZE = 100;    // GRID_SIZE * GRID_SIZE 个小球
+
+    ShaderBlinnPhong      shader_phong;
+    std::vector<RTObject> spheres;
+
+    bool   use_instancing = true;
+    size_t draw_calls     = 0;
+
+    void init() override
+    {
+        shader_phong.init(camera.proj_matrix());
+
+        /// 所有小球共享同一份几何数据，颜色不同
+        const RTObject sphere = ModelManager::load(MODEL_SPHERE)[0];
+        spheres.reserve(GRID_SIZE * GRID_SIZE);
+        for (int i = 0; i < GRID_SIZE; ++i)
+            for (int j = 0; j < GRID_SIZE; ++j)
+            {
+                RTObject obj = sphere;
+                obj.set_matrix(glm::scale(glm::translate(glm::mat4(1.f),
+                                                         {(float) (i - GRID_SIZE / 2) * 1.5f, 0.f,
+                                                          (float) (j - GRID_SIZE / 2) * 1.5f}),
+                                          glm::vec3(0.5f)));
+                obj.mesh.mat.metallic_roughness.base_color = {
+                        (float) i / GRID_SIZE, 0.5f, (float) j / GRID_SIZE, 1.f};
+                spheres.push_back(obj);
+            }
+    }
+
+    void tick_render() override
+    {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        shader_phong.update_per_frame(camera.view_matrix(), camera.get_pos(), {0.f, 20.f, 0.f},
+                                      100.f);
+        if (use_instancing)
+            draw_calls = shader_phong.draw_instanced(spheres);
+        else
+        {
+            for (const RTObject &obj: spheres)
+                shader_phong.draw(obj);
+            draw_calls = spheres.size();
+        }
+    }
+
+    void tick_gui() override
+    {
+        ImGui::Begin("setting");
+        ImGui::Checkbox("instancing", &use_instancing);
+        ImGui::Text("spheres: %zu, draw calls: %zu", spheres.size(), draw_calls);
+        ImGui::Text("%.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate,
+                    ImGui::GetIO().Framerate);
+        ImGui::End();
+    }
+};
+
+
+int main(int argc, char **argv)
+{
+    Engine::parse_args(argc, argv);
+    auto engine = Instancing();
+    engine.engine_main();
+}
@@ -0,0 +1,190 @@
+/**
+ * JobSystem 的性能测试：线程数量从 1 开始翻倍，测量几种负载的加速比和并行效率\n
+ * - compute：parallel_for，每个元素做固定的浮点运算，纯计算、没有共享数据\n
+ * - tiny tasks：大量几乎为空的任务，测量调度本身的开销\n
+ * - nested：递归地创建 TaskGroup 并等待，测量窃取和嵌套等待\n
+ * - bvh build、frustum cull：框架中实际使用任务系统的地方\n
+ * 不需要创建窗口；可以用 --threads N 指定最大线程数量，默认是 CPU 的核心数
+ */
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+
+#include "core/bvh.h"
+#include "core/culling.h"
+#include "core/job-system.h"
+
+
+template<typename Func>
+static double time_ms(Func &&func)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin)
+            .count();
+}
+
+
+/// 多次运行，取最小值
+template<typename Func>
+static double best_ms(int repeat, Func &&func)
+{
+    double best = DBL_MAX;
+    for (int i = 0; i < repeat; ++i)
+        best = std::min(best, time_ms(func));
+    return best;
+}
+
+
+/// 一个元素的计算量大约是 1 微秒的几十分之一，结果写回数组，避免被优化掉
+static void bench_compute(std::vector<float> &data)
+{
+    parallel_for(0, data.size(), 4096, [&](size_t i) {
+        float x = (float) i * 1e-6f;
+        for (int k = 0; k < 16; ++k)
+            x = std::fma(x, 0.999f, std::sin(x) * 1e-3f);
+        data[i] = x;
+    });
+}
+
+
+static void bench_tiny_tasks(size_t cnt)
+{
+    std::atomic<size_t> sum{0};
+    TaskGroup           group;
+    for (size_t i = 0; i < cnt; ++i)
+        group.run([&sum] { sum.fetch_add(1, std::memory_order_relaxed); });
+    group.wait();
+}
+
+
+/// 递归的斐波那契数，低于 cutoff 时串行计算
+static uint64_t fib(int n, int cutoff)
+{
+    if (n < 2)
+        return n;
+    if (n <= cutoff)
+        return fib(n - 1, cutoff) + fib(n - 2, cutoff);
+
+    uint64_t  a = 0;
+    TaskGroup group;
+    group.run([&a, n, cutoff] { a = fib(n - 1, cutoff); });
+    const uint64_t b = fib(n - 2, cutoff);
+    group.wait();
+    return a + b;
+}
+
+
+/// 随机分布的小三角形
+static void make_triangles(size_t tri_cnt, std::vector<glm::vec3> &positions,
+                           std::vector<uint32_t> &indices)
+{
+    std::mt19937                          rng(7);    // NOLINT
+    std::uniform_real_distribution<float> dist(-100.f, 100.f);
+    std::uniform_real_distribution<float> offset(-0.5f, 0.5f);
+    for (size_t i = 0; i < tri_cnt; ++i)
+    {
+        const glm::vec3 center(dist(rng), dist(rng), dist(rng));
+        for (int k = 0; k < 3; ++k)
+        {
+            indices.push_back((uint32_t) positions.size());
+            positions.push_back(center + glm::vec3(offset(rng), offset(rng), offset(rng)));
+        }
+    }
+}
+
+
+static std::vector<AABB> make_boxes(size_t cnt)
+{
+    std::mt19937                          rng(11);    // NOLINT
+    std::uniform_real_distribution<float> dist(-200.f, 200.f);
+    std::vector<AABB>                     boxes(cnt);
+    for (auto &box: boxes)
+    {
+        const glm::vec3 c(dist(rng), dist(rng), dist(rng));
+        box = {.min = c - 0.5f, .max = c + 0.5f};
+    }
+    return boxes;
+}
+
+
+int main(int argc, char **argv)
+{
+    int max_threads = (int) std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i + 1 < argc; ++i)
+        if (std::strcmp(argv[i], "--threads") == 0)
+            max_threads = std::max(std::atoi(argv[i + 1]), 1);
+
+    std::vector<int> thread_cnts;
+    for (int t = 1; t < max_threads; t *= 2)
+        thread_cnts.push_back(t);
+    thread_cnts.push_back(max_threads);
+
+    /// 测试数据只生成一次
+    constexpr size_t   COMPUTE_CNT = 1 << 20;
+    constexpr size_t   TINY_CNT    = 1 << 20;
+    constexpr int      FIB_N       = 32;
+    constexpr int      FIB_CUTOFF  = 16;
+    constexpr size_t   TRI_CNT     = 1 << 18;
+    constexpr size_t   BOX_CNT     = 1 << 20;
+    constexpr int      REPEAT      = 3;
+    std::vector<float> data(COMPUTE_CNT);
+
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t>  indices;
+    make_triangles(TRI_CNT, positions, indices);
+
+    CullingBatch culling;
+    culling.update(make_boxes(BOX_CNT));
+    const glm::mat4 vp = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 500.f) *
+                         glm::lookAt(glm::vec3(0.f), glm::vec3(1.f, 0.f, 0.f),
+                                     glm::vec3(0.f, 1.f, 0.f));
+    std::vector<uint32_t> visible;
+
+    struct Result {
+        const char         *name;
+        std::vector<double> ms;
+    };
+    std::vector<Result> results = {{"compute"},  {"tiny tasks"},    {"nested"},
+                                   {"bvh build"}, {"frustum cull"}};
+
+    for (int t: thread_cnts)
+    {
+        JobSystem::init(t);
+        MeshBVH bvh;
+        results[0].ms.push_back(best_ms(REPEAT, [&] { bench_compute(data); }));
+        results[1].ms.push_back(best_ms(REPEAT, [&] { bench_tiny_tasks(TINY_CNT); }));
+        results[2].ms.push_back(best_ms(REPEAT, [&] { fib(FIB_N, FIB_CUTOFF); }));
+        results[3].ms.push_back(best_ms(REPEAT, [&] { bvh.build(positions, indices, {}); }));
+        results[4].ms.push_back(best_ms(REPEAT, [&] { culling.cull(vp, visible); }));
+    }
+
+    /// 加速比相对于 1 个线程，效率 = 加速比 / 线程数量
+    std::string header = fmt::format("{:<14}", "threads");
+    for (int t: thread_cnts)
+        header += fmt::format("{:>22}", t);
+    SPDLOG_INFO("{}", header);
+    for (const auto &r: results)
+    {
+        std::string line = fmt::format("{:<14}", r.name);
+        for (size_t i = 0; i < r.ms.size(); ++i)
+        {
+            const double speedup = r.ms[0] / r.ms[i];
+            line += fmt::format("{:>9.2f} ms {:>5.2f}x {:>3.0f}%", r.ms[i], speedup,
+                                100.0 * speedup / thread_cnts[i]);
+        }
+        SPDLOG_INFO("{}", line);
+    }
+    SPDLOG_INFO("tiny tasks: {:.1f} ns/task with 1 thread, compute checksum: {}",
+                results[1].ms[0] * 1e6 / TINY_CNT, data[data.size() / 3]);
+}
@@ -0,0 +1,156 @@
+/**
+ * meshlet 剔除的统计：在角色模型周围放置若干个摄像机和一个点光源，
+ * 比较每个 pass 提交的三角形、meshlet 剔除之后绘制的三角形、
+ * 以及真正可见（正面且在视锥体内）的三角形\n
+ * 只使用 CPU 上的模型数据，不需要创建窗口
+ */
+#include <chrono>
+#include <filesystem>
+
+#include <spdlog/spdlog.h>
+
+#include "config.hpp"
+#include "core/culling.h"
+#include "core/import-obj.h"
+#include "core/meshlet.h"
+
+
+/// 模型的一个部分，和导入时的 Mesh2 对应
+struct Part {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t>  indices;
+    Mesh2                  mesh;    // 只用到 index_cnt 和 meshlets
+};
+
+
+/// 一个 pass 的统计
+struct PassStats {
+    size_t submitted = 0;    // 提交的三角形
+    size_t drawn     = 0;    // meshlet 剔除之后绘制的三角形
+    size_t visible   = 0;    // 正面且和视锥体相交的三角形
+};
+
+
+/**
+ * 逐个三角形统计真正可见的数量，作为 meshlet 剔除的下限
+ */
+static size_t exact_visible(const std::vector<Part> &parts, const glm::mat4 &vp,
+                            const glm::vec3 &eye)
+{
+    const Frustum frustum = Frustum::from_matrix(vp);
+    size_t        cnt     = 0;
+    for (const auto &part: parts)
+        for (size_t t = 0; t + 2 < part.indices.size(); t += 3)
+        {
+            const glm::vec3 &p0 = part.positions[part.indices[t]];
+            const glm::vec3 &p1 = part.positions[part.indices[t + 1]];
+            const glm::vec3 &p2 = part.positions[part.indices[t + 2]];
+            if (glm::dot(glm::cross(p1 - p0, p2 - p0), p0 - eye) >= 0.f)
+                continue;
+            AABB aabb;
+            aabb.expand(p0);
+            aabb.expand(p1);
+            aabb.expand(p2);
+            cnt += frustum.test_aabb(aabb);
+        }
+    return cnt;
+}
+
+
+static PassStats run_pass(const std::vector<Part> &parts, const glm::mat4 &vp,
+                          const glm::vec3 &eye)
+{
+    MeshletCuller culler;
+    culler.begin(vp, eye);
+    for (const auto &part: parts)
+        culler.cull(part.mesh, glm::mat4(1.f));
+    return {.submitted = culler.stats().triangles_total,
+            .drawn     = culler.stats().triangles_visible,
+            .visible   = exact_visible(parts, vp, eye)};
+}
+
+
+static void bench_model(const char *path)
+{
+    if (!std::filesystem::exists(path))
+    {
+        SPDLOG_WARN("model not found, skip: {}", path);
+        return;
+    }
+
+    /// 读取模型，和 ImportObj 一样，只对三角形足够多的部分划分 meshlet
+    constexpr size_t  STRIDE = 8;    // pos, normal, uv
+    std::vector<Part> parts;
+    AABB              bounds;
+    size_t            meshlet_cnt = 0;
+    double            build_ms    = 0.0;
+    for (const auto &data: read_obj(path))
+    {
+        Part &part = parts.emplace_back();
+        for (size_t i = 0; i + STRIDE <= data.vertices.size(); i += STRIDE)
+        {
+            part.positions.emplace_back(data.vertices[i], data.vertices[i + 1],
+                                        data.vertices[i + 2]);
+            bounds.expand(part.positions.back());
+        }
+        part.indices.assign(data.faces.begin(), data.faces.end());
+        part.mesh.index_cnt            = part.indices.size();
+        part.mesh.index_component_type = GL_UNSIGNED_INT;
+
+        if (part.indices.size() / 3 < MESHLET_MIN_MESH_TRIANGLES)
+            continue;
+        const auto begin = std::chrono::steady_clock::now();
+        part.mesh.meshlets =
+                std::make_shared<const std::vector<Meshlet>>(build_meshlets(part.positions,
+                                                                            part.indices));
+        build_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                              begin)
+                            .count();
+        meshlet_cnt += part.mesh.meshlets->size();
+    }
+
+    /// 摄像机绕着模型转一圈，点光源在斜上方，光源的视锥体覆盖整个模型
+    constexpr int   VIEW_CNT = 8;
+    const glm::vec3 center   = bounds.center();
+    const float     radius   = glm::length(bounds.extent());
+    const glm::mat4 proj =
+            glm::perspective(glm::radians(45.f), 16.f / 9.f, 0.1f, 10.f * radius);
+
+    PassStats camera_total;
+    for (int v = 0; v < VIEW_CNT; ++v)
+    {
+        const float     angle = glm::radians(360.f * (float) v / VIEW_CNT);
+        const glm::vec3 eye   = center + 2.f * radius * glm::vec3(std::cos(angle), 0.2f,
+                                                                  std::sin(angle));
+        const PassStats s = run_pass(parts, proj * glm::lookAt(eye, center, {0, 1, 0}), eye);
+        camera_total.submitted += s.submitted;
+        camera_total.drawn += s.drawn;
+        camera_total.visible += s.visible;
+    }
+
+    const glm::vec3 light_pos  = center + 2.f * radius * glm::normalize(glm::vec3(1, 2, 3));
+    const glm::mat4 light_proj = glm::perspective(glm::radians(60.f), 1.f, 0.1f, 10.f * radius);
+    const PassStats shadow =
+            run_pass(parts, light_proj * glm::lookAt(light_pos, center, {0, 1, 0}), light_pos);
+
+    auto report = [](const char *pass, const PassStats &s) {
+        SPDLOG_INFO("    {}: submitted {}, drawn {} ({:.1f}%), visible {} ({:.1f}%)", pass,
+                    s.submitted, s.drawn, 100.0 * (double) s.drawn / (double) s.submitted,
+                    s.visible, 100.0 * (double) s.visible / (double) s.submitted);
+    };
+    size_t tri_cnt = 0;
+    for (const auto &part: parts)
+        tri_cnt += part.indices.size() / 3;
+    SPDLOG_INFO("{}: {} triangles, {} parts, {} meshlets, build {:.2f} ms",
+                std::filesystem::path(path).filename().string(), tri_cnt, parts.size(),
+                meshlet_cnt, build_ms);
+    report("camera (sum of 8 views)", camera_total);
+    report("shadow (point light)", shadow);
+}
+
+
+int main()
+{
+    for (const char *path: {MODEL_DIONA, MODEL_HUTAO, MODEL_LUCY})
+        bench_model(path);
+}
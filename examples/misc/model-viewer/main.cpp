@@ -13,6 +13,7 @@
 #include "config.hpp"
 #include "core/engine.h"
 #include "core/mesh.h"
+#include "core/model-manager.h"
 
 
 #include "shader/diffuse/diffuse.h"
@@ -34,7 +35,7 @@ class TestEngine : public Engine
         // load model
         for (auto &path: model_path_list)
         {
-            auto model = ImportObj::load_obj(path);
+            const auto &model = ModelManager::load(path);
             models.insert(models.end(), model.begin(), model.end());
         }
 
@@ -73,18 +74,19 @@ public:
 };
 
 
-int main(int args, char **argv)
+int main(int argc, char **argv)
 {
-    if (args == 1)
+    const auto model_paths = Engine::parse_args(argc, argv);
+    if (model_paths.empty())
     {
         std::cout << "cmd [model1.obj] [model2.obj]" << std::endl;
         return 0;
     }
 
     auto engine = TestEngine();
-    for (int i = 1; i < args; ++i)
+    for (const auto &path: model_paths)
     {
-        engine.model_path_list.emplace_back(argv[i]);
+        engine.model_path_list.emplace_back(path);
     }
 
     engine.engine_main();
@@ -0,0 +1,93 @@
+/**
+ * 软件遮挡剔除的无窗口测试：一面墙作为遮挡物，检查墙前、墙后、墙边等物体的可见性是否符合预期\n
+ * 全部符合时返回 0，否则返回 1
+ */
+#include <algorithm>
+#include <chrono>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+
+#include "core/occlusion.h"
+
+
+/// 中心为 center，边长为 size 的立方体
+static RTObject make_box(const glm::vec3 &center, float size)
+{
+    Mesh2 mesh;
+    mesh.aabb.expand(glm::vec3(-0.5f));
+    mesh.aabb.expand(glm::vec3(0.5f));
+    mesh.sphere = BoundingSphere::from_aabb(mesh.aabb);
+
+    const glm::mat4 matrix = glm::scale(glm::translate(glm::mat4(1.f), center), glm::vec3(size));
+    return RTObject(mesh, matrix);
+}
+
+
+/// z = 0 平面上，[-half, half] 范围内的一面墙
+static Occluder make_wall(float half)
+{
+    return {
+            .positions = {{-half, -half, 0.f}, {half, -half, 0.f}, {half, half, 0.f},
+                          {-half, half, 0.f}},
+            .indices   = {0, 1, 2, 0, 2, 3},
+    };
+}
+
+
+int main()
+{
+    const glm::mat4 proj = glm::perspective(glm::radians(60.f), 2.f, 0.1f, 100.f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.f, 0.f, 5.f), glm::vec3(0.f), {0.f, 1.f, 0.f});
+    const glm::mat4 vp   = proj * view;
+
+    const std::vector<Occluder> occluders = {make_wall(2.f)};
+
+    struct Case {
+        const char *name;
+        RTObject    obj;
+        bool        expect_visible;
+    };
+    const std::vector<Case> cases = {
+            {"behind wall", make_box({0.f, 0.f, -3.f}, 1.f), false},
+            {"far behind wall", make_box({0.5f, -0.5f, -20.f}, 1.f), false},
+            {"in front of wall", make_box({0.f, 0.f, 2.f}, 1.f), true},
+            {"beside wall", make_box({5.f, 0.f, -3.f}, 1.f), true},
+            {"across wall edge", make_box({2.f, 0.f, -1.f}, 1.f), true},
+            {"larger than wall", make_box({0.f, 0.f, -10.f}, 10.f), true},
+            {"intersects wall", make_box({0.f, 0.f, 0.f}, 1.f), true},
+            {"behind camera", make_box({0.f, 0.f, 8.f}, 1.f), true},
+    };
+
+    std::vector<RTObject> objs;
+    std::vector<uint32_t> candidates;
+    for (const auto &c: cases)
+    {
+        candidates.push_back((uint32_t) objs.size());
+        objs.push_back(c.obj);
+    }
+
+    /// 在工作线程中剔除，和正常渲染时的用法一致
+    OcclusionCuller culler(256, 128);
+    const auto      begin = std::chrono::steady_clock::now();
+    culler.cull_async(vp, occluders, objs, candidates);
+    std::vector<uint32_t> visible;
+    const CullStats       stats = culler.wait(visible);
+    const double          ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin)
+                    .count();
+
+    int failed = 0;
+    for (size_t i = 0; i < cases.size(); ++i)
+    {
+        const bool is_visible = std::find(visible.begin(), visible.end(), i) != visible.end();
+        const bool ok         = is_visible == cases[i].expect_visible;
+        failed += !ok;
+        SPDLOG_INFO("[{}] {}: expect {}, got {}", ok ? "PASS" : "FAIL", cases[i].name,
+                    cases[i].expect_visible ? "visible" : "occluded",
+                    is_visible ? "visible" : "occluded");
+    }
+    SPDLOG_INFO("visible {}, culled {}, {:.3f} ms", stats.visible, stats.culled, ms);
+
+    return failed == 0 ? 0 : 1;
+}
@@ -7,6 +7,7 @@
 #include "core/misc.h"
 #include "core/light.h"
 #include "core/texture.h"
+#include "core/model-manager.h"
 
 
 class RayMarch : public Engine
@@ -19,7 +20,7 @@ class RayMarch : public Engine
 
     PointLight point_light{.pos = {1.f, 2.f, 3.f}, .color = {0.9f, 0.9f, 0.9f}};
 
-    RTObject canvas = ImportObj::load_obj(MODEL_SQUARE)[0];
+    RTObject canvas = ModelManager::load(MODEL_SQUARE)[0];
 
     void init() override
     {
@@ -44,6 +45,8 @@ class RayMarch : public Engine
                 {"camera_pos", camera.get_pos()},
                 {"light_pos", point_light.pos},
                 {"light_color", point_light.color},
+                {"texcoord_jitter", sample_jitter() / glm::vec2(Window::framebuffer_width(),
+                                                                Window::framebuffer_height())},
         });
         canvas.mesh.draw();
     }
@@ -67,8 +70,9 @@ class RayMarch : public Engine
 };
 
 
-int main()
+int main(int argc, char **argv)
 {
+    Engine::parse_args(argc, argv);
     auto a = RayMarch();
     a.engine_main();
 }
\ No newline at end of file
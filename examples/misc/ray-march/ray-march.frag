@@ -16,6 +16,7 @@ uniform vec3  camera_front;
 uniform vec3  camera_up;
 uniform vec3  camera_right;     // 这三者互相垂直
 uniform float near;             // 摄像机近平面的位置
+uniform vec2  texcoord_jitter;  // 亚像素抖动，已经除以了屏幕尺寸，渐进累积时用于抗锯齿
 
 struct SDF_RES {
     float dis;
@@ -161,7 +162,7 @@ vec3 shading(vec3 pos, vec3 l_pos, vec3 color)
 void main() 
 {
     /// 将纹理坐标从 [0, 1]^2 转换为 [-0.5, 0.5]^2
-    vec2 canvas_coord = TexCoord - 0.5;
+    vec2 canvas_coord = TexCoord + texcoord_jitter - 0.5;
     float canvas_size = 2.0 * near * tan(camera_fov / 2.0 / 180.0 * PI);
 
     /// 计算光线的方向：从摄像机朝近平面像素上发射光线
@@ -0,0 +1,102 @@
+/**
+ * Scene 和 std::vector<RTObject> 的比较：内存占用、复制整个场景、每帧遍历位姿和包围盒的耗时\n
+ * 只使用 CPU 上的数据，不需要创建窗口
+ */
+#include <chrono>
+#include <cfloat>
+#include <random>
+
+#include <spdlog/spdlog.h>
+
+#include "core/scene.h"
+
+
+template<typename Func>
+static double time_ms(Func &&func)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin)
+            .count();
+}
+
+
+/// std::vector<RTObject> 占用的内存，包括 mesh 和 material 中的字符串
+static size_t memory_usage(const std::vector<RTObject> &objs)
+{
+    size_t bytes = objs.capacity() * sizeof(RTObject);
+    for (const auto &obj: objs)
+        bytes += obj.mesh.name.capacity() + obj.mesh.mat.name.capacity();
+    return bytes;
+}
+
+
+int main()
+{
+    constexpr size_t OBJ_CNT  = 100'000;
+    constexpr size_t MESH_CNT = 64;    // 场景中不同的模型数量
+    constexpr int    REPEAT   = 10;
+
+    /// 模拟导入的模型：名字足够长，不会被短字符串优化
+    std::vector<Mesh2> meshes(MESH_CNT);
+    for (size_t i = 0; i < MESH_CNT; ++i)
+    {
+        meshes[i].vao       = static_cast<GLuint>(i + 1);
+        meshes[i].index_cnt = 3 * 1024;
+        meshes[i].name      = fmt::format("imported-model/mesh-with-a-long-name-{}", i);
+        meshes[i].mat.name  = fmt::format("imported-model/material-with-a-long-name-{}", i % 8);
+        meshes[i].aabb      = {.min = glm::vec3(-1.f), .max = glm::vec3(1.f)};
+    }
+
+    std::mt19937                          rng(42);    // NOLINT
+    std::uniform_real_distribution<float> dist(-100.f, 100.f);
+    std::vector<RTObject>                 objs;
+    Scene                                 scene;
+    for (size_t i = 0; i < OBJ_CNT; ++i)
+    {
+        const glm::mat4 matrix =
+                glm::translate(glm::mat4(1.f), glm::vec3(dist(rng), dist(rng), dist(rng)));
+        objs.emplace_back(meshes[i % MESH_CNT], matrix);
+        scene.add(meshes[i % MESH_CNT], matrix);
+    }
+
+    /// 复制整个场景，例如 scenes[0] = model_xxx
+    double copy_vec_ms = DBL_MAX, copy_scene_ms = DBL_MAX;
+    for (int i = 0; i < REPEAT; ++i)
+    {
+        copy_vec_ms   = std::min(copy_vec_ms, time_ms([&] {
+            std::vector<RTObject> copy = objs;
+            (void) copy;
+        }));
+        copy_scene_ms = std::min(copy_scene_ms, time_ms([&] {
+            Scene copy = scene;
+            (void) copy;
+        }));
+    }
+
+    /// 每帧的遍历：读取位姿和世界坐标系下的包围盒，例如剔除和提交绘制
+    float  sink          = 0.f;
+    double iter_vec_ms   = DBL_MAX;
+    double iter_scene_ms = DBL_MAX;
+    for (int i = 0; i < REPEAT; ++i)
+    {
+        iter_vec_ms   = std::min(iter_vec_ms, time_ms([&] {
+            for (const auto &obj: objs)
+                sink += obj.matrix()[3].x + obj.world_aabb().max.y;
+        }));
+        iter_scene_ms = std::min(iter_scene_ms, time_ms([&] {
+            const SceneView view = scene.view();
+            for (size_t k = 0; k < view.size(); ++k)
+                sink += view.matrices[k][3].x + view.bounds[k].max.y;
+        }));
+    }
+
+    SPDLOG_INFO("{} objects, {} meshes, {} materials", scene.size(), scene.mesh_cnt(),
+                scene.material_cnt());
+    SPDLOG_INFO("    memory: vector<RTObject> {:.1f} MB, Scene {:.1f} MB",
+                (double) memory_usage(objs) / 1e6, (double) scene.memory_usage() / 1e6);
+    SPDLOG_INFO("    copy:   vector<RTObject> {:.2f} ms, Scene {:.2f} ms", copy_vec_ms,
+                copy_scene_ms);
+    SPDLOG_INFO("    iterate: vector<RTObject> {:.2f} ms, Scene {:.2f} ms ({})", iter_vec_ms,
+                iter_scene_ms, sink != 0.f);
+}
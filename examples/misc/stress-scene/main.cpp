@@ -0,0 +1,345 @@
+/**
+ * 压力测试场景：用 bunny、sphere、cube 生成任意数量的物体，
+ * 统计每帧各个阶段在 CPU 上的耗时随物体数量的变化：
+ * 动态物体的位姿更新、视锥体剔除、按材质排序、物体数据上传、提交绘制\n
+ * "scaling sweep" 依次测量 1k、10k、100k、1M 个物体，结果输出到日志中\n
+ * 位姿更新、剔除和排序在 tick_update 中完成，结果通过 TripleBuffer 交给 tick_render；
+ * --threaded 时它们在更新线程中执行，和物体数据上传、提交绘制重叠；--objects N 设置初始的物体数量
+ */
+#include <algorithm>
+#include <chrono>
+
+#include "config.hpp"
+#include "core/engine.h"
+#include "core/culling.h"
+#include "core/indirect-draw.h"
+#include "core/model-manager.h"
+#include "core/object-buffer.h"
+#include "core/stress-scene.h"
+#include "core/triple-buffer.h"
+
+
+/// 每个阶段的耗时（毫秒）
+struct PhaseTimes {
+    double update = 0.0;
+    double cull   = 0.0;
+    double sort   = 0.0;
+    double upload = 0.0;
+    double submit = 0.0;
+
+    PhaseTimes &operator+=(const PhaseTimes &o)
+    {
+        update += o.update;
+        cull += o.cull;
+        sort += o.sort;
+        upload += o.upload;
+        submit += o.submit;
+        return *this;
+    }
+
+    PhaseTimes operator/(double k) const
+    {
+        return {update / k, cull / k, sort / k, upload / k, submit / k};
+    }
+};
+
+
+/**
+ * 更新线程发布给渲染线程的一帧，渲染只读取这里的数据以及 Scene 中不会被 update 修改的部分
+ */
+struct FrameSnapshot {
+    glm::mat4              view{1.f};
+    glm::mat4              proj{1.f};
+    std::vector<glm::mat4> moving;       // 和 StressScene::moving() 一一对应的位姿
+    std::vector<uint64_t>  sort_keys;    // [63, 44] material，[43, 24] mesh，[23, 0] 物体的下标
+    size_t                 changed_cnt = 0;
+    size_t                 visible_cnt = 0;
+    PhaseTimes             times;    // 只有 update、cull、sort
+};
+
+
+class StressTest : public Engine
+{
+    static constexpr size_t OBJECT_CNTS[] = {1'000, 10'000, 100'000, 1'000'000};
+    static constexpr int    SWEEP_FRAMES  = 60;    // 每个规模统计的帧数
+
+    std::vector<RTObject> assets;
+    StressSceneDesc       desc;
+    int                   cnt_idx = 0;
+    int                   layout  = 0;
+    StressScene           stress;
+
+    Shader2 shader          = {EXAMPLE_CUR_PATH + "shader/object.vert",
+                               EXAMPLE_CUR_PATH + "shader/object.frag"};
+    Shader2 shader_indirect = {EXAMPLE_CUR_PATH + "shader/object.vert",
+                               EXAMPLE_CUR_PATH + "shader/object.frag",
+                               {{"OBJECT_ID_ATTRIBUTE", ""}}};
+
+    static constexpr int OBJECT_DATA_UNIT = 1;    // 0: diffuse 纹理
+
+    /// 只在 tick_update 中使用
+    CullingBatch          culling;
+    std::vector<uint32_t> visible;
+
+    TripleBuffer<FrameSnapshot> snapshots;
+
+    /// 只在渲染线程中使用
+    ObjectDataBuffer   object_data;
+    IndirectDrawBuffer indirect_draw;
+
+    bool enable_indirect = IndirectDrawBuffer::supported();
+    bool animate         = true;
+
+    PhaseTimes times;
+    size_t     changed_cnt  = 0;
+    size_t     visible_cnt  = 0;
+    size_t     upload_bytes = 0;
+    size_t     draw_calls   = 0;
+
+    /// 规模扫描：依次生成每个规模的场景，统计 SWEEP_FRAMES 帧的平均耗时，生成之后的第一帧不统计
+    int                                        sweep_step  = -1;
+    int                                        sweep_frame = 0;
+    PhaseTimes                                 sweep_sum;
+    std::vector<std::pair<size_t, PhaseTimes>> sweep_results;
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+public:
+    /**
+     * 初始的物体数量，取 OBJECT_CNTS 中不小于 cnt 的第一个，需要在 engine_main 之前调用
+     */
+    void set_object_cnt(size_t cnt)
+    {
+        cnt_idx = 0;
+        while (cnt_idx + 1 < (int) std::size(OBJECT_CNTS) && OBJECT_CNTS[cnt_idx] < cnt)
+            ++cnt_idx;
+    }
+
+private:
+
+    void init() override
+    {
+        for (const char *path: {MODEL_BUNNY, MODEL_SPHERE, MODEL_CUBE})
+        {
+            const auto &objs = ModelManager::load(path);
+            assets.insert(assets.end(), objs.begin(), objs.end());
+        }
+        desc.material_cnt     = 16;
+        desc.dynamic_fraction = 0.1f;
+        regenerate();
+    }
+
+    /**
+     * 重新生成场景，只在更新线程空闲时调用（init 或者 tick_gui）\n
+     * 之前发布的快照属于旧的场景，因此立即发布一个新的快照，渲染线程总是拿到新场景的结果
+     */
+    void regenerate()
+    {
+        desc.object_cnt = OBJECT_CNTS[cnt_idx];
+        desc.layout     = (StressLayout) layout;
+        stress.generate(desc, assets);
+        object_data.sync(stress.scene().view());
+        tick_update(camera);
+    }
+
+    static double ms(std::chrono::steady_clock::time_point a,
+                     std::chrono::steady_clock::time_point b)
+    {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    }
+
+    void tick_update(const Camera2 &view_camera) override
+    {
+        using clock = std::chrono::steady_clock;
+
+        FrameSnapshot &snap = snapshots.write_buffer();
+
+        const auto t0    = clock::now();
+        const auto t     = std::chrono::duration<float>(t0 - start).count();
+        snap.changed_cnt = animate ? stress.update(t) : 0;
+
+        /// 快照中是所有可能运动的物体的位姿，而不是这一帧的增量，中间的快照被跳过时不会丢失更新
+        const Scene &scene = stress.scene();
+        snap.moving.resize(stress.moving().size());
+        for (size_t k = 0; k < stress.moving().size(); ++k)
+            snap.moving[k] = scene.matrices()[stress.moving()[k]];
+
+        const auto t1 = clock::now();
+        snap.view     = view_camera.view_matrix();
+        snap.proj     = view_camera.proj_matrix();
+        culling.update(scene.bounds());
+        culling.cull(snap.proj * snap.view, visible);
+        snap.visible_cnt = visible.size();
+
+        /// 按照材质和几何排序，逐个绘制时相同的纹理是连续的
+        const auto t2 = clock::now();
+        snap.sort_keys.clear();
+        for (uint32_t idx: visible)
+            snap.sort_keys.push_back((uint64_t) scene.material_ids()[idx] << 44 |
+                                     (uint64_t) scene.mesh_ids()[idx] << 24 | idx);
+        std::sort(snap.sort_keys.begin(), snap.sort_keys.end());
+
+        const auto t3 = clock::now();
+        snap.times    = {ms(t0, t1), ms(t1, t2), ms(t2, t3)};
+        snapshots.publish();
+    }
+
+    void tick_render() override
+    {
+        using clock = std::chrono::steady_clock;
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        snapshots.update();
+        const FrameSnapshot &snap  = snapshots.read();
+        const Scene         &scene = stress.scene();
+
+        /// 位姿没有变化的物体 set_matrix 不会标记为脏
+        const auto t0 = clock::now();
+        for (size_t k = 0; k < snap.moving.size(); ++k)
+            object_data.set_matrix(stress.moving()[k], snap.moving[k]);
+        upload_bytes = object_data.upload();
+        object_data.bind(OBJECT_DATA_UNIT);
+
+        const auto t1 = clock::now();
+        submit(scene, snap);
+        const auto t2 = clock::now();
+
+        times        = snap.times;
+        times.upload = ms(t0, t1);
+        times.submit = ms(t1, t2);
+        changed_cnt  = snap.changed_cnt;
+        visible_cnt  = snap.visible_cnt;
+    }
+
+    void submit(const Scene &scene, const FrameSnapshot &snap)
+    {
+        const bool use_indirect = enable_indirect && IndirectDrawBuffer::supported();
+        Shader2   &s            = use_indirect ? shader_indirect : shader;
+        s.set_uniform({
+                {"m_view", snap.view},
+                {"m_proj", snap.proj},
+                {"object_data", OBJECT_DATA_UNIT},
+                {"tex_diffuse", 0},
+                {"use_texture", use_indirect ? 0 : 1},
+        });
+
+        if (use_indirect)
+        {
+            indirect_draw.clear();
+            for (uint64_t key: snap.sort_keys)
+            {
+                const auto idx = (uint32_t) (key & 0xFFFFFF);
+                indirect_draw.push(scene.mesh(idx), idx);
+            }
+            draw_calls = indirect_draw.draw_indirect();
+            return;
+        }
+
+        int bound_tex = -1;
+        for (uint64_t key: snap.sort_keys)
+        {
+            const auto      idx = (uint32_t) (key & 0xFFFFFF);
+            const Material &mat = scene.material(idx);
+            if (mat.has_tex_basecolor() && mat.metallic_roughness.tex_base_color != bound_tex)
+            {
+                bound_tex = mat.metallic_roughness.tex_base_color;
+                glBindTexture_(GL_TEXTURE_2D, 0, bound_tex);
+            }
+            shader.set_uniform({{"object_id", (int) idx}});
+            scene.mesh(idx).draw();
+        }
+        draw_calls = snap.sort_keys.size();
+    }
+
+    void tick_sweep()
+    {
+        if (sweep_step < 0)
+            return;
+        if (sweep_frame++ > 0)
+            sweep_sum += times;
+        if (sweep_frame <= SWEEP_FRAMES)
+            return;
+
+        sweep_results.emplace_back(OBJECT_CNTS[sweep_step], sweep_sum / SWEEP_FRAMES);
+        const auto &[cnt, avg] = sweep_results.back();
+        SPDLOG_INFO("{:>8} objects: update {:.3f} ms, cull {:.3f} ms, sort {:.3f} ms, "
+                    "upload {:.3f} ms, submit {:.3f} ms",
+                    cnt, avg.update, avg.cull, avg.sort, avg.upload, avg.submit);
+
+        if (++sweep_step == (int) std::size(OBJECT_CNTS))
+        {
+            sweep_step = -1;
+            return;
+        }
+        cnt_idx     = sweep_step;
+        sweep_frame = 0;
+        sweep_sum   = {};
+        regenerate();
+    }
+
+    /// 更新线程在 tick_gui 时是空闲的，因此重新生成场景只能在这里进行
+    void tick_gui() override
+    {
+        tick_sweep();
+
+        /// 动画和扫描每帧都在变化，--idle 时不能跳过
+        if (animate || sweep_step >= 0)
+            mark_changed();
+
+        ImGui::Begin("setting");
+
+        const char *cnt_names[]    = {"1k", "10k", "100k", "1M"};
+        const char *layout_names[] = {"grid", "scatter", "hierarchy"};
+        ImGui::Combo("objects", &cnt_idx, cnt_names, IM_ARRAYSIZE(cnt_names));
+        ImGui::Combo("layout", &layout, layout_names, IM_ARRAYSIZE(layout_names));
+        ImGui::SliderInt("materials", &desc.material_cnt, 1, 64);
+        ImGui::SliderInt("textures", &desc.texture_cnt, 0, desc.material_cnt);
+        ImGui::SliderFloat("dynamic fraction", &desc.dynamic_fraction, 0.f, 1.f);
+        ImGui::SliderInt("hierarchy fanout", &desc.hierarchy_fanout, 2, 16);
+        if (ImGui::Button("generate"))
+            regenerate();
+        ImGui::SameLine();
+        if (ImGui::Button("scaling sweep") && sweep_step < 0)
+        {
+            sweep_results.clear();
+            sweep_step  = 0;
+            sweep_frame = 0;
+            sweep_sum   = {};
+            cnt_idx     = 0;
+            regenerate();
+        }
+
+        ImGui::Checkbox("animate", &animate);
+        if (!IndirectDrawBuffer::supported())
+            enable_indirect = false;
+        ImGui::Checkbox("indirect draw", &enable_indirect);
+
+        ImGui::Text("objects %zu, dynamic %zu, changed %zu, visible %zu", stress.scene().size(),
+                    stress.dynamic_cnt(), changed_cnt, visible_cnt);
+        ImGui::Text("update thread: %s", Engine::options().threaded ? "on" : "off");
+        ImGui::Text("update %.3f ms, cull %.3f ms, sort %.3f ms", times.update, times.cull,
+                    times.sort);
+        ImGui::Text("upload %.3f ms (%zu bytes), submit %.3f ms (%zu draw calls)", times.upload,
+                    upload_bytes, times.submit, draw_calls);
+        ImGui::Text("%.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate,
+                    ImGui::GetIO().Framerate);
+
+        for (const auto &[cnt, avg]: sweep_results)
+            ImGui::Text("%8zu: %.3f / %.3f / %.3f / %.3f / %.3f ms", cnt, avg.update, avg.cull,
+                        avg.sort, avg.upload, avg.submit);
+
+        ImGui::End();
+    }
+};
+
+
+int main(int argc, char **argv)
+{
+    const std::vector<std::string> args = Engine::parse_args(argc, argv);
+    auto                           engine = StressTest();
+    for (size_t i = 0; i + 1 < args.size(); ++i)
+        if (args[i] == "--objects")
+            engine.set_object_cnt(std::stoul(args[i + 1]));
+    engine.engine_main();
+}
@@ -0,0 +1,23 @@
+#version 330 core
+
+in vec3 world_normal;
+in vec2 uv;
+flat in vec4 base_color;
+flat in int has_texture;
+
+out vec4 frag_color;
+
+uniform sampler2D tex_diffuse;
+uniform bool use_texture;    // 间接绘制时无法逐个物体绑定纹理，只使用 base color
+
+const vec3 LIGHT_DIR = normalize(vec3(1, 2, 3));
+
+void main()
+{
+    vec3 kd = base_color.rgb;
+    if (use_texture && has_texture != 0)
+        kd = texture(tex_diffuse, uv).rgb;
+
+    float diffuse = max(dot(normalize(world_normal), LIGHT_DIR), 0.0);
+    frag_color = vec4(kd * (0.2 + 0.8 * diffuse), 1.0);
+}
@@ -0,0 +1,26 @@
+#version 330 core
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 tex_coord;
+
+out vec3 world_normal;
+out vec2 uv;
+flat out vec4 base_color;
+flat out int has_texture;
+
+#include "object-data.glsl"
+
+uniform mat4 m_view;
+uniform mat4 m_proj;
+
+void main()
+{
+    mat4 m_model = object_model();
+    gl_Position = m_proj * m_view * m_model * vec4(pos, 1.0);
+
+    world_normal = mat3(m_model) * normal;
+    uv = tex_coord;
+    base_color = object_base_color();
+    has_texture = int(object_params().z);
+}
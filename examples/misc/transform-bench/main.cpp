@@ -0,0 +1,118 @@
+/**
+ * TransformTree 的性能测试：动画化大量节点时 update() 的耗时，
+ * 并和逐节点用 glm 计算世界矩阵的朴素做法比较\n
+ * 不需要创建窗口
+ */
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include <spdlog/spdlog.h>
+
+#include "core/transform.h"
+
+
+template<typename Func>
+static double time_us(Func &&func)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin)
+            .count();
+}
+
+
+/// 多次运行，取最小值
+template<typename Func>
+static double best_us(int repeat, Func &&func)
+{
+    double best = DBL_MAX;
+    for (int i = 0; i < repeat; ++i)
+        best = std::min(best, time_us(func));
+    return best;
+}
+
+
+int main()
+{
+    /// 场景：ROOT_CNT 棵树，每个节点有 BRANCH 个孩子，深度为 DEPTH
+    constexpr int ROOT_CNT = 64;
+    constexpr int BRANCH   = 4;
+    constexpr int DEPTH    = 4;
+    constexpr int REPEAT   = 20;
+
+    std::mt19937                          rng(42);    // NOLINT
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+    TransformTree            tree;
+    std::vector<TransformId> roots, leaves;
+    for (int r = 0; r < ROOT_CNT; ++r)
+    {
+        std::vector<TransformId> level = {
+                tree.add(INVALID_TRANSFORM, glm::vec3(dist(rng), 0.f, dist(rng)) * 100.f)};
+        roots.push_back(level[0]);
+        for (int d = 1; d < DEPTH; ++d)
+        {
+            std::vector<TransformId> next;
+            for (TransformId parent: level)
+                for (int b = 0; b < BRANCH; ++b)
+                    next.push_back(tree.add(
+                            parent, glm::vec3(dist(rng), dist(rng), dist(rng)),
+                            glm::angleAxis(dist(rng) * 3.14f, glm::vec3(0.f, 1.f, 0.f)),
+                            glm::vec3(0.9f)));
+            level = std::move(next);
+        }
+        leaves.insert(leaves.end(), level.begin(), level.end());
+    }
+    tree.update();
+
+    /// 动画化所有的根节点，整棵树都需要更新
+    float        angle    = 0.f;
+    size_t       full_cnt = 0;
+    const double full_us  = best_us(REPEAT, [&] {
+        angle += 0.01f;
+        for (TransformId id: roots)
+            tree.set_rotation(id, glm::angleAxis(angle, glm::vec3(0.f, 1.f, 0.f)));
+        full_cnt = tree.update();
+    });
+
+    /// 只动画化 1% 的叶子节点
+    size_t       partial_cnt = 0;
+    const double partial_us  = best_us(REPEAT, [&] {
+        angle += 0.01f;
+        for (size_t i = 0; i < leaves.size(); i += 100)
+            tree.set_translation(leaves[i], glm::vec3(std::sin(angle), 0.f, 0.f));
+        partial_cnt = tree.update();
+    });
+
+    /// 没有修改时 update() 直接返回
+    const double idle_us = best_us(REPEAT, [&] { tree.update(); });
+
+    /// 朴素做法：每个节点都用 glm 组合局部矩阵并乘上父节点的世界矩阵
+    std::vector<glm::mat4> naive(tree.size());
+    const double           naive_us = best_us(REPEAT, [&] {
+        for (TransformId id = 0; id < tree.size(); ++id)
+        {
+            const glm::mat4 local = glm::translate(glm::mat4(1.f), tree.translation(id)) *
+                                    glm::mat4_cast(tree.rotation(id)) *
+                                    glm::scale(glm::mat4(1.f), tree.scale(id));
+            const TransformId p = tree.parent(id);
+            naive[id]           = p == INVALID_TRANSFORM ? local : naive[p] * local;
+        }
+    });
+
+    /// 检查结果是否一致
+    float max_err = 0.f;
+    for (TransformId id = 0; id < tree.size(); ++id)
+        for (int c = 0; c < 4; ++c)
+            for (int r = 0; r < 4; ++r)
+                max_err = std::max(max_err, std::abs(tree.world(id)[c][r] - naive[id][c][r]));
+
+    SPDLOG_INFO("{} nodes, {} roots, {} leaves", tree.size(), roots.size(), leaves.size());
+    SPDLOG_INFO("    animate roots:  {} nodes updated, {:.1f} us", full_cnt, full_us);
+    SPDLOG_INFO("    animate leaves: {} nodes updated, {:.1f} us", partial_cnt, partial_us);
+    SPDLOG_INFO("    no change:      {:.2f} us", idle_us);
+    SPDLOG_INFO("    naive glm:      {:.1f} us, max error {:.2e}", naive_us, max_err);
+}
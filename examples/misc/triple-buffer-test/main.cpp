@@ -0,0 +1,180 @@
+/**
+ * TripleBuffer 和 UpdateThread 的多线程压力测试，不需要创建窗口\n
+ * - triple buffer：一个线程不停地发布完整的快照，另一个线程不停地读取，
+ *   检查读到的快照没有被撕裂、版本号单调递增\n
+ * - update handoff：和 Engine 的 --threaded 模式相同的 wait / update / kick 顺序，
+ *   渲染线程在 kick 之后读取快照，同时更新线程写入下一个快照；
+ *   检查每帧读到的正是上一次更新的结果，以及更新函数的异常会在 wait 中重新抛出\n
+ * 用 -fsanitize=thread 编译时可以同时检查数据竞争；可以用 --iterations N 指定发布的次数。
+ * 全部通过时返回 0，否则返回 1
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "core/triple-buffer.h"
+#include "core/update-thread.h"
+
+
+/// 一个快照：所有元素都等于版本号，读到不一致的元素说明快照被撕裂了
+struct Snapshot {
+    uint64_t              version = 0;
+    std::vector<uint64_t> data;
+
+    void fill(uint64_t v, size_t size)
+    {
+        version = v;
+        data.assign(size, v);
+    }
+
+    [[nodiscard]] bool consistent() const
+    {
+        for (uint64_t x: data)
+            if (x != version)
+                return false;
+        return true;
+    }
+};
+
+
+static bool report(const char *name, bool ok, const std::string &detail)
+{
+    SPDLOG_INFO("[{}] {}: {}", ok ? "PASS" : "FAIL", name, detail);
+    return ok;
+}
+
+
+/// 写入线程发布 1..iterations 共 iterations 个版本，读取线程一直读到最后一个版本
+static bool test_triple_buffer(uint64_t iterations)
+{
+    constexpr size_t       DATA_SIZE = 64;
+    TripleBuffer<Snapshot> buffer;
+
+    std::thread writer([&] {
+        for (uint64_t v = 1; v <= iterations; ++v)
+        {
+            /// 根据版本号改变大小，让 vector 的重新分配也参与测试
+            buffer.write_buffer().fill(v, DATA_SIZE + v % 7);
+            buffer.publish();
+        }
+    });
+
+    uint64_t last     = 0;
+    uint64_t received = 0;
+    uint64_t torn     = 0;
+    uint64_t reversed = 0;
+    if (buffer.read().version != 0)
+        ++torn;
+    while (last < iterations)
+    {
+        if (!buffer.update())
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        const Snapshot &s = buffer.read();
+        torn += !s.consistent();
+        reversed += s.version <= last;
+        last = s.version;
+        ++received;
+    }
+    writer.join();
+
+    /// 写入方停止之后不会再有新的内容
+    const bool stale = buffer.update();
+    return report("triple buffer", torn == 0 && reversed == 0 && !stale,
+                  fmt::format("published {}, received {}, torn {}, out of order {}", iterations,
+                              received, torn, reversed));
+}
+
+
+/// 每帧：wait 上一次更新 -> 取得快照 -> 修改更新函数的输入 -> kick -> 读取快照
+static bool test_update_handoff(uint64_t frames)
+{
+    constexpr size_t       DATA_SIZE = 256;
+    TripleBuffer<Snapshot> buffer;
+    uint64_t               input = 0;    // 只在 wait 和 kick 之间由渲染线程修改
+
+    UpdateThread update([&] {
+        buffer.write_buffer().fill(input, DATA_SIZE);
+        buffer.publish();
+    });
+
+    uint64_t mismatched = 0;
+    uint64_t torn       = 0;
+    uint64_t checksum   = 0;
+    for (uint64_t frame = 1; frame <= frames; ++frame)
+    {
+        update.wait();
+        const bool fresh = buffer.update();
+        if (frame > 1 && (!fresh || buffer.read().version != frame - 1))
+            ++mismatched;
+
+        input = frame;
+        update.kick();
+
+        /// 和更新线程写入下一个快照同时进行
+        const Snapshot &s = buffer.read();
+        torn += !s.consistent();
+        for (uint64_t x: s.data)
+            checksum += x;
+    }
+    update.wait();
+
+    return report("update handoff", mismatched == 0 && torn == 0,
+                  fmt::format("frames {}, mismatched {}, torn {}, checksum {}", frames, mismatched,
+                              torn, checksum));
+}
+
+
+/// 更新函数抛出的异常在下一次 wait 中重新抛出，之后线程可以继续使用
+static bool test_update_exception()
+{
+    int          calls = 0;
+    UpdateThread update([&] {
+        if (++calls == 2)
+            throw std::runtime_error("update failed");
+    });
+
+    bool thrown = false;
+    for (int i = 0; i < 3; ++i)
+    {
+        update.kick();
+        try
+        {
+            update.wait();
+        } catch (const std::runtime_error &)
+        {
+            thrown = thrown || i == 1;
+        }
+    }
+    return report("update exception", thrown && calls == 3,
+                  fmt::format("calls {}, rethrown {}", calls, thrown));
+}
+
+
+int main(int argc, char **argv)
+{
+    uint64_t iterations = 200000;
+    for (int i = 1; i + 1 < argc; ++i)
+        if (std::strcmp(argv[i], "--iterations") == 0)
+            iterations = std::max<uint64_t>(std::strtoull(argv[i + 1], nullptr, 10), 1);
+
+    const auto begin = std::chrono::steady_clock::now();
+    bool       ok    = test_triple_buffer(iterations);
+    ok               = test_update_handoff(iterations / 10 + 1) && ok;
+    ok               = test_update_exception() && ok;
+    SPDLOG_INFO("{:.1f} ms", std::chrono::duration<double, std::milli>(
+                                     std::chrono::steady_clock::now() - begin)
+                                     .count());
+
+    return ok ? 0 : 1;
+}
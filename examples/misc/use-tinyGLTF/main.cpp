@@ -3,6 +3,8 @@
 #include "core/engine.h"
 #include "config.hpp"
 #include "core/shader.h"
+#include "core/shader-lib.h"
+#include "core/render-queue.h"
 #include "shader/diffuse/diffuse.h"
 #include "core/import-gltf.h"
 
@@ -10,9 +12,21 @@
 class TestGLTF : public Engine
 {
     std::vector<RTObject> obj_list;
+    RenderQueue           render_queue;    // 按照着色器变体排序后的绘制顺序
 
     Shader2 shader_base = {SHADER + "base/base.vert", SHADER + "base/base.frag"};
-    Shader2 shader_gltf = {SHADER + "gltf/gltf.vert", SHADER + "gltf/gltf.frag"};
+
+    /**
+     * 根据材质有哪些纹理，获取 gltf 着色器的变体
+     */
+    static Shader2 &shader_gltf(const Material &mat)
+    {
+        /// gltf 着色器用不到 metallic-roughness 纹理，也不区分双面材质
+        constexpr MaterialFeatures mask =
+                MAT_TEX_BASECOLOR | MAT_TEX_OCCLUSION | MAT_TEX_EMISSIVE | MAT_TEX_NORMAL;
+        static ShaderVariants variants(SHADER + "gltf/gltf.vert", SHADER + "gltf/gltf.frag", mask);
+        return variants.get(mat.features);
+    }
 
     void init() override
     {
@@ -24,6 +38,12 @@ class TestGLTF : public Engine
         // GLTF gltf = GLTF {EXAMPLE_CUR_PATH + "test-gltf/test.gltf"};
         ImportGLTF gltf = ImportGLTF{"/Users/qizhengjie/Library/Mobile Documents/com~apple~CloudDocs/常用3D模型/warrior_girl/scene.gltf"};
         obj_list = gltf.get_obj_list();
+
+        for (const auto &obj: obj_list)
+            render_queue.push(shader_gltf(obj.mesh.mat), obj);
+        render_queue.sort();
+        SPDLOG_INFO("objects: {}, shader permutations: {}", obj_list.size(),
+                    render_queue.permutation_cnt());
     }
 
     void tick_render() override
@@ -35,47 +55,54 @@ class TestGLTF : public Engine
                 {"u_vp", camera.proj_matrix() * camera.view_matrix()},
         });
 
-        shader_gltf.set_uniform({
-                {"u_proj", camera.proj_matrix()},
-
-                {"u_light_pos", glm::vec3(2.f, 4.f, 2.f)},
-                {"u_light_color", glm::vec3(0.7f)},
-        });
-
-        for (const auto &obj: obj_list)
+        const Shader2 *cur_shader = nullptr;
+        for (const auto &item: render_queue.items())
         {
-
+            const auto &obj  = *item.obj;
             const auto &mesh = obj.mesh;
             const auto &mat  = mesh.mat;
             // shader_base.set_uniform({{"u_model", obj.matrix}});
 
-            shader_gltf.set_uniform({
+            /// 队列已经按照变体排序，每个变体只需要设置一次 per-frame 的 uniform
+            if (item.shader != cur_shader)
+            {
+                cur_shader = item.shader;
+                item.shader->set_uniform({
+                        {"u_proj", camera.proj_matrix()},
+                        {"u_light_pos", glm::vec3(2.f, 4.f, 2.f)},
+                        {"u_light_color", glm::vec3(0.7f)},
+                });
+            }
+
+            /// 变体中只存在材质用得到的 uniform
+            std::vector<UniformAttribute2> uniforms = {
                     {"u_model_view", camera.view_matrix() * obj.matrix()},
-
-                    {"u_basecolor", mat.metallic_roughness.base_color},
-                    {"u_has_basecolor", (int) mat.has_tex_basecolor()},
-                    {"u_tex_basecolor", 0},
-
-                    {"u_occlusion_strength", (float) mat.occusion_strength},
-                    {"u_has_occlusion", (int) mat.has_tex_occlusion()},
-                    {"u_tex_occlusion", 1},
-
-                    {"u_emissive", mat.emissive},
-                    {"u_has_emissive", (int) mat.has_tex_emissive()},
-                    {"u_tex_emissive", 2},
-
-                    {"u_normal_scale", (float) mat.normal_scale},
-                    {"u_has_normal", (int) mat.has_tex_normal()},
-                    {"u_tex_normal", 3},
-            });
+            };
             if (mat.has_tex_basecolor())
+            {
+                uniforms.emplace_back("u_tex_basecolor", 0);
                 glBindTexture_(GL_TEXTURE_2D, 0, mat.metallic_roughness.tex_base_color);
+            } else
+                uniforms.emplace_back("u_basecolor", mat.metallic_roughness.base_color);
             if (mat.has_tex_occlusion())
+            {
+                uniforms.emplace_back("u_occlusion_strength", (float) mat.occusion_strength);
+                uniforms.emplace_back("u_tex_occlusion", 1);
                 glBindTexture_(GL_TEXTURE_2D, 1, mat.tex_occlusion);
+            }
             if (mat.has_tex_emissive())
+            {
+                uniforms.emplace_back("u_tex_emissive", 2);
                 glBindTexture_(GL_TEXTURE_2D, 2, mat.tex_emissive);
+            } else
+                uniforms.emplace_back("u_emissive", mat.emissive);
             if (mat.has_tex_normal())
+            {
+                uniforms.emplace_back("u_normal_scale", (float) mat.normal_scale);
+                uniforms.emplace_back("u_tex_normal", 3);
                 glBindTexture_(GL_TEXTURE_2D, 3, mat.tex_normal);
+            }
+            item.shader->set_uniform(uniforms);
 
             glBindVertexArray(mesh.vao);
             glDrawElements(mesh.primitive_mode, (GLsizei) mesh.index_cnt,
@@ -83,11 +110,20 @@ class TestGLTF : public Engine
             CHECK_GL_ERROR();
         }
     }
+
+    void tick_gui() override
+    {
+        ImGui::Begin("setting");
+        ImGui::Text("objects: %zu", obj_list.size());
+        ImGui::Text("shader permutations: %zu", render_queue.permutation_cnt());
+        ImGui::End();
+    }
 };
 
 
-int main()
+int main(int argc, char **argv)
 {
+    Engine::parse_args(argc, argv);
     try
     {
         auto engine = TestGLTF();
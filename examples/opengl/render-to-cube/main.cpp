@@ -10,6 +10,7 @@
 #include "core/engine.h"
 #include "core/misc.h"
 #include "core/texture.h"
+#include "core/model-manager.h"
 
 
 #include "shader/skybox/skybox.h"
@@ -45,8 +46,8 @@ struct CubeFramebuffer {
 
 class EngineTest : public Engine
 {
-    std::vector<RTObject> model_three = ImportObj::load_obj(MODEL_THREE_OBJS);
-    std::vector<RTObject> model_202   = ImportObj::load_obj(MODEL_202_CHAN);
+    std::vector<RTObject> model_three = ModelManager::load(MODEL_THREE_OBJS);
+    std::vector<RTObject> model_202   = ModelManager::load(MODEL_202_CHAN);
 
     ShaderDiffuse    shader_lambert;
     ShaderBlinnPhong shader_phong;
@@ -124,8 +125,9 @@ class EngineTest : public Engine
 };
 
 
-int main()
+int main(int argc, char **argv)
 {
+    Engine::parse_args(argc, argv);
     auto engine = EngineTest();
     engine.engine_main();
 }
\ No newline at end of file
@@ -15,7 +15,7 @@
 #include "core/engine.h"
 #include "core/misc.h"
 #include "core/texture.h"
-#include "core/import-obj.h"
+#include "core/model-manager.h"
 
 #include "shader/skybox/skybox.h"
 #include "shader/tex2d-visual/tex-visual.h"
@@ -59,8 +59,8 @@ class EngineTest : public Engine
     ShaderDiffuse   shader_lambert;
     ShaderTexVisual shader_texvisual;
 
-    std::vector<RTObject> three_objs   = ImportObj::load_obj(MODEL_THREE_OBJS);
-    RTObject              model_square = ImportObj::load_obj(MODEL_SQUARE)[0];
+    std::vector<RTObject> three_objs   = ModelManager::load(MODEL_THREE_OBJS);
+    RTObject              model_square = ModelManager::load(MODEL_SQUARE)[0];
 
     SkyBox skybox;
 
@@ -106,8 +106,9 @@ class EngineTest : public Engine
 };
 
 
-int main()
+int main(int argc, char **argv)
 {
+    Engine::parse_args(argc, argv);
     auto engine = EngineTest();
     engine.engine_main();
 }
\ No newline at end of file
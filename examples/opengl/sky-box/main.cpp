@@ -9,6 +9,7 @@
 
 #include "config.hpp"
 #include "core/engine.h"
+#include "core/model-manager.h"
 
 #include "shader/skybox/skybox.h"
 #include "shader/diffuse/diffuse.h"
@@ -18,7 +19,7 @@ class EngineTest : public Engine
 {
     ShaderDiffuse shader_lambert;
 
-    std::vector<RTObject> model_202 = ImportObj::load_obj(MODEL_202_CHAN);
+    std::vector<RTObject> model_202 = ModelManager::load(MODEL_202_CHAN);
 
     SkyBox        skybox;
     CubeMapVisual visual;
@@ -69,8 +70,9 @@ class EngineTest : public Engine
     }
 };
 
-int main()
+int main(int argc, char **argv)
 {
+    Engine::parse_args(argc, argv);
     auto engine = EngineTest();
     engine.engine_main();
 }
\ No newline at end of file
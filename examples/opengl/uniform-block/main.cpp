@@ -8,6 +8,7 @@
 #include "core/engine.h"
 #include "core/mesh.h"
 #include "core/shader.h"
+#include "core/model-manager.h"
 #include "functions/axis.h"
 
 
@@ -67,7 +68,7 @@ class EngineTest : public Engine
     Axis axis;
 
     /// model
-    std::vector<RTObject> model_diona = ImportObj::load_obj(MODEL_DIONA);
+    std::vector<RTObject> model_diona = ModelManager::load(MODEL_DIONA);
 
     /// shader
     ShaderDiffuse shader_diffuse;
@@ -121,8 +122,9 @@ GLuint EngineTest::create_ubo(int total_size)
 }
 
 
-int main()
+int main(int argc, char **argv)
 {
+    Engine::parse_args(argc, argv);
     auto engine = EngineTest();
     engine.engine_main();
 }
\ No newline at end of file
@@ -4,12 +4,14 @@ layout (location = 0) in vec3 pos;
 
 out vec3 pos_in_view_coord;
 
-uniform mat4 m_model;
+#include "object-data.glsl"
+
 uniform mat4 m_view;
 uniform mat4 m_proj;
 
 void main()
 {
+    mat4 m_model = object_model();
     gl_Position = m_proj * m_view * m_model * vec4(pos, 1.0);
     pos_in_view_coord = vec3(m_view * m_model * vec4(pos, 1.0));
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
  */
 
 #define GL_SILENCE_DEPRECATION
+#include <chrono>
+
 #include <glad/glad.h>
 
 #include "config.hpp"
@@ -10,6 +12,12 @@
 #include "core/mesh.h"
 #include "core/misc.h"
 #include "core/texture.h"
+#include "core/model-manager.h"
+#include "core/culling.h"
+#include "core/occlusion.h"
+#include "core/object-buffer.h"
+#include "core/indirect-draw.h"
+#include "core/scene.h"
 
 #include "shader/diffuse/diffuse.h"
 
@@ -23,12 +31,12 @@ private:
 
     const GLsizei frame_buffer_size = 1024;
 
-    std::vector<RTObject> model_three_obj = ImportObj::load_obj(MODEL_THREE_OBJS);
-    std::vector<RTObject> model_matrix    = ImportObj::load_obj(MODEL_SPHERE_MATRIX);
-    std::vector<RTObject> model_202       = ImportObj::load_obj(MODEL_202_CHAN);
-    std::vector<RTObject> model_diona     = ImportObj::load_obj(MODEL_DIONA);
-    RTObject              model_light     = ImportObj::load_obj(MODEL_LIGHT)[0];
-    RTObject              model_floor     = ImportObj::load_obj(MODLE_FLOOR)[0];
+    std::vector<RTObject> model_three_obj = ModelManager::load(MODEL_THREE_OBJS);
+    std::vector<RTObject> model_matrix    = ModelManager::load(MODEL_SPHERE_MATRIX);
+    std::vector<RTObject> model_202       = ModelManager::load(MODEL_202_CHAN);
+    std::vector<RTObject> model_diona     = ModelManager::load(MODEL_DIONA);
+    RTObject              model_light     = ModelManager::load(MODEL_LIGHT)[0];
+    RTObject              model_floor     = ModelManager::load(MODLE_FLOOR)[0];
 
     Shader2       shader_depth  = {EXAMPLE_CUR_PATH + "shader/distance-to-light.vert",
                                    EXAMPLE_CUR_PATH + "shader/distance-to-light.frag"};
@@ -36,11 +44,49 @@ private:
                                    EXAMPLE_CUR_PATH + "shader/shadow-mapping.frag"};
     ShaderDiffuse shader_diffuse;
 
+    /// 有 base color 纹理的材质使用的变体，没有动态分支
+    Shader2 shader_shadow_tex = {EXAMPLE_CUR_PATH + "shader/shadow-mapping.vert",
+                                 EXAMPLE_CUR_PATH + "shader/shadow-mapping.frag",
+                                 {{"HAS_TEX_BASECOLOR", ""}}};
+
     const int SCENE_MAX_CNT  = 4;    // 场景的总数
     int       scene_switcher = 0;    // 当前选中哪个场景
 
     /// 场景的详细信息
-    std::vector<std::vector<RTObject>> scenes = std::vector<std::vector<RTObject>>(SCENE_MAX_CNT);
+    std::vector<Scene> scenes = std::vector<Scene>(SCENE_MAX_CNT);
+
+    /// 视锥体剔除：cube map 的 6 个面以及摄像机各自剔除一次
+    CullingBatch             culling;
+    std::vector<uint32_t>    visible;
+    std::array<CullStats, 6> face_stats;
+    CullStats                camera_stats;
+
+    /// 遮挡剔除：每个场景的遮挡物是简化之后的模型，在工作线程中和 shadow pass 并行
+    std::vector<std::vector<Occluder>> scene_occluders =
+            std::vector<std::vector<Occluder>>(SCENE_MAX_CNT);
+    OcclusionCuller       occlusion;
+    bool                  enable_occlusion = true;
+    std::vector<uint32_t> camera_visible;
+    CullStats             occlusion_stats;
+
+    /// meshlet 剔除：在物体级别的剔除之后，剔除视锥体之外以及背向视点的三角形簇
+    MeshletCuller                       meshlet_culler;
+    std::array<MeshletCuller::Stats, 6> face_meshlet_stats;
+    MeshletCuller::Stats                camera_meshlet_stats;
+
+    /// shadow pass 的间接绘制：每个面按 VAO 提交几次 glMultiDrawElementsIndirect，不剔除 meshlet
+    Shader2 shader_depth_indirect = {EXAMPLE_CUR_PATH + "shader/distance-to-light.vert",
+                                     EXAMPLE_CUR_PATH + "shader/distance-to-light.frag",
+                                     {{"OBJECT_ID_ATTRIBUTE", ""}}};
+    IndirectDrawBuffer indirect_draw;
+    bool               enable_indirect   = IndirectDrawBuffer::supported();
+    size_t             shadow_draw_calls = 0;
+    double             shadow_submit_ms  = 0.0;    // shadow pass 在 CPU 上提交的耗时
+
+    /// 物体的位姿和材质常驻显存，绘制时只需要设置 object_id
+    static constexpr int OBJECT_DATA_UNIT = 2;    // 0: shadow map，1: diffuse 纹理
+    ObjectDataBuffer     object_data;
+    size_t               upload_bytes = 0;
 
 protected:
     void init() override
@@ -67,15 +113,28 @@ protected:
 
         /// 场景信息
         {
-            combine(scenes[0], model_202);
-            scenes[0].push_back(model_floor);
+            scenes[0].add(model_202);
+            scenes[0].add(model_floor);
+
+            scenes[1].add(model_three_obj);
+
+            scenes[2].add(model_matrix);
+
+            scenes[3].add(model_diona);
+            scenes[3].add(model_floor);
+        }
 
-            combine(scenes[1], model_three_obj);
+        /// 遮挡物：场景中的物体都没有移动，直接使用模型空间的数据
+        {
+            constexpr size_t OCCLUDER_MAX_TRIANGLES = 2048;
 
-            combine(scenes[2], model_matrix);
+            const Occluder floor = Occluder::from_obj(MODLE_FLOOR);
 
-            combine(scenes[3], model_diona);
-            scenes[3].push_back(model_floor);
+            scene_occluders[0] = {Occluder::from_obj(MODEL_202_CHAN, OCCLUDER_MAX_TRIANGLES),
+                                  floor};
+            scene_occluders[1] = {Occluder::from_obj(MODEL_THREE_OBJS, OCCLUDER_MAX_TRIANGLES)};
+            scene_occluders[2] = {Occluder::from_obj(MODEL_SPHERE_MATRIX, OCCLUDER_MAX_TRIANGLES)};
+            scene_occluders[3] = {Occluder::from_obj(MODEL_DIONA, OCCLUDER_MAX_TRIANGLES), floor};
         }
 
         glDepthFunc(GL_LEQUAL);
@@ -85,13 +144,29 @@ protected:
 
     void tick_render() override
     {
-        std::vector<RTObject> &scene = scenes[scene_switcher];
+        const Scene &scene = scenes[scene_switcher];
+        culling.update(scene.bounds());
+
+        /// 场景静止时不会上传任何数据，切换场景时才会上传
+        object_data.sync(scene.view());
+        upload_bytes = object_data.upload();
+        object_data.bind(OBJECT_DATA_UNIT);
+
+        /// 摄像机的视锥体剔除之后，在提交 shadow pass 的同时进行遮挡剔除
+        const glm::mat4 camera_vp = camera.proj_matrix() * camera.view_matrix();
+        camera_stats              = culling.cull(camera_vp, camera_visible);
+        if (enable_occlusion)
+            occlusion.cull_async(camera_vp, scene_occluders[scene_switcher], scene.bounds(),
+                                 camera_visible);
+
         shadow_pass(scene);
+
+        occlusion_stats = enable_occlusion ? occlusion.wait(camera_visible) : CullStats{};
         color_pass(scene);
     }
 
 
-    void shadow_pass(const std::vector<RTObject> &scene)
+    void shadow_pass(const Scene &scene)
     {
         // generate depth cube map
         glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
@@ -100,7 +175,13 @@ protected:
         /// 重点：确保视角是 90 度
         glm::mat4 proj = glm::perspective(glm::radians(90.f), 1.0f, 0.1f, 20.f);
 
+        const bool use_indirect = enable_indirect && IndirectDrawBuffer::supported();
+        Shader2   &shader       = use_indirect ? shader_depth_indirect : shader_depth;
+        const auto begin        = std::chrono::steady_clock::now();
+        shadow_draw_calls       = 0;
+
         /// 将场景绘制到 cube map 的某个面上
+        int  face     = 0;
         auto draw_dir = [&](GLenum textarget, const glm::vec3 &front, const glm::vec3 &up) {
             // textarget: for cube map, specify which face is to be attached
             glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textarget, cube_shadow_map,
@@ -110,18 +191,31 @@ protected:
             glm::mat4 m_view =
                     glm::lookAt(model_light.position(), model_light.position() + front, up);
 
-            shader_depth.set_uniform({
+            shader.set_uniform({
                     {"m_view", m_view},
                     {"m_proj", proj},
+                    {"object_data", OBJECT_DATA_UNIT},
             });
 
-            for (auto &m: scene)
+            face_stats[face] = culling.cull(proj * m_view, visible);
+            if (use_indirect)
             {
-                shader_depth.set_uniform({
-                        {"m_model", m.matrix()},
-                });
-                m.mesh.draw();
+                indirect_draw.clear();
+                for (uint32_t idx: visible)
+                    indirect_draw.push(scene.mesh(idx), idx);
+                shadow_draw_calls += indirect_draw.draw_indirect();
+                face_meshlet_stats[face++] = {};
+                return;
             }
+
+            meshlet_culler.begin(proj * m_view, model_light.position());
+            for (uint32_t idx: visible)
+            {
+                shader_depth.set_uniform({{"object_id", (int) idx}});
+                meshlet_culler.draw(scene.mesh(idx), scene.matrices()[idx]);
+            }
+            shadow_draw_calls += visible.size();
+            face_meshlet_stats[face++] = meshlet_culler.stats();
         };
 
         /// 绘制某个面时，需要将摄像机的 up 和 front 调整为如下值
@@ -137,10 +231,14 @@ protected:
                  CameraDirDrawCube::pos_y.up);
         draw_dir(GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, CameraDirDrawCube::neg_y.front,
                  CameraDirDrawCube::neg_y.up);
+
+        shadow_submit_ms =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin)
+                        .count();
     }
 
 
-    void color_pass(const std::vector<RTObject> &scene)
+    void color_pass(const Scene &scene)
     {
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -148,27 +246,29 @@ protected:
 
         // phong with shadow mapping
         glBindTexture_(GL_TEXTURE_CUBE_MAP, 0, cube_shadow_map);
-        shader_shadow.set_uniform({
-                {"m_view", camera.view_matrix()},
-                {"m_proj", camera.proj_matrix()},
-                {"camera_pos", camera.get_pos()},
-                {"light_pos", model_light.position()},
-                {"shadow_map_cube", 0},
-        });
-
-        for (auto &m: scene)
-        {
-            if (m.mesh.mat.has_tex_basecolor())
-                glBindTexture_(GL_TEXTURE_2D, 1, m.mesh.mat.metallic_roughness.tex_base_color);
-            shader_shadow.set_uniform({
-                    {"m_model", m.matrix()},
-                    {"kd", glm::vec3(m.mesh.mat.metallic_roughness.base_color)},
+        for (Shader2 *shader: {&shader_shadow, &shader_shadow_tex})
+            shader->set_uniform({
+                    {"m_view", camera.view_matrix()},
+                    {"m_proj", camera.proj_matrix()},
+                    {"camera_pos", camera.get_pos()},
+                    {"light_pos", model_light.position()},
+                    {"shadow_map_cube", 0},
                     {"ks", glm::vec3(0.5f)},
-                    {"has_diffuse", m.mesh.mat.has_tex_basecolor()},
-                    {"tex_diffuse", 1},
+                    {"object_data", OBJECT_DATA_UNIT},
             });
-            m.mesh.draw();
+        shader_shadow_tex.set_uniform({{"tex_diffuse", 1}});
+
+        meshlet_culler.begin(camera.proj_matrix() * camera.view_matrix(), camera.get_pos());
+        for (uint32_t idx: camera_visible)
+        {
+            const Material &mat    = scene.material(idx);
+            Shader2        &shader = mat.has_tex_basecolor() ? shader_shadow_tex : shader_shadow;
+            if (mat.has_tex_basecolor())
+                glBindTexture_(GL_TEXTURE_2D, 1, mat.metallic_roughness.tex_base_color);
+            shader.set_uniform({{"object_id", (int) idx}});
+            meshlet_culler.draw(scene.mesh(idx), scene.matrices()[idx]);
         }
+        camera_meshlet_stats = meshlet_culler.stats();
 
         // light visualization
         shader_diffuse.update_per_fame(camera.view_matrix());
@@ -187,6 +287,46 @@ protected:
 
         ImGui::SliderInt("scene switcher", &scene_switcher, 0, SCENE_MAX_CNT - 1);
 
+        /// 剔除的统计信息
+        {
+            const char *face_names[] = {"+x", "-x", "+z", "-z", "+y", "-y"};
+            for (int i = 0; i < 6; ++i)
+                ImGui::Text("shadow %s: visible %zu, culled %zu", face_names[i],
+                            face_stats[i].visible, face_stats[i].culled);
+            ImGui::Text("camera: visible %zu, culled %zu", camera_stats.visible,
+                        camera_stats.culled);
+
+            ImGui::Checkbox("occlusion culling", &enable_occlusion);
+            ImGui::Text("occlusion: visible %zu, culled %zu", occlusion_stats.visible,
+                        occlusion_stats.culled);
+            ImGui::Text("object data upload: %zu bytes, %zu ranges", upload_bytes,
+                        object_data.last_upload_ranges());
+
+            ImGui::Checkbox("meshlet backface culling", &meshlet_culler.backface_culling);
+            auto meshlet_text = [](const char *pass, const MeshletCuller::Stats &stats) {
+                ImGui::Text("%s: triangles %zu / %zu, meshlets %zu / %zu", pass,
+                            stats.triangles_visible, stats.triangles_total,
+                            stats.meshlets_visible, stats.meshlets_total);
+            };
+            MeshletCuller::Stats shadow_meshlet_stats;
+            for (const auto &stats: face_meshlet_stats)
+            {
+                shadow_meshlet_stats.meshlets_total += stats.meshlets_total;
+                shadow_meshlet_stats.meshlets_visible += stats.meshlets_visible;
+                shadow_meshlet_stats.triangles_total += stats.triangles_total;
+                shadow_meshlet_stats.triangles_visible += stats.triangles_visible;
+            }
+            meshlet_text("meshlet shadow", shadow_meshlet_stats);
+            meshlet_text("meshlet camera", camera_meshlet_stats);
+
+            /// 不支持间接绘制时不能勾选
+            if (!IndirectDrawBuffer::supported())
+                enable_indirect = false;
+            ImGui::Checkbox("indirect draw (shadow)", &enable_indirect);
+            ImGui::Text("shadow submit: %zu draw calls, %.3f ms", shadow_draw_calls,
+                        shadow_submit_ms);
+        }
+
         {
             glm::vec3 light_pos = model_light.position();
             ImGui::SliderFloat("light x", &light_pos.x, -10, 10);
@@ -199,8 +339,9 @@ protected:
     }
 };
 
-int main()
+int main(int argc, char **argv)
 {
+    Engine::parse_args(argc, argv);
     auto engine = EngineTest();
     engine.engine_main();
 }
\ No newline at end of file
@@ -3,12 +3,13 @@
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoord;
+flat in vec3 ObjectKd;
 
 out vec4 FragColor;
 
-uniform bool has_diffuse;
+#ifdef HAS_TEX_BASECOLOR
 uniform sampler2D tex_diffuse;
-uniform vec3 kd;
+#endif
 uniform vec3 ks;
 uniform vec3 camera_pos;
 uniform vec3 light_pos;
@@ -19,7 +20,11 @@ const float light_indensity = 2.0f;
 vec3 shading()
 {
     // color from texture, gamma correct
-    vec3 color = has_diffuse ? pow(texture(tex_diffuse, TexCoord).rgb, vec3(2.2)) : kd;
+#ifdef HAS_TEX_BASECOLOR
+    vec3 color = pow(texture(tex_diffuse, TexCoord).rgb, vec3(2.2));
+#else
+    vec3 color = ObjectKd;
+#endif
 
     // ambient
     vec3 ambient = 0.15 * color;
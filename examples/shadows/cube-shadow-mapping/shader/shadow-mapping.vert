@@ -7,16 +7,20 @@ layout (location = 2) in vec2 aTexCoord;
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
+flat out vec3 ObjectKd;
+
+#include "object-data.glsl"
 
-uniform mat4 m_model;
 uniform mat4 m_view;
 uniform mat4 m_proj;
 
 
 void main() {
+    mat4 m_model = object_model();
     gl_Position = m_proj * m_view * m_model * vec4(aPos, 1.0f);
 
     FragPos = vec3(m_model * vec4(aPos, 1.0f));
     Normal = transpose(inverse(mat3(m_model))) * aNormal;
     TexCoord = aTexCoord;
+    ObjectKd = object_base_color().rgb;
 }
\ No newline at end of file
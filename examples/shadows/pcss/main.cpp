@@ -1,6 +1,6 @@
 /**
  * 首先生成 2D 的 shadow map，然后绘制软/硬阴影
- * 手动在 pcss.frag 里面去更改阴影类型：shadow-mapping，pcf，pcss
+ * 在 GUI 中选择阴影类型：shadow-mapping，pcf，pcss，每种类型对应 pcss.frag 的一个变体
  */
 
 
@@ -12,6 +12,9 @@
 #include "core/mesh.h"
 #include "core/misc.h"
 #include "core/texture.h"
+#include "core/shader-lib.h"
+#include "core/model-manager.h"
+#include "core/scene.h"
 
 #include "shader/tex2d-visual/tex-visual.h"
 #include "shader/diffuse/diffuse.h"
@@ -52,29 +55,50 @@ class TestEngine : public Engine
 {
     DepthFramebuffer buffer;
 
-    std::vector<RTObject> model_three_obj  = ImportObj::load_obj(MODEL_THREE_OBJS);
-    std::vector<RTObject> model_matrix     = ImportObj::load_obj(MODEL_SPHERE_MATRIX);
-    std::vector<RTObject> model_202        = ImportObj::load_obj(MODEL_202_CHAN);
-    std::vector<RTObject> model_diona      = ImportObj::load_obj(MODEL_DIONA);
-    RTObject              model_cube       = ImportObj::load_obj(MODEL_CUBE)[0];
-    RTObject              model_light      = ImportObj::load_obj(MODEL_LIGHT)[0];
-    RTObject              model_floor      = ImportObj::load_obj(MODLE_FLOOR)[0];
-    RTObject              model_gray_floor = ImportObj::load_obj(MODEL_GRAY_FLOOR)[0];
-    RTObject              model_square     = ImportObj::load_obj(MODEL_SQUARE)[0];
+    std::vector<RTObject> model_three_obj  = ModelManager::load(MODEL_THREE_OBJS);
+    std::vector<RTObject> model_matrix     = ModelManager::load(MODEL_SPHERE_MATRIX);
+    std::vector<RTObject> model_202        = ModelManager::load(MODEL_202_CHAN);
+    std::vector<RTObject> model_diona      = ModelManager::load(MODEL_DIONA);
+    RTObject              model_cube       = ModelManager::load(MODEL_CUBE)[0];
+    RTObject              model_light      = ModelManager::load(MODEL_LIGHT)[0];
+    RTObject              model_floor      = ModelManager::load(MODLE_FLOOR)[0];
+    RTObject              model_gray_floor = ModelManager::load(MODEL_GRAY_FLOOR)[0];
+    RTObject              model_square     = ModelManager::load(MODEL_SQUARE)[0];
 
     Shader2          shader_depth = {EXAMPLE_CUR_PATH + "shader/depth.vert",
                                      EXAMPLE_CUR_PATH + "shader/depth.frag"};
-    Shader2          shader_pcss  = {EXAMPLE_CUR_PATH + "shader/pcss.vert",
-                                     EXAMPLE_CUR_PATH + "shader/pcss.frag"};
     ShaderDiffuse    shader_lambert;
     ShaderBlinnPhong shader_phong;
     ShaderTexVisual  shader_texvisual;
 
-    int                   scene_switcher = 0;
-    std::vector<RTObject> scene;
+    int                scene_switcher = 0;
+    std::vector<Scene> scenes         = std::vector<Scene>(4);
+
+    int shadow_type = 1;    // 0: shadow mapping, 1: pcf, 2: pcss
+
+    /// pcss.frag 的变体：每种阴影类型一组，组内按材质是否有 basecolor 纹理区分
+    std::array<ShaderVariants, 3> pcss_variants = {
+            pcss_variant(0),
+            pcss_variant(1),
+            pcss_variant(2),
+    };
+
+    static ShaderVariants pcss_variant(int type)
+    {
+        return {EXAMPLE_CUR_PATH + "shader/pcss.vert", EXAMPLE_CUR_PATH + "shader/pcss.frag",
+                MAT_TEX_BASECOLOR, {{"SHADOW_TYPE", std::to_string(type)}}};
+    }
+
+    /**
+     * 根据阴影类型和材质，获取 pcss.frag 的变体
+     */
+    Shader2 &shader_pcss(MaterialFeatures features)
+    {
+        return pcss_variants[shadow_type].get(features);
+    }
 
     struct {
-        RTObject                model          = ImportObj::load_obj(MODEL_LIGHT)[0];
+        RTObject                model          = ModelManager::load(MODEL_LIGHT)[0];
         glm::vec3               shadow_map_dir = {1, 2, 3};
         [[nodiscard]] glm::mat4 get_view() const
         {
@@ -90,10 +114,20 @@ class TestEngine : public Engine
         shader_lambert.init(camera.proj_matrix());
         light.model.set_pos({-5.8, 5.8, 3.5});
         shader_phong.init(camera.proj_matrix());
+
+        /// 场景只在这里构建一次，切换场景不会复制任何数据
+        scenes[0].add(model_diona);
+        scenes[0].add(model_floor);
+        scenes[1].add(model_matrix);
+        scenes[2].add(model_three_obj);
+        scenes[3].add(model_202);
+        scenes[3].add(model_gray_floor);
     }
 
     void tick_pre_render() override
     {
+        PROFILE_SCOPE("shadow pass");
+
         glBindFramebuffer(GL_FRAMEBUFFER, buffer.frame_buffer);
         glViewport(0, 0, buffer.size, buffer.size);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -102,24 +136,11 @@ class TestEngine : public Engine
                 {"m_view", light.get_view()},
                 {"m_proj", light.proj},
         });
-        switch (scene_switcher)
-        {
-            case 0:
-                scene = model_diona;
-                scene.push_back(model_floor);
-                break;
-            case 1: scene = model_matrix; break;
-            case 2: scene = model_three_obj; break;
-            case 3:
-                scene = model_202;
-                scene.push_back(model_gray_floor);
-                break;
-            default: scene = {};
-        }
-        for (const auto &m: scene)
+        const SceneView scene = scenes[scene_switcher].view();
+        for (size_t i = 0; i < scene.size(); ++i)
         {
-            shader_depth.set_uniform({{"m_model", m.matrix()}});
-            m.mesh.draw();
+            shader_depth.set_uniform({{"m_model", scene.matrices[i]}});
+            scene.mesh(i).draw();
         }
 
         glBindTexture(GL_TEXTURE_2D, buffer.shadow_map);
@@ -128,34 +149,52 @@ class TestEngine : public Engine
 
     void tick_render() override
     {
+        PROFILE_SCOPE("color pass");
+
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
         glViewport(0, 0, Window::framebuffer_width(), Window::framebuffer_width());
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        shader_pcss.set_uniform({
-                {"m_view", camera.view_matrix()},
-                {"m_proj", camera.proj_matrix()},
-                {"light_vp", light.proj * light.get_view()},
-                {"light_pos", light.model.position()},
-                {"camera_pos", camera.get_pos()},
-                {"rand_seed", glm::vec3(std::rand(), std::rand(), 0)},
-        });
+        /// 有纹理和没有纹理的材质使用不同的变体，两个变体都需要设置
+        /// 累积时使用分布均匀的序列，否则每帧随机
+        const glm::vec3 rand_seed =
+                accum_sample() >= 0 ? sample_seed() : glm::vec3(std::rand(), std::rand(), 0);
+        for (MaterialFeatures features: {0u, (MaterialFeatures) MAT_TEX_BASECOLOR})
+        {
+            FrameVector<UniformAttribute2> frame_uniforms(&FrameArena::local());
+            frame_uniforms.assign({
+                    {"m_view", camera.view_matrix()},
+                    {"m_proj", camera.proj_matrix()},
+                    {"light_vp", light.proj * light.get_view()},
+                    {"light_pos", light.model.position()},
+                    {"camera_pos", camera.get_pos()},
+                    {"ks", glm::vec3(0.3f)},
+                    {"shadow_map", 0},
+            });
+            /// 只有 pcss 需要随机数
+            if (shadow_type == 2)
+                frame_uniforms.emplace_back("rand_seed", rand_seed);
+            if (features & MAT_TEX_BASECOLOR)
+                frame_uniforms.emplace_back("tex_diffuse", 1);
+            shader_pcss(features).set_uniform(frame_uniforms);
+        }
 
         glBindTexture_(GL_TEXTURE_2D, 0, buffer.shadow_map);
-        for (const auto &m: scene)
+        const SceneView scene = scenes[scene_switcher].view();
+        for (size_t i = 0; i < scene.size(); ++i)
         {
-            const Material &mat = m.mesh.mat;
+            const Material &mat    = scene.material(i);
+            Shader2        &shader = shader_pcss(mat.features);
             if (mat.has_tex_basecolor())
+            {
                 glBindTexture_(GL_TEXTURE_2D, 1, mat.metallic_roughness.tex_base_color);
-            shader_pcss.set_uniform({
-                    {"kd", glm::vec3(mat.metallic_roughness.base_color)},
-                    {"ks", glm::vec3(0.3f)},
-                    {"has_diffuse", mat.has_tex_basecolor()},
-                    {"tex_diffuse", 1},
-                    {"shadow_map", 0},
-                    {"m_model", m.matrix()},
-            });
-            m.mesh.draw();
+                shader.set_uniform({{"m_model", scene.matrices[i]}});
+            } else
+                shader.set_uniform({
+                        {"kd", glm::vec3(mat.metallic_roughness.base_color)},
+                        {"m_model", scene.matrices[i]},
+                });
+            scene.mesh(i).draw();
         }
 
         shader_lambert.update_per_fame(camera.view_matrix());
@@ -182,13 +221,19 @@ class TestEngine : public Engine
             light.model.set_pos(pos);
         }
         ImGui::SliderInt("scene switcher", &scene_switcher, 0, 3);
+        ImGui::Text("shadow type:");
+        ImGui::RadioButton("shadow mapping", &shadow_type, 0);
+        ImGui::RadioButton("pcf", &shadow_type, 1);
+        ImGui::RadioButton("pcss", &shadow_type, 2);
+        ImGui::Text("shader variants: %zu", ShaderLib::variant_cnt());
         ImGui::End();
     }
 };
 
 
-int main()
+int main(int argc, char **argv)
 {
+    Engine::parse_args(argc, argv);
     auto engine = TestEngine();
     engine.engine_main();
 }
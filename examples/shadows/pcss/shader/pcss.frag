@@ -10,12 +10,21 @@ out vec4 FragColor;
 uniform sampler2D shadow_map;
 uniform vec3 light_pos;
 uniform vec3 camera_pos;
-uniform vec3 kd;
 uniform vec3 ks;
-uniform bool has_diffuse;
-uniform sampler2D tex_diffuse;
 uniform vec3 rand_seed;
 
+/// 材质是否有 diffuse 纹理，通过宏定义 HAS_TEX_BASECOLOR 选择
+#ifdef HAS_TEX_BASECOLOR
+uniform sampler2D tex_diffuse;
+#else
+uniform vec3 kd;
+#endif
+
+/// 阴影的类型，通过宏定义选择：0 - shadow mapping，1 - pcf，2 - pcss
+#ifndef SHADOW_TYPE
+#define SHADOW_TYPE 1
+#endif
+
 const float BIAS_BASE = 0.1f;
 const float BIAS_MIN = 0.1f;
 const float light_indensity = 2.0f;
@@ -32,7 +41,7 @@ vec2 poisson_disk[NUM_SAMPLES];
 
 /**
  1. 可以选择通过 gen_possion_disk 来动态生成泊松圆盘，也可以直接使用静态的泊松圆盘
- 2. 可以选择三种阴影方式：shadow mapping, pcf, pcss
+ 2. 可以选择三种阴影方式：shadow mapping, pcf, pcss，通过宏定义 SHADOW_TYPE 选择
  3. 可以手动调节 bias 相关的参数
  参考：https://developer.download.nvidia.cn/whitepapers/2008/PCSS_Integration.pdf
  */
@@ -85,7 +94,11 @@ vec3 g_diffuse;
 vec3 g_specular;
 void phong_shading()
 {
-    vec3 color = has_diffuse ? pow(texture(tex_diffuse, TexCoord).rgb, vec3(2.2)) : kd;
+#ifdef HAS_TEX_BASECOLOR
+    vec3 color = pow(texture(tex_diffuse, TexCoord).rgb, vec3(2.2));
+#else
+    vec3 color = kd;
+#endif
 
     // ambient
     g_ambient = 0.20 * color;
@@ -155,9 +168,6 @@ float visibility_pcss(float frag_depth, vec2 frag_uv, float bias)
 
 void main()
 {
-    // generate poisson disk
-    gen_poisson_disk(rand_seed.xy);
-
     float frag_depth = frag_clip_light_coord.w;
     vec2 frag_uv = frag_clip_light_coord.xy / frag_clip_light_coord.w * 0.5 + 0.5;
 
@@ -167,5 +177,14 @@ void main()
     phong_shading();
 
     // three implement: visibility_pcss, visibility_shadow_mapping, visibility_pcf
-    FragColor = vec4(pow((g_diffuse + g_specular) * visibility_pcf(frag_depth, frag_uv, bias) + g_ambient, vec3(1.0/2.2)), 1.0);
+#if SHADOW_TYPE == 0
+    float visibility = visibility_shadow_mapping(frag_depth, frag_uv, bias);
+#elif SHADOW_TYPE == 1
+    float visibility = visibility_pcf(frag_depth, frag_uv, bias);
+#else
+    // generate poisson disk, only pcss needs it
+    gen_poisson_disk(rand_seed.xy);
+    float visibility = visibility_pcss(frag_depth, frag_uv, bias);
+#endif
+    FragColor = vec4(pow((g_diffuse + g_specular) * visibility + g_ambient, vec3(1.0/2.2)), 1.0);
 }
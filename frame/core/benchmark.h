@@ -0,0 +1,144 @@
+/**
+ * 可复现的性能测试：录制每一帧的摄像机位姿和输入，之后按照同样的路径回放固定的帧数，
+ * 统计帧时间的分布、绘制调用的数量以及内存峰值，输出为 JSON 报告
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "./camera.h"
+
+
+/**
+ * 一帧的摄像机位姿，以及这一帧的输入
+ */
+struct CameraFrame {
+    glm::vec3 pos;
+    float     yaw;      // 角度
+    float     pitch;    // 角度
+
+    uint32_t  keys;        // 第 i 位表示 CameraPath::KEYS[i] 是否按下
+    bool      rotating;    // 鼠标右键是否按下
+    glm::vec2 cursor;
+};
+
+
+/**
+ * @brief 摄像机路径，每帧一个 CameraFrame
+ * 回放时直接设置位姿，而不是重新模拟输入，因此和帧率、输入设备都无关
+ */
+struct CameraPath {
+    /// 录制的按键
+    static constexpr int KEYS[] = {GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A,
+                                   GLFW_KEY_D, GLFW_KEY_Q, GLFW_KEY_E};
+
+    std::vector<CameraFrame> frames;
+
+    /**
+     * 记录摄像机当前的位姿以及当前的输入
+     */
+    void record(const Camera2 &camera);
+
+    /**
+     * 第 frame 帧的位姿，超出范围时从头循环
+     */
+    [[nodiscard]] const CameraFrame &at(size_t frame) const
+    {
+        return frames[frame % frames.size()];
+    }
+
+    void save(const std::string &path) const;
+
+    /**
+     * 读取之前保存的路径，文件不存在或者格式错误时抛出异常
+     */
+    static CameraPath load(const std::string &path);
+};
+
+
+/**
+ * @brief 统计绘制调用的数量
+ * install 之后，glad 中的绘制函数会被替换为先计数、再调用原来的函数，和 headless 模式替换
+ * glBindFramebuffer 的方式相同；glMultiDraw* 的每一项算作一次绘制，顶点数是各项之和；
+ * 间接绘制只统计调用和命令的数量，不统计顶点数量
+ */
+struct DrawCounter {
+    struct Counts {
+        size_t calls;       // 绘制函数的调用次数
+        size_t draws;       // 绘制的数量，一次 multi draw 可能包含多个
+        size_t vertices;    // 顶点（索引）数量乘以实例数量
+    };
+
+    /**
+     * 替换 glad 中的绘制函数，需要在 glad 初始化之后调用，重复调用没有影响
+     */
+    static void install();
+
+    [[nodiscard]] static const Counts &counts() { return _counts; }
+
+    static void reset() { _counts = {}; }
+
+private:
+    friend struct DrawCounterHooks;
+
+    static inline bool   _installed = false;
+    static inline Counts _counts{};
+};
+
+
+/**
+ * @brief 回放摄像机路径并统计每一帧
+ * 前 warmup 帧停留在路径的第一帧，不计入统计，用于完成着色器编译、纹理上传等一次性的工作；
+ * 之后回放 frames 帧，frames 为 0 时回放整条路径
+ */
+class Benchmark
+{
+public:
+    Benchmark(CameraPath path, int warmup, int frames);
+
+    /**
+     * 总共需要运行的帧数，包括 warmup
+     */
+    [[nodiscard]] int total_frames() const { return _warmup + _frames; }
+
+    /**
+     * 每帧开始时调用：结束上一帧的统计，并把摄像机设置到这一帧的位姿
+     */
+    void tick(Camera2 &camera);
+
+    /**
+     * 最后一帧结束之后调用，结束最后一帧的统计
+     */
+    void finish();
+
+    /**
+     * 输出 JSON 报告：帧时间的分布、绘制调用、内存峰值、Profiler 中每个 scope 的统计，
+     * 以及每一帧的原始数据
+     */
+    bool write_report(const std::string &path, const std::string &camera_path) const;
+
+private:
+    CameraPath _path;
+    int        _warmup;
+    int        _frames;
+
+    int    _frame = -1;    // 当前帧的序号，从 0 开始，包括 warmup
+    double _frame_begin{};
+
+    /// 每个统计帧的数据
+    std::vector<double>              _frame_ms;
+    std::vector<DrawCounter::Counts> _draw_counts;
+
+    void end_frame();
+};
+
+
+/**
+ * 进程的内存峰值（resident set size），单位是 MB，不支持的平台返回 0
+ */
+double peak_memory_mb();
@@ -0,0 +1,74 @@
+/**
+ * 包围体：AABB 和包围球
+ */
+#pragma once
+
+#include <cfloat>
+
+#include <glm/glm.hpp>
+
+
+/**
+ * 轴对齐包围盒
+ */
+struct AABB {
+    glm::vec3 min{FLT_MAX};
+    glm::vec3 max{-FLT_MAX};
+
+    /**
+     * 是否包含至少一个点
+     */
+    [[nodiscard]] bool valid() const { return min.x <= max.x; }
+
+    [[nodiscard]] glm::vec3 center() const { return (min + max) * 0.5f; }
+
+    /// 半边长
+    [[nodiscard]] glm::vec3 extent() const { return (max - min) * 0.5f; }
+
+    void expand(const glm::vec3 &p)
+    {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+
+    void expand(const AABB &other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    /// 表面积，用于 SAH
+    [[nodiscard]] float surface_area() const
+    {
+        if (!valid())
+            return 0.f;
+        const glm::vec3 d = max - min;
+        return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    /**
+     * 经过仿射变换后的包围盒，仍然是轴对齐的（会变大）
+     */
+    [[nodiscard]] AABB transform(const glm::mat4 &matrix) const;
+};
+
+
+/**
+ * 包围球
+ */
+struct BoundingSphere {
+    glm::vec3 center{0.f};
+    float     radius{-1.f};    // 小于 0 表示无效
+
+    [[nodiscard]] bool valid() const { return radius >= 0.f; }
+
+    /**
+     * 从 AABB 得到包围球，球心是 AABB 的中心
+     */
+    static BoundingSphere from_aabb(const AABB &aabb);
+
+    /**
+     * 经过仿射变换后的包围球，半径按照最大的缩放系数放大
+     */
+    [[nodiscard]] BoundingSphere transform(const glm::mat4 &matrix) const;
+};
@@ -0,0 +1,268 @@
+/**
+ * CPU 上的 BVH，用于光线拾取、层次剔除、烘焙等空间查询\n
+ * 分为两层：SceneBVH 以物体的世界包围盒为图元，MeshBVH 以网格的三角形为图元
+ */
+#pragma once
+
+#include <atomic>
+#include <cfloat>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "./bounds.h"
+#include "./culling.h"
+#include "./rt-object.h"
+#include "./simd.h"
+
+
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 dir;
+    float     t_max = FLT_MAX;    // 只考虑 [0, t_max] 范围内的交点
+};
+
+
+/**
+ * 预先计算好的光线数据，用于 SIMD 的 slab test，第 4 个分量复制 x
+ */
+struct RaySIMD {
+    f32x4 origin;
+    f32x4 inv_dir;
+
+    explicit RaySIMD(const Ray &ray)
+    {
+        const float org[4] = {ray.origin.x, ray.origin.y, ray.origin.z, ray.origin.x};
+        const float inv[4] = {1.f / ray.dir.x, 1.f / ray.dir.y, 1.f / ray.dir.z, 1.f / ray.dir.x};
+        origin             = f32x4::load(org);
+        inv_dir            = f32x4::load(inv);
+    }
+};
+
+
+/**
+ * 扁平化的 BVH 节点，32 字节，两个兄弟节点在数组中相邻
+ */
+struct BVHNode {
+    glm::vec3 bb_min;
+    uint32_t  left_first;    // 内部节点：左孩子的下标，右孩子紧随其后；叶子节点：第一个图元的位置
+    glm::vec3 bb_max;
+    uint32_t  prim_cnt;      // 叶子节点中图元的数量，0 表示内部节点
+
+    [[nodiscard]] bool is_leaf() const { return prim_cnt > 0; }
+};
+static_assert(sizeof(BVHNode) == 32);
+
+
+/**
+ * @brief BVH 的通用部分，只依赖图元的包围盒，和图元的具体类型无关
+ * 使用 binned SAH 构建，图元数量较多的子树通过 JobSystem 并行构建
+ */
+class BVH
+{
+public:
+    struct BuildOptions {
+        uint32_t max_leaf_size      = 4;       // 图元不超过这个数量，且 SAH 认为不划分更好时成为叶子
+        uint32_t parallel_threshold = 4096;    // 图元数量超过这个值的子树才会并行构建
+        bool     parallel           = true;
+    };
+
+    /**
+     * 根据图元的包围盒构建 BVH
+     */
+    void build(const std::vector<AABB> &prim_bounds, const BuildOptions &options);
+    void build(const std::vector<AABB> &prim_bounds) { build(prim_bounds, BuildOptions{}); }
+
+    /**
+     * 图元移动之后，拓扑结构不变，自底向上更新节点的包围盒
+     * @param prim_bounds 图元新的包围盒，顺序和数量需要和 build 时一致
+     * @note 移动幅度很大时 BVH 的质量会下降，这时应该重新 build
+     */
+    void refit(const std::vector<AABB> &prim_bounds);
+
+    /**
+     * 由近到远遍历和光线相交的叶子节点
+     * @param leaf_func void(uint32_t prim_idx, Ray &ray)，和图元求交，可以通过缩短 ray.t_max 来剪枝
+     */
+    template<typename LeafFunc>
+    void traverse(Ray &ray, LeafFunc &&leaf_func) const;
+
+    /**
+     * 和视锥体相交的所有图元，写入 out（不会清空）
+     */
+    void query(const Frustum &frustum, std::vector<uint32_t> &out) const;
+
+    [[nodiscard]] const std::vector<BVHNode>  &nodes() const { return _nodes; }
+    [[nodiscard]] const std::vector<uint32_t> &prim_indices() const { return _prim_indices; }
+    [[nodiscard]] bool                          empty() const { return _nodes.empty(); }
+
+    /**
+     * 光线和节点包围盒的 slab test，使用 SIMD 同时计算三个轴
+     * @return 进入包围盒的距离，没有相交时返回 FLT_MAX
+     */
+    static float intersect_node(const BVHNode &node, const RaySIMD &ray, float t_max)
+    {
+        const f32x4 t1 = (f32x4::load3(&node.bb_min.x) - ray.origin) * ray.inv_dir;
+        const f32x4 t2 = (f32x4::load3(&node.bb_max.x) - ray.origin) * ray.inv_dir;
+
+        const float t_near = f32x4::min(t1, t2).hmax();
+        const float t_far  = f32x4::max(t1, t2).hmin();
+        if (t_far < t_near || t_far < 0.f || t_near > t_max)
+            return FLT_MAX;
+        return t_near;
+    }
+
+private:
+    static constexpr int MAX_DEPTH = 64;    // 也是遍历时栈的大小
+
+    std::vector<BVHNode>  _nodes;
+    std::vector<uint32_t> _prim_indices;    // 叶子节点引用的图元，按照叶子的顺序排列
+    std::atomic<uint32_t> _node_cnt{0};     // 已经使用的节点数量，并行构建时用于分配节点
+
+    /**
+     * 递归地划分节点，节点的图元范围是 [node.left_first, node.left_first + node.prim_cnt)
+     */
+    void subdivide(uint32_t node_idx, const std::vector<AABB> &prim_bounds,
+                   const std::vector<glm::vec3> &centroids, const BuildOptions &options,
+                   int depth);
+
+    /**
+     * 根据图元更新叶子节点的包围盒
+     */
+    void update_leaf_bounds(BVHNode &node, const std::vector<AABB> &prim_bounds) const;
+};
+
+
+template<typename LeafFunc>
+void BVH::traverse(Ray &ray, LeafFunc &&leaf_func) const
+{
+    if (_nodes.empty())
+        return;
+
+    const RaySIMD ray_simd(ray);
+
+    /// 栈中存放节点以及进入节点的距离，出栈时如果距离已经超过 t_max，就可以跳过
+    struct {
+        uint32_t node;
+        float    t;
+    } stack[MAX_DEPTH];
+    int sp = 0;
+
+    if (intersect_node(_nodes[0], ray_simd, ray.t_max) == FLT_MAX)
+        return;
+    uint32_t node_idx = 0;
+    while (true)
+    {
+        const BVHNode &node = _nodes[node_idx];
+        if (node.is_leaf())
+        {
+            for (uint32_t i = 0; i < node.prim_cnt; ++i)
+                leaf_func(_prim_indices[node.left_first + i], ray);
+        } else
+        {
+            /// 先访问更近的孩子
+            uint32_t near_idx = node.left_first, far_idx = node.left_first + 1;
+            float    t_near   = intersect_node(_nodes[near_idx], ray_simd, ray.t_max);
+            float    t_far    = intersect_node(_nodes[far_idx], ray_simd, ray.t_max);
+            if (t_near > t_far)
+            {
+                std::swap(near_idx, far_idx);
+                std::swap(t_near, t_far);
+            }
+            if (t_near != FLT_MAX)
+            {
+                if (t_far != FLT_MAX)
+                    stack[sp++] = {far_idx, t_far};
+                node_idx = near_idx;
+                continue;
+            }
+        }
+
+        /// 出栈
+        while (sp > 0 && stack[sp - 1].t > ray.t_max)
+            --sp;
+        if (sp == 0)
+            break;
+        node_idx = stack[--sp].node;
+    }
+}
+
+
+/**
+ * 三角形求交的结果
+ */
+struct TriangleHit {
+    uint32_t tri = UINT32_MAX;    // 三角形的序号，UINT32_MAX 表示没有相交
+    float    t   = FLT_MAX;
+    float    u   = 0.f;    // 重心坐标
+    float    v   = 0.f;
+
+    [[nodiscard]] bool hit() const { return tri != UINT32_MAX; }
+};
+
+
+/**
+ * 底层 BVH：以一个网格的三角形为图元，用于精确的光线求交
+ */
+class MeshBVH
+{
+public:
+    /**
+     * @param positions 模型空间的顶点位置
+     * @param indices 三角形的顶点索引，每 3 个一组
+     */
+    void build(std::vector<glm::vec3> positions, std::vector<uint32_t> indices,
+               const BVH::BuildOptions &options = {});
+
+    /**
+     * 求光线和网格最近的交点（Möller-Trumbore），相交时会缩短 ray.t_max
+     */
+    TriangleHit intersect(Ray &ray) const;
+
+    [[nodiscard]] const BVH &bvh() const { return _bvh; }
+    [[nodiscard]] size_t     triangle_cnt() const { return _indices.size() / 3; }
+
+private:
+    std::vector<glm::vec3> _positions;
+    std::vector<uint32_t>  _indices;
+    BVH                    _bvh;
+};
+
+
+/**
+ * 顶层 BVH：以物体的世界包围盒为图元
+ */
+class SceneBVH
+{
+public:
+    void build(const std::vector<RTObject> &objs);
+
+    /**
+     * 物体移动之后（例如 RTObjectBase::set_pos）更新包围盒，objs 需要和 build 时一致
+     */
+    void refit(const std::vector<RTObject> &objs);
+
+    /**
+     * 光线拾取：返回包围盒最先被光线击中的物体的下标，没有击中时返回 -1
+     * @param t 击中包围盒的距离
+     * @note 只和包围盒求交，需要精确的结果时，对候选物体再使用 MeshBVH
+     */
+    int pick(Ray ray, float *t = nullptr) const;
+
+    /**
+     * 层次化的视锥体剔除，返回可见物体的下标
+     */
+    void cull(const glm::mat4 &vp, std::vector<uint32_t> &visible) const;
+
+    [[nodiscard]] const BVH &bvh() const { return _bvh; }
+
+private:
+    std::vector<AABB>     _bounds;
+    std::vector<uint32_t> _prim_to_obj;    // BVH 中的图元对应的物体下标
+    std::vector<uint32_t> _unbounded;      // 没有包围盒的物体，不参与 BVH，剔除时总是可见
+    BVH                   _bvh;
+
+    void update_bounds(const std::vector<RTObject> &objs);
+};
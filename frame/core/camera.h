@@ -35,6 +35,12 @@ struct Camera2 {
      */
     [[nodiscard]] glm::mat4 proj_matrix() const { return _proj_matrix; }
 
+    /**
+     * 直接设置摄像机的位置和朝向，用于回放录制的摄像机路径
+     * @param yaw, pitch 角度
+     */
+    void set_pose(const glm::vec3 &pos, float yaw, float pitch);
+
     /**
      * 摄像机旋转：按下鼠标右键才能旋转摄像机
      */
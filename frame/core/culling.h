@@ -0,0 +1,139 @@
+/**
+ * 基于包围盒的视锥体剔除，可以用于任意的 view-projection 矩阵：
+ * 摄像机、方向光的正交投影、cube map 的各个面
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "./bounds.h"
+#include "./rt-object.h"
+
+
+/**
+ * 视锥体，由 6 个平面组成，平面的法线指向视锥体内部：
+ * dot(plane.xyz, p) + plane.w >= 0 表示 p 在平面的内侧
+ */
+struct Frustum {
+    std::array<glm::vec4, 6> planes;    // left, right, bottom, top, near, far
+
+    /**
+     * 从 view-projection 矩阵中提取视锥体的平面（Gribb-Hartmann 方法）
+     * @note 透视投影和正交投影都适用，平面没有归一化
+     */
+    static Frustum from_matrix(const glm::mat4 &vp);
+
+    [[nodiscard]] bool test_aabb(const AABB &aabb) const;
+    [[nodiscard]] bool test_sphere(const BoundingSphere &sphere) const;
+};
+
+
+/**
+ * 一次剔除的统计信息
+ */
+struct CullStats {
+    size_t visible = 0;
+    size_t culled  = 0;
+};
+
+
+/**
+ * @brief 一批物体的世界坐标系包围盒，以 SoA 的方式存放
+ * 剔除时每次用 SIMD 同时测试 4 个包围盒和一个平面；物体较多时分段交给 JobSystem 并行剔除
+ */
+class CullingBatch
+{
+public:
+    /**
+     * 使用物体当前的位姿，更新世界坐标系下的包围盒
+     * @note 没有包围盒的物体总是可见的
+     */
+    void update(const std::vector<RTObject> &objs);
+
+    /**
+     * 直接使用世界坐标系下的包围盒，例如 Scene::bounds()
+     */
+    void update(std::span<const AABB> world_bounds);
+
+    /**
+     * 和 view-projection 矩阵对应的视锥体求交
+     * @param visible 输出可见物体的下标（按照 update 时的顺序），会先被清空
+     */
+    CullStats cull(const glm::mat4 &vp, std::vector<uint32_t> &visible) const;
+
+    [[nodiscard]] size_t size() const { return _cnt; }
+
+private:
+    size_t _cnt = 0;
+
+    /// 包围盒的中心和半边长，长度补齐到 4 的倍数
+    std::vector<float> _center_x, _center_y, _center_z;
+    std::vector<float> _extent_x, _extent_y, _extent_z;
+
+    /// 设置物体的数量，清空所有包围盒
+    void resize(size_t cnt);
+
+    void set_bounds(size_t i, const AABB &aabb);
+
+    /**
+     * 剔除 [first, last) 中的物体，first 是 4 的倍数
+     * @param out 写入可见物体的下标，需要能容纳 last - first 个
+     * @return 可见物体的数量
+     */
+    size_t cull_range(const Frustum &frustum, size_t first, size_t last, uint32_t *out) const;
+};
+
+
+/**
+ * @brief meshlet 粒度的剔除和绘制，见 Mesh2::meshlets
+ * 每个视图（摄像机、光源的某个面）调用一次 begin()，然后对每个物体调用 draw()：
+ * 在模型空间中剔除视锥体之外以及背向视点的 meshlet，相邻的可见 meshlet 合并成一段，
+ * 最后用一次 glMultiDrawElements 绘制
+ */
+class MeshletCuller
+{
+public:
+    struct Stats {
+        size_t meshlets_total    = 0;
+        size_t meshlets_visible  = 0;
+        size_t triangles_total   = 0;    // 提交的物体的三角形数量
+        size_t triangles_visible = 0;    // 剔除之后实际绘制的三角形数量
+    };
+
+    /// 是否使用法线锥剔除背向视点的 meshlet，只对旋转、平移和均匀缩放的物体生效
+    bool backface_culling = true;
+
+    /**
+     * 开始一个视图，清空统计信息
+     * @param eye 视点在世界坐标系下的位置，只支持透视投影
+     */
+    void begin(const glm::mat4 &vp, const glm::vec3 &eye);
+
+    /**
+     * 剔除一个物体的 meshlet，结果用于之后的 draw，不需要 OpenGL 上下文
+     * @return 剔除之后的三角形数量
+     */
+    size_t cull(const Mesh2 &mesh, const glm::mat4 &model);
+
+    /**
+     * 剔除并绘制一个物体，调用之前需要设置好着色器
+     * @note 没有 meshlet 的网格整体绘制
+     */
+    void draw(const Mesh2 &mesh, const glm::mat4 &model);
+
+    [[nodiscard]] const Stats &stats() const { return _stats; }
+
+private:
+    glm::mat4 _vp{1.f};
+    glm::vec3 _eye{0.f};
+    Stats     _stats;
+
+    /// cull 的结果：每一段的索引数量以及在 EBO 中的字节偏移
+    std::vector<GLsizei>      _counts;
+    std::vector<const void *> _offsets;
+};
@@ -1,9 +1,83 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "./benchmark.h"
 #include "./camera.h"
 #include "./ext-init.h"
+#include "./frame-accumulator.h"
+#include "./frame-arena.h"
+#include "./frame-capture.h"
+#include "./job-system.h"
 #include "./shader.h"
+#include "./shader-lib.h"
+#include "./opengl-debug.h"
 #include "./opengl-misc.h"
+#include "./profiler.h"
+#include "./startup-trace.h"
+#include "./update-thread.h"
+
+
+/**
+ * 画面静止（摄像机、输入事件、场景都没有变化）时的处理方式
+ */
+enum class IdleMode {
+    off,           // 总是渲染
+    skip,          // 不再渲染和交换缓冲，等待输入事件，CPU 和 GPU 都空闲
+    accumulate,    // 每帧使用不同的随机数种子继续渲染并平均，累积 idle_samples 帧之后和 skip 相同
+};
+
+
+/**
+ * 运行方式，默认从环境变量读取，例如：RTR_HEADLESS=1 RTR_FRAMES=300 RTR_SIZE=1280x720，
+ * RTR_PROFILER=1，RTR_PROFILE_OUT=profile，RTR_RECORD=path.json，RTR_BENCH=path.json，
+ * RTR_BENCH_REPORT=report.json，RTR_WARMUP=30，RTR_STARTUP_TRACE=startup.json，RTR_GL_DEBUG=0，
+ * RTR_GL_SYNC=1，RTR_CAPTURE=frames/%05d.png，RTR_THREADED=1，RTR_JOBS=8，RTR_IDLE=accumulate，
+ * RTR_IDLE_SAMPLES=256\n
+ * 这样不需要修改任何项目的 main 函数，就能在没有显示器的机器上运行
+ */
+struct EngineOptions {
+    bool headless = false;    // 不创建窗口，通过 EGL 渲染到离屏 FBO
+    int  frames   = 0;        // 运行的帧数，到达后退出；0 表示不限制，headless 时为 100
+    int  width    = 0;        // framebuffer 的尺寸，0 表示使用 Window 的默认值
+    int  height   = 0;
+
+    bool        profiler = false;    // 启动时显示 Profiler 的统计
+    std::string profile_out;         // 退出时导出 Profiler 的结果：<profile_out>.json 和 .csv
+
+    std::string record_path;                           // 录制摄像机路径，退出时保存
+    std::string bench_path;                            // 回放摄像机路径，进行性能测试
+    std::string bench_report = "bench-report.json";    // 性能测试的报告
+    int         warmup       = 30;                     // 性能测试中不计入统计的帧数
+
+    std::string startup_trace;    // 第一帧结束后把启动过程导出为 Chrome trace
+
+#ifdef NDEBUG
+    bool gl_debug = false;    // 通过 KHR_debug 的回调函数报告 OpenGL 的错误，release 默认关闭
+#else
+    bool gl_debug = true;
+#endif
+    bool gl_sync = false;    // 同步的调试输出，日志中带有出错的位置
+
+    std::string capture;    // 捕获每一帧：文件名模板或者 |命令，见 FrameCapture
+
+    bool threaded = false;    // tick_update 在更新线程中执行，比渲染提前一帧
+    int  jobs     = 0;        // JobSystem 的线程数量，0 表示 CPU 的核心数
+
+    IdleMode idle         = IdleMode::off;    // 画面静止时的处理方式，性能测试时总是 off
+    int      idle_samples = 256;              // accumulate 时最多累积的帧数
+
+    static EngineOptions from_env();
+
+    /**
+     * 实际运行的帧数，0 表示不限制；性能测试时由 Benchmark 决定
+     */
+    [[nodiscard]] int frame_limit() const { return frames > 0 ? frames : (headless ? 100 : 0); }
+};
 
 
 class Engine
@@ -16,10 +90,54 @@ protected:
      */
     virtual void init() {}
 
+    /**
+     * 每帧的更新逻辑：位姿、剔除、生成渲染队列等，结果通过 TripleBuffer 发布给 tick_render\n
+     * threaded 时在更新线程中执行，和这一帧的 tick_pre_render、tick_render 同时进行，
+     * 因此不能调用 OpenGL，也不能修改渲染线程使用的数据；tick_gui 执行时更新线程是空闲的
+     * @param view_camera 这一帧摄像机的副本，不要使用 camera 成员
+     */
+    virtual void tick_update(const Camera2 &view_camera) {}
+
     virtual void tick_gui() {}
     virtual void tick_pre_render() {}
     virtual void tick_render() {}
 
+    /**
+     * 场景有输入事件和摄像机之外的变化（动画、代码修改的参数等），下一帧需要重新渲染；
+     * idle 不是 off 时，持续变化的项目需要每帧调用，在渲染线程中调用
+     */
+    void mark_changed() { _changed = true; }
+
+    /**
+     * 渐进累积中这一帧的序号，-1 表示没有在累积：idle 不是 accumulate，或者画面刚刚变化
+     */
+    [[nodiscard]] int accum_sample() const { return _accum_sample; }
+
+    /**
+     * 这一帧的随机数种子：累积时每帧不同，是 [0, 1) 中的 Halton 序列；
+     * 不在累积时以及累积的第一帧为 base，因此开始累积时画面不会跳变
+     */
+    [[nodiscard]] glm::vec3 sample_seed(const glm::vec3 &base = glm::vec3(0.5f)) const
+    {
+        if (_accum_sample <= 0)
+            return base;
+        const auto i = (uint32_t) _accum_sample;
+        return {FrameAccumulator::halton(i, 2), FrameAccumulator::halton(i, 3),
+                FrameAccumulator::halton(i, 5)};
+    }
+
+    /**
+     * 这一帧的亚像素抖动，单位是像素，范围是 [-0.5, 0.5)，累积时用于抗锯齿；
+     * 不在累积时以及累积的第一帧为 0
+     */
+    [[nodiscard]] glm::vec2 sample_jitter() const
+    {
+        if (_accum_sample <= 0)
+            return glm::vec2(0.f);
+        const auto i = (uint32_t) _accum_sample;
+        return {FrameAccumulator::halton(i, 2) - 0.5f, FrameAccumulator::halton(i, 3) - 0.5f};
+    }
+
 
 public:
     /**
@@ -27,55 +145,401 @@ public:
      */
     Engine()
     {
+        _startup_begin = std::chrono::steady_clock::now();
+        StartupTrace::begin();
         spdlog_init();
-        if (!Window::init())
+        JobSystem::init(_options.jobs);
         {
-            std::fprintf(stderr, "fail to init window.\n");
-            exit(0);
+            StartupScope scope("context");
+            if (_options.headless)
+                init_headless();
+            else
+            {
+                if (!Window::init())
+                {
+                    std::fprintf(stderr, "fail to init window.\n");
+                    exit(0);
+                }
+                if (_options.width > 0 && _options.height > 0)
+                    Window::set_framebuffer_size(_options.width, _options.height);
+                imgui_init(Window::window());
+                glad_init();
+            }
+            if (_options.gl_debug)
+                GLDebug::init(_options.gl_sync);
         }
-        imgui_init(Window::window());
-        glad_init();
+        if (!_options.bench_path.empty())
+            init_benchmark();
+        if (!_options.capture.empty())
+            init_capture();
+        if (_options.idle == IdleMode::accumulate)
+            _accumulator = std::make_unique<FrameAccumulator>();
     }
 
 
+    /**
+     * 从命令行参数修改运行方式，需要在创建 Engine 之前调用\n
+     * 支持 --headless、--frames N、--size WxH、--profiler、--profile-out PATH、
+     * --record PATH、--bench PATH、--bench-report PATH、--warmup N、--startup-trace PATH、
+     * --gl-debug、--no-gl-debug、--gl-sync、--capture OUTPUT、--threaded、--jobs N、
+     * --idle off|skip|accumulate、--idle-samples N
+     * @return 没有被识别的参数，由项目自己处理
+     */
+    static std::vector<std::string> parse_args(int argc, char **argv);
+
+    static const EngineOptions &options() { return _options; }
+
+
     void engine_main()
     {
         try
         {
-            init();
+            {
+                StartupScope scope("init");
+                init();
+            }
             glEnable(GL_DEPTH_TEST);
             glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-            while (!Window::should_close())
-                main_loop();
+            if (_options.threaded)
+                _update = std::make_unique<UpdateThread>(
+                        [this] { tick_update(_update_camera); });
+
+            /// 着色器在第一次使用时才完成链接，因此启动时间统计到第一帧结束
+            const int frame_limit = _benchmark ? _benchmark->total_frames()
+                                               : _options.frame_limit();
+            int       frame_cnt   = 0;
+            if (!Window::should_close())
+            {
+                {
+                    StartupScope scope("first frame");
+                    main_loop();
+                }
+                report_startup();
+                ++frame_cnt;
+            }
+            const auto loop_begin = std::chrono::steady_clock::now();
+            while (!Window::should_close() && (frame_limit == 0 || frame_cnt < frame_limit))
+            {
+                if (main_loop())
+                    ++frame_cnt;
+            }
+            _update.reset();
+            report_frames(frame_cnt - 1, loop_begin);
+            if (_benchmark)
+            {
+                _benchmark->finish();
+                _benchmark->write_report(_options.bench_report, _options.bench_path);
+            }
+            if (!_options.record_path.empty())
+                _recording.save(_options.record_path);
+            _capture.reset();
+            _accumulator.reset();
+            if (!_options.profile_out.empty())
+            {
+                Profiler::export_chrome_trace(_options.profile_out + ".json");
+                Profiler::export_csv(_options.profile_out + ".csv");
+            }
             Window::terminate();
         } catch (std::exception &e)
         {
+            /// 更新线程使用子类的成员，需要在子类析构之前退出
+            _update.reset();
             SPDLOG_ERROR("exception occurs, exit.");
         }
     }
 
 private:
-    void main_loop()
+    static inline EngineOptions _options = EngineOptions::from_env();
+
+    std::chrono::steady_clock::time_point _startup_begin;
+
+    /// 是否显示 Profiler 的统计，F3 切换
+    bool _show_profiler = _options.profiler;
+
+    /// 回放摄像机路径的性能测试，没有 --bench 时为空
+    std::unique_ptr<Benchmark> _benchmark;
+    CameraPath                 _recording;
+
+    /// 捕获每一帧，没有 --capture 时为空
+    std::unique_ptr<FrameCapture> _capture;
+
+    /// 更新线程，没有 --threaded 时为空，tick_update 在渲染线程中执行
+    std::unique_ptr<UpdateThread> _update;
+    Camera2                       _update_camera;    // 这一帧摄像机的副本，只复制位姿
+    bool                          _update_started = false;
+
+    /// 每帧分配内存的次数（见 AllocCounter），退出时报告，用来确认稳定运行之后不再访问堆
+    struct AllocStats {
+        uint64_t frame       = 0;    // main_loop 执行的次数
+        uint64_t render      = 0;    // 第一帧之后渲染线程累计的分配次数
+        uint64_t update      = 0;    // 第一帧之后更新线程累计的分配次数
+        uint64_t render_last = 0;    // 最后一次有分配的帧
+        uint64_t update_last = 0;
+    } _allocs;
+
+    /// 变化之后至少正常渲染这么多帧才认为静止，ImGui 的悬停等状态需要一帧才能更新
+    static constexpr uint32_t IDLE_SETTLE_FRAMES = 2;
+
+    /// 静止时等待输入事件的最长时间（秒）
+    static constexpr double IDLE_WAIT_SECONDS = 0.1;
+
+    /// 画面静止的检测，见 IdleMode
+    bool      _changed        = true;    // mark_changed，第一帧总是需要渲染
+    uint64_t  _last_event_cnt = 0;
+    glm::vec3 _last_camera_pos{0.f};
+    glm::vec2 _last_camera_euler{0.f};    // yaw, pitch
+    uint32_t  _static_frames = 0;         // 连续没有变化的帧数
+    int       _accum_sample  = -1;
+    bool      _idle          = false;    // 上一次主循环没有渲染
+
+    /// 渐进累积的历史，没有 --idle accumulate 时为空
+    std::unique_ptr<FrameAccumulator> _accumulator;
+
+    /**
+     * 创建 EGL 上下文和离屏 FBO，失败时直接退出
+     */
+    void init_headless()
+    {
+        const int width  = _options.width > 0 ? _options.width : Window::framebuffer_width();
+        const int height = _options.height > 0 ? _options.height : Window::framebuffer_height();
+        if (!Window::init_headless(width, height))
+        {
+            std::fprintf(stderr, "fail to init headless context.\n");
+            exit(1);
+        }
+        glad_init(Window::proc_loader());
+        Window::init_offscreen_framebuffer();
+        imgui_init_headless(width, height);
+    }
+
+    /**
+     * 读取摄像机路径，关闭垂直同步，开始统计绘制调用；路径读取失败时直接退出\n
+     * 性能测试需要每帧都渲染，因此关闭 idle
+     */
+    void init_benchmark()
+    {
+        try
+        {
+            _benchmark = std::make_unique<Benchmark>(CameraPath::load(_options.bench_path),
+                                                     _options.warmup, _options.frames);
+        } catch (std::exception &e)
+        {
+            std::fprintf(stderr, "fail to init benchmark.\n");
+            exit(1);
+        }
+        Window::set_vsync(false);
+        _options.idle = IdleMode::off;
+    }
+
+    /**
+     * 捕获时关闭垂直同步，配合 --bench 可以全速录制回放；输出格式错误时直接退出
+     */
+    void init_capture()
     {
-        // tick logic
-        Window::tick_window_event();
-
-        // tick camera
-        camera.tick_rotate();
-        camera.tick_move();
-
-        // tick gui
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-        tick_gui();
-        ImGui::Render();
-
-        // tick render
-        tick_pre_render();
-        tick_render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-        Window::swap_framebuffer();
+        try
+        {
+            _capture = std::make_unique<FrameCapture>(_options.capture);
+        } catch (std::exception &e)
+        {
+            std::fprintf(stderr, "fail to init frame capture.\n");
+            exit(1);
+        }
+        Window::set_vsync(false);
+    }
+
+    /**
+     * 打印启动耗时、创建的 program 数量，以及每个阶段、每个资源的耗时
+     */
+    void report_startup() const
+    {
+        auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                            _startup_begin)
+                          .count();
+        SPDLOG_INFO("startup: {:.1f} ms, shader programs: {} (shared: {}, variants: {})", ms,
+                    shader_program_cnt(), ShaderLib::program_cnt(), ShaderLib::variant_cnt());
+        StartupTrace::finish(ms, _options.startup_trace);
+    }
+
+    /**
+     * 打印第一帧之后的平均帧时间，以及第一帧之后分配内存的次数
+     */
+    void report_frames(int frame_cnt, std::chrono::steady_clock::time_point begin) const
+    {
+        if (frame_cnt <= 0)
+            return;
+        auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                            begin)
+                          .count();
+        SPDLOG_INFO("frames: {}, {:.3f} ms/frame", frame_cnt, ms / frame_cnt);
+        if (!AllocCounter::ENABLED)
+        {
+            SPDLOG_INFO("heap allocation counting is off, configure with -DFRAME_COUNT_ALLOCS=ON");
+            return;
+        }
+        SPDLOG_INFO("heap allocations after the first frame: render thread {} (last in frame {}), "
+                    "update thread {} (last in frame {}), frame arena peak {} bytes",
+                    _allocs.render, _allocs.render_last, _allocs.update, _allocs.update_last,
+                    FrameArena::local().peak());
+    }
+
+    /**
+     * 累计这一帧渲染线程和更新线程分配内存的次数，第一帧不计入
+     */
+    void count_allocs(uint64_t render, uint64_t update)
+    {
+        if (++_allocs.frame == 1)
+            return;
+        _allocs.render += render;
+        _allocs.update += update;
+        if (render > 0)
+            _allocs.render_last = _allocs.frame;
+        if (update > 0)
+            _allocs.update_last = _allocs.frame;
+    }
+
+    /**
+     * 检测画面是否静止，更新渐进累积的序号
+     * @return 这一帧是否不需要渲染；headless 模式没有可以等待的事件，总是渲染
+     */
+    bool tick_idle()
+    {
+        if (_options.idle == IdleMode::off)
+            return false;
+
+        const glm::vec3 camera_pos   = camera.get_pos();
+        const glm::vec2 camera_euler = {camera.get_euler().yaw, camera.get_euler().pitch};
+        const bool      changed      = std::exchange(_changed, false) ||
+                                       Window::event_cnt() != _last_event_cnt ||
+                                       camera_pos != _last_camera_pos ||
+                                       camera_euler != _last_camera_euler;
+        _last_event_cnt    = Window::event_cnt();
+        _last_camera_pos   = camera_pos;
+        _last_camera_euler = camera_euler;
+        _static_frames     = changed ? 0 : _static_frames + 1;
+
+        const bool settled = _static_frames >= IDLE_SETTLE_FRAMES;
+        _accum_sample      = _options.idle == IdleMode::accumulate && settled
+                                     ? (int) (_static_frames - IDLE_SETTLE_FRAMES)
+                                     : -1;
+        const bool done    = _options.idle == IdleMode::skip
+                                     ? settled
+                                     : _accum_sample >= _options.idle_samples;
+        _idle              = done && !Window::headless();
+        return _idle;
+    }
+
+    /**
+     * 一次主循环；画面静止时只处理输入事件，不渲染
+     * @return 是否渲染了一帧
+     */
+    bool main_loop()
+    {
+        const uint64_t alloc_begin  = AllocCounter::count();
+        uint64_t       update_alloc = 0;
+
+        // tick logic，上一次已经静止时等待输入事件，而不是立即返回
+        Window::tick_window_event(_idle ? IDLE_WAIT_SECONDS : 0.0);
+        JobSystem::run_main_jobs();
+        if (Window::key_has_action(GLFW_KEY_F3, GLFW_PRESS))
+            _show_profiler = !_show_profiler;
+        if (Window::key_has_action(GLFW_KEY_F4, GLFW_PRESS))
+            GLDebug::set_synchronous(!GLDebug::synchronous());
+
+        // tick camera，性能测试时由 Benchmark 设置位姿
+        if (_benchmark)
+            _benchmark->tick(camera);
+        else
+        {
+            camera.tick_rotate();
+            camera.tick_move();
+        }
+        if (tick_idle())
+        {
+            FrameArena::local().reset();
+            return false;
+        }
+        if (!_options.record_path.empty())
+            _recording.record(camera);
+
+        Profiler::begin_frame();
+        {
+            PROFILE_SCOPE("frame");
+
+            // 上一帧的更新完成之后才能修改更新线程使用的数据
+            if (_update)
+            {
+                PROFILE_CPU_SCOPE("update wait");
+                _update->wait();
+                update_alloc = _update->last_alloc_cnt();
+            }
+
+            // tick gui
+            {
+                PROFILE_CPU_SCOPE("gui");
+                ImGui_ImplOpenGL3_NewFrame();
+                if (Window::headless())
+                    imgui_headless_new_frame(Window::framebuffer_width(),
+                                             Window::framebuffer_height());
+                else
+                    ImGui_ImplGlfw_NewFrame();
+                ImGui::NewFrame();
+                tick_gui();
+                if (_show_profiler)
+                    Profiler::draw_gui();
+                ImGui::Render();
+            }
+
+            // tick update，threaded 时和下面的渲染同时进行；第一帧还没有可以渲染的结果，需要等待
+            _update_camera.set_pose(camera.get_pos(), camera.get_euler().yaw,
+                                    camera.get_euler().pitch);
+            if (_update)
+            {
+                _update->kick();
+                if (!std::exchange(_update_started, true))
+                    _update->wait();
+            } else
+            {
+                PROFILE_CPU_SCOPE("update");
+                tick_update(_update_camera);
+            }
+
+            // tick render；累积已经收敛时（只有 headless 会执行到这里）直接显示历史
+            if (_accum_sample >= _options.idle_samples)
+                _accumulator->present();
+            else
+            {
+                {
+                    PROFILE_SCOPE("pre render");
+                    tick_pre_render();
+                }
+                {
+                    PROFILE_SCOPE("render");
+                    tick_render();
+                }
+                if (_accum_sample >= 0)
+                {
+                    PROFILE_SCOPE("accumulate");
+                    _accumulator->accumulate((uint32_t) _accum_sample);
+                }
+            }
+            {
+                PROFILE_SCOPE("imgui");
+                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            }
+            if (_capture)
+            {
+                _capture->poll();
+                _capture->capture();
+            }
+
+            PROFILE_CPU_SCOPE("swap");
+            Window::swap_framebuffer();
+        }
+        Profiler::end_frame();
+
+        /// 渲染线程的帧内存在这一帧结束时释放，更新线程的在每次更新之后释放
+        FrameArena::local().reset();
+        count_allocs(AllocCounter::count() - alloc_begin, update_alloc);
+        return true;
     }
 };
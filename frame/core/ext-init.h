@@ -8,6 +8,9 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
+#include "./frame-arena.h"
+#include "./opengl-ext.h"
+
 
 inline void spdlog_init()
 {
@@ -29,15 +32,20 @@ inline void spdlog_init()
 }
 
 
-inline void glad_init()
+/**
+ * @param loader 获取 OpenGL 函数地址的函数，headless 模式下是 eglGetProcAddress
+ */
+inline void glad_init(GLADloadproc loader = (GLADloadproc) glfwGetProcAddress)
 {
-    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress))
+    if (!gladLoadGLLoader(loader))
         std::fprintf(stderr, "fail to environment_init glad.");
+    GLExtension::init(loader);
 }
 
 
 inline void imgui_init(GLFWwindow *window)
 {
+    ImGui::SetAllocatorFunctions(AllocCounter::imgui_alloc, AllocCounter::imgui_free);
     ImGui::CreateContext();
     ImGuiIO &io = ImGui::GetIO();
     (void) io;
@@ -45,3 +53,29 @@ inline void imgui_init(GLFWwindow *window)
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330");
 }
+
+
+/**
+ * headless 模式没有窗口，不使用 glfw 的后端，显示区域就是离屏 FBO 的大小
+ */
+inline void imgui_init_headless(int width, int height)
+{
+    ImGui::SetAllocatorFunctions(AllocCounter::imgui_alloc, AllocCounter::imgui_free);
+    ImGui::CreateContext();
+    ImGuiIO &io    = ImGui::GetIO();
+    io.DisplaySize = ImVec2((float) width, (float) height);
+    io.IniFilename = nullptr;
+    ImGui::StyleColorsLight();
+    ImGui_ImplOpenGL3_Init("#version 330");
+}
+
+
+/**
+ * 代替 ImGui_ImplGlfw_NewFrame：没有输入，每帧的时间固定
+ */
+inline void imgui_headless_new_frame(int width, int height)
+{
+    ImGuiIO &io    = ImGui::GetIO();
+    io.DisplaySize = ImVec2((float) width, (float) height);
+    io.DeltaTime   = 1.f / 60.f;
+}
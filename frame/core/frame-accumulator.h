@@ -0,0 +1,74 @@
+/**
+ * 渐进累积：画面静止时，每帧使用不同的随机数种子渲染，把结果平均到历史中，
+ * 随着帧数增加逐渐收敛到没有噪声的参考图像
+ */
+#pragma once
+
+#include <cstdint>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "./shader.h"
+
+
+/**
+ * @brief 把默认 framebuffer 中这一帧的颜色累积到一个 RGBA32F 的历史缓冲中
+ * 第 n 帧（从 0 开始）的权重是 1 / (n + 1)，因此历史总是前 n + 1 帧的平均值；
+ * 累积之后把平均值写回默认 framebuffer，之后再绘制 ImGui\n
+ * 平均的是输出到屏幕的颜色，已经经过了色调映射和 gamma 校正，对于噪声的收敛已经足够
+ * @note 需要 OpenGL 上下文，framebuffer 尺寸变化时自动重新创建缓冲
+ */
+class FrameAccumulator
+{
+public:
+    FrameAccumulator();
+    ~FrameAccumulator();
+
+    FrameAccumulator(const FrameAccumulator &)            = delete;
+    FrameAccumulator &operator=(const FrameAccumulator &) = delete;
+
+    /**
+     * 累积默认 framebuffer 的颜色，并把平均值写回
+     * @param sample 这一帧的序号，0 表示丢弃之前的历史
+     */
+    void accumulate(uint32_t sample);
+
+    /**
+     * 把历史写回默认 framebuffer，用于已经收敛、不再渲染的帧
+     */
+    void present() const;
+
+    /// 历史中已经累积的帧数
+    [[nodiscard]] uint32_t samples() const { return _samples; }
+
+    /**
+     * 第 index 个 Halton 序列的值，范围是 [0, 1)，用于生成分布均匀的随机数种子和抖动
+     * @param base 互质的底数，例如 2 和 3
+     */
+    [[nodiscard]] static float halton(uint32_t index, uint32_t base);
+
+private:
+    Shader2 _shader;
+
+    GLuint _vao{};    // 空的 VAO，core profile 中绘制时必须绑定
+
+    GLuint _current_fbo{};    // 这一帧的颜色，RGBA8
+    GLuint _current_tex{};
+    GLuint _history_fbo{};    // 累积的平均值，RGBA32F
+    GLuint _history_tex{};
+
+    int      _width   = 0;
+    int      _height  = 0;
+    uint32_t _samples = 0;
+
+    /**
+     * 根据 framebuffer 的尺寸创建缓冲，尺寸变化时重新创建，历史被清空
+     */
+    void resize(int width, int height);
+
+    void release();
+
+    /// 从 src 复制颜色到 dst 的 GL_COLOR_ATTACHMENT0，0 表示默认 framebuffer
+    void blit(GLuint src, GLuint dst) const;
+};
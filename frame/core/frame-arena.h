@@ -0,0 +1,149 @@
+/**
+ * 帧内存：每个线程一个线性分配器，只在帧结束时整体释放，用于每帧临时的小数组、字符串等\n
+ * 通过 std::pmr 容器使用，稳定运行之后不再访问全局的堆；AllocCounter 统计 operator new 的次数，
+ * 需要在 CMake 中打开 FRAME_COUNT_ALLOCS
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief 线性分配器：在一组内存块中依次分配，单独的释放不做任何事情，reset 时全部释放
+ * 内存块在 reset 之后保留，下一帧继续使用；某一帧用到了多个内存块时，
+ * reset 会把它们合并为一个，因此稳定之后每帧只使用一个内存块，不再分配新的内存\n
+ * 每个线程有自己的 FrameArena，只能在所属的线程中分配；分配的内存在 reset 之前有效：
+ * - 主线程：Engine 在每帧 swap 之后 reset
+ * - 更新线程：每次 tick_update 结束之后 reset
+ * - JobSystem 的任务：每个任务在一个 Scope 中执行，任务结束时释放任务中分配的内存
+ * @note 不能用于需要跨帧保存、或者交给其他线程的数据，例如 TripleBuffer 中的快照
+ */
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+    static constexpr size_t BLOCK_SIZE = 256 * 1024;
+
+    /// 当前线程的 FrameArena
+    static FrameArena &local();
+
+    FrameArena() = default;
+    ~FrameArena() override;
+
+    FrameArena(const FrameArena &)            = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    /**
+     * 释放所有分配的内存，只能在所属的线程中调用，之前分配的内存都不能再使用
+     */
+    void reset();
+
+    /// 分配的位置，用于释放某个时刻之后分配的内存
+    struct Marker {
+        size_t block  = 0;
+        size_t offset = 0;
+    };
+
+    [[nodiscard]] Marker mark() const { return {_block, _offset}; }
+
+    /**
+     * 释放 mark 之后分配的内存，marker 之间需要满足栈的顺序
+     */
+    void rewind(const Marker &marker);
+
+    /**
+     * @brief 在构造和析构之间分配的内存，析构时释放
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(FrameArena &arena = local())
+            : _arena(arena), _marker(arena.mark())
+        {}
+        ~Scope() { _arena.rewind(_marker); }
+
+        Scope(const Scope &)            = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        FrameArena &_arena;
+        Marker      _marker;
+    };
+
+    /// 这一帧已经使用的字节数，包括对齐以及内存块末尾放不下的部分
+    [[nodiscard]] size_t used() const;
+
+    /// 所有帧中 used 的最大值
+    [[nodiscard]] size_t peak() const { return _peak; }
+
+    /// 内存块的总大小
+    [[nodiscard]] size_t capacity() const;
+
+private:
+    struct Block {
+        std::byte *data;
+        size_t     size;
+    };
+
+    std::vector<Block> _blocks;
+    size_t             _block  = 0;    // 正在使用的内存块
+    size_t             _offset = 0;    // 在正在使用的内存块中的偏移
+    size_t             _peak   = 0;
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void  do_deallocate(void *, size_t, size_t) override {}
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    static Block new_block(size_t size);
+    static void  free_block(const Block &block);
+};
+
+
+/**
+ * 使用当前线程 FrameArena 的容器，例如：FrameVector<GLenum> buffers(&FrameArena::local());
+ */
+template<typename T>
+using FrameVector = std::pmr::vector<T>;
+using FrameString = std::pmr::string;
+
+
+/**
+ * @brief 统计当前线程通过 operator new（以及 ImGui）分配内存的次数和字节数
+ * 定义了 FRAME_COUNT_ALLOCS 时，程序中的全局 operator new 被替换为计数之后再调用 malloc 的版本；
+ * 没有定义时不替换，只统计 ImGui 的分配。计数器是 thread_local 的，不需要原子操作\n
+ * 用法是在一段代码前后各读取一次，差值就是这段代码分配的次数，
+ * Engine 用它统计每帧渲染线程和更新线程的分配次数
+ * @note 不包括直接调用 malloc 的第三方库，例如 OpenGL 驱动
+ */
+class AllocCounter
+{
+public:
+    /// 是否替换了全局的 operator new
+#ifdef FRAME_COUNT_ALLOCS
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+
+    /// 当前线程累计的分配次数
+    [[nodiscard]] static uint64_t count();
+
+    /// 当前线程累计分配的字节数
+    [[nodiscard]] static uint64_t bytes();
+
+    /**
+     * ImGui 的内存分配函数，也计入统计，需要在 ImGui::CreateContext 之前设置：
+     * ImGui::SetAllocatorFunctions(AllocCounter::imgui_alloc, AllocCounter::imgui_free)
+     */
+    static void *imgui_alloc(size_t size, void *user_data);
+    static void  imgui_free(void *ptr, void *user_data);
+
+private:
+    AllocCounter() = default;
+};
@@ -0,0 +1,120 @@
+/**
+ * 非阻塞的帧捕获：通过 pixel pack buffer 异步读取 framebuffer，几帧之后再映射，
+ * 编码和写文件在单独的线程中完成，用于回归测试的截图以及录制视频
+ */
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+
+
+/**
+ * @brief 帧捕获，每帧调用 capture 和 poll
+ * capture 把 framebuffer 读取到环形队列中的一个 PBO，并插入 fence；
+ * poll 检查之前的 fence，已经完成的 PBO 才会映射，复制出数据之后交给编码线程，
+ * 因此正常情况下渲染线程不会等待 GPU，也不会等待编码\n
+ * 输出由 output 决定：\n
+ * - "frames/%05d.png"：每帧一张 PNG，%d 替换为帧号\n
+ * - "frames/%05d.hdr"：以 float 读取，保存为 Radiance HDR\n
+ * - "|ffmpeg -f rawvideo -pix_fmt rgba -s 1280x720 -i - out.mp4"：以 | 开头时，
+ *   把 RGBA8 的原始数据按顺序写入这个命令的标准输入
+ */
+class FrameCapture
+{
+public:
+    /// PBO 的数量，读取的结果最晚在 RING_SIZE 帧之后映射
+    static constexpr int RING_SIZE = 3;
+
+    /// 等待编码的最大帧数，超过时渲染线程等待编码线程
+    static constexpr size_t MAX_QUEUED = 8;
+
+    /**
+     * @param output 输出的文件名模板或者命令，见类的说明，格式错误时抛出异常
+     */
+    explicit FrameCapture(const std::string &output);
+
+    /**
+     * 等待所有的帧写入完成
+     * @note 需要在 OpenGL 上下文销毁之前析构
+     */
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture &)            = delete;
+    FrameCapture &operator=(const FrameCapture &) = delete;
+
+    /**
+     * 读取 framebuffer 的一个 attachment，不会阻塞；0 表示默认 framebuffer，
+     * headless 模式下是离屏 FBO
+     * @param attachment 默认 framebuffer 时忽略
+     */
+    void capture(GLuint framebuffer = 0, int width = 0, int height = 0,
+                 GLenum attachment = GL_COLOR_ATTACHMENT0);
+
+    /**
+     * 映射已经完成的 PBO，交给编码线程；每帧调用一次
+     */
+    void poll();
+
+    /// 已经写出的帧数
+    [[nodiscard]] size_t written_cnt() const;
+
+    /// 环形队列或编码队列已满、渲染线程不得不等待的次数
+    [[nodiscard]] size_t stall_cnt() const { return _stall_cnt; }
+
+private:
+    enum class Output { png, hdr, pipe };
+
+    struct Slot {
+        GLuint   pbo   = 0;
+        GLsync   fence = nullptr;
+        uint64_t frame = 0;
+        int      width = 0, height = 0;
+        size_t   size = 0;    // PBO 的容量
+    };
+
+    /// 交给编码线程的一帧
+    struct Frame {
+        uint64_t             frame;
+        int                  width, height;
+        std::vector<uint8_t> data;    // 从下到上，和 glReadPixels 的顺序相同
+    };
+
+    Output      _output;
+    std::string _target;    // 文件名模板或者命令
+    FILE       *_pipe = nullptr;
+
+    std::array<Slot, RING_SIZE> _slots{};
+    uint64_t                    _next_frame = 0;    // 下一次 capture 的帧号
+    uint64_t                    _next_map   = 0;    // 下一个需要映射的帧号
+    size_t                      _stall_cnt  = 0;
+
+    /// 编码线程
+    std::thread             _worker;
+    mutable std::mutex      _mutex;
+    std::condition_variable _cv;
+    std::deque<Frame>       _queue;
+    std::vector<Frame>      _free;    // 复用的缓冲
+    bool                    _stop        = false;
+    size_t                  _written_cnt = 0;
+
+    [[nodiscard]] size_t pixel_size() const { return _output == Output::hdr ? 12 : 4; }
+
+    /**
+     * 映射一个 slot 并交给编码线程
+     * @param wait fence 没有完成时是否等待
+     * @return 是否完成了映射
+     */
+    bool map_slot(Slot &slot, bool wait);
+
+    void worker_loop();
+    void write_frame(Frame &frame);
+};
@@ -10,6 +10,7 @@
 #include "./mesh.h"
 #include "./material.h"
 #include "./rt-object.h"
+#include "./transform.h"
 
 
 class ImportGLTF
@@ -24,7 +25,22 @@ public:
     /**
      * 获取从文件中读取到的 object
      */
-    std::vector<RTObject> get_obj_list() { return _obj_list; }
+    [[nodiscard]] const std::vector<RTObject> &get_obj_list() const { return _obj_list; }
+
+
+    /**
+     * gltf 中节点的层级，包括不含 mesh 的节点
+     */
+    [[nodiscard]] const TransformTree &get_transforms() const { return _transforms; }
+
+
+    /**
+     * 每个 object 在 get_transforms() 中对应的节点，和 get_obj_list() 一一对应
+     */
+    [[nodiscard]] const std::vector<TransformId> &get_obj_transform_ids() const
+    {
+        return _obj_transform_ids;
+    }
 
 
     /**
@@ -33,7 +49,7 @@ public:
     static std::vector<RTObject> load_gltf(const std::string &filepath)
     {
         ImportGLTF im{filepath};
-        return im.get_obj_list();
+        return std::move(im._obj_list);
     }
 
 
@@ -41,6 +57,13 @@ private:
     tinygltf::Model       _gltf;        // gltf 的整个数据
     std::vector<RTObject> _obj_list;    // 从 gltf 中读到的 object
 
+    TransformTree            _transforms;           // 节点的层级
+    std::vector<TransformId> _obj_transform_ids;    // 每个 object 对应的节点
+    std::vector<int>         _obj_meshes;           // 每个 object 对应的 gltf mesh index
+
+    /// 所有 mesh 的 GL 资源
+    std::shared_ptr<GLGeometry> _geometry = std::make_shared<GLGeometry>();
+
     /**
      * node.mesh.primitive.attribute 可能取的值
      */
@@ -58,13 +81,13 @@ private:
     void load_scene();
 
     /**
-     * 递归地处理 gltf 的 node，将结果写入 obj_list
+     * 递归地处理 gltf 的 node，将节点加入 _transforms，记录 mesh 节点
      * @param node 要处理的 gltf 节点
-     * @param parent_matrix_world 父节点在世界坐标系下的位姿
+     * @param parent 父节点在 _transforms 中的 id
      * @TODO 支持摄像机和灯光
-     * @note 只支持 matrix 形式的位姿
+     * @note 支持 matrix 和 TRS 两种形式的位姿
      */
-    void load_node(const tinygltf::Node &node, const glm::mat4 &parent_matrix_world);
+    void load_node(const tinygltf::Node &node, TransformId parent);
 
 #pragma region buffer view
 
@@ -3,6 +3,7 @@
  */
 #pragma once
 
+#include <map>
 #include <vector>
 #include <string>
 #include <queue>
@@ -43,29 +44,49 @@ ObjData process_mesh(const aiMesh &ai_mesh, const aiScene &scene, const std::str
 class ImportObj
 {
 public:
-    explicit ImportObj(const std::string &filepath);
+    /// 默认的 Assimp 后处理选项：三角化，自动生成法向量
+    static constexpr unsigned int DEFAULT_IMPORT_FLAGS =
+            aiProcess_Triangulate | aiProcess_GenNormals;
+
+    /**
+     * @param import_flags Assimp 的后处理选项
+     */
+    explicit ImportObj(const std::string &filepath,
+                       unsigned int       import_flags = DEFAULT_IMPORT_FLAGS);
 
     /**
      * 读取 .obj 模型文件，返回 mesh 的列表
+     * @note 每次调用都会重新读取文件并创建 GL 资源，需要共享模型时使用 ModelManager
      */
-    static std::vector<RTObject> load_obj(const std::string &filepath)
+    static std::vector<RTObject> load_obj(const std::string &filepath,
+                                          unsigned int import_flags = DEFAULT_IMPORT_FLAGS)
     {
-        ImportObj im{filepath};
-        return im._obj_list;
+        ImportObj im{filepath, import_flags};
+        return std::move(im._obj_list);
     }
 
 
 private:
     /**
-     * 递归地从 assimp 的 node 中提取模型
+     * 递归地从 assimp 的 node 中收集 mesh
      */
     void process_node(const aiNode &node);
 
 
     /**
-     * 读取 assimp 中的 mesh 中的几何数据，建立 VAO
+     * 为收集到的 mesh 创建 RTObject\n
+     * 去掉平移之后完全相同的 mesh（例如 sphere-matrix 中的小球）共享同一个 VAO，
+     * 平移放到 RTObject 的矩阵中，这样就可以实例化绘制
      */
-    static GLuint load_mesh_geometry(const aiMesh &mesh);
+    void build_obj_list();
+
+
+    /**
+     * 读取 assimp 中的 mesh 中的几何数据，建立 VAO\n
+     * 三角形足够多时同时划分 meshlet，记录在 _meshlets 中
+     * @param offset 所有顶点的位置都减去 offset
+     */
+    GLuint load_mesh_geometry(const aiMesh &mesh, const glm::vec3 &offset);
 
 
     /**
@@ -75,13 +96,20 @@ private:
 
 
     /**
-     * 从 assimp 的中读取几何和材质信息，创建 Mesh2 对象
-     * @return
+     * 从 assimp 的中读取材质信息，和已经建立好的 VAO 一起创建 Mesh2 对象
+     * @param aabb 模型空间的包围盒
      */
-    Mesh2 load_mesh(const aiMesh &mesh);
+    Mesh2 load_mesh(const aiMesh &mesh, GLuint vao, const AABB &aabb);
 
 
-    std::vector<RTObject> _obj_list;    // 存放提取出的模型
+    std::vector<const aiMesh *> _meshes;      // 按照遍历顺序收集的 mesh
+    std::vector<RTObject>       _obj_list;    // 存放提取出的模型
+
+    /// 划分了 meshlet 的 VAO，同一个 VAO 的所有 Mesh2 共享
+    std::map<GLuint, std::shared_ptr<const std::vector<Meshlet>>> _meshlets;
     const aiScene        *_scene;       // .obj 模型对应的场景文件（Assimp)
     std::string           _dir_path;    // 模型所在目录
+
+    /// 所有 mesh 的 GL 资源
+    std::shared_ptr<GLGeometry> _geometry = std::make_shared<GLGeometry>();
 };
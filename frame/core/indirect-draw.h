@@ -0,0 +1,93 @@
+/**
+ * 间接绘制：把一个 pass 中所有物体的绘制调用写入 GL_DRAW_INDIRECT_BUFFER，
+ * 用 glMultiDrawElementsIndirect 一次提交
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "./mesh.h"
+#include "./shader.h"
+
+
+/**
+ * 和 OpenGL 规定的布局相同
+ */
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instance_cnt;
+    GLuint first_index;
+    GLint  base_vertex;
+    GLuint base_instance;
+};
+
+
+/**
+ * @brief 一个 pass 的绘制列表，可以间接绘制，也可以逐个物体绘制
+ * 间接绘制时，每个物体的下标写在命令的 baseInstance 中，配合一个内容为 0, 1, 2... 的
+ * per-instance 顶点属性，着色器在定义 OBJECT_ID_ATTRIBUTE 之后就能读到 object_id，
+ * 再从 ObjectDataBuffer 中读取位姿和材质\n
+ * glMultiDrawElementsIndirect 只能使用一个 VAO，因此绘制会按照 VAO 排序，
+ * 每个 VAO（以及图元类型、索引类型）提交一次；使用相同几何的物体越多，提交的次数越少
+ */
+class IndirectDrawBuffer
+{
+public:
+    /**
+     * 当前上下文是否支持间接绘制，不支持时只能使用 draw_loop
+     */
+    static bool supported() { return GLExtension::multi_draw_indirect(); }
+
+    void clear() { _draws.clear(); }
+
+    /**
+     * 添加一个物体的绘制
+     * @param object_id 物体在 ObjectDataBuffer 中的下标
+     */
+    void push(const Mesh2 &mesh, uint32_t object_id);
+
+    [[nodiscard]] size_t size() const { return _draws.size(); }
+
+    /**
+     * 间接绘制所有物体，调用之前需要设置好着色器（定义了 OBJECT_ID_ATTRIBUTE 的变体）
+     * @return glMultiDrawElementsIndirect 的调用次数
+     */
+    size_t draw_indirect();
+
+    /**
+     * 逐个物体设置 object_id 并绘制，用于不支持间接绘制的上下文，以及和间接绘制对比
+     * @return glDrawElements 的调用次数
+     */
+    size_t draw_loop(Shader2 &shader) const;
+
+    /**
+     * 释放缓冲，需要在 OpenGL 上下文有效时调用
+     */
+    void release();
+
+private:
+    struct Draw {
+        GLuint   vao;
+        GLenum   primitive_mode;
+        GLenum   index_type;
+        GLuint   index_cnt;
+        GLuint   first_index;    // 以索引元素为单位
+        uint32_t object_id;
+    };
+    std::vector<Draw> _draws;
+
+    std::vector<DrawElementsIndirectCommand> _commands;
+
+    GLuint _command_buffer{};
+    size_t _command_capacity{};
+    GLuint _id_buffer{};    // 0, 1, 2 ... 作为 per-instance 的 object_id
+    size_t _id_capacity{};
+
+    /**
+     * 确保 object_id 缓冲至少有 cnt 个元素
+     */
+    void reserve_ids(size_t cnt);
+};
@@ -0,0 +1,206 @@
+/**
+ * 任务系统：固定数量的工作线程，每个线程有自己的任务队列，空闲时从其他线程的队列中窃取任务\n
+ * 用于导入、烘焙、BVH 构建、剔除等可以并行的工作；需要 OpenGL 的任务可以交给主线程执行
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class TaskGroup;
+
+
+/**
+ * @brief 任务系统，通过静态成员管理，和 Profiler、ShaderLib 类似
+ * 每个工作线程（以及主线程）有一个双端队列：自己在尾部放入和取出任务，后进先出，
+ * 缓存更友好；其他线程从头部窃取，拿到的是较早放入、通常也更大的任务\n
+ * 其他线程（例如 UpdateThread）提交的任务放在一个共享队列中\n
+ * 主线程是程序启动时的线程，也就是创建 OpenGL 上下文的线程，
+ * 通过 TaskGroup::run_on_main 提交的任务只在主线程中执行：
+ * Engine 每帧调用 run_main_jobs，主线程在 TaskGroup::wait 中等待时也会执行
+ */
+class JobSystem
+{
+public:
+    /**
+     * 启动工作线程，之前已经启动时先停止；第一次提交任务时会自动以默认数量启动
+     * @param thread_cnt 执行任务的线程总数，包括等待任务的主线程，即工作线程的数量加 1；
+     *        0 表示 hardware_concurrency
+     * @note 调用时不能有正在执行的任务
+     */
+    static void init(int thread_cnt = 0);
+
+    /**
+     * 停止所有工作线程，队列中剩余的任务会被丢弃；程序退出时会自动调用
+     */
+    static void shutdown();
+
+    /// 执行任务的线程总数，包括主线程
+    [[nodiscard]] static int thread_cnt();
+
+    /// 是否在主线程中
+    [[nodiscard]] static bool is_main_thread();
+
+    /**
+     * 执行通过 run_on_main 提交的任务，只能在主线程调用
+     * @return 执行的任务数量
+     */
+    static size_t run_main_jobs();
+
+    /**
+     * 尝试执行一个任务（主线程上也包括 run_on_main 的任务），用于在等待时帮忙
+     * @return 是否执行了任务
+     */
+    static bool run_one();
+
+private:
+    JobSystem() = default;
+
+    friend class TaskGroup;
+
+    struct Job {
+        std::function<void()> func;
+        TaskGroup            *group        = nullptr;
+        bool                  continuation = false;    // 是 TaskGroup::then 注册的后续任务
+    };
+
+    /// 一个线程的任务队列，任务的粒度远大于加锁的开销，因此直接使用互斥锁
+    struct alignas(64) Queue {
+        std::mutex      mutex;
+        std::deque<Job> jobs;    // 尾部是最新的任务
+
+        void push(Job &&job);
+        bool pop(Job &job);      // 所属的线程从尾部取出
+        bool steal(Job &job);    // 其他线程从头部窃取
+    };
+
+    /// 0 是主线程，1 到 N 是工作线程，最后一个是其他线程共享的队列
+    static std::vector<std::unique_ptr<Queue>> _queues;
+    static std::vector<std::thread>            _workers;
+    static Queue                               _main_jobs;    // 只在主线程执行的任务
+
+    static std::mutex        _init_mutex;
+    static std::atomic<bool> _running;
+    static std::atomic<bool> _stop;
+
+    /// 空闲的工作线程在 _sleep_cv 上等待，每次提交任务时 _epoch 加 1
+    static std::mutex              _sleep_mutex;
+    static std::condition_variable _sleep_cv;
+    static std::atomic<uint64_t>   _epoch;
+    static std::atomic<int>        _sleeping;
+
+    static const std::thread::id _main_thread;
+
+    static void start(int thread_cnt);
+
+    static void submit(Job &&job);
+    static void submit_main(Job &&job);
+    static void execute(Job &job);
+    static bool find_job(Job &job);
+    static void worker_loop(int index);
+    static void ensure_init();
+
+    /// 当前线程的队列，不是主线程和工作线程时是共享队列
+    static Queue &local_queue();
+};
+
+
+/**
+ * @brief 一组任务，可以等待它们全部完成，也可以注册全部完成之后执行的后续任务
+ * 任务中抛出的异常会被记录，在 wait 中重新抛出（只保留第一个）\n
+ * wait 的线程不会空等，而是执行队列中的任务，因此任务中可以嵌套创建 TaskGroup 并等待
+ * @note 析构之前会等待所有任务完成
+ */
+class TaskGroup
+{
+public:
+    /**
+     * @param profile_name 非空时每个任务在 Profiler 中记录为一个 CPU scope，需要是字符串常量
+     */
+    explicit TaskGroup(const char *profile_name = nullptr);
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup &)            = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    /**
+     * 提交一个任务，可能在任意工作线程或者调用 wait 的线程中执行
+     */
+    void run(std::function<void()> func);
+
+    /**
+     * 提交一个只能在主线程执行的任务，例如创建纹理、上传缓冲等 OpenGL 调用
+     */
+    void run_on_main(std::function<void()> func);
+
+    /**
+     * 当前所有任务完成之后执行 func；已经没有未完成的任务时立即提交\n
+     * 后续任务中可以继续向这个 TaskGroup 提交任务，wait 会等待它们
+     */
+    void then(std::function<void()> func);
+
+    /**
+     * 等待所有任务以及后续任务完成，等待时执行其他任务
+     */
+    void wait();
+
+    /// 是否还有没有完成的任务
+    [[nodiscard]] bool busy() const
+    {
+        return _pending.load(std::memory_order_acquire) > 0 ||
+               _cont_pending.load(std::memory_order_acquire) > 0;
+    }
+
+private:
+    friend class JobSystem;
+
+    uint32_t _profile_id = UINT32_MAX;
+
+    std::atomic<size_t> _pending{0};         // 没有完成的任务（不包括后续任务）
+    std::atomic<size_t> _cont_pending{0};    // 注册之后没有完成的后续任务
+
+    std::mutex                         _mutex;
+    std::vector<std::function<void()>> _continuations;
+    std::exception_ptr                 _error;
+
+    void finish(const JobSystem::Job &job, std::exception_ptr error);
+};
+
+
+/**
+ * 并行地对 [first, last) 中的每个区间调用 func(begin, end)\n
+ * 区间不断对半划分，一半留给自己、一半放入队列等待窃取，直到长度不超过 grain；
+ * 空闲的线程窃取到的总是较大的一半，因此负载不均匀时也能很快平衡
+ * @param grain 每次调用 func 的最大区间长度，应该让一次调用至少有几微秒的工作量
+ * @param profile_name 非空时每次调用 func 在 Profiler 中记录为一个 CPU scope
+ */
+void parallel_for_range(size_t first, size_t last, size_t grain,
+                        const std::function<void(size_t, size_t)> &func,
+                        const char                                *profile_name = nullptr);
+
+
+/**
+ * 并行地对 [first, last) 中的每个下标调用 func(i)，见 parallel_for_range
+ */
+template<typename Func>
+void parallel_for(size_t first, size_t last, size_t grain, Func &&func,
+                  const char *profile_name = nullptr)
+{
+    parallel_for_range(
+            first, last, grain,
+            [&func](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                    func(i);
+            },
+            profile_name);
+}
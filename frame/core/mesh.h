@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include <glad/glad.h>
@@ -9,6 +10,8 @@
 #include "./misc.h"
 #include "./opengl-misc.h"
 #include "./material.h"
+#include "./bounds.h"
+#include "./meshlet.h"
 
 
 /**
@@ -19,9 +22,84 @@ const struct {
     GLuint normal  = 1;
     GLuint tex_0   = 2;
     GLuint tangent = 3;
+
+    /// 以下是 per-instance 的属性，见 InstanceData
+    GLuint instance_model  = 4;    // mat4 占用 4 个 slot：4, 5, 6, 7
+    GLuint instance_color  = 8;
+    GLuint instance_params = 9;
+
+    /// 间接绘制时物体的下标，见 IndirectDrawBuffer
+    GLuint object_id = 10;
 } VERTEX_ATTRBUTE_SLOT;
 
 
+/**
+ * 实例化绘制时，每个实例的数据
+ */
+struct InstanceData {
+    glm::mat4 model;
+    glm::vec4 base_color;
+    glm::vec4 params;    // x: metallic, y: roughness, z: 是否有 base color 纹理
+
+    static InstanceData from(const glm::mat4 &model, const Material &mat)
+    {
+        const auto &mr = mat.metallic_roughness;
+        return {
+                .model      = model,
+                .base_color = mr.base_color,
+                .params     = {(float) mr.metallic, (float) mr.roughness,
+                               mat.has_tex_basecolor() ? 1.f : 0.f, 0.f},
+        };
+    }
+};
+
+
+/**
+ * @brief 存放 InstanceData 的顶点缓冲
+ * 多个 batch 的实例数据放在同一个缓冲中，绘制某个 batch 之前，用 bind 指定它的起始位置
+ */
+class InstanceBuffer
+{
+public:
+    /**
+     * 上传所有实例的数据，容量不足时重新分配
+     */
+    void upload(const std::vector<InstanceData> &instances);
+
+    /**
+     * 将 per-instance 的属性绑定到 vao 上
+     * @param first_instance 第一个实例在缓冲中的位置
+     * @note 只用到 OpenGL 3.3 的功能，因此通过属性的偏移，而不是 base instance 来指定起始位置
+     */
+    void bind(GLuint vao, size_t first_instance) const;
+
+    /**
+     * 释放缓冲，需要在 OpenGL 上下文有效时调用
+     */
+    void release();
+
+private:
+    GLuint _buffer{};
+    size_t _capacity{};    // 缓冲能容纳的实例数量
+};
+
+
+/**
+ * 一个模型的 GL 几何资源（VAO、VBO、EBO），同一个模型的所有 Mesh2 共享\n
+ * Mesh2 被拷贝时只增加引用计数，不会复制显存中的数据
+ */
+struct GLGeometry {
+    std::vector<GLuint> vaos;
+    std::vector<GLuint> buffers;    // VBO 和 EBO
+
+    /**
+     * 释放所有的 GL 资源
+     * @note 需要在 OpenGL 上下文有效时调用，因此不放在析构函数中
+     */
+    void release();
+};
+
+
 struct Mesh2 {
     GLuint      vao{};
     std::string name;
@@ -32,8 +110,21 @@ struct Mesh2 {
 
     Material mat;    // mesh 的 material 信息
 
+    std::shared_ptr<GLGeometry> geometry;    // 几何数据的所有者，用于引用计数
+
+    AABB           aabb;      // 模型空间的包围盒，导入时计算
+    BoundingSphere sphere;    // 模型空间的包围球，导入时计算
+
+    /// 三角形足够多的网格在导入时划分的 meshlet，为空表示没有划分，见 MeshletCuller
+    std::shared_ptr<const std::vector<Meshlet>> meshlets;
+
     /**
      * 绘制 VAO
      */
     void draw() const;
+
+    /**
+     * 实例化绘制，需要先用 InstanceBuffer::bind 绑定实例数据
+     */
+    void draw_instanced(GLsizei instance_cnt) const;
 };
@@ -0,0 +1,53 @@
+/**
+ * meshlet：把大的网格划分成小的三角形簇，每个簇有自己的包围球和法线锥，
+ * 可以在 CPU 上按簇剔除视锥体之外和背向视点的部分
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "./bounds.h"
+
+
+/// 每个 meshlet 最多引用的顶点数量和三角形数量
+constexpr uint32_t MESHLET_MAX_VERTICES  = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+/// 三角形数量不少于这个值的网格，导入时才会划分 meshlet
+constexpr uint32_t MESHLET_MIN_MESH_TRIANGLES = 1024;
+
+
+/**
+ * 一个三角形簇，三角形是网格索引中连续的一段
+ */
+struct Meshlet {
+    BoundingSphere sphere;    // 模型空间的包围球
+
+    /**
+     * 法线锥：视点满足 dot(normalize(cone_apex - eye), cone_axis) >= cone_cutoff 时，
+     * 簇中的所有三角形都背向视点\n
+     * 法线分布太分散时 cone_cutoff 大于 1，永远不会被剔除
+     */
+    glm::vec3 cone_apex{0.f};
+    glm::vec3 cone_axis{0.f, 0.f, 1.f};
+    float     cone_cutoff = 2.f;
+
+    uint32_t first_index  = 0;    // 在网格索引中的位置（元素数量）
+    uint32_t triangle_cnt = 0;
+    uint32_t vertex_cnt   = 0;    // 引用的不同顶点的数量
+};
+
+
+/**
+ * 贪心地划分 meshlet：从一个三角形开始，不断加入和 meshlet 共享顶点的三角形，
+ * 优先选择新增顶点少、离 meshlet 中心近、法线接近的三角形，直到达到顶点或三角形的上限\n
+ * 位置相同的顶点（uv 或法线的接缝）视为相邻，避免 meshlet 在接缝处被截断
+ * @param positions 模型空间的顶点位置
+ * @param indices 三角形的顶点索引，每 3 个一组；会被按 meshlet 的顺序重排，
+ *                之后每个 meshlet 是其中连续的一段，因此需要在上传 EBO 之前调用
+ */
+std::vector<Meshlet> build_meshlets(const std::vector<glm::vec3> &positions,
+                                    std::vector<uint32_t>        &indices);
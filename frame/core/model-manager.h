@@ -0,0 +1,54 @@
+/**
+ * 模型资源管理，多处读取同一个模型时共享显存中的几何数据
+ */
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "./import-obj.h"
+#include "./import-gltf.h"
+
+
+/**
+ * @brief 模型资源管理
+ * 以 (规范化的路径, 导入选项) 作为 key，同一个模型只会读取一次，只创建一份 VAO/VBO/EBO。
+ * 返回的 RTObject 可以直接拷贝，拷贝只会增加几何数据的引用计数。
+ * 通过静态 map 实现资源管理，和 TextureManager 类似
+ */
+class ModelManager
+{
+public:
+    /**
+     * 读取模型，如果已经读取过，直接返回缓存的结果\n
+     * .gltf 使用 ImportGLTF 读取，其他格式使用 Assimp 读取
+     * @param import_flags Assimp 的后处理选项，对 .gltf 无效
+     * @note 返回的引用在 release_unused() 之前一直有效
+     */
+    static const std::vector<RTObject> &
+    load(const std::string &file_path,
+         unsigned int       import_flags = ImportObj::DEFAULT_IMPORT_FLAGS);
+
+    /**
+     * 释放没有被任何 RTObject 拷贝引用的模型，以及对应的 GL 资源
+     * @return 释放的模型数量
+     */
+    static size_t release_unused();
+
+    /**
+     * 当前缓存的模型数量
+     */
+    static size_t model_cnt() { return m.size(); }
+
+private:
+    ModelManager() = default;
+
+    struct Entry {
+        std::vector<RTObject>       obj_list;
+        std::shared_ptr<GLGeometry> geometry;
+    };
+
+    inline static std::map<std::pair<std::string, unsigned int>, Entry> m;
+};
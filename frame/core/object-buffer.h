@@ -0,0 +1,88 @@
+/**
+ * 常驻显存的物体数据：位姿和材质常量只在变化时上传，着色器通过物体的下标读取
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "./mesh.h"
+#include "./rt-object.h"
+#include "./scene.h"
+
+
+/**
+ * @brief 以物体下标索引的 texture buffer
+ * 每个物体占用 TEXELS_PER_OBJECT 个 RGBA32F 的 texel，布局和 InstanceData 相同：
+ * 0-3 是模型矩阵的 4 列，4 是 base color，5 是 params\n
+ * CPU 端保留一份副本，set 时和副本比较，只有内容真正变化的物体才会被标记为脏，
+ * upload() 把相邻的脏物体合并成区间上传，静态场景每帧的上传量为 0\n
+ * 着色器中 #include "object-data.glsl"，用物体的下标读取数据\n
+ * texel 的数量受 GL_MAX_TEXTURE_BUFFER_SIZE 限制，GL 3.3 只保证 65536 个，即 10922 个物体；
+ * 超过上限时 upload() 抛出异常
+ */
+class ObjectDataBuffer
+{
+public:
+    static constexpr int TEXELS_PER_OBJECT = sizeof(InstanceData) / sizeof(glm::vec4);
+
+    /**
+     * 调整物体的数量，新增的物体是单位矩阵和默认材质
+     */
+    void resize(size_t cnt);
+
+    /**
+     * 当前上下文中 texture buffer 能容纳的物体数量，第一次调用时查询，需要 OpenGL 上下文
+     */
+    static size_t max_objects();
+
+    void set(uint32_t id, const InstanceData &data);
+    void set_matrix(uint32_t id, const glm::mat4 &matrix);
+    void set_material(uint32_t id, const Material &mat);
+
+    /**
+     * 和场景同步：数量以及每个物体的位姿和材质，物体的下标就是场景中的稠密下标
+     */
+    void sync(const SceneView &scene);
+    void sync(const std::vector<RTObject> &objs);
+
+    /**
+     * 上传所有脏区间，容量不足时重新分配并上传全部数据
+     * @throw 物体数量超过 max_objects()
+     * @return 本次上传的字节数
+     */
+    size_t upload();
+
+    /**
+     * 将 texture buffer 绑定到某个纹理单元上，对应着色器中的 samplerBuffer
+     */
+    void bind(int texture_unit) const;
+
+    /**
+     * 释放缓冲和纹理，需要在 OpenGL 上下文有效时调用
+     */
+    void release();
+
+    [[nodiscard]] size_t size() const { return _data.size(); }
+
+    /// 上一次 upload() 上传的区间数量
+    [[nodiscard]] size_t last_upload_ranges() const { return _last_ranges; }
+
+private:
+    std::vector<InstanceData> _data;     // CPU 端的副本
+    std::vector<uint64_t>     _dirty;    // 每个物体一位
+    bool                      _any_dirty{};
+
+    GLuint _buffer{};
+    GLuint _texture{};
+    size_t _capacity{};    // 缓冲能容纳的物体数量
+    size_t _last_ranges{};
+
+    void mark_dirty(uint32_t id)
+    {
+        _dirty[id / 64] |= 1ull << (id % 64);
+        _any_dirty = true;
+    }
+};
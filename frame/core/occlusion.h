@@ -0,0 +1,145 @@
+/**
+ * CPU 上的软件遮挡剔除：把少量遮挡物光栅化到低分辨率的深度缓冲中，
+ * 再用物体的包围盒和分层深度（HiZ）比较，去掉完全被遮挡的物体
+ */
+#pragma once
+
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "./bounds.h"
+#include "./culling.h"
+#include "./job-system.h"
+#include "./rt-object.h"
+
+
+/**
+ * 遮挡物：只需要顶点位置和三角形索引，通常是原始模型的简化版本
+ */
+struct Occluder {
+    std::vector<glm::vec3> positions;    // 模型空间的顶点位置
+    std::vector<uint32_t>  indices;      // 每 3 个一组
+    glm::mat4              model{1.f};
+
+    [[nodiscard]] size_t triangle_cnt() const { return indices.size() / 3; }
+
+    /**
+     * 只保留面积最大的若干个三角形，作为简单的 LOD
+     * @note 保留的三角形是原始表面的子集，因此剔除结果仍然是保守的
+     */
+    void simplify(size_t max_triangles);
+
+    /**
+     * 从 .obj 文件读取遮挡物，文件中的所有 mesh 会合并成一个遮挡物
+     * @param max_triangles 三角形数量的上限，0 表示不限制
+     */
+    static Occluder from_obj(const std::string &path, size_t max_triangles = 0);
+};
+
+
+/**
+ * @brief 软件遮挡剔除
+ * 深度缓冲按照 8x8 的 tile 维护每个 tile 的最远深度（HiZ），
+ * 测试时先和 tile 比较，不能确定时再逐像素比较。光栅化和测试都用 SIMD 每次处理 4 个像素
+ */
+class OcclusionCuller
+{
+public:
+    static constexpr int TILE_SIZE = 8;
+
+    /**
+     * @param width, height 深度缓冲的分辨率，会向上对齐到 TILE_SIZE 的倍数
+     */
+    explicit OcclusionCuller(int width = 256, int height = 128);
+    ~OcclusionCuller();
+
+    OcclusionCuller(const OcclusionCuller &)            = delete;
+    OcclusionCuller &operator=(const OcclusionCuller &) = delete;
+
+    /**
+     * 开始新的一帧：清空深度缓冲，设置 view-projection 矩阵
+     */
+    void clear(const glm::mat4 &vp);
+
+    /// 将遮挡物光栅化到深度缓冲中，只保留最近的深度
+    void rasterize(const Occluder &occluder);
+
+    /// 光栅化完成之后，更新每个 tile 的最远深度
+    void build_hiz();
+
+    /**
+     * 世界坐标系中的包围盒是否可能可见
+     * @note 与近平面相交、或者没有包围盒的物体总是可见的；视锥体之外的物体交给视锥体剔除处理
+     */
+    [[nodiscard]] bool test(const AABB &world_aabb) const;
+
+    /**
+     * 从 visible 中去掉被遮挡的物体
+     * @param visible 物体在 objs 中的下标，通常是视锥体剔除的结果
+     */
+    CullStats filter(const std::vector<RTObject> &objs, std::vector<uint32_t> &visible) const;
+
+    /**
+     * 同上，直接使用世界坐标系下的包围盒，例如 Scene::bounds()
+     */
+    CullStats filter(std::span<const AABB> world_bounds, std::vector<uint32_t> &visible) const;
+
+    /**
+     * 在工作线程中完成一整次剔除：clear、光栅化所有遮挡物、build_hiz、filter\n
+     * 通常在提交阴影等其他 pass 之前调用，在需要结果的 pass 之前调用 wait()
+     * @note 在 wait() 返回之前，occluders 和 objs 不能被修改或者销毁
+     */
+    void cull_async(const glm::mat4 &vp, const std::vector<Occluder> &occluders,
+                    const std::vector<RTObject> &objs, std::vector<uint32_t> candidates);
+
+    /**
+     * 同上，直接使用世界坐标系下的包围盒
+     * @note 在 wait() 返回之前，world_bounds 指向的数据不能被修改或者销毁
+     */
+    void cull_async(const glm::mat4 &vp, const std::vector<Occluder> &occluders,
+                    std::span<const AABB> world_bounds, std::vector<uint32_t> candidates);
+
+    /**
+     * 等待 cull_async 完成
+     * @param visible 输出没有被遮挡的物体的下标
+     */
+    CullStats wait(std::vector<uint32_t> &visible);
+
+    [[nodiscard]] int width() const { return _width; }
+    [[nodiscard]] int height() const { return _height; }
+
+    /// 深度缓冲，行优先，[0, 1] 越大越远，用于调试可视化
+    [[nodiscard]] const std::vector<float> &depth_buffer() const { return _depth; }
+
+private:
+    int _width;
+    int _height;
+    int _tile_cols;
+    int _tile_rows;
+
+    glm::mat4          _vp{1.f};
+    std::vector<float> _depth;    // 逐像素的最近深度
+    std::vector<float> _hiz;      // 每个 tile 的最远深度
+
+    /// cull_async 相关的状态
+    TaskGroup                                         _task;
+    std::vector<uint32_t>                             _async_visible;
+    CullStats                                         _async_stats;
+    std::function<CullStats(std::vector<uint32_t> &)> _async_filter;
+
+    /**
+     * 光栅化屏幕空间中的一个三角形，顶点是 (x, y, depth)，x 和 y 以像素为单位
+     */
+    void rasterize_triangle(const glm::vec3 &v0, const glm::vec3 &v1, const glm::vec3 &v2);
+
+    /**
+     * 提交给 JobSystem：光栅化遮挡物之后，用 filter_func 过滤 candidates
+     */
+    void launch(const glm::mat4 &vp, const std::vector<Occluder> &occluders,
+                std::vector<uint32_t>                             candidates,
+                std::function<CullStats(std::vector<uint32_t> &)> filter_func);
+};
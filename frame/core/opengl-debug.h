@@ -0,0 +1,85 @@
+/**
+ * 通过 GL_KHR_debug 的回调函数接收驱动报告的错误和警告，代替每次调用之后的 glGetError\n
+ * glGetError 在很多驱动上是一个同步点；回调函数默认是异步的，不会让 CPU 等待驱动
+ */
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include <glad/glad.h>
+
+
+/**
+ * @brief 调试输出，通过静态成员管理
+ * 启用之后 CHECK_GL_ERROR 不再调用 glGetError，只记录源码的位置；
+ * 需要定位是哪一次调用产生的错误时，切换到同步模式：回调函数在出错的 OpenGL 调用中执行，
+ * 日志会带上最近一次 CHECK_GL_ERROR 的位置\n
+ * 驱动的消息中通常只有对象的编号，因此纹理、着色器等对象在创建时通过 label 设置名称，
+ * 驱动的消息以及 RenderDoc 等工具都会显示这个名称
+ */
+class GLDebug
+{
+public:
+    /**
+     * 注册回调函数，忽略 notification 级别的消息，需要在 glad 和 GLExtension 初始化之后调用
+     * @param synchronous 是否使用同步模式
+     * @return 驱动不支持 KHR_debug 时返回 false，CHECK_GL_ERROR 继续使用 glGetError
+     */
+    static bool init(bool synchronous = false);
+
+    [[nodiscard]] static bool enabled() { return _enabled; }
+
+    /**
+     * 同步模式下驱动不能延迟报告消息，会影响性能，只在查找错误时使用
+     */
+    static void set_synchronous(bool synchronous);
+
+    [[nodiscard]] static bool synchronous() { return _synchronous; }
+
+    /**
+     * 不再报告某个 id 的消息，例如驱动中已知无害的警告
+     */
+    static void ignore(GLuint id);
+
+    /**
+     * 为对象设置名称，没有启用时没有任何影响
+     * @param identifier 对象的类型，例如 GL_TEXTURE, GL_PROGRAM, GL_BUFFER
+     */
+    static void label(GLenum identifier, GLuint name, const std::string &label);
+
+    /**
+     * 记录当前的源码位置，由 CHECK_GL_ERROR 调用，只写入两个变量
+     */
+    static void checkpoint(const char *file, int line)
+    {
+        _file = file;
+        _line = line;
+    }
+
+    /**
+     * 收到的错误（GL_DEBUG_TYPE_ERROR）的数量
+     */
+    [[nodiscard]] static size_t error_cnt() { return _error_cnt.load(std::memory_order_relaxed); }
+
+private:
+    GLDebug() = default;
+
+    /// 同一个 id 的消息最多报告的次数，避免每帧重复的消息刷屏
+    static constexpr int MAX_REPEAT = 8;
+
+    static inline bool _enabled     = false;
+    static inline bool _synchronous = false;
+
+    /// 对象名称的最大长度，超出时保留末尾的部分
+    static inline GLint _max_label_length = 0;
+
+    /// 最近一次 CHECK_GL_ERROR 的位置
+    static inline const char *_file = nullptr;
+    static inline int         _line = 0;
+
+    static inline std::atomic<size_t> _error_cnt{0};
+
+    static void APIENTRY callback(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                  GLsizei length, const GLchar *message, const void *user_param);
+};
@@ -0,0 +1,122 @@
+/**
+ * glad 只生成了 OpenGL 3.3 core 的接口，没有任何扩展\n
+ * 这里根据运行时的 OpenGL 实现，手动查询和加载需要用到的扩展
+ */
+#pragma once
+
+#include <string>
+#include <unordered_set>
+
+#include <glad/glad.h>
+
+
+/// GL_KHR_parallel_shader_compile
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR           0x91B1
+typedef void(APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+/// GL_ARB_draw_indirect, GL_ARB_multi_draw_indirect
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+typedef void(APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type,
+                                                           const void *indirect,
+                                                           GLsizei drawcount, GLsizei stride);
+
+/// GL_KHR_debug，4.3 之后是核心功能；GLDEBUGPROC 在 glad 中已经定义
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS     0x8242
+#define GL_DEBUG_SOURCE_API             0x8246
+#define GL_DEBUG_SOURCE_WINDOW_SYSTEM   0x8247
+#define GL_DEBUG_SOURCE_SHADER_COMPILER 0x8248
+#define GL_DEBUG_SOURCE_THIRD_PARTY     0x8249
+#define GL_DEBUG_SOURCE_APPLICATION     0x824A
+#define GL_DEBUG_SOURCE_OTHER           0x824B
+#define GL_DEBUG_TYPE_ERROR             0x824C
+#define GL_DEBUG_TYPE_DEPRECATED        0x824D
+#define GL_DEBUG_TYPE_UNDEFINED         0x824E
+#define GL_DEBUG_TYPE_PORTABILITY       0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE       0x8250
+#define GL_DEBUG_TYPE_OTHER             0x8251
+#define GL_DEBUG_TYPE_MARKER            0x8268
+#define GL_DEBUG_TYPE_PUSH_GROUP        0x8269
+#define GL_DEBUG_TYPE_POP_GROUP         0x826A
+#define GL_DEBUG_SEVERITY_NOTIFICATION  0x826B
+#define GL_BUFFER                       0x82E0
+#define GL_SHADER                       0x82E1
+#define GL_PROGRAM                      0x82E2
+#define GL_MAX_LABEL_LENGTH             0x82E8
+#define GL_DEBUG_SEVERITY_HIGH          0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM        0x9147
+#define GL_DEBUG_SEVERITY_LOW           0x9148
+#define GL_DEBUG_OUTPUT                 0x92E0
+#define GL_CONTEXT_FLAG_DEBUG_BIT       0x00000002
+typedef void(APIENTRYP PFNGLDEBUGMESSAGECALLBACKPROC)(GLDEBUGPROC callback, const void *user_param);
+typedef void(APIENTRYP PFNGLDEBUGMESSAGECONTROLPROC)(GLenum source, GLenum type, GLenum severity,
+                                                     GLsizei count, const GLuint *ids,
+                                                     GLboolean enabled);
+typedef void(APIENTRYP PFNGLOBJECTLABELPROC)(GLenum identifier, GLuint name, GLsizei length,
+                                             const GLchar *label);
+
+
+struct GLExtension {
+    /**
+     * 查询当前上下文支持的扩展，加载扩展的函数
+     * @param loader 获取 OpenGL 函数地址的函数，和 gladLoadGLLoader 使用的相同
+     * @note 需要在 glad 初始化之后调用
+     */
+    static void init(GLADloadproc loader);
+
+    /**
+     * 当前 OpenGL 上下文是否支持某个扩展
+     * @param name 扩展的名称，例如 GL_KHR_parallel_shader_compile
+     */
+    static bool is_supported(const std::string &name) { return _extensions.contains(name); }
+
+    /**
+     * 是否支持 GL_KHR_parallel_shader_compile（或者 ARB 版本）\n
+     * 支持时，驱动会在后台线程编译着色器，可以通过 GL_COMPLETION_STATUS_KHR 无阻塞地查询状态
+     */
+    static bool parallel_shader_compile() { return _parallel_shader_compile; }
+
+    /**
+     * 是否支持 glMultiDrawElementsIndirect，并且间接绘制命令中的 baseInstance 有效\n
+     * OpenGL 4.3 之后是核心功能，之前需要 GL_ARB_multi_draw_indirect 和 GL_ARB_base_instance
+     */
+    static bool multi_draw_indirect() { return _multi_draw_elements_indirect != nullptr; }
+
+    /// 不支持时为 nullptr
+    static PFNGLMULTIDRAWELEMENTSINDIRECTPROC multi_draw_elements_indirect()
+    {
+        return _multi_draw_elements_indirect;
+    }
+
+    /**
+     * 是否支持 GL_KHR_debug：通过回调函数接收驱动的错误和警告，以及为对象设置名称\n
+     * OpenGL 4.3 之后是核心功能
+     */
+    static bool debug_output() { return _debug_message_callback != nullptr; }
+
+    /// 不支持时为 nullptr
+    static PFNGLDEBUGMESSAGECALLBACKPROC debug_message_callback()
+    {
+        return _debug_message_callback;
+    }
+    static PFNGLDEBUGMESSAGECONTROLPROC debug_message_control() { return _debug_message_control; }
+    static PFNGLOBJECTLABELPROC         object_label() { return _object_label; }
+
+    /// 用于获取扩展函数地址的函数
+    static GLADloadproc loader() { return _loader; }
+
+private:
+    /// 统计绘制调用时需要替换 _multi_draw_elements_indirect
+    friend struct DrawCounterHooks;
+
+    static inline GLADloadproc                    _loader = nullptr;
+    static inline std::unordered_set<std::string> _extensions;
+
+    static inline bool _parallel_shader_compile = false;
+
+    static inline PFNGLMULTIDRAWELEMENTSINDIRECTPROC _multi_draw_elements_indirect = nullptr;
+
+    static inline PFNGLDEBUGMESSAGECALLBACKPROC _debug_message_callback = nullptr;
+    static inline PFNGLDEBUGMESSAGECONTROLPROC  _debug_message_control  = nullptr;
+    static inline PFNGLOBJECTLABELPROC          _object_label           = nullptr;
+};
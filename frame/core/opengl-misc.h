@@ -1,7 +1,10 @@
 #pragma once
 
 #include <array>
+#include <string>
 #include <vector>
+#include <utility>
+#include <unordered_map>
 
 #include <glad/glad.h>
 
@@ -9,12 +12,18 @@
 
 
 /**
- * 使用 OpenGL 的接口检查错误信息
+ * 使用 OpenGL 的接口检查错误信息\n
+ * 启用了 GLDebug 时不调用 glGetError，只记录位置，错误由回调函数报告
  */
 void check_gl_error(const char *file, int line);
 
 
+/// release 模式下没有任何开销，错误只能通过 GLDebug 的回调函数报告
+#ifdef NDEBUG
+#define CHECK_GL_ERROR() ((void) 0)
+#else
 #define CHECK_GL_ERROR() check_gl_error(__FILE_NAME__, __LINE__)
+#endif
 
 
 /**
@@ -167,6 +176,22 @@ struct TexCubeInfo {
 GLuint new_cubemap(const TexCubeInfo &info);
 
 
+/**
+ * 着色器的宏定义列表，格式为 (name, value)，value 可以为空\n
+ * 例如：{{"HAS_TEX_BASECOLOR", ""}, {"SHADOW_TYPE", "2"}}
+ */
+using ShaderDefines = std::vector<std::pair<std::string, std::string>>;
+
+
+/**
+ * 读取 glsl 文件，展开 include，并在 #version 之后注入宏定义\n
+ * 支持两种 include 的写法：#include "file.glsl" 以及 m4 风格的 include(file.glsl)\n
+ * 先在当前文件所在的目录中查找，然后在 frame/shader 中查找
+ * @note 同一个文件只会被展开一次
+ */
+std::string glsl_preprocess(const std::string &file_path, const ShaderDefines &defines = {});
+
+
 /**
  * 从文件读取着色器文本，编译成着色器对象
  * @param shader_type 着色器类型，可以是 GL_FRAGMENT_SHADER 或 GL_VERTEX_SHADER
@@ -177,4 +202,46 @@ GLuint shader_compile(const std::string &file_path, GLenum shader_type);
 /**
  * 链接多个着色器对象，变成 program
  */
-GLuint shader_link(GLuint vertex, GLuint fragment, GLuint geometry = 0);
\ No newline at end of file
+GLuint shader_link(GLuint vertex, GLuint fragment, GLuint geometry = 0);
+
+
+/**
+ * 从文件读取着色器文本，提交编译，但是不检查编译结果
+ * @note 查询 GL_COMPILE_STATUS 会等待驱动完成编译，因此将检查推迟到 shader_check_compile
+ */
+GLuint shader_compile_submit(const std::string &file_path, GLenum shader_type,
+                             const ShaderDefines &defines = {});
+
+
+/**
+ * 提交着色器源码的编译，但是不检查编译结果
+ * @param source 已经预处理过的完整源码
+ */
+GLuint shader_compile_source_submit(const std::string &source, GLenum shader_type);
+
+
+/**
+ * 检查着色器的编译结果，如果编译失败，就打印日志并抛出异常
+ * @param name 用于日志的名称，例如文件路径
+ */
+void shader_check_compile(GLuint shader_id, const std::string &name);
+
+
+/**
+ * 提交 program 的链接，但是不检查链接结果
+ * @note 着色器对象会被标记为删除，program 被删除时才会真正释放
+ */
+GLuint shader_link_submit(GLuint vertex, GLuint fragment, GLuint geometry = 0);
+
+
+/**
+ * 检查 program 的链接结果，如果链接失败，会同时检查各个着色器的编译结果，然后抛出异常
+ * @param name 用于日志的名称
+ */
+void shader_check_link(GLuint program_id, const std::string &name);
+
+
+/**
+ * 目前为止创建的 program 数量
+ */
+size_t shader_program_cnt();
\ No newline at end of file
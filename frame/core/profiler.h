@@ -0,0 +1,302 @@
+/**
+ * 帧分析：每个 pass 的 CPU 耗时和 GPU 耗时\n
+ * 结果写入一个无锁的环形缓冲，在 ImGui 中显示滚动的 p50/p95/p99，
+ * 也可以导出为 Chrome trace（chrome://tracing 或者 Perfetto 打开）以及 CSV
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <glad/glad.h>
+
+
+/**
+ * 一个 scope 的一次测量，时间的单位都是微秒，起点是第一次使用 Profiler 的时刻
+ */
+struct ProfileSample {
+    uint32_t name_id;
+    uint32_t depth;     // 同一个线程内的嵌套深度，0 是最外层
+    uint32_t thread;    // 线程的编号，按照第一次记录的顺序分配
+    uint32_t seq;       // 在所在的帧、所在的线程中开始的顺序
+    uint64_t frame;
+
+    double cpu_begin;
+    double cpu_time;
+    double gpu_begin;    // 已经转换到 CPU 的时间轴
+    double gpu_time;     // 小于 0 表示没有 GPU 计时
+
+    [[nodiscard]] bool has_gpu() const { return gpu_time >= 0.0; }
+};
+
+
+/**
+ * @brief 多个线程写入、一个线程读取的定长环形缓冲，写满之后覆盖最旧的数据
+ * 写入时用 fetch_add 占据一个位置，每个位置有一个序号，写入前后各修改一次（seqlock）；
+ * 读取时如果前后两次读到的序号不同，或者和期望的不同，说明这个位置正在被写入或者已经被覆盖，
+ * 直接跳过，因此读写双方都不需要加锁\n
+ * 数据按 8 字节拆开，用 relaxed 原子操作读写，读取和写入重叠时也不会产生数据竞争
+ */
+template<typename T, size_t N>
+class ProfileRing
+{
+    static_assert((N & (N - 1)) == 0, "capacity must be power of 2.");
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable.");
+
+public:
+    void push(const T &value)
+    {
+        const uint64_t idx  = _head.fetch_add(1, std::memory_order_relaxed);
+        Slot          &slot = _slots[idx & (N - 1)];
+        slot.seq.store(2 * idx + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        store(slot, value);
+        slot.seq.store(2 * idx + 2, std::memory_order_release);
+    }
+
+    /**
+     * 读取序号在 [from, head) 之间、仍然保存在缓冲中的数据
+     * @return head，下一次从这里开始读
+     */
+    uint64_t read(uint64_t from, std::vector<T> &out) const
+    {
+        const uint64_t head = _head.load(std::memory_order_acquire);
+        for (uint64_t idx = std::max(from, head > N ? head - N : 0); idx < head; ++idx)
+        {
+            const Slot    &slot = _slots[idx & (N - 1)];
+            const uint64_t seq  = slot.seq.load(std::memory_order_acquire);
+            if (seq != 2 * idx + 2)
+                continue;
+            T value = load(slot);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == seq)
+                out.push_back(value);
+        }
+        return head;
+    }
+
+    [[nodiscard]] uint64_t head() const { return _head.load(std::memory_order_acquire); }
+
+private:
+    static constexpr size_t WORD_CNT = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    struct Slot {
+        std::atomic<uint64_t>                        seq{0};
+        std::array<std::atomic<uint64_t>, WORD_CNT> words{};
+    };
+
+    static void store(Slot &slot, const T &value)
+    {
+        uint64_t words[WORD_CNT]{};
+        std::memcpy(words, &value, sizeof(T));
+        for (size_t i = 0; i < WORD_CNT; ++i)
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    static T load(const Slot &slot)
+    {
+        uint64_t words[WORD_CNT];
+        for (size_t i = 0; i < WORD_CNT; ++i)
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+    std::array<Slot, N>   _slots;
+    std::atomic<uint64_t> _head{0};
+};
+
+
+/**
+ * @brief 帧分析器，通过静态成员管理，和 ShaderLib 类似
+ * CPU 计时使用 steady_clock；GPU 计时在 scope 的开始和结束各插入一个 GL_TIMESTAMP 查询，
+ * 查询结果在 QUERY_LATENCY 帧之后才读取，读取时如果结果还没有准备好就放弃这次的 GPU 计时，
+ * 因此永远不会等待 GPU\n
+ * Engine 在每一帧的开始和结束调用 begin_frame 和 end_frame，项目中用 PROFILE_SCOPE 标记 pass
+ */
+class Profiler
+{
+public:
+    /// 查询结果延迟读取的帧数，也是查询对象的组数
+    static constexpr int QUERY_LATENCY = 3;
+
+    /// 每个 scope 保留最近多少次的测量，用于计算百分位数
+    static constexpr size_t WINDOW_SIZE = 256;
+
+    /// 环形缓冲的容量，也是导出时最多包含的测量数量
+    static constexpr size_t RING_CAPACITY = 1 << 16;
+
+    struct Percentiles {
+        float p50 = 0.f;
+        float p95 = 0.f;
+        float p99 = 0.f;
+    };
+
+    /**
+     * 每个 scope 的滚动统计，单位是毫秒
+     */
+    struct Stats {
+        uint32_t name_id;
+        uint32_t depth;
+        uint32_t thread;
+        uint64_t order;    // 第 0 帧（主循环之前）的 scope 排在前面，之后按照 seq 排序
+
+        Percentiles cpu;
+        Percentiles gpu;    // 全为 0 表示没有 GPU 计时
+        size_t      cnt;
+    };
+
+    static bool enabled() { return _enabled.load(std::memory_order_relaxed); }
+    static void set_enabled(bool enabled) { _enabled.store(enabled, std::memory_order_relaxed); }
+
+    /**
+     * 注册 scope 的名称，同一个名称总是返回同一个编号，线程安全
+     */
+    static uint32_t name_id(const char *name);
+    static std::string name(uint32_t id);
+
+    /**
+     * 读取 QUERY_LATENCY 帧之前的 GPU 查询结果，并开始新的一帧，需要在 OpenGL 线程调用
+     */
+    static void begin_frame();
+
+    /**
+     * 把这一帧的测量加入滚动统计
+     */
+    static void end_frame();
+
+    [[nodiscard]] static uint64_t frame() { return _frame.load(std::memory_order_relaxed); }
+
+    /**
+     * 所有 scope 的统计，按照线程和最近一次的开始时间排序，也就是一帧中的执行顺序
+     */
+    static std::vector<Stats> stats();
+
+    /**
+     * GPU 结果没有及时准备好、被放弃的次数
+     */
+    static size_t dropped_gpu_cnt() { return _dropped_gpu_cnt.load(std::memory_order_relaxed); }
+
+    /**
+     * 在 ImGui 窗口中显示统计，需要在 ImGui::NewFrame 和 ImGui::Render 之间调用
+     */
+    static void draw_gui();
+
+    /**
+     * 导出环形缓冲中所有的测量，GPU 的测量在单独的 "GPU" 线程中
+     * @return 是否成功写入文件
+     */
+    static bool export_chrome_trace(const std::string &path);
+
+    /**
+     * 导出为 CSV，每行一次测量：frame,thread,depth,name,cpu_begin_us,cpu_us,gpu_begin_us,gpu_us
+     */
+    static bool export_csv(const std::string &path);
+
+private:
+    friend class ProfileScope;
+
+    Profiler() = default;
+
+    /**
+     * 开始一个 scope
+     * @return GPU 查询的下标，没有 GPU 计时时为 -1
+     */
+    static int begin_gpu_query();
+
+    /**
+     * 记录一个 scope 的结束，有 GPU 计时时先挂起，等查询结果准备好之后再写入环形缓冲
+     */
+    static void end_scope(const ProfileSample &sample, int query_begin);
+
+    /**
+     * 当前线程的编号
+     */
+    static uint32_t thread_index();
+
+    /**
+     * 从起点开始的微秒数
+     */
+    static double now_us();
+
+    static inline std::atomic<bool>     _enabled{true};
+    static inline std::atomic<uint64_t> _frame{0};
+    static inline std::atomic<size_t>   _dropped_gpu_cnt{0};
+
+    static inline ProfileRing<ProfileSample, RING_CAPACITY> _ring;
+    static inline uint64_t                                   _read_pos = 0;
+
+    /// 一帧中挂起的 GPU 测量，以及这一帧使用的查询对象
+    struct FrameQueries {
+        uint64_t                   frame = 0;
+        std::vector<GLuint>        queries;
+        size_t                     query_cnt = 0;
+        std::vector<ProfileSample> pending;
+        std::vector<int>           pending_queries;    // 每个挂起的测量开始的查询下标
+
+        /// 同一时刻的 GPU 时间戳（纳秒）和 CPU 时间（微秒），用于转换到 CPU 的时间轴
+        int64_t gpu_ref = 0;
+        double  cpu_ref = 0.0;
+    };
+    static std::array<FrameQueries, QUERY_LATENCY> _frame_queries;
+
+    /// GPU 是否支持 GL_TIMESTAMP 查询，第一次 begin_frame 时检查
+    static inline int _gpu_supported = -1;
+
+    /// 每个 scope 的滚动窗口，以 name_id 和线程区分
+    struct Rolling {
+        Stats                          stats{};
+        std::array<float, WINDOW_SIZE> cpu{};
+        std::array<float, WINDOW_SIZE> gpu{};
+        size_t                         gpu_cnt = 0;
+    };
+    static std::vector<Rolling> _rollings;
+
+    static void resolve(FrameQueries &fq);
+};
+
+
+/**
+ * @brief 测量所在作用域的 CPU 耗时，gpu 为 true 时同时测量 GPU 耗时
+ * @note GPU 计时只能在 OpenGL 线程使用；其他线程应该使用 PROFILE_CPU_SCOPE
+ */
+class ProfileScope
+{
+public:
+    explicit ProfileScope(uint32_t name_id, bool gpu = true);
+    ~ProfileScope();
+
+    ProfileScope(const ProfileScope &)            = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    ProfileSample _sample{};
+    int           _query_begin = -1;
+    bool          _active      = false;
+};
+
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b)       PROFILE_CONCAT_INNER(a, b)
+
+/**
+ * 测量当前作用域的 CPU 和 GPU 耗时，name 需要是字符串常量，例如 PROFILE_SCOPE("ssr pass")
+ */
+#define PROFILE_SCOPE(name)                                                                        \
+    static const uint32_t PROFILE_CONCAT(_profile_id_, __LINE__) = Profiler::name_id(name);        \
+    ProfileScope          PROFILE_CONCAT(_profile_scope_, __LINE__)(                               \
+            PROFILE_CONCAT(_profile_id_, __LINE__), true)
+
+/**
+ * 只测量 CPU 耗时，可以在任意线程使用
+ */
+#define PROFILE_CPU_SCOPE(name)                                                                    \
+    static const uint32_t PROFILE_CONCAT(_profile_id_, __LINE__) = Profiler::name_id(name);        \
+    ProfileScope          PROFILE_CONCAT(_profile_scope_, __LINE__)(                               \
+            PROFILE_CONCAT(_profile_id_, __LINE__), false)
@@ -0,0 +1,86 @@
+/**
+ * 渲染队列：按照 sort key 对绘制调用排序，减少着色器和纹理的切换
+ */
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "./shader.h"
+#include "./rt-object.h"
+
+
+/**
+ * 一次绘制调用
+ */
+struct RenderItem {
+    uint64_t        sort_key;
+    Shader2        *shader;
+    const RTObject *obj;
+};
+
+
+/**
+ * 一次实例化绘制：几何、着色器、材质特性、纹理都相同的连续 RenderItem 合并而成
+ */
+struct RenderBatch {
+    Shader2        *shader;
+    const RTObject *obj;               // 第一个实例，用于获取几何和纹理
+    uint32_t        first_instance;    // 在 instances() 中的起始位置
+    uint32_t        instance_cnt;
+};
+
+
+/**
+ * @brief 按照着色器变体、材质特性、纹理、几何的顺序排序的渲染队列
+ * sort key 的布局（从高位到低位）：\n
+ * [63, 48] 着色器变体在队列中的序号；[47, 32] MaterialFeatures；[31, 16] basecolor 纹理；
+ * [15, 0] VAO\n
+ * 纹理和 VAO 只取低 16 位，只影响排序的效果，合并 batch 时会比较完整的值
+ */
+class RenderQueue
+{
+public:
+    void clear()
+    {
+        _items.clear();
+        _shader_idx.clear();
+        _batches.clear();
+        _instances.clear();
+    }
+
+    /**
+     * 添加一次绘制调用，shader 一般是根据 obj 的材质特性选出的变体
+     */
+    void push(Shader2 &shader, const RTObject &obj);
+
+    /**
+     * 按照 sort key 排序，相同变体的绘制调用会相邻
+     */
+    void sort();
+
+    [[nodiscard]] const std::vector<RenderItem> &items() const { return _items; }
+
+    /**
+     * 在 sort 之后调用：将可以实例化绘制的相邻 RenderItem 合并成 batch，并生成每个实例的数据\n
+     * 材质中的 base_color、metallic、roughness 放在实例数据中，不会阻止合并
+     */
+    void build_batches();
+
+    [[nodiscard]] const std::vector<RenderBatch>  &batches() const { return _batches; }
+    [[nodiscard]] const std::vector<InstanceData> &instances() const { return _instances; }
+
+    /**
+     * 队列中用到的着色器变体数量
+     */
+    [[nodiscard]] size_t permutation_cnt() const { return _shader_idx.size(); }
+
+private:
+    std::vector<RenderItem>   _items;
+    std::vector<RenderBatch>  _batches;
+    std::vector<InstanceData> _instances;
+
+    /// 着色器变体 -> 在队列中的序号，用序号作为 key 而不是 program id，避免等待着色器链接完成
+    std::unordered_map<const Shader2 *, uint16_t> _shader_idx;
+};
@@ -47,5 +47,16 @@ struct RTObject : public RTObjectBase {
     {}
 
 
+    /**
+     * 世界坐标系下的包围盒
+     */
+    [[nodiscard]] AABB world_aabb() const { return mesh.aabb.transform(matrix()); }
+
+    /**
+     * 世界坐标系下的包围球
+     */
+    [[nodiscard]] BoundingSphere world_sphere() const { return mesh.sphere.transform(matrix()); }
+
+
     Mesh2 mesh;
 };
\ No newline at end of file
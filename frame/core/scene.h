@@ -0,0 +1,192 @@
+/**
+ * 场景容器：物体通过稳定的句柄访问，组件以 SoA 的方式连续存放在数组中，
+ * mesh 和 material 在场景内去重，每个物体只保存它们的下标
+ */
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <span>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "./bounds.h"
+#include "./rt-object.h"
+
+
+/// 去重之后的 mesh 和 material 在场景中的下标
+using MeshId     = uint32_t;
+using MaterialId = uint32_t;
+
+
+/**
+ * 物体的句柄：slot 的下标以及 slot 的代数\n
+ * 物体被删除之后 slot 的代数会增加，旧的句柄因此失效，不会误用到新的物体
+ */
+struct SceneHandle {
+    uint32_t slot       = UINT32_MAX;
+    uint32_t generation = 0;
+
+    [[nodiscard]] bool valid() const { return slot != UINT32_MAX; }
+
+    bool operator==(const SceneHandle &) const = default;
+};
+
+
+/**
+ * 场景的只读视图，不持有任何数据，可以直接按值传递\n
+ * 下标 i 表示第 i 个物体（稠密的下标），和剔除结果中的下标一致
+ * @note 场景增删物体之后，之前得到的视图失效
+ */
+struct SceneView {
+    std::span<const glm::mat4>  matrices;        // 世界坐标系下的位姿
+    std::span<const MeshId>     mesh_ids;
+    std::span<const MaterialId> material_ids;
+    std::span<const AABB>       bounds;          // 世界坐标系下的包围盒
+
+    std::span<const Mesh2>    meshes;       // 去重之后的 mesh，以 MeshId 索引
+    std::span<const Material> materials;    // 去重之后的 material，以 MaterialId 索引
+
+    [[nodiscard]] size_t size() const { return matrices.size(); }
+    [[nodiscard]] bool   empty() const { return matrices.empty(); }
+
+    [[nodiscard]] const Mesh2    &mesh(size_t i) const { return meshes[mesh_ids[i]]; }
+    [[nodiscard]] const Material &material(size_t i) const { return materials[material_ids[i]]; }
+
+    /**
+     * 连续的一部分物体，共享同一个 mesh 和 material 表
+     */
+    [[nodiscard]] SceneView subview(size_t first, size_t cnt) const
+    {
+        return {matrices.subspan(first, cnt), mesh_ids.subspan(first, cnt),
+                material_ids.subspan(first, cnt), bounds.subspan(first, cnt), meshes, materials};
+    }
+};
+
+
+/**
+ * @brief 场景容器
+ * 组件（位姿、mesh、material、包围盒）分别存放在连续的数组中，删除物体时用最后一个物体填补空位，
+ * 因此遍历总是连续的。外部通过句柄引用物体，句柄到数组下标的映射由 slot 表维护\n
+ * 添加物体时 mesh 的几何数据只增加引用计数，material 按内容去重，
+ * 场景的复制和遍历都不需要复制 Mesh2 和 Material 中的字符串
+ */
+class Scene
+{
+public:
+    /**
+     * 添加一个物体
+     * @param mesh 只会使用 mesh 的几何数据，material 取自 mesh.mat
+     */
+    SceneHandle add(const Mesh2 &mesh, const glm::mat4 &matrix = glm::mat4(1.f));
+    SceneHandle add(const RTObject &obj) { return add(obj.mesh, obj.matrix()); }
+
+    /**
+     * 添加一个物体，使用已经去重的材质，不需要再查找 material 表，适合大量共享材质的物体
+     * @param material add_material 的返回值，mesh.mat 被忽略
+     */
+    SceneHandle add(const Mesh2 &mesh, MaterialId material,
+                    const glm::mat4 &matrix = glm::mat4(1.f));
+
+    /**
+     * 把材质加入 material 表，内容相同的材质只会保存一份
+     */
+    MaterialId add_material(const Material &mat) { return intern_material(mat); }
+
+    /**
+     * 添加一组物体，例如 ModelManager::load 的结果
+     * @return 每个物体的句柄
+     */
+    std::vector<SceneHandle> add(const std::vector<RTObject> &objs);
+
+    /**
+     * 删除物体，最后一个物体会被移动到空出来的位置
+     * @note 句柄无效时什么都不做
+     */
+    void remove(SceneHandle handle);
+
+    /// 删除所有物体，保留 mesh 和 material 表
+    void clear();
+
+    [[nodiscard]] bool contains(SceneHandle handle) const
+    {
+        return handle.slot < _slots.size() && _slots[handle.slot].generation == handle.generation &&
+               _slots[handle.slot].dense != UINT32_MAX;
+    }
+
+    /// 句柄对应的稠密下标，句柄必须有效
+    [[nodiscard]] uint32_t index(SceneHandle handle) const { return _slots[handle.slot].dense; }
+
+    /// 稠密下标对应的句柄
+    [[nodiscard]] SceneHandle handle(uint32_t index) const
+    {
+        const uint32_t slot = _dense_to_slot[index];
+        return {slot, _slots[slot].generation};
+    }
+
+    /**
+     * 修改物体的位姿，同时更新世界坐标系下的包围盒
+     */
+    void set_matrix(SceneHandle handle, const glm::mat4 &matrix);
+
+    [[nodiscard]] const glm::mat4 &matrix(SceneHandle handle) const
+    {
+        return _matrices[index(handle)];
+    }
+
+    [[nodiscard]] size_t size() const { return _matrices.size(); }
+    [[nodiscard]] bool   empty() const { return _matrices.empty(); }
+
+    [[nodiscard]] const std::vector<glm::mat4>  &matrices() const { return _matrices; }
+    [[nodiscard]] const std::vector<MeshId>     &mesh_ids() const { return _mesh_ids; }
+    [[nodiscard]] const std::vector<MaterialId> &material_ids() const { return _material_ids; }
+    [[nodiscard]] const std::vector<AABB>       &bounds() const { return _bounds; }
+
+    [[nodiscard]] const Mesh2    &mesh(size_t i) const { return _meshes[_mesh_ids[i]]; }
+    [[nodiscard]] const Material &material(size_t i) const { return _materials[_material_ids[i]]; }
+
+    /// 去重之后的 mesh 和 material 的数量
+    [[nodiscard]] size_t mesh_cnt() const { return _meshes.size(); }
+    [[nodiscard]] size_t material_cnt() const { return _materials.size(); }
+
+    [[nodiscard]] SceneView view() const
+    {
+        return {_matrices, _mesh_ids, _material_ids, _bounds, _meshes, _materials};
+    }
+
+    /**
+     * 场景占用的内存（字节），包括数组的容量以及 mesh 和 material 中字符串的容量，
+     * 不包括 GL 资源
+     */
+    [[nodiscard]] size_t memory_usage() const;
+
+private:
+    struct Slot {
+        uint32_t dense      = UINT32_MAX;    // 物体在稠密数组中的下标，UINT32_MAX 表示空闲
+        uint32_t generation = 0;
+    };
+
+    std::vector<Slot>     _slots;
+    std::vector<uint32_t> _free_slots;
+    std::vector<uint32_t> _dense_to_slot;
+
+    /// 组件，以稠密下标索引
+    std::vector<glm::mat4>  _matrices;
+    std::vector<MeshId>     _mesh_ids;
+    std::vector<MaterialId> _material_ids;
+    std::vector<AABB>       _bounds;
+
+    /// 去重之后的 mesh（不包含 material）和 material
+    std::vector<Mesh2>                                          _meshes;
+    std::vector<Material>                                       _materials;
+    std::map<std::tuple<GLuint, size_t, size_t, GLint>, MeshId> _mesh_table;
+
+    /// material 内容的 hash -> MaterialId，hash 相同时再比较完整的内容
+    std::unordered_multimap<size_t, MaterialId> _material_table;
+
+    MeshId     intern_mesh(const Mesh2 &mesh);
+    MaterialId intern_material(const Material &mat);
+};
@@ -0,0 +1,124 @@
+/**
+ * 着色器变体的管理\n
+ * 同一组着色器文件，注入不同的宏定义，就得到不同的变体。
+ * 例如根据材质是否有纹理，生成没有动态分支的着色器
+ */
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "./shader.h"
+#include "../material.h"
+
+
+/**
+ * @brief 着色器 program 的注册表
+ * 以预处理之后的 (vert, frag) 源码作为 key，宏定义已经注入到源码中，因此不同路径、相同内容的
+ * 着色器也只会创建一个 program。第一次请求某个变体时才会编译。
+ * 通过静态 map 实现资源管理，和 TextureManager 类似
+ * @note program 是共享的，uniform 也是共享的状态，绘制之前需要设置所有用到的 uniform
+ */
+class ShaderLib
+{
+public:
+    /**
+     * 获取着色器变体，如果还没有编译过，就新建一个
+     * @param defines 宏定义，顺序不影响结果
+     * @note 返回的引用在程序运行期间一直有效
+     */
+    static Shader2 &get(const std::string &vert, const std::string &frag,
+                        const ShaderDefines &defines = {});
+
+    /**
+     * 根据材质特性获取着色器变体，每个特性对应一个宏，例如 MAT_TEX_BASECOLOR 对应 HAS_TEX_BASECOLOR
+     * @param features 着色器没有用到的特性应该事先屏蔽掉，否则会产生重复的变体
+     * @param extra 其他的宏定义
+     */
+    static Shader2 &get_for_material(const std::string &vert, const std::string &frag,
+                                     MaterialFeatures features, const ShaderDefines &extra = {});
+
+    /**
+     * 材质特性对应的宏定义
+     */
+    static ShaderDefines feature_defines(MaterialFeatures features);
+
+    /**
+     * 已经请求过的变体数量，即不同的 (vert, frag, defines) 组合
+     */
+    static size_t variant_cnt() { return _variant_lut.size(); }
+
+    /**
+     * 注册表中实际创建的 program 数量
+     */
+    static size_t program_cnt() { return m.size(); }
+
+private:
+    ShaderLib() = default;
+
+    /// 预处理之后的 (vert, frag) 源码
+    using SourceKey = std::pair<std::string, std::string>;
+
+    struct SourceKeyHash {
+        size_t operator()(const SourceKey &key) const;
+    };
+
+    /// 源码 -> program，源码完整地保存在 key 中，hash 冲突时不会共享 program
+    inline static std::unordered_map<SourceKey, Shader2, SourceKeyHash> m;
+
+    /**
+     * 变体的完整标识，defines 已经排序；hash 只用于分桶，查找时比较完整的 key，
+     * 因此 hash 冲突不会返回错误的 program
+     */
+    struct VariantKey {
+        std::string   vert;
+        std::string   frag;
+        ShaderDefines defines;
+
+        bool operator==(const VariantKey &) const = default;
+    };
+
+    struct VariantKeyHash {
+        size_t operator()(const VariantKey &key) const;
+    };
+
+    /// (vert, frag, defines) -> program，避免每次都读取文件
+    inline static std::unordered_map<VariantKey, Shader2 *, VariantKeyHash> _variant_lut;
+};
+
+
+/**
+ * @brief 一组着色器文件按照材质特性产生的所有变体
+ * 每个变体第一次使用时通过 ShaderLib::get_for_material 查找，之后以 features & mask 为下标
+ * 直接从表中取出，绘制时不需要构造路径字符串、宏定义列表以及计算 hash，也不会分配内存
+ * @note mask 不能太大，表的大小是 mask + 1
+ */
+class ShaderVariants
+{
+public:
+    ShaderVariants(std::string vert, std::string frag, MaterialFeatures mask,
+                   ShaderDefines extra = {})
+        : _vert(std::move(vert)), _frag(std::move(frag)), _mask(mask), _extra(std::move(extra)),
+          _variants(mask + 1, nullptr)
+    {}
+
+    /**
+     * 材质特性对应的变体，没有用到的特性会被屏蔽掉
+     */
+    Shader2 &get(MaterialFeatures features)
+    {
+        Shader2 *&variant = _variants[features & _mask];
+        if (!variant)
+            variant = &ShaderLib::get_for_material(_vert, _frag, features & _mask, _extra);
+        return *variant;
+    }
+
+private:
+    std::string            _vert;
+    std::string            _frag;
+    MaterialFeatures       _mask;
+    ShaderDefines          _extra;
+    std::vector<Shader2 *> _variants;    // features & mask -> 变体
+};
@@ -9,12 +9,14 @@
 #pragma once
 
 #include <map>
+#include <span>
 #include <vector>
 #include <fstream>
 #include <sstream>
 #include <utility>
 #include <exception>
 #include <functional>
+#include <initializer_list>
 #include <unordered_map>
 
 #include <glad/glad.h>
@@ -23,6 +25,9 @@
 #include <spdlog/spdlog.h>
 
 #include "./opengl-misc.h"
+#include "./opengl-debug.h"
+#include "./opengl-ext.h"
+#include "./startup-trace.h"
 
 
 /**
@@ -35,6 +40,7 @@ enum UniAttrType {
     MAT3,
     VEC3,
     VEC4,
+    VEC2,
     /// 确保这个变量在最后一个位置，表示类型的总数
     _total_
 };
@@ -50,6 +56,7 @@ union UniAttrValue {
     glm::mat3 _mat3;
     glm::vec3 _vec3;
     glm::vec4 _vec4;
+    glm::vec2 _vec2;
 };
 
 
@@ -80,6 +87,9 @@ struct UniformAttribute2 {
     UniformAttribute2(std::string n, const glm::vec4 &v)
         : name(std::move(n)), type(VEC4), value({._vec4 = v})
     {}
+    UniformAttribute2(std::string n, const glm::vec2 &v)
+        : name(std::move(n)), type(VEC2), value({._vec2 = v})
+    {}
 
     static void set(GLint location, UniAttrValue value, UniAttrType type)
     {
@@ -109,27 +119,99 @@ private:
 };
 
 
+/**
+ * 着色器程序。创建分为两个阶段：\n
+ * 1. submit：构造函数中提交编译和链接，不查询状态，驱动可以在后台并行编译多个 program\n
+ * 2. resolve：第一次使用 program 时才检查编译和链接的结果
+ */
 class Shader2
 {
 public:
-    Shader2(const std::string &vert, const std::string &frag)
+    /**
+     * @param vert vertex shader 的文件路径
+     * @param frag fragment shader 的文件路径
+     * @param defines 注入到两个着色器中的宏定义，用于生成着色器变体
+     */
+    Shader2(const std::string &vert, const std::string &frag, const ShaderDefines &defines = {})
+        : _name(vert + " | " + frag)
     {
-        program_id = shader_link(shader_compile(vert, GL_VERTEX_SHADER),
-                                 shader_compile(frag, GL_FRAGMENT_SHADER));
+        StartupScope scope("shader", _name);
+        program_id = shader_link_submit(shader_compile_submit(vert, GL_VERTEX_SHADER, defines),
+                                        shader_compile_submit(frag, GL_FRAGMENT_SHADER, defines));
+        GLDebug::label(GL_PROGRAM, program_id, _name);
     }
 
-    void set_uniform(const std::vector<UniformAttribute2> &attrs);
+    /**
+     * 从预处理好的源码创建 program
+     * @param name 用于日志的名称
+     */
+    static Shader2 from_source(const std::string &name, const std::string &vert_source,
+                               const std::string &frag_source);
 
-    void use() const { glUseProgram(program_id); }
+    /**
+     * 设置多个 uniform，例如 set_uniform({{"m_view", view}, {"m_proj", proj}})\n
+     * 花括号列表直接使用 initializer_list，不会创建 vector；名字不超过 15 个字符时 std::string
+     * 不分配内存（SSO），因此每帧调用不会访问堆
+     */
+    void set_uniform(std::initializer_list<UniformAttribute2> attrs)
+    {
+        set_uniform(std::span<const UniformAttribute2>(attrs.begin(), attrs.size()));
+    }
+    void set_uniform(std::span<const UniformAttribute2> attrs);
 
-    [[nodiscard]] GLuint get_program_id() const { return program_id; }
+    /**
+     * program 中所有 active uniform 的 name -> location，链接完成后通过反射得到
+     * @note 数组只记录 name 和 name[0]
+     */
+    [[nodiscard]] const std::unordered_map<std::string, GLint> &uniforms() const
+    {
+        resolve();
+        return uniform_location_lut;
+    }
+
+    [[nodiscard]] bool has_uniform(const std::string &name) const
+    {
+        return uniforms().contains(name);
+    }
+
+    void use() const
+    {
+        resolve();
+        glUseProgram(program_id);
+    }
+
+    [[nodiscard]] GLuint get_program_id() const
+    {
+        resolve();
+        return program_id;
+    }
+
+    /**
+     * 编译和链接是否已经完成，不会阻塞
+     * @note 如果驱动不支持 parallel shader compile，无法无阻塞地查询，总是返回 true
+     */
+    [[nodiscard]] bool is_ready() const;
 
 
 private:
-    GLuint program_id;
+    Shader2() = default;
+
+    GLuint program_id{};
+
+    /// 用于日志的名称
+    std::string _name;
+
+    /// 是否已经检查过编译和链接的结果
+    mutable bool _resolved = false;
+
+    /**
+     * 检查编译和链接的结果，并反射 uniform 信息，只会执行一次
+     * @note 如果驱动还没有完成编译，这里会阻塞
+     */
+    void resolve() const;
 
     /**
      * 缓存当前 shader program 中的 uniform attribute location
      */
-    std::unordered_map<std::string, GLint> uniform_location_lut;
+    mutable std::unordered_map<std::string, GLint> uniform_location_lut;
 };
@@ -0,0 +1,275 @@
+/**
+ * 4 路 float 的 SIMD 封装，根据平台选择 SSE、NEON 或者标量实现\n
+ * 只包含剔除等 CPU 批量计算需要用到的少量操作
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RT_SIMD_SSE
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RT_SIMD_NEON
+#include <arm_neon.h>
+#else
+#define RT_SIMD_SCALAR
+#endif
+
+
+/**
+ * 4 个 float 组成的向量，比较运算的结果也用 f32x4 表示，每个分量全 1 或者全 0
+ */
+struct f32x4 {
+#if defined(RT_SIMD_SSE)
+    __m128 v;
+#elif defined(RT_SIMD_NEON)
+    float32x4_t v;
+#else
+    float v[4];
+#endif
+
+    static constexpr int WIDTH = 4;
+
+    /// 读取 4 个连续的 float，不要求对齐
+    static f32x4 load(const float *p)
+    {
+#if defined(RT_SIMD_SSE)
+        return {_mm_loadu_ps(p)};
+#elif defined(RT_SIMD_NEON)
+        return {vld1q_f32(p)};
+#else
+        return {{p[0], p[1], p[2], p[3]}};
+#endif
+    }
+
+    /**
+     * 读取 3 个连续的 float，第 4 个分量复制第 1 个分量，用于 vec3 的运算
+     * @note 会读取 p[3]，调用者需要保证 p[3] 可以访问（例如 vec3 后面紧跟着其他成员）
+     */
+    static f32x4 load3(const float *p)
+    {
+#if defined(RT_SIMD_SSE)
+        const __m128 v = _mm_loadu_ps(p);
+        return {_mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 2, 1, 0))};
+#elif defined(RT_SIMD_NEON)
+        const float32x4_t v = vld1q_f32(p);
+        return {vsetq_lane_f32(vgetq_lane_f32(v, 0), v, 3)};
+#else
+        return {{p[0], p[1], p[2], p[0]}};
+#endif
+    }
+
+    /// 4 个分量都是 x
+    static f32x4 broadcast(float x)
+    {
+#if defined(RT_SIMD_SSE)
+        return {_mm_set1_ps(x)};
+#elif defined(RT_SIMD_NEON)
+        return {vdupq_n_f32(x)};
+#else
+        return {{x, x, x, x}};
+#endif
+    }
+
+    void store(float *p) const
+    {
+#if defined(RT_SIMD_SSE)
+        _mm_storeu_ps(p, v);
+#elif defined(RT_SIMD_NEON)
+        vst1q_f32(p, v);
+#else
+        for (int i = 0; i < 4; ++i)
+            p[i] = v[i];
+#endif
+    }
+
+    friend f32x4 operator+(const f32x4 &a, const f32x4 &b)
+    {
+#if defined(RT_SIMD_SSE)
+        return {_mm_add_ps(a.v, b.v)};
+#elif defined(RT_SIMD_NEON)
+        return {vaddq_f32(a.v, b.v)};
+#else
+        return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+#endif
+    }
+
+    friend f32x4 operator-(const f32x4 &a, const f32x4 &b)
+    {
+#if defined(RT_SIMD_SSE)
+        return {_mm_sub_ps(a.v, b.v)};
+#elif defined(RT_SIMD_NEON)
+        return {vsubq_f32(a.v, b.v)};
+#else
+        return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};
+#endif
+    }
+
+    friend f32x4 operator*(const f32x4 &a, const f32x4 &b)
+    {
+#if defined(RT_SIMD_SSE)
+        return {_mm_mul_ps(a.v, b.v)};
+#elif defined(RT_SIMD_NEON)
+        return {vmulq_f32(a.v, b.v)};
+#else
+        return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};
+#endif
+    }
+
+    /// a * b + c
+    static f32x4 fmadd(const f32x4 &a, const f32x4 &b, const f32x4 &c)
+    {
+#if defined(RT_SIMD_NEON)
+        return {vmlaq_f32(c.v, a.v, b.v)};
+#else
+        return a * b + c;
+#endif
+    }
+
+    static f32x4 min(const f32x4 &a, const f32x4 &b)
+    {
+#if defined(RT_SIMD_SSE)
+        return {_mm_min_ps(a.v, b.v)};
+#elif defined(RT_SIMD_NEON)
+        return {vminq_f32(a.v, b.v)};
+#else
+        return {{std::fmin(a.v[0], b.v[0]), std::fmin(a.v[1], b.v[1]),
+                 std::fmin(a.v[2], b.v[2]), std::fmin(a.v[3], b.v[3])}};
+#endif
+    }
+
+    static f32x4 max(const f32x4 &a, const f32x4 &b)
+    {
+#if defined(RT_SIMD_SSE)
+        return {_mm_max_ps(a.v, b.v)};
+#elif defined(RT_SIMD_NEON)
+        return {vmaxq_f32(a.v, b.v)};
+#else
+        return {{std::fmax(a.v[0], b.v[0]), std::fmax(a.v[1], b.v[1]),
+                 std::fmax(a.v[2], b.v[2]), std::fmax(a.v[3], b.v[3])}};
+#endif
+    }
+
+    /// 4 个分量中的最小值
+    [[nodiscard]] float hmin() const
+    {
+#if defined(RT_SIMD_SSE)
+        __m128 m = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        m        = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(m);
+#elif defined(RT_SIMD_NEON) && defined(__aarch64__)
+        return vminvq_f32(v);
+#else
+        float a[4];
+        store(a);
+        return std::fmin(std::fmin(a[0], a[1]), std::fmin(a[2], a[3]));
+#endif
+    }
+
+    /// 4 个分量中的最大值
+    [[nodiscard]] float hmax() const
+    {
+#if defined(RT_SIMD_SSE)
+        __m128 m = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        m        = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(m);
+#elif defined(RT_SIMD_NEON) && defined(__aarch64__)
+        return vmaxvq_f32(v);
+#else
+        float a[4];
+        store(a);
+        return std::fmax(std::fmax(a[0], a[1]), std::fmax(a[2], a[3]));
+#endif
+    }
+
+    /// a >= b，结果的分量全 1 或者全 0
+    static f32x4 cmp_ge(const f32x4 &a, const f32x4 &b)
+    {
+#if defined(RT_SIMD_SSE)
+        return {_mm_cmpge_ps(a.v, b.v)};
+#elif defined(RT_SIMD_NEON)
+        return {vreinterpretq_f32_u32(vcgeq_f32(a.v, b.v))};
+#else
+        f32x4 r{};
+        for (int i = 0; i < 4; ++i)
+            r.v[i] = bits_to_float(a.v[i] >= b.v[i] ? 0xFFFFFFFFu : 0u);
+        return r;
+#endif
+    }
+
+    /// a <= b，结果的分量全 1 或者全 0
+    static f32x4 cmp_le(const f32x4 &a, const f32x4 &b) { return cmp_ge(b, a); }
+
+    /// 按位与，用于合并比较的结果
+    friend f32x4 operator&(const f32x4 &a, const f32x4 &b)
+    {
+#if defined(RT_SIMD_SSE)
+        return {_mm_and_ps(a.v, b.v)};
+#elif defined(RT_SIMD_NEON)
+        return {vreinterpretq_f32_u32(
+                vandq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)))};
+#else
+        f32x4 r{};
+        for (int i = 0; i < 4; ++i)
+            r.v[i] = bits_to_float(float_to_bits(a.v[i]) & float_to_bits(b.v[i]));
+        return r;
+#endif
+    }
+
+    /**
+     * 按分量选择：mask 的分量为全 1 时取 a，否则取 b
+     */
+    static f32x4 select(const f32x4 &mask, const f32x4 &a, const f32x4 &b)
+    {
+#if defined(RT_SIMD_SSE)
+        return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};
+#elif defined(RT_SIMD_NEON)
+        return {vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v)};
+#else
+        f32x4 r{};
+        for (int i = 0; i < 4; ++i)
+            r.v[i] = (float_to_bits(mask.v[i]) >> 31) ? a.v[i] : b.v[i];
+        return r;
+#endif
+    }
+
+    /**
+     * 取出每个分量的最高位，第 i 个分量对应第 i 位
+     */
+    [[nodiscard]] int movemask() const
+    {
+#if defined(RT_SIMD_SSE)
+        return _mm_movemask_ps(v);
+#elif defined(RT_SIMD_NEON)
+        const uint32x4_t bits   = vshrq_n_u32(vreinterpretq_u32_f32(v), 31);
+        const int32x4_t  shifts = {0, 1, 2, 3};
+        const uint32x4_t masked = vshlq_u32(bits, shifts);
+        return (int) (vgetq_lane_u32(masked, 0) | vgetq_lane_u32(masked, 1) |
+                      vgetq_lane_u32(masked, 2) | vgetq_lane_u32(masked, 3));
+#else
+        int mask = 0;
+        for (int i = 0; i < 4; ++i)
+            mask |= (int) (float_to_bits(v[i]) >> 31) << i;
+        return mask;
+#endif
+    }
+
+#if defined(RT_SIMD_SCALAR)
+private:
+    static uint32_t float_to_bits(float f)
+    {
+        uint32_t u;
+        std::memcpy(&u, &f, sizeof(u));
+        return u;
+    }
+    static float bits_to_float(uint32_t u)
+    {
+        float f;
+        std::memcpy(&f, &u, sizeof(f));
+        return f;
+    }
+#endif
+};
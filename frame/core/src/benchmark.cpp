@@ -0,0 +1,405 @@
+#include "../benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <utility>
+
+#include <json.hpp>
+#include <spdlog/spdlog.h>
+
+#include "../misc.h"
+#include "../opengl-ext.h"
+#include "../profiler.h"
+
+#if defined(__APPLE__) || defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+
+void CameraPath::record(const Camera2 &camera)
+{
+    uint32_t keys = 0;
+    for (size_t i = 0; i < std::size(KEYS); ++i)
+        if (Window::keyboard_last_action(KEYS[i]) == GLFW_PRESS)
+            keys |= 1u << i;
+
+    const auto cursor = Window::cursor_pos();
+    frames.push_back({
+            .pos      = camera.get_pos(),
+            .yaw      = camera.get_euler().yaw,
+            .pitch    = camera.get_euler().pitch,
+            .keys     = keys,
+            .rotating = Window::mouse_button_last_action(GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS,
+            .cursor   = {(float) cursor[0], (float) cursor[1]},
+    });
+}
+
+
+void CameraPath::save(const std::string &path) const
+{
+    nlohmann::json json_frames = nlohmann::json::array();
+    for (const CameraFrame &f: frames)
+        json_frames.push_back({
+                {"pos", {f.pos.x, f.pos.y, f.pos.z}},
+                {"yaw", f.yaw},
+                {"pitch", f.pitch},
+                {"keys", f.keys},
+                {"rotating", f.rotating},
+                {"cursor", {f.cursor.x, f.cursor.y}},
+        });
+
+    std::ofstream file(path);
+    if (!file.is_open())
+        LOG_AND_THROW("fail to open file: {}", path);
+    file << nlohmann::json{{"frames", json_frames}}.dump(1) << '\n';
+    SPDLOG_INFO("save camera path: {}, frames: {}", path, frames.size());
+}
+
+
+CameraPath CameraPath::load(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+        LOG_AND_THROW("fail to open file: {}", path);
+
+    CameraPath res;
+    try
+    {
+        const nlohmann::json json = nlohmann::json::parse(file);
+        for (const auto &f: json.at("frames"))
+        {
+            const auto &pos = f.at("pos");
+            res.frames.push_back({
+                    .pos      = {pos.at(0).get<float>(), pos.at(1).get<float>(),
+                                 pos.at(2).get<float>()},
+                    .yaw      = f.at("yaw").get<float>(),
+                    .pitch    = f.at("pitch").get<float>(),
+                    .keys     = f.value("keys", 0u),
+                    .rotating = f.value("rotating", false),
+                    .cursor   = {},
+            });
+            if (f.contains("cursor"))
+                res.frames.back().cursor = {f["cursor"].at(0).get<float>(),
+                                            f["cursor"].at(1).get<float>()};
+        }
+    } catch (nlohmann::json::exception &e)
+    {
+        LOG_AND_THROW("invalid camera path: {}, {}", path, e.what());
+    }
+
+    if (res.frames.empty())
+        LOG_AND_THROW("empty camera path: {}", path);
+    SPDLOG_INFO("load camera path: {}, frames: {}", path, res.frames.size());
+    return res;
+}
+
+
+/// ==================================================================
+
+
+/**
+ * 替换 glad 中绘制函数的包装函数，原来的函数保存在 orig_xxx 中
+ */
+struct DrawCounterHooks {
+    static inline PFNGLDRAWARRAYSPROC                      orig_draw_arrays;
+    static inline PFNGLDRAWELEMENTSPROC                    orig_draw_elements;
+    static inline PFNGLDRAWRANGEELEMENTSPROC               orig_draw_range_elements;
+    static inline PFNGLDRAWELEMENTSBASEVERTEXPROC          orig_draw_elements_base_vertex;
+    static inline PFNGLDRAWARRAYSINSTANCEDPROC             orig_draw_arrays_instanced;
+    static inline PFNGLDRAWELEMENTSINSTANCEDPROC           orig_draw_elements_instanced;
+    static inline PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC orig_draw_elements_instanced_bv;
+    static inline PFNGLMULTIDRAWARRAYSPROC                 orig_multi_draw_arrays;
+    static inline PFNGLMULTIDRAWELEMENTSPROC               orig_multi_draw_elements;
+    static inline PFNGLMULTIDRAWELEMENTSBASEVERTEXPROC     orig_multi_draw_elements_bv;
+    static inline PFNGLMULTIDRAWELEMENTSINDIRECTPROC       orig_multi_draw_elements_indirect;
+
+    static void count(size_t draws, size_t vertices)
+    {
+        DrawCounter::_counts.calls += 1;
+        DrawCounter::_counts.draws += draws;
+        DrawCounter::_counts.vertices += vertices;
+    }
+
+    static void APIENTRY draw_arrays(GLenum mode, GLint first, GLsizei cnt)
+    {
+        count(1, cnt);
+        orig_draw_arrays(mode, first, cnt);
+    }
+
+    static void APIENTRY draw_elements(GLenum mode, GLsizei cnt, GLenum type, const void *indices)
+    {
+        count(1, cnt);
+        orig_draw_elements(mode, cnt, type, indices);
+    }
+
+    static void APIENTRY draw_range_elements(GLenum mode, GLuint start, GLuint end, GLsizei cnt,
+                                             GLenum type, const void *indices)
+    {
+        count(1, cnt);
+        orig_draw_range_elements(mode, start, end, cnt, type, indices);
+    }
+
+    static void APIENTRY draw_elements_base_vertex(GLenum mode, GLsizei cnt, GLenum type,
+                                                   const void *indices, GLint base_vertex)
+    {
+        count(1, cnt);
+        orig_draw_elements_base_vertex(mode, cnt, type, indices, base_vertex);
+    }
+
+    static void APIENTRY draw_arrays_instanced(GLenum mode, GLint first, GLsizei cnt,
+                                               GLsizei instance_cnt)
+    {
+        count(1, (size_t) cnt * instance_cnt);
+        orig_draw_arrays_instanced(mode, first, cnt, instance_cnt);
+    }
+
+    static void APIENTRY draw_elements_instanced(GLenum mode, GLsizei cnt, GLenum type,
+                                                 const void *indices, GLsizei instance_cnt)
+    {
+        count(1, (size_t) cnt * instance_cnt);
+        orig_draw_elements_instanced(mode, cnt, type, indices, instance_cnt);
+    }
+
+    static void APIENTRY draw_elements_instanced_bv(GLenum mode, GLsizei cnt, GLenum type,
+                                                    const void *indices, GLsizei instance_cnt,
+                                                    GLint base_vertex)
+    {
+        count(1, (size_t) cnt * instance_cnt);
+        orig_draw_elements_instanced_bv(mode, cnt, type, indices, instance_cnt, base_vertex);
+    }
+
+    /// multi draw 的每一项都算作一次绘制，顶点数是所有项的 count 之和
+    static size_t sum_counts(const GLsizei *cnt, GLsizei draw_cnt)
+    {
+        size_t vertices = 0;
+        for (GLsizei i = 0; i < draw_cnt; ++i)
+            vertices += cnt[i];
+        return vertices;
+    }
+
+    static void APIENTRY multi_draw_arrays(GLenum mode, const GLint *first, const GLsizei *cnt,
+                                           GLsizei draw_cnt)
+    {
+        count(draw_cnt, sum_counts(cnt, draw_cnt));
+        orig_multi_draw_arrays(mode, first, cnt, draw_cnt);
+    }
+
+    static void APIENTRY multi_draw_elements(GLenum mode, const GLsizei *cnt, GLenum type,
+                                             const void *const *indices, GLsizei draw_cnt)
+    {
+        count(draw_cnt, sum_counts(cnt, draw_cnt));
+        orig_multi_draw_elements(mode, cnt, type, indices, draw_cnt);
+    }
+
+    static void APIENTRY multi_draw_elements_bv(GLenum mode, const GLsizei *cnt, GLenum type,
+                                                const void *const *indices, GLsizei draw_cnt,
+                                                const GLint *base_vertex)
+    {
+        count(draw_cnt, sum_counts(cnt, draw_cnt));
+        orig_multi_draw_elements_bv(mode, cnt, type, indices, draw_cnt, base_vertex);
+    }
+
+    static void APIENTRY multi_draw_elements_indirect(GLenum mode, GLenum type,
+                                                      const void *indirect, GLsizei draw_cnt,
+                                                      GLsizei stride)
+    {
+        count(draw_cnt, 0);
+        orig_multi_draw_elements_indirect(mode, type, indirect, draw_cnt, stride);
+    }
+
+    static void install()
+    {
+        orig_draw_arrays                = std::exchange(glad_glDrawArrays, draw_arrays);
+        orig_draw_elements              = std::exchange(glad_glDrawElements, draw_elements);
+        orig_draw_range_elements        = std::exchange(glad_glDrawRangeElements,
+                                                        draw_range_elements);
+        orig_draw_elements_base_vertex  = std::exchange(glad_glDrawElementsBaseVertex,
+                                                        draw_elements_base_vertex);
+        orig_draw_arrays_instanced      = std::exchange(glad_glDrawArraysInstanced,
+                                                        draw_arrays_instanced);
+        orig_draw_elements_instanced    = std::exchange(glad_glDrawElementsInstanced,
+                                                        draw_elements_instanced);
+        orig_draw_elements_instanced_bv = std::exchange(glad_glDrawElementsInstancedBaseVertex,
+                                                        draw_elements_instanced_bv);
+        orig_multi_draw_arrays      = std::exchange(glad_glMultiDrawArrays, multi_draw_arrays);
+        orig_multi_draw_elements    = std::exchange(glad_glMultiDrawElements, multi_draw_elements);
+        orig_multi_draw_elements_bv = std::exchange(glad_glMultiDrawElementsBaseVertex,
+                                                    multi_draw_elements_bv);
+        if (GLExtension::_multi_draw_elements_indirect)
+            orig_multi_draw_elements_indirect = std::exchange(
+                    GLExtension::_multi_draw_elements_indirect, multi_draw_elements_indirect);
+    }
+};
+
+
+void DrawCounter::install()
+{
+    if (_installed)
+        return;
+    _installed = true;
+    DrawCounterHooks::install();
+}
+
+
+/// ==================================================================
+
+
+namespace {
+
+double now_ms()
+{
+    return std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
+
+/**
+ * 有序数组的百分位数，使用最近的排名
+ */
+double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    const auto idx = (size_t) std::ceil(p * (double) sorted.size());
+    return sorted[std::clamp(idx, (size_t) 1, sorted.size()) - 1];
+}
+
+}    // namespace
+
+
+Benchmark::Benchmark(CameraPath path, int warmup, int frames)
+    : _path(std::move(path)), _warmup(std::max(warmup, 0)),
+      _frames(frames > 0 ? frames : (int) _path.frames.size())
+{
+    if (_path.frames.empty())
+        LOG_AND_THROW("benchmark needs a camera path.");
+    _frame_ms.reserve(_frames);
+    _draw_counts.reserve(_frames);
+    DrawCounter::install();
+}
+
+
+void Benchmark::tick(Camera2 &camera)
+{
+    if (_frame >= 0)
+        end_frame();
+
+    ++_frame;
+    const CameraFrame &f = _path.at(_frame < _warmup ? 0 : _frame - _warmup);
+    camera.set_pose(f.pos, f.yaw, f.pitch);
+
+    DrawCounter::reset();
+    _frame_begin = now_ms();
+}
+
+
+void Benchmark::finish()
+{
+    if (_frame >= 0)
+        end_frame();
+    _frame = -1;
+}
+
+
+void Benchmark::end_frame()
+{
+    if (_frame < _warmup)
+        return;
+    _frame_ms.push_back(now_ms() - _frame_begin);
+    _draw_counts.push_back(DrawCounter::counts());
+}
+
+
+bool Benchmark::write_report(const std::string &path, const std::string &camera_path) const
+{
+    std::vector<double> sorted = _frame_ms;
+    std::sort(sorted.begin(), sorted.end());
+    const double n    = std::max((double) sorted.size(), 1.0);
+    const double mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / n;
+    double       var  = 0.0;
+    for (double t: sorted)
+        var += (t - mean) * (t - mean);
+
+    auto draw_stats = [&](size_t DrawCounter::Counts::*field) {
+        size_t sum = 0, max = 0;
+        for (const auto &c: _draw_counts)
+        {
+            sum += c.*field;
+            max = std::max(max, c.*field);
+        }
+        return nlohmann::json{{"mean", (double) sum / n}, {"max", max}};
+    };
+
+    nlohmann::json scopes = nlohmann::json::array();
+    for (const Profiler::Stats &s: Profiler::stats())
+        scopes.push_back({
+                {"name", Profiler::name(s.name_id)},
+                {"thread", s.thread},
+                {"depth", s.depth},
+                {"cpu_ms", {{"p50", s.cpu.p50}, {"p95", s.cpu.p95}, {"p99", s.cpu.p99}}},
+                {"gpu_ms", {{"p50", s.gpu.p50}, {"p95", s.gpu.p95}, {"p99", s.gpu.p99}}},
+        });
+
+    auto gl_string = [](GLenum name) {
+        const auto *str = (const char *) glGetString(name);
+        return std::string(str ? str : "");
+    };
+
+    const nlohmann::json report = {
+            {"camera_path", camera_path},
+            {"renderer", gl_string(GL_RENDERER)},
+            {"gl_version", gl_string(GL_VERSION)},
+            {"resolution", {Window::framebuffer_width(), Window::framebuffer_height()}},
+            {"warmup_frames", _warmup},
+            {"frames", _frame_ms.size()},
+            {"frame_ms",
+             {
+                     {"min", sorted.empty() ? 0.0 : sorted.front()},
+                     {"mean", mean},
+                     {"stddev", std::sqrt(var / n)},
+                     {"p50", percentile(sorted, 0.50)},
+                     {"p90", percentile(sorted, 0.90)},
+                     {"p95", percentile(sorted, 0.95)},
+                     {"p99", percentile(sorted, 0.99)},
+                     {"max", sorted.empty() ? 0.0 : sorted.back()},
+             }},
+            {"fps", mean > 0.0 ? 1000.0 / mean : 0.0},
+            {"draw_calls", draw_stats(&DrawCounter::Counts::calls)},
+            {"draws", draw_stats(&DrawCounter::Counts::draws)},
+            {"vertices", draw_stats(&DrawCounter::Counts::vertices)},
+            {"peak_memory_mb", peak_memory_mb()},
+            {"scopes", scopes},
+            {"frame_times_ms", _frame_ms},
+    };
+
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        SPDLOG_ERROR("fail to open file: {}", path);
+        return false;
+    }
+    file << report.dump(2) << '\n';
+    SPDLOG_INFO("benchmark: {} frames, mean {:.3f} ms, p95 {:.3f} ms, p99 {:.3f} ms, report: {}",
+                _frame_ms.size(), mean, percentile(sorted, 0.95), percentile(sorted, 0.99), path);
+    return true;
+}
+
+
+double peak_memory_mb()
+{
+#if defined(__APPLE__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return (double) usage.ru_maxrss / (1024.0 * 1024.0);    // 字节
+#elif defined(__linux__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return (double) usage.ru_maxrss / 1024.0;    // KB
+#else
+    return 0.0;
+#endif
+}
@@ -0,0 +1,39 @@
+#include "../bounds.h"
+
+#include <algorithm>
+
+
+AABB AABB::transform(const glm::mat4 &matrix) const
+{
+    if (!valid())
+        return *this;
+
+    /// Arvo 的方法：新的中心由矩阵变换得到，新的半边长是 |M| * extent
+    const glm::vec3 c = glm::vec3(matrix * glm::vec4(center(), 1.f));
+    const glm::vec3 e = extent();
+    const glm::vec3 new_e =
+            glm::abs(glm::vec3(matrix[0])) * e.x + glm::abs(glm::vec3(matrix[1])) * e.y +
+            glm::abs(glm::vec3(matrix[2])) * e.z;
+
+    return {.min = c - new_e, .max = c + new_e};
+}
+
+
+BoundingSphere BoundingSphere::from_aabb(const AABB &aabb)
+{
+    if (!aabb.valid())
+        return {};
+    return {.center = aabb.center(), .radius = glm::length(aabb.extent())};
+}
+
+
+BoundingSphere BoundingSphere::transform(const glm::mat4 &matrix) const
+{
+    if (!valid())
+        return *this;
+
+    const float scale = std::sqrt(std::max({glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0])),
+                                            glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1])),
+                                            glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2]))}));
+    return {.center = glm::vec3(matrix * glm::vec4(center, 1.f)), .radius = radius * scale};
+}
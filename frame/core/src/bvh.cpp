@@ -0,0 +1,349 @@
+#include "../bvh.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../job-system.h"
+
+
+namespace {
+
+constexpr int   BIN_CNT       = 16;     // binned SAH 中每个轴的桶数量
+constexpr float TRAVERSE_COST = 1.f;    // 遍历一个节点的代价，相对于和一个图元求交的代价
+
+struct Bin {
+    AABB     bounds;
+    uint32_t cnt = 0;
+};
+
+/// 中心点落在哪个桶中
+int bin_index(float centroid, float lo, float scale)
+{
+    return std::min(BIN_CNT - 1, (int) ((centroid - lo) * scale));
+}
+
+}    // namespace
+
+
+void BVH::build(const std::vector<AABB> &prim_bounds, const BuildOptions &options)
+{
+    _nodes.clear();
+    _prim_indices.clear();
+    _node_cnt = 0;
+    if (prim_bounds.empty())
+        return;
+
+    const auto n = (uint32_t) prim_bounds.size();
+
+    /// 没有包围盒的图元以原点作为中心，避免划分时出现 NaN
+    std::vector<glm::vec3> centroids(n);
+    for (uint32_t i = 0; i < n; ++i)
+        centroids[i] = prim_bounds[i].valid() ? prim_bounds[i].center() : glm::vec3(0.f);
+
+    _prim_indices.resize(n);
+    for (uint32_t i = 0; i < n; ++i)
+        _prim_indices[i] = i;
+
+    /// 最多 2N - 1 个节点；下标 1 空出来，使得兄弟节点从偶数下标开始，落在同一个 cache line 中
+    _nodes.resize(2 * (size_t) n + 1);
+    _nodes[0] = {.left_first = 0, .prim_cnt = n};
+    _node_cnt = 2;
+
+    subdivide(0, prim_bounds, centroids, options, 0);
+
+    _nodes.resize(_node_cnt);
+    _nodes.shrink_to_fit();
+}
+
+
+void BVH::update_leaf_bounds(BVHNode &node, const std::vector<AABB> &prim_bounds) const
+{
+    AABB bounds;
+    for (uint32_t i = 0; i < node.prim_cnt; ++i)
+        bounds.expand(prim_bounds[_prim_indices[node.left_first + i]]);
+    node.bb_min = bounds.min;
+    node.bb_max = bounds.max;
+}
+
+
+void BVH::subdivide(uint32_t node_idx, const std::vector<AABB> &prim_bounds,
+                    const std::vector<glm::vec3> &centroids, const BuildOptions &options,
+                    int depth)
+{
+    BVHNode &node = _nodes[node_idx];
+    update_leaf_bounds(node, prim_bounds);
+
+    const uint32_t first = node.left_first;
+    const uint32_t cnt   = node.prim_cnt;
+    if (cnt <= 1 || depth >= MAX_DEPTH - 1)
+        return;
+
+    /// 中心点的包围盒，桶是在这个范围内划分的
+    AABB centroid_bounds;
+    for (uint32_t i = 0; i < cnt; ++i)
+        centroid_bounds.expand(centroids[_prim_indices[first + i]]);
+
+    /// 在三个轴上分别计算每个划分位置的 SAH 代价，选出最小的
+    float best_cost  = FLT_MAX;
+    int   best_axis  = -1;
+    int   best_split = 0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const float lo = centroid_bounds.min[axis];
+        const float hi = centroid_bounds.max[axis];
+        if (hi <= lo)
+            continue;
+
+        Bin         bins[BIN_CNT];
+        const float scale = (float) BIN_CNT / (hi - lo);
+        for (uint32_t i = 0; i < cnt; ++i)
+        {
+            const uint32_t prim = _prim_indices[first + i];
+            const int      b    = bin_index(centroids[prim][axis], lo, scale);
+            bins[b].bounds.expand(prim_bounds[prim]);
+            bins[b].cnt++;
+        }
+
+        /// 从两边分别扫描，得到每个划分位置左右两侧的面积和数量
+        float    left_area[BIN_CNT - 1], right_area[BIN_CNT - 1];
+        uint32_t left_cnt[BIN_CNT - 1], right_cnt[BIN_CNT - 1];
+        AABB     left_box, right_box;
+        uint32_t left_sum = 0, right_sum = 0;
+        for (int i = 0; i < BIN_CNT - 1; ++i)
+        {
+            left_sum += bins[i].cnt;
+            left_cnt[i] = left_sum;
+            left_box.expand(bins[i].bounds);
+            left_area[i] = left_box.surface_area();
+
+            right_sum += bins[BIN_CNT - 1 - i].cnt;
+            right_cnt[BIN_CNT - 2 - i] = right_sum;
+            right_box.expand(bins[BIN_CNT - 1 - i].bounds);
+            right_area[BIN_CNT - 2 - i] = right_box.surface_area();
+        }
+
+        for (int i = 0; i < BIN_CNT - 1; ++i)
+        {
+            if (left_cnt[i] == 0 || right_cnt[i] == 0)
+                continue;
+            const float cost =
+                    (float) left_cnt[i] * left_area[i] + (float) right_cnt[i] * right_area[i];
+            if (cost < best_cost)
+            {
+                best_cost  = cost;
+                best_axis  = axis;
+                best_split = i;
+            }
+        }
+    }
+
+    /// 所有图元的中心重合，无法划分
+    if (best_axis < 0)
+        return;
+
+    /// 划分的代价（加上遍历一个节点的代价）比直接作为叶子更高时，停止划分
+    const AABB  node_bounds{.min = node.bb_min, .max = node.bb_max};
+    const float node_area = node_bounds.surface_area();
+    const float leaf_cost = (float) cnt * node_area;
+    if (cnt <= options.max_leaf_size && best_cost + TRAVERSE_COST * node_area >= leaf_cost)
+        return;
+
+    /// 按照桶的位置原地划分图元
+    const float lo    = centroid_bounds.min[best_axis];
+    const float scale = (float) BIN_CNT / (centroid_bounds.max[best_axis] - lo);
+    auto        mid   = std::partition(_prim_indices.begin() + first,
+                                       _prim_indices.begin() + first + cnt, [&](uint32_t prim) {
+                                           return bin_index(centroids[prim][best_axis], lo, scale) <=
+                                                  best_split;
+                                       });
+    const auto left_cnt = (uint32_t) (mid - (_prim_indices.begin() + first));
+    if (left_cnt == 0 || left_cnt == cnt)
+        return;
+
+    /// 两个孩子在数组中相邻；节点数组已经预先分配好，其他线程分配节点不会使引用失效
+    const uint32_t left_idx = _node_cnt.fetch_add(2);
+    _nodes[left_idx]        = {.left_first = first, .prim_cnt = left_cnt};
+    _nodes[left_idx + 1]    = {.left_first = first + left_cnt, .prim_cnt = cnt - left_cnt};
+    node.left_first         = left_idx;
+    node.prim_cnt           = 0;
+
+    /// 左右子树的图元范围不重叠，可以在不同的线程中构建；右子树交给任务系统，
+    /// 空闲的线程会窃取它，没有被窃取时由当前线程在 wait 中自己构建
+    if (options.parallel && cnt >= options.parallel_threshold)
+    {
+        TaskGroup group;
+        group.run([&, left_idx, depth] {
+            subdivide(left_idx + 1, prim_bounds, centroids, options, depth + 1);
+        });
+        subdivide(left_idx, prim_bounds, centroids, options, depth + 1);
+        group.wait();
+    } else
+    {
+        subdivide(left_idx, prim_bounds, centroids, options, depth + 1);
+        subdivide(left_idx + 1, prim_bounds, centroids, options, depth + 1);
+    }
+}
+
+
+void BVH::refit(const std::vector<AABB> &prim_bounds)
+{
+    /// 孩子的下标总是大于父节点，逆序遍历即可保证自底向上
+    for (auto i = (int64_t) _nodes.size() - 1; i >= 0; --i)
+    {
+        if (i == 1)
+            continue;
+        BVHNode &node = _nodes[i];
+        if (node.is_leaf())
+        {
+            update_leaf_bounds(node, prim_bounds);
+        } else
+        {
+            const BVHNode &left  = _nodes[node.left_first];
+            const BVHNode &right = _nodes[node.left_first + 1];
+            node.bb_min          = glm::min(left.bb_min, right.bb_min);
+            node.bb_max          = glm::max(left.bb_max, right.bb_max);
+        }
+    }
+}
+
+
+void BVH::query(const Frustum &frustum, std::vector<uint32_t> &out) const
+{
+    if (_nodes.empty())
+        return;
+
+    uint32_t stack[MAX_DEPTH + 1];
+    int      sp = 0;
+    stack[sp++] = 0;
+    while (sp > 0)
+    {
+        const BVHNode &node = _nodes[stack[--sp]];
+        if (!frustum.test_aabb({.min = node.bb_min, .max = node.bb_max}))
+            continue;
+
+        if (node.is_leaf())
+        {
+            for (uint32_t i = 0; i < node.prim_cnt; ++i)
+                out.push_back(_prim_indices[node.left_first + i]);
+        } else
+        {
+            stack[sp++] = node.left_first + 1;
+            stack[sp++] = node.left_first;
+        }
+    }
+}
+
+
+void MeshBVH::build(std::vector<glm::vec3> positions, std::vector<uint32_t> indices,
+                    const BVH::BuildOptions &options)
+{
+    _positions = std::move(positions);
+    _indices   = std::move(indices);
+
+    std::vector<AABB> tri_bounds(_indices.size() / 3);
+    for (size_t i = 0; i < tri_bounds.size(); ++i)
+    {
+        tri_bounds[i].expand(_positions[_indices[3 * i]]);
+        tri_bounds[i].expand(_positions[_indices[3 * i + 1]]);
+        tri_bounds[i].expand(_positions[_indices[3 * i + 2]]);
+    }
+    _bvh.build(tri_bounds, options);
+}
+
+
+TriangleHit MeshBVH::intersect(Ray &ray) const
+{
+    TriangleHit hit;
+    _bvh.traverse(ray, [&](uint32_t tri, Ray &r) {
+        const glm::vec3 &p0 = _positions[_indices[3 * tri]];
+        const glm::vec3 &p1 = _positions[_indices[3 * tri + 1]];
+        const glm::vec3 &p2 = _positions[_indices[3 * tri + 2]];
+
+        /// Möller-Trumbore
+        const glm::vec3 e1  = p1 - p0;
+        const glm::vec3 e2  = p2 - p0;
+        const glm::vec3 h   = glm::cross(r.dir, e2);
+        const float     det = glm::dot(e1, h);
+        if (std::abs(det) < 1e-8f)
+            return;
+        const float     inv_det = 1.f / det;
+        const glm::vec3 s       = r.origin - p0;
+        const float     u       = glm::dot(s, h) * inv_det;
+        if (u < 0.f || u > 1.f)
+            return;
+        const glm::vec3 q = glm::cross(s, e1);
+        const float     v = glm::dot(r.dir, q) * inv_det;
+        if (v < 0.f || u + v > 1.f)
+            return;
+        const float t = glm::dot(e2, q) * inv_det;
+        if (t <= 0.f || t >= r.t_max)
+            return;
+
+        r.t_max = t;
+        hit     = {.tri = tri, .t = t, .u = u, .v = v};
+    });
+    return hit;
+}
+
+
+void SceneBVH::update_bounds(const std::vector<RTObject> &objs)
+{
+    _bounds.resize(_prim_to_obj.size());
+    for (size_t i = 0; i < _prim_to_obj.size(); ++i)
+        _bounds[i] = objs[_prim_to_obj[i]].world_aabb();
+}
+
+
+void SceneBVH::build(const std::vector<RTObject> &objs)
+{
+    _prim_to_obj.clear();
+    _unbounded.clear();
+    for (uint32_t i = 0; i < (uint32_t) objs.size(); ++i)
+    {
+        if (objs[i].mesh.aabb.valid())
+            _prim_to_obj.push_back(i);
+        else
+            _unbounded.push_back(i);
+    }
+
+    update_bounds(objs);
+    _bvh.build(_bounds);
+}
+
+
+void SceneBVH::refit(const std::vector<RTObject> &objs)
+{
+    update_bounds(objs);
+    _bvh.refit(_bounds);
+}
+
+
+int SceneBVH::pick(Ray ray, float *t) const
+{
+    const RaySIMD ray_simd(ray);
+
+    int nearest = -1;
+    _bvh.traverse(ray, [&](uint32_t prim, Ray &r) {
+        /// 复制到节点中，保证 load3 读取的内存是合法的
+        const BVHNode box{.bb_min = _bounds[prim].min, .bb_max = _bounds[prim].max};
+        const float   t_hit = BVH::intersect_node(box, ray_simd, r.t_max);
+        if (t_hit == FLT_MAX)
+            return;
+        r.t_max = std::max(t_hit, 0.f);
+        nearest = (int) _prim_to_obj[prim];
+    });
+
+    if (t && nearest >= 0)
+        *t = ray.t_max;
+    return nearest;
+}
+
+
+void SceneBVH::cull(const glm::mat4 &vp, std::vector<uint32_t> &visible) const
+{
+    visible.clear();
+    _bvh.query(Frustum::from_matrix(vp), visible);
+    for (auto &idx: visible)
+        idx = _prim_to_obj[idx];
+    visible.insert(visible.end(), _unbounded.begin(), _unbounded.end());
+}
@@ -7,6 +7,15 @@ glm::mat4 Camera2::view_matrix() const
 }
 
 
+void Camera2::set_pose(const glm::vec3 &pos, float yaw, float pitch)
+{
+    _position   = pos;
+    euler.yaw   = yaw;
+    euler.pitch = pitch;
+    rotate_eular(0.0, 0.0);
+}
+
+
 void Camera2::tick_rotate()
 {
     std::array<double, 2> cursor_pos = Window::cursor_pos();
@@ -24,11 +33,11 @@ void Camera2::tick_move()
     /**
          * 键盘按键与方向控制的对应关系
          */
-    std::vector<std::pair<int, glm::vec3>> m = {
+    const std::array<std::pair<int, glm::vec3>, 6> m = {{
             {GLFW_KEY_W, ahead},        {GLFW_KEY_S, -ahead}, {GLFW_KEY_A, -_right_cache},
             {GLFW_KEY_D, _right_cache}, {GLFW_KEY_Q, UP},     {GLFW_KEY_E, -UP},
-    };
-    for (auto &[key, dir]: m)
+    }};
+    for (const auto &[key, dir]: m)
 
         if (Window::keyboard_last_action(key) == GLFW_PRESS)
             _position += dir * CAMERA_MOVE_SPEED;
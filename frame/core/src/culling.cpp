@@ -0,0 +1,278 @@
+#include "../culling.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+#include "../frame-arena.h"
+#include "../job-system.h"
+#include "../simd.h"
+
+
+namespace {
+
+/// 并行剔除时每段的物体数量，是 SIMD 宽度的倍数；物体少于两段时直接在当前线程剔除
+constexpr size_t CULL_CHUNK = 8192;
+
+
+/**
+ * 变换是否只包含旋转、平移和均匀缩放（且不是镜像），只有这时角度保持不变
+ */
+bool is_similarity(const glm::mat4 &model)
+{
+    const glm::vec3 x   = glm::vec3(model[0]);
+    const glm::vec3 y   = glm::vec3(model[1]);
+    const glm::vec3 z   = glm::vec3(model[2]);
+    const float     s   = glm::dot(x, x);
+    const float     eps = 1e-4f * s;
+    return s > 0.f && std::abs(glm::dot(y, y) - s) <= eps && std::abs(glm::dot(z, z) - s) <= eps &&
+           std::abs(glm::dot(x, y)) <= eps && std::abs(glm::dot(y, z)) <= eps &&
+           std::abs(glm::dot(z, x)) <= eps && glm::dot(glm::cross(x, y), z) > 0.f &&
+           model[0][3] == 0.f && model[1][3] == 0.f && model[2][3] == 0.f && model[3][3] == 1.f;
+}
+
+}    // namespace
+
+
+Frustum Frustum::from_matrix(const glm::mat4 &vp)
+{
+    /// glm 是列主序，vp[col][row]，这里取出矩阵的每一行
+    const glm::vec4 row0 = {vp[0][0], vp[1][0], vp[2][0], vp[3][0]};
+    const glm::vec4 row1 = {vp[0][1], vp[1][1], vp[2][1], vp[3][1]};
+    const glm::vec4 row2 = {vp[0][2], vp[1][2], vp[2][2], vp[3][2]};
+    const glm::vec4 row3 = {vp[0][3], vp[1][3], vp[2][3], vp[3][3]};
+
+    return {.planes = {row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2,
+                       row3 - row2}};
+}
+
+
+bool Frustum::test_aabb(const AABB &aabb) const
+{
+    if (!aabb.valid())
+        return true;
+
+    const glm::vec3 c = aabb.center();
+    const glm::vec3 e = aabb.extent();
+    for (const auto &plane: planes)
+    {
+        const glm::vec3 n = glm::vec3(plane);
+        if (glm::dot(n, c) + plane.w + glm::dot(glm::abs(n), e) < 0.f)
+            return false;
+    }
+    return true;
+}
+
+
+bool Frustum::test_sphere(const BoundingSphere &sphere) const
+{
+    if (!sphere.valid())
+        return true;
+
+    /// 平面没有归一化，半径需要乘以法线的长度
+    for (const auto &plane: planes)
+    {
+        const glm::vec3 n = glm::vec3(plane);
+        if (glm::dot(n, sphere.center) + plane.w < -sphere.radius * glm::length(n))
+            return false;
+    }
+    return true;
+}
+
+
+void CullingBatch::update(const std::vector<RTObject> &objs)
+{
+    resize(objs.size());
+    for (size_t i = 0; i < _cnt; ++i)
+        set_bounds(i, objs[i].world_aabb());
+}
+
+
+void CullingBatch::update(std::span<const AABB> world_bounds)
+{
+    resize(world_bounds.size());
+    for (size_t i = 0; i < _cnt; ++i)
+        set_bounds(i, world_bounds[i]);
+}
+
+
+void CullingBatch::resize(size_t cnt)
+{
+    _cnt                = cnt;
+    const size_t padded = (_cnt + f32x4::WIDTH - 1) / f32x4::WIDTH * f32x4::WIDTH;
+    for (auto *v: {&_center_x, &_center_y, &_center_z, &_extent_x, &_extent_y, &_extent_z})
+        v->assign(padded, 0.f);
+}
+
+
+void CullingBatch::set_bounds(size_t i, const AABB &aabb)
+{
+    if (!aabb.valid())
+    {
+        /// 没有包围盒，使用无穷大的包围盒，保证总是可见
+        _extent_x[i] = _extent_y[i] = _extent_z[i] = FLT_MAX;
+        return;
+    }
+    const glm::vec3 c = aabb.center();
+    const glm::vec3 e = aabb.extent();
+
+    _center_x[i] = c.x;
+    _center_y[i] = c.y;
+    _center_z[i] = c.z;
+    _extent_x[i] = e.x;
+    _extent_y[i] = e.y;
+    _extent_z[i] = e.z;
+}
+
+
+CullStats CullingBatch::cull(const glm::mat4 &vp, std::vector<uint32_t> &visible) const
+{
+    const Frustum frustum = Frustum::from_matrix(vp);
+
+    /// 每段先写到 visible 中自己的位置，之后按顺序向前移动，结果和单线程的顺序相同
+    visible.resize(_cnt);
+    size_t visible_cnt = 0;
+    if (_cnt < 2 * CULL_CHUNK)
+        visible_cnt = cull_range(frustum, 0, _cnt, visible.data());
+    else
+    {
+        const size_t        chunk_cnt = (_cnt + CULL_CHUNK - 1) / CULL_CHUNK;
+        FrameVector<size_t> chunk_visible(chunk_cnt, &FrameArena::local());
+        parallel_for(0, chunk_cnt, 1, [&](size_t c) {
+            const size_t first = c * CULL_CHUNK;
+            chunk_visible[c]   = cull_range(frustum, first, std::min(first + CULL_CHUNK, _cnt),
+                                            visible.data() + first);
+        });
+        for (size_t c = 0; c < chunk_cnt; ++c)
+        {
+            const auto first = (std::ptrdiff_t) (c * CULL_CHUNK);
+            std::copy(visible.begin() + first, visible.begin() + first + chunk_visible[c],
+                      visible.begin() + visible_cnt);
+            visible_cnt += chunk_visible[c];
+        }
+    }
+    visible.resize(visible_cnt);
+
+    return {.visible = visible_cnt, .culled = _cnt - visible_cnt};
+}
+
+
+size_t CullingBatch::cull_range(const Frustum &frustum, size_t first, size_t last,
+                                uint32_t *out) const
+{
+    const f32x4 zero = f32x4::broadcast(0.f);
+
+    size_t cnt = 0;
+    for (size_t base = first; base < last; base += f32x4::WIDTH)
+    {
+        const f32x4 cx = f32x4::load(&_center_x[base]);
+        const f32x4 cy = f32x4::load(&_center_y[base]);
+        const f32x4 cz = f32x4::load(&_center_z[base]);
+        const f32x4 ex = f32x4::load(&_extent_x[base]);
+        const f32x4 ey = f32x4::load(&_extent_y[base]);
+        const f32x4 ez = f32x4::load(&_extent_z[base]);
+
+        /// 包围盒在所有平面的内侧（或者相交）才可见：dot(n, c) + d + dot(|n|, e) >= 0
+        f32x4 inside = f32x4::cmp_ge(zero, zero);
+        for (const auto &plane: frustum.planes)
+        {
+            f32x4 dist = f32x4::broadcast(plane.w);
+            dist       = f32x4::fmadd(cx, f32x4::broadcast(plane.x), dist);
+            dist       = f32x4::fmadd(cy, f32x4::broadcast(plane.y), dist);
+            dist       = f32x4::fmadd(cz, f32x4::broadcast(plane.z), dist);
+            dist       = f32x4::fmadd(ex, f32x4::broadcast(std::abs(plane.x)), dist);
+            dist       = f32x4::fmadd(ey, f32x4::broadcast(std::abs(plane.y)), dist);
+            dist       = f32x4::fmadd(ez, f32x4::broadcast(std::abs(plane.z)), dist);
+            inside     = inside & f32x4::cmp_ge(dist, zero);
+        }
+
+        /// 最后一组可能有补齐的元素，需要去掉
+        int mask = inside.movemask();
+        if (last - base < f32x4::WIDTH)
+            mask &= (1 << (last - base)) - 1;
+        for (int i = 0; i < f32x4::WIDTH; ++i)
+            if (mask & (1 << i))
+                out[cnt++] = (uint32_t) (base + i);
+    }
+    return cnt;
+}
+
+
+void MeshletCuller::begin(const glm::mat4 &vp, const glm::vec3 &eye)
+{
+    _vp    = vp;
+    _eye   = eye;
+    _stats = {};
+}
+
+
+size_t MeshletCuller::cull(const Mesh2 &mesh, const glm::mat4 &model)
+{
+    _counts.clear();
+    _offsets.clear();
+
+    const size_t tri_total = mesh.index_cnt / 3;
+    _stats.triangles_total += tri_total;
+    if (!mesh.meshlets)
+    {
+        _stats.triangles_visible += tri_total;
+        return tri_total;
+    }
+
+    /// 在模型空间中剔除：视锥体用 vp * model 提取，视点变换到模型空间。
+    /// 球和平面的相交关系在仿射变换下不变，视锥体测试总是和世界空间中相同；
+    /// 法线锥的夹角只在相似变换下保持不变，非均匀缩放、错切或者镜像时不做背面剔除
+    const Frustum   frustum   = Frustum::from_matrix(_vp * model);
+    const glm::vec3 eye_model = glm::vec3(glm::inverse(model) * glm::vec4(_eye, 1.f));
+    const bool      cone_test = backface_culling && is_similarity(model);
+
+    const size_t index_size = mesh.index_component_type == GL_UNSIGNED_SHORT ? 2
+                              : mesh.index_component_type == GL_UNSIGNED_BYTE ? 1
+                                                                              : 4;
+    size_t tri_visible = 0;
+    size_t last_end    = SIZE_MAX;    // 上一段结束的字节偏移
+    for (const Meshlet &m: *mesh.meshlets)
+    {
+        if (!frustum.test_sphere(m.sphere))
+            continue;
+        if (cone_test && m.cone_cutoff <= 1.f &&
+            glm::dot(glm::normalize(m.cone_apex - eye_model), m.cone_axis) >= m.cone_cutoff)
+            continue;
+
+        ++_stats.meshlets_visible;
+        tri_visible += m.triangle_cnt;
+
+        /// 和上一段相邻时直接合并
+        const size_t offset = mesh.index_offset + m.first_index * index_size;
+        const auto   count  = (GLsizei) (m.triangle_cnt * 3);
+        if (offset == last_end)
+            _counts.back() += count;
+        else
+        {
+            _counts.push_back(count);
+            _offsets.push_back((const void *) offset);
+        }
+        last_end = offset + count * index_size;
+    }
+    _stats.meshlets_total += mesh.meshlets->size();
+    _stats.triangles_visible += tri_visible;
+    return tri_visible;
+}
+
+
+void MeshletCuller::draw(const Mesh2 &mesh, const glm::mat4 &model)
+{
+    cull(mesh, model);
+    if (!mesh.meshlets)
+    {
+        mesh.draw();
+        return;
+    }
+    if (_counts.empty())
+        return;
+
+    glBindVertexArray(mesh.vao);
+    glMultiDrawElements(mesh.primitive_mode, _counts.data(), mesh.index_component_type,
+                        _offsets.data(), (GLsizei) _counts.size());
+}
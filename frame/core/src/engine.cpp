@@ -0,0 +1,138 @@
+#include "../engine.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+namespace {
+
+/**
+ * 解析 "1280x720" 形式的尺寸，失败时不修改
+ */
+void parse_size(const char *str, int &width, int &height)
+{
+    int w = 0, h = 0;
+    if (std::sscanf(str, "%dx%d", &w, &h) == 2 && w > 0 && h > 0)
+    {
+        width  = w;
+        height = h;
+    } else
+        SPDLOG_WARN("invalid size: {}, expect WxH.", str);
+}
+
+
+/**
+ * 环境变量存在并且不是空字符串或者 "0"
+ */
+bool env_flag(const char *name)
+{
+    const char *value = std::getenv(name);
+    return value != nullptr && std::strcmp(value, "") != 0 && std::strcmp(value, "0") != 0;
+}
+
+
+/**
+ * 解析 "off"、"skip"、"accumulate"，失败时不修改
+ */
+void parse_idle(const char *str, IdleMode &mode)
+{
+    if (std::strcmp(str, "off") == 0)
+        mode = IdleMode::off;
+    else if (std::strcmp(str, "skip") == 0)
+        mode = IdleMode::skip;
+    else if (std::strcmp(str, "accumulate") == 0)
+        mode = IdleMode::accumulate;
+    else
+        SPDLOG_WARN("invalid idle mode: {}, expect off, skip or accumulate.", str);
+}
+
+}    // namespace
+
+
+EngineOptions EngineOptions::from_env()
+{
+    EngineOptions options;
+    options.headless = env_flag("RTR_HEADLESS");
+    options.profiler = env_flag("RTR_PROFILER");
+    if (const char *frames = std::getenv("RTR_FRAMES"))
+        options.frames = std::max(std::atoi(frames), 0);
+    if (const char *size = std::getenv("RTR_SIZE"))
+        parse_size(size, options.width, options.height);
+    if (const char *profile_out = std::getenv("RTR_PROFILE_OUT"))
+        options.profile_out = profile_out;
+    if (const char *record_path = std::getenv("RTR_RECORD"))
+        options.record_path = record_path;
+    if (const char *bench_path = std::getenv("RTR_BENCH"))
+        options.bench_path = bench_path;
+    if (const char *bench_report = std::getenv("RTR_BENCH_REPORT"))
+        options.bench_report = bench_report;
+    if (const char *warmup = std::getenv("RTR_WARMUP"))
+        options.warmup = std::max(std::atoi(warmup), 0);
+    if (const char *startup_trace = std::getenv("RTR_STARTUP_TRACE"))
+        options.startup_trace = startup_trace;
+    if (std::getenv("RTR_GL_DEBUG"))
+        options.gl_debug = env_flag("RTR_GL_DEBUG");
+    if (const char *capture = std::getenv("RTR_CAPTURE"))
+        options.capture = capture;
+    options.threaded = env_flag("RTR_THREADED");
+    if (const char *jobs = std::getenv("RTR_JOBS"))
+        options.jobs = std::max(std::atoi(jobs), 0);
+    if (const char *idle = std::getenv("RTR_IDLE"))
+        parse_idle(idle, options.idle);
+    if (const char *idle_samples = std::getenv("RTR_IDLE_SAMPLES"))
+        options.idle_samples = std::max(std::atoi(idle_samples), 1);
+    options.gl_sync = env_flag("RTR_GL_SYNC");
+    if (options.gl_sync)
+        options.gl_debug = true;
+    return options;
+}
+
+
+std::vector<std::string> Engine::parse_args(int argc, char **argv)
+{
+    std::vector<std::string> rest;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--headless") == 0)
+            _options.headless = true;
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            _options.frames = std::max(std::atoi(argv[++i]), 0);
+        else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+            parse_size(argv[++i], _options.width, _options.height);
+        else if (std::strcmp(argv[i], "--profiler") == 0)
+            _options.profiler = true;
+        else if (std::strcmp(argv[i], "--profile-out") == 0 && i + 1 < argc)
+            _options.profile_out = argv[++i];
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            _options.record_path = argv[++i];
+        else if (std::strcmp(argv[i], "--bench") == 0 && i + 1 < argc)
+            _options.bench_path = argv[++i];
+        else if (std::strcmp(argv[i], "--bench-report") == 0 && i + 1 < argc)
+            _options.bench_report = argv[++i];
+        else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            _options.warmup = std::max(std::atoi(argv[++i]), 0);
+        else if (std::strcmp(argv[i], "--startup-trace") == 0 && i + 1 < argc)
+            _options.startup_trace = argv[++i];
+        else if (std::strcmp(argv[i], "--gl-debug") == 0)
+            _options.gl_debug = true;
+        else if (std::strcmp(argv[i], "--no-gl-debug") == 0)
+            _options.gl_debug = false;
+        else if (std::strcmp(argv[i], "--gl-sync") == 0)
+            _options.gl_debug = _options.gl_sync = true;
+        else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+            _options.capture = argv[++i];
+        else if (std::strcmp(argv[i], "--threaded") == 0)
+            _options.threaded = true;
+        else if (std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc)
+            _options.jobs = std::max(std::atoi(argv[++i]), 0);
+        else if (std::strcmp(argv[i], "--idle") == 0 && i + 1 < argc)
+            parse_idle(argv[++i], _options.idle);
+        else if (std::strcmp(argv[i], "--idle-samples") == 0 && i + 1 < argc)
+            _options.idle_samples = std::max(std::atoi(argv[++i]), 1);
+        else
+            rest.emplace_back(argv[i]);
+    }
+    return rest;
+}
@@ -0,0 +1,162 @@
+#include "../frame-accumulator.h"
+
+#include <spdlog/spdlog.h>
+
+#include "frame-config.hpp"
+#include "../opengl-debug.h"
+#include "../opengl-misc.h"
+#include "../window.h"
+
+
+FrameAccumulator::FrameAccumulator()
+    : _shader(SHADER + "accumulate/accumulate.vert", SHADER + "accumulate/accumulate.frag")
+{
+    glGenVertexArrays(1, &_vao);
+}
+
+
+FrameAccumulator::~FrameAccumulator()
+{
+    release();
+    if (_vao)
+        glDeleteVertexArrays(1, &_vao);
+}
+
+
+float FrameAccumulator::halton(uint32_t index, uint32_t base)
+{
+    float result = 0.f;
+    float f      = 1.f;
+    while (index > 0)
+    {
+        f /= (float) base;
+        result += f * (float) (index % base);
+        index /= base;
+    }
+    return result;
+}
+
+
+void FrameAccumulator::resize(int width, int height)
+{
+    if (width == _width && height == _height && _history_fbo)
+        return;
+    release();
+    _width   = width;
+    _height  = height;
+    _samples = 0;
+
+    _current_tex = new_tex2d({
+            .width           = width,
+            .height          = height,
+            .internal_format = GL_RGBA8,
+            .external_format = GL_RGBA,
+            .external_type   = GL_UNSIGNED_BYTE,
+            .filter_min      = GL_NEAREST,
+            .filter_mag      = GL_NEAREST,
+    });
+    _history_tex = new_tex2d({
+            .width           = width,
+            .height          = height,
+            .internal_format = GL_RGBA32F,
+            .external_format = GL_RGBA,
+            .external_type   = GL_FLOAT,
+            .filter_min      = GL_NEAREST,
+            .filter_mag      = GL_NEAREST,
+    });
+
+    /// 创建时需要绑定，结束后恢复之前绑定的 framebuffer
+    GLint last_framebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &last_framebuffer);
+    auto new_fbo = [](GLuint tex) {
+        GLuint fbo;
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tex, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            SPDLOG_ERROR("accumulation framebuffer incomplete.");
+        return fbo;
+    };
+    _current_fbo = new_fbo(_current_tex);
+    _history_fbo = new_fbo(_history_tex);
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint) last_framebuffer);
+    GLDebug::label(GL_FRAMEBUFFER, _history_fbo, "accumulation history");
+}
+
+
+void FrameAccumulator::release()
+{
+    if (_current_fbo)
+        glDeleteFramebuffers(1, &_current_fbo);
+    if (_history_fbo)
+        glDeleteFramebuffers(1, &_history_fbo);
+    if (_current_tex)
+        glDeleteTextures(1, &_current_tex);
+    if (_history_tex)
+        glDeleteTextures(1, &_history_tex);
+    _current_fbo = _history_fbo = _current_tex = _history_tex = 0;
+}
+
+
+void FrameAccumulator::blit(GLuint src, GLuint dst) const
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, src);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst);
+    glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height, GL_COLOR_BUFFER_BIT,
+                      GL_NEAREST);
+}
+
+
+void FrameAccumulator::accumulate(uint32_t sample)
+{
+    resize(Window::framebuffer_width(), Window::framebuffer_height());
+    if (sample == 0)
+        _samples = 0;
+
+    /// 项目的渲染状态不确定，需要修改的状态都在结束时恢复
+    GLint     last_viewport[4];
+    GLint     last_src_rgb, last_dst_rgb, last_src_alpha, last_dst_alpha;
+    GLboolean last_blend      = glIsEnabled(GL_BLEND);
+    GLboolean last_depth_test = glIsEnabled(GL_DEPTH_TEST);
+    glGetIntegerv(GL_VIEWPORT, last_viewport);
+    glGetIntegerv(GL_BLEND_SRC_RGB, &last_src_rgb);
+    glGetIntegerv(GL_BLEND_DST_RGB, &last_dst_rgb);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &last_src_alpha);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &last_dst_alpha);
+
+    blit(0, _current_fbo);
+
+    /// history = current * alpha + history * (1 - alpha)，第一帧 alpha 为 1，直接覆盖
+    glBindFramebuffer(GL_FRAMEBUFFER, _history_fbo);
+    glViewport(0, 0, _width, _height);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendColor(0.f, 0.f, 0.f, 1.f / (float) (_samples + 1));
+    glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+    glBindTexture_(GL_TEXTURE_2D, 0, _current_tex);
+    _shader.set_uniform({{"tex_current", 0}});
+    glBindVertexArray(_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    ++_samples;
+
+    blit(_history_fbo, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(last_viewport[0], last_viewport[1], last_viewport[2], last_viewport[3]);
+    glBlendFuncSeparate(last_src_rgb, last_dst_rgb, last_src_alpha, last_dst_alpha);
+    if (!last_blend)
+        glDisable(GL_BLEND);
+    if (last_depth_test)
+        glEnable(GL_DEPTH_TEST);
+    CHECK_GL_ERROR();
+}
+
+
+void FrameAccumulator::present() const
+{
+    if (_samples == 0)
+        return;
+    blit(_history_fbo, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,213 @@
+#include "../frame-arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+
+namespace {
+
+/// 当前线程的分配次数和字节数，平凡类型的 thread_local 不需要初始化，在 operator new 中可以使用
+thread_local uint64_t alloc_cnt   = 0;
+thread_local uint64_t alloc_bytes = 0;
+
+#ifdef FRAME_COUNT_ALLOCS
+void *counted_malloc(size_t size)
+{
+    ++alloc_cnt;
+    alloc_bytes += size;
+    while (true)
+    {
+        if (void *ptr = std::malloc(size ? size : 1))
+            return ptr;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void *counted_aligned_malloc(size_t size, size_t alignment)
+{
+    ++alloc_cnt;
+    alloc_bytes += size;
+    alignment = std::max(alignment, sizeof(void *));
+    while (true)
+    {
+#ifdef _WIN32
+        if (void *ptr = _aligned_malloc(size ? size : 1, alignment))
+            return ptr;
+#else
+        void *ptr = nullptr;
+        if (posix_memalign(&ptr, alignment, size ? size : 1) == 0)
+            return ptr;
+#endif
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void aligned_free(void *ptr)
+{
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+#endif
+
+}    // namespace
+
+
+#ifdef FRAME_COUNT_ALLOCS
+/// 只替换这几个基本的版本：标准库中数组、nothrow、sized 的版本都会调用它们
+void *operator new(size_t size)
+{
+    return counted_malloc(size);
+}
+
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    return counted_aligned_malloc(size, (size_t) alignment);
+}
+
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    aligned_free(ptr);
+}
+#endif
+
+
+uint64_t AllocCounter::count()
+{
+    return alloc_cnt;
+}
+
+
+uint64_t AllocCounter::bytes()
+{
+    return alloc_bytes;
+}
+
+
+void *AllocCounter::imgui_alloc(size_t size, void *)
+{
+    ++alloc_cnt;
+    alloc_bytes += size;
+    return std::malloc(size);
+}
+
+
+void AllocCounter::imgui_free(void *ptr, void *)
+{
+    std::free(ptr);
+}
+
+
+/// ==================================================================
+
+
+FrameArena &FrameArena::local()
+{
+    thread_local FrameArena arena;
+    return arena;
+}
+
+
+FrameArena::~FrameArena()
+{
+    for (const auto &block: _blocks)
+        free_block(block);
+}
+
+
+FrameArena::Block FrameArena::new_block(size_t size)
+{
+    return {static_cast<std::byte *>(::operator new(size, std::align_val_t{64})), size};
+}
+
+
+void FrameArena::free_block(const Block &block)
+{
+    ::operator delete(block.data, std::align_val_t{64});
+}
+
+
+void FrameArena::reset()
+{
+    _peak = std::max(_peak, used());
+
+    /// 这一帧用到了多个内存块，合并为一个足够大的，下一帧就不需要再分配
+    if (_blocks.size() > 1)
+    {
+        const size_t size = capacity();
+        for (const auto &block: _blocks)
+            free_block(block);
+        _blocks.clear();
+        _blocks.push_back(new_block(size));
+    }
+    _block  = 0;
+    _offset = 0;
+}
+
+
+void FrameArena::rewind(const Marker &marker)
+{
+    _peak   = std::max(_peak, used());
+    _block  = marker.block;
+    _offset = marker.offset;
+}
+
+
+size_t FrameArena::used() const
+{
+    size_t size = _offset;
+    for (size_t i = 0; i < _block && i < _blocks.size(); ++i)
+        size += _blocks[i].size;
+    return size;
+}
+
+
+size_t FrameArena::capacity() const
+{
+    size_t size = 0;
+    for (const auto &block: _blocks)
+        size += block.size;
+    return size;
+}
+
+
+void *FrameArena::do_allocate(size_t bytes, size_t alignment)
+{
+    while (true)
+    {
+        if (_block < _blocks.size())
+        {
+            const Block &block = _blocks[_block];
+            const auto   base  = reinterpret_cast<uintptr_t>(block.data);
+            const size_t begin = ((base + _offset + alignment - 1) & ~(alignment - 1)) - base;
+            if (begin + bytes <= block.size)
+            {
+                _offset = begin + bytes;
+                return block.data + begin;
+            }
+
+            /// 放不下时使用下一个内存块，当前内存块剩余的部分浪费掉
+            ++_block;
+            _offset = 0;
+            continue;
+        }
+        _blocks.push_back(new_block(std::max(BLOCK_SIZE, bytes + alignment)));
+    }
+}
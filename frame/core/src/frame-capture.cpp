@@ -0,0 +1,278 @@
+#include "../frame-capture.h"
+
+#include <cctype>
+#include <cstring>
+
+#include <stb_image_write.h>
+
+#include "../misc.h"
+#include "../opengl-misc.h"
+#include "../profiler.h"
+#include "../window.h"
+
+/// 原始数据需要以二进制的方式写入
+#ifdef _WIN32
+#define popen        _popen
+#define pclose       _pclose
+#define PIPE_MODE "wb"
+#else
+#define PIPE_MODE "w"
+#endif
+
+
+namespace {
+
+/**
+ * 文件名模板中只能有一个 %d（可以带宽度，例如 %05d），其余的 % 必须是 %%
+ */
+bool valid_pattern(const std::string &pattern)
+{
+    int int_cnt = 0;
+    for (size_t i = 0; i < pattern.size(); ++i)
+    {
+        if (pattern[i] != '%')
+            continue;
+        if (++i < pattern.size() && pattern[i] == '%')
+            continue;
+        while (i < pattern.size() && std::isdigit((unsigned char) pattern[i]))
+            ++i;
+        if (i >= pattern.size() || pattern[i] != 'd')
+            return false;
+        ++int_cnt;
+    }
+    return int_cnt == 1;
+}
+
+
+bool ends_with(const std::string &str, const std::string &suffix)
+{
+    return str.size() >= suffix.size() &&
+           str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}    // namespace
+
+
+FrameCapture::FrameCapture(const std::string &output)
+{
+    if (!output.empty() && output[0] == '|')
+    {
+        _output = Output::pipe;
+        _target = output.substr(1);
+        _pipe   = popen(_target.c_str(), PIPE_MODE);
+        if (!_pipe)
+            LOG_AND_THROW("fail to open capture pipe: {}", _target);
+    } else
+    {
+        if (ends_with(output, ".png"))
+            _output = Output::png;
+        else if (ends_with(output, ".hdr"))
+            _output = Output::hdr;
+        else
+            LOG_AND_THROW("capture output should be *.png, *.hdr or |command: {}", output);
+        if (!valid_pattern(output))
+            LOG_AND_THROW("capture output should contain one frame number like %05d: {}", output);
+        _target = output;
+    }
+
+    _worker = std::thread(&FrameCapture::worker_loop, this);
+    SPDLOG_INFO("frame capture: {}", output);
+}
+
+
+FrameCapture::~FrameCapture()
+{
+    /// 剩余的 PBO 全部映射，之后不再需要 OpenGL
+    while (_next_map < _next_frame)
+        map_slot(_slots[_next_map % RING_SIZE], true);
+    for (Slot &slot: _slots)
+        if (slot.pbo)
+            glDeleteBuffers(1, &slot.pbo);
+
+    {
+        std::lock_guard lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_all();
+    _worker.join();
+
+    if (_pipe)
+        pclose(_pipe);
+    SPDLOG_INFO("frame capture: {} frames, stalls: {}", _written_cnt, _stall_cnt);
+}
+
+
+size_t FrameCapture::written_cnt() const
+{
+    std::lock_guard lock(_mutex);
+    return _written_cnt;
+}
+
+
+void FrameCapture::capture(GLuint framebuffer, int width, int height, GLenum attachment)
+{
+    PROFILE_CPU_SCOPE("capture");
+
+    if (width <= 0 || height <= 0)
+    {
+        width  = Window::framebuffer_width();
+        height = Window::framebuffer_height();
+    }
+
+    /// 环形队列已满：最旧的一帧还没有映射，只能等待
+    Slot &slot = _slots[_next_frame % RING_SIZE];
+    if (slot.fence)
+        map_slot(slot, true);
+
+    const size_t size = (size_t) width * height * pixel_size();
+    if (!slot.pbo)
+        glGenBuffers(1, &slot.pbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if (slot.size < size)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr) size, nullptr, GL_STREAM_READ);
+        slot.size = size;
+    }
+
+    /// 只修改读取的 framebuffer，不影响之后的绘制
+    GLint last_read_framebuffer = 0, last_read_buffer = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &last_read_framebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glGetIntegerv(GL_READ_BUFFER, &last_read_buffer);
+    glReadBuffer(framebuffer == 0 && !Window::headless() ? GL_BACK : attachment);
+
+    glReadPixels(0, 0, width, height, _output == Output::hdr ? GL_RGB : GL_RGBA,
+                 _output == Output::hdr ? GL_FLOAT : GL_UNSIGNED_BYTE, nullptr);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    glReadBuffer((GLenum) last_read_buffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint) last_read_framebuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    CHECK_GL_ERROR();
+
+    slot.frame  = _next_frame++;
+    slot.width  = width;
+    slot.height = height;
+}
+
+
+void FrameCapture::poll()
+{
+    while (_next_map < _next_frame && map_slot(_slots[_next_map % RING_SIZE], false))
+        ;
+}
+
+
+bool FrameCapture::map_slot(Slot &slot, bool wait)
+{
+    /// 第一次检查时 flush，保证 fence 最终会完成
+    GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+    {
+        if (!wait)
+            return false;
+        ++_stall_cnt;
+        while (status == GL_TIMEOUT_EXPIRED)
+            status = glClientWaitSync(slot.fence, 0, 1'000'000'000);
+    }
+    if (status == GL_WAIT_FAILED)
+        SPDLOG_ERROR("fail to wait capture fence.");
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    /// 编码线程跟不上时等待，保证不丢帧
+    Frame frame;
+    {
+        std::unique_lock lock(_mutex);
+        if (_queue.size() >= MAX_QUEUED)
+        {
+            ++_stall_cnt;
+            _cv.wait(lock, [this] { return _queue.size() < MAX_QUEUED; });
+        }
+        if (!_free.empty())
+        {
+            frame = std::move(_free.back());
+            _free.pop_back();
+        }
+    }
+
+    const size_t size = (size_t) slot.width * slot.height * pixel_size();
+    frame.frame       = slot.frame;
+    frame.width       = slot.width;
+    frame.height      = slot.height;
+    frame.data.resize(size);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const void *ptr = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr) size, GL_MAP_READ_BIT);
+    if (ptr)
+    {
+        std::memcpy(frame.data.data(), ptr, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else
+        SPDLOG_ERROR("fail to map capture buffer, frame: {}", slot.frame);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    {
+        std::lock_guard lock(_mutex);
+        _queue.push_back(std::move(frame));
+    }
+    _cv.notify_all();
+    ++_next_map;
+    return true;
+}
+
+
+void FrameCapture::worker_loop()
+{
+    while (true)
+    {
+        Frame frame;
+        {
+            std::unique_lock lock(_mutex);
+            _cv.wait(lock, [this] { return _stop || !_queue.empty(); });
+            if (_queue.empty())
+                return;
+            frame = std::move(_queue.front());
+            _queue.pop_front();
+        }
+        _cv.notify_all();
+
+        write_frame(frame);
+
+        {
+            std::lock_guard lock(_mutex);
+            ++_written_cnt;
+            _free.push_back(std::move(frame));
+        }
+    }
+}
+
+
+void FrameCapture::write_frame(Frame &frame)
+{
+    PROFILE_CPU_SCOPE("capture encode");
+
+    /// OpenGL 读取的第一行是图片的最下面一行
+    const size_t row = (size_t) frame.width * pixel_size();
+    if (_output == Output::pipe)
+    {
+        for (int y = frame.height - 1; y >= 0; --y)
+            std::fwrite(frame.data.data() + y * row, 1, row, _pipe);
+        return;
+    }
+
+    std::vector<uint8_t> flipped(frame.data.size());
+    for (int y = 0; y < frame.height; ++y)
+        std::memcpy(flipped.data() + y * row, frame.data.data() + (frame.height - 1 - y) * row,
+                    row);
+
+    char path[1024];
+    std::snprintf(path, sizeof(path), _target.c_str(), (int) frame.frame);
+    const int ok =
+            _output == Output::png
+                    ? stbi_write_png(path, frame.width, frame.height, 4, flipped.data(), (int) row)
+                    : stbi_write_hdr(path, frame.width, frame.height, 3,
+                                     reinterpret_cast<const float *>(flipped.data()));
+    if (!ok)
+        SPDLOG_ERROR("fail to write capture: {}", path);
+}
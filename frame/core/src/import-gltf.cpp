@@ -1,5 +1,6 @@
 #include "../import-gltf.h"
 #include "../misc.h"
+#include "../startup-trace.h"
 #include "../texture.h"
 
 
@@ -9,10 +10,15 @@ ImportGLTF::ImportGLTF(const std::string &filename)
     std::string        err, warn;
 
     SPDLOG_INFO("load gltf file: {}", filename);
+    StartupScope import_scope("import", filename);
 
     /// 读取文件失败的处理
-    if (!loader.LoadASCIIFromFile(&_gltf, &err, &warn, filename))
-        SPDLOG_ERROR("fail to load gltf file. warn: {}, err: {}", warn, err);
+    {
+        StartupScope scope("parse");
+        scope.add_file_bytes(filename);
+        if (!loader.LoadASCIIFromFile(&_gltf, &err, &warn, filename))
+            SPDLOG_ERROR("fail to load gltf file. warn: {}, err: {}", warn, err);
+    }
 
     try
     {
@@ -35,24 +41,42 @@ void ImportGLTF::load_scene()
 
     for (size_t node_idx: scene.nodes)
     {
-        load_node(_gltf.nodes[node_idx], glm::mat4(1.f));
+        load_node(_gltf.nodes[node_idx], INVALID_TRANSFORM);
+    }
+
+    /// 所有节点都加入层级之后，统一计算世界坐标系下的位姿
+    _transforms.update();
+    for (size_t i = 0; i < _obj_meshes.size(); ++i)
+    {
+        _obj_list.emplace_back(get_mesh(_obj_meshes[i]), _transforms.world(_obj_transform_ids[i]));
     }
 }
 
 
-void ImportGLTF::load_node(const tinygltf::Node &node, const glm::mat4 &parent_matrix_world)
+void ImportGLTF::load_node(const tinygltf::Node &node, TransformId parent)
 {
-    /// 计算当前 node 的位姿
-    glm::mat4 cur_matrix_world;
+    /// 当前 node 相对于父 node 的位姿，matrix 和 TRS 只会出现其中一种
+    TransformId cur;
+    if (!node.matrix.empty())
+    {
+        const glm::mat4 cur_matrix =
+                glm::mat4(node.matrix[0], node.matrix[1], node.matrix[2], node.matrix[3],
+                          node.matrix[4], node.matrix[5], node.matrix[6], node.matrix[7],
+                          node.matrix[8], node.matrix[9], node.matrix[10], node.matrix[11],
+                          node.matrix[12], node.matrix[13], node.matrix[14], node.matrix[15]);
+        cur = _transforms.add(parent, cur_matrix);
+    } else
     {
-        glm::mat4 cur_matrix = glm::mat4(1.f);    // 当前 node 相对于父 node 的位姿
-        if (!node.matrix.empty())
-            cur_matrix =
-                    glm::mat4(node.matrix[0], node.matrix[1], node.matrix[2], node.matrix[3],
-                              node.matrix[4], node.matrix[5], node.matrix[6], node.matrix[7],
-                              node.matrix[8], node.matrix[9], node.matrix[10], node.matrix[11],
-                              node.matrix[12], node.matrix[13], node.matrix[14], node.matrix[15]);
-        cur_matrix_world = parent_matrix_world * cur_matrix;
+        glm::vec3 translation(0.f), scale(1.f);
+        glm::quat rotation(1.f, glm::vec3(0.f));
+        if (node.translation.size() == 3)
+            translation = {node.translation[0], node.translation[1], node.translation[2]};
+        if (node.rotation.size() == 4)    // gltf 中四元数的顺序是 xyzw
+            rotation = glm::quat((float) node.rotation[3], (float) node.rotation[0],
+                                 (float) node.rotation[1], (float) node.rotation[2]);
+        if (node.scale.size() == 3)
+            scale = {node.scale[0], node.scale[1], node.scale[2]};
+        cur = _transforms.add(parent, translation, rotation, scale);
     }
 
     /// 如果当前节点是 mesh
@@ -60,14 +84,15 @@ void ImportGLTF::load_node(const tinygltf::Node &node, const glm::mat4 &parent_m
     {
         if (node.mesh >= _gltf.meshes.size())
             LOG_AND_THROW("current node is mesh, but idx out of range: {}", node.mesh);
-        
-        _obj_list.emplace_back(get_mesh(node.mesh), cur_matrix_world);
+
+        _obj_meshes.push_back(node.mesh);
+        _obj_transform_ids.push_back(cur);
     }
 
     /// 子节点
     for (int child: node.children)
     {
-        load_node(_gltf.nodes[child], cur_matrix_world);
+        load_node(_gltf.nodes[child], cur);
     }
 }
 
@@ -96,6 +121,7 @@ GLuint ImportGLTF::get_ebo_vbo(int buffer_view_idx)
 
     /// 返回
     _bufferview_bo_table[buffer_view_idx] = ebo_vbo;
+    _geometry->buffers.push_back(ebo_vbo);
     return ebo_vbo;
 }
 
@@ -185,6 +211,7 @@ Material ImportGLTF::create_material(int mat_idx)
     }
 
 #undef CHECK_TEXCOORD
+    mat.update_features();
     return mat;
 }
 
@@ -300,6 +327,7 @@ Mesh2 ImportGLTF::create_mesh(int mesh_idx)
     GLuint vao;
     glGenVertexArrays(1, &vao);
     glBindVertexArray(vao);
+    _geometry->vaos.push_back(vao);
 
     /// 只考虑 mesh 的第一个 primitive
     if (gltf_mesh.primitives.empty())
@@ -311,6 +339,7 @@ Mesh2 ImportGLTF::create_mesh(int mesh_idx)
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, get_ebo_vbo(index_accessor.bufferView));
 
     /// 顶点属性
+    AABB aabb;
     for (const auto &attr: primitive.attributes)
     {
         tinygltf::Accessor accessor = _gltf.accessors[attr.second];
@@ -323,8 +352,17 @@ Mesh2 ImportGLTF::create_mesh(int mesh_idx)
         GLuint vertex_attr_idx;
         {
             if (attr.first == VERTEX_ATTRIBUTE_NAME.pos)
+            {
                 vertex_attr_idx = VERTEX_ATTRBUTE_SLOT.pos;
-            else if (attr.first == VERTEX_ATTRIBUTE_NAME.normal)
+                /// gltf 要求 POSITION 必须提供 min 和 max，可以直接作为包围盒
+                if (accessor.minValues.size() == 3 && accessor.maxValues.size() == 3)
+                {
+                    aabb.expand(glm::vec3(accessor.minValues[0], accessor.minValues[1],
+                                          accessor.minValues[2]));
+                    aabb.expand(glm::vec3(accessor.maxValues[0], accessor.maxValues[1],
+                                          accessor.maxValues[2]));
+                }
+            } else if (attr.first == VERTEX_ATTRIBUTE_NAME.normal)
                 vertex_attr_idx = VERTEX_ATTRBUTE_SLOT.normal;
             else if (attr.first == VERTEX_ATTRIBUTE_NAME.tex_0)
                 vertex_attr_idx = VERTEX_ATTRBUTE_SLOT.tex_0;
@@ -356,5 +394,8 @@ Mesh2 ImportGLTF::create_mesh(int mesh_idx)
             .index_component_type = index_accessor.componentType,
             .index_offset         = index_accessor.byteOffset,
             .mat                  = mat,
+            .geometry             = _geometry,
+            .aabb                 = aabb,
+            .sphere               = BoundingSphere::from_aabb(aabb),
     };
 }
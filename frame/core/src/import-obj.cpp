@@ -1,13 +1,25 @@
 #include "../import-obj.h"
 
+#include <unordered_map>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../startup-trace.h"
+
 
 std::vector<ObjData> read_obj(const std::string &file_path)
 {
     SPDLOG_INFO("load obj: {}...", file_path);
+    StartupScope import_scope("import", file_path);
 
     /// load file
     Assimp::Importer importer;
-    const auto scene = importer.ReadFile(file_path, aiProcess_Triangulate | aiProcess_GenNormals);
+    const aiScene   *scene;
+    {
+        StartupScope scope("parse");
+        scope.add_file_bytes(file_path);
+        scene = importer.ReadFile(file_path, aiProcess_Triangulate | aiProcess_GenNormals);
+    }
     if (!scene || (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) || !scene->mRootNode)
         SPDLOG_WARN("fail to load model: {}", file_path);
 
@@ -87,12 +99,23 @@ ObjData process_mesh(const aiMesh &ai_mesh, const aiScene &scene, const std::str
 }
 
 
-ImportObj::ImportObj(const std::string &filepath)
+ImportObj::ImportObj(const std::string &filepath, unsigned int import_flags)
 {
+    StartupScope     import_scope("import", filepath);
     Assimp::Importer impoter;
 
-    // 模型三角化，自动生成法向量，还可以选择生成 Tangent
-    _scene = impoter.ReadFile(filepath, aiProcess_Triangulate | aiProcess_GenNormals);
+    // 默认会将模型三角化，自动生成法向量，还可以选择生成 Tangent
+    // 先只读取、解析文件，再单独进行后处理，这样启动分析可以区分两者的耗时
+    {
+        StartupScope scope("parse");
+        scope.add_file_bytes(filepath);
+        _scene = impoter.ReadFile(filepath, 0);
+    }
+    if (_scene)
+    {
+        StartupScope scope("post-process");
+        _scene = impoter.ApplyPostProcessing(import_flags);
+    }
     if (!_scene || (_scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) || !_scene->mRootNode)
         LOG_AND_THROW("fail to load model: {}", filepath);
 
@@ -100,12 +123,144 @@ ImportObj::ImportObj(const std::string &filepath)
     _dir_path = filepath.substr(0, filepath.find_last_of('/')) + '/';
 
     process_node(*_scene->mRootNode);
+    build_obj_list();
 }
 
 
-GLuint ImportObj::load_mesh_geometry(const aiMesh &mesh)
+namespace {
 
+AABB mesh_aabb(const aiMesh &mesh)
 {
+    AABB aabb;
+    for (unsigned i = 0; i < mesh.mNumVertices; ++i)
+        aabb.expand({mesh.mVertices[i].x, mesh.mVertices[i].y, mesh.mVertices[i].z});
+    return aabb;
+}
+
+
+/**
+ * 拓扑结构（顶点数量、面数量、索引）的 hash，相同形状的 mesh 一定有相同的 hash
+ */
+size_t topology_hash(const aiMesh &mesh)
+{
+    size_t hash = std::hash<size_t>{}(((size_t) mesh.mNumVertices << 32) | mesh.mNumFaces);
+    for (unsigned i = 0; i < mesh.mNumFaces; ++i)
+        for (unsigned j = 0; j < 3; ++j)
+            hash = hash * 31 + mesh.mFaces[i].mIndices[j];
+    return hash;
+}
+
+
+/**
+ * 两个 mesh 分别以 center_a、center_b 为原点时，顶点数据和索引是否相同
+ */
+bool same_shape(const aiMesh &a, const glm::vec3 &center_a, const aiMesh &b,
+                const glm::vec3 &center_b)
+{
+    if (a.mNumVertices != b.mNumVertices || a.mNumFaces != b.mNumFaces ||
+        a.HasTextureCoords(0) != b.HasTextureCoords(0))
+        return false;
+
+    const glm::vec3 offset = center_b - center_a;
+    const float     eps    = 1e-4f * std::max(1.f, glm::length(mesh_aabb(a).extent()));
+    for (unsigned i = 0; i < a.mNumVertices; ++i)
+    {
+        const glm::vec3 pa = {a.mVertices[i].x, a.mVertices[i].y, a.mVertices[i].z};
+        const glm::vec3 pb = {b.mVertices[i].x, b.mVertices[i].y, b.mVertices[i].z};
+        if (glm::length(pb - pa - offset) > eps)
+            return false;
+
+        const glm::vec3 na = {a.mNormals[i].x, a.mNormals[i].y, a.mNormals[i].z};
+        const glm::vec3 nb = {b.mNormals[i].x, b.mNormals[i].y, b.mNormals[i].z};
+        if (glm::length(na - nb) > 1e-3f)
+            return false;
+
+        if (a.HasTextureCoords(0))
+        {
+            const aiVector3D &ta = a.mTextureCoords[0][i];
+            const aiVector3D &tb = b.mTextureCoords[0][i];
+            if (std::abs(ta.x - tb.x) > 1e-4f || std::abs(ta.y - tb.y) > 1e-4f)
+                return false;
+        }
+    }
+
+    for (unsigned i = 0; i < a.mNumFaces; ++i)
+        for (unsigned j = 0; j < 3; ++j)
+            if (a.mFaces[i].mIndices[j] != b.mFaces[i].mIndices[j])
+                return false;
+    return true;
+}
+
+}    // namespace
+
+
+void ImportObj::build_obj_list()
+{
+    /// 按照形状分组：先用拓扑的 hash 找到候选，再比较顶点数据
+    std::vector<AABB>                       aabbs(_meshes.size());
+    std::vector<size_t>                     shape_of(_meshes.size());
+    std::vector<std::vector<size_t>>        shapes;    // 每种形状包含哪些 mesh
+    std::unordered_multimap<size_t, size_t> lut;       // 拓扑的 hash -> 形状
+    for (size_t i = 0; i < _meshes.size(); ++i)
+    {
+        aabbs[i]          = mesh_aabb(*_meshes[i]);
+        const size_t hash = topology_hash(*_meshes[i]);
+
+        auto shape = (size_t) -1;
+        for (auto [it, end] = lut.equal_range(hash); it != end; ++it)
+        {
+            const size_t first = shapes[it->second][0];
+            if (same_shape(*_meshes[first], aabbs[first].center(), *_meshes[i], aabbs[i].center()))
+            {
+                shape = it->second;
+                break;
+            }
+        }
+        if (shape == (size_t) -1)
+        {
+            shape = shapes.size();
+            shapes.emplace_back();
+            lut.emplace(hash, shape);
+        }
+        shapes[shape].push_back(i);
+        shape_of[i] = shape;
+    }
+
+    /// 只有重复出现的形状才以中心为原点，其他 mesh 保持原来的坐标，不改变 set_pos 等操作的效果
+    std::vector<GLuint> shape_vao(shapes.size());
+    for (size_t s = 0; s < shapes.size(); ++s)
+    {
+        const size_t first = shapes[s][0];
+        shape_vao[s]       = load_mesh_geometry(
+                *_meshes[first], shapes[s].size() > 1 ? aabbs[first].center() : glm::vec3(0.f));
+    }
+
+    for (size_t i = 0; i < _meshes.size(); ++i)
+    {
+        const size_t s = shape_of[i];
+        if (shapes[s].size() == 1)
+        {
+            _obj_list.emplace_back(load_mesh(*_meshes[i], shape_vao[s], aabbs[i]));
+            continue;
+        }
+
+        const glm::vec3 center = aabbs[i].center();
+        const AABB      local{.min = aabbs[i].min - center, .max = aabbs[i].max - center};
+        _obj_list.emplace_back(load_mesh(*_meshes[i], shape_vao[s], local),
+                               glm::translate(glm::mat4(1.f), center));
+    }
+
+    if (shapes.size() < _meshes.size())
+        SPDLOG_INFO("meshes: {}, unique geometry: {}", _meshes.size(), shapes.size());
+}
+
+
+GLuint ImportObj::load_mesh_geometry(const aiMesh &mesh, const glm::vec3 &offset)
+{
+    StartupScope scope("upload");
+    scope.add_bytes(sizeof(float) * mesh.mNumVertices * (mesh.HasTextureCoords(0) ? 8 : 6) +
+                    sizeof(unsigned int) * mesh.mNumFaces * 3);
+
     GLuint vao;
     glGenVertexArrays(1, &vao);
     glBindVertexArray(vao);
@@ -120,7 +275,8 @@ GLuint ImportObj::load_mesh_geometry(const aiMesh &mesh)
     const size_t normal_data_byte   = sizeof(float) * vertex_cnt * 3;    // normal 数据大小
     for (int i = 0; i < vertex_cnt; ++i)
     {
-        combine(positon, {mesh.mVertices[i].x, mesh.mVertices[i].y, mesh.mVertices[i].z});
+        combine(positon, {mesh.mVertices[i].x - offset.x, mesh.mVertices[i].y - offset.y,
+                          mesh.mVertices[i].z - offset.z});
         combine(normal, {mesh.mNormals[i].x, mesh.mNormals[i].y, mesh.mNormals[i].z});
     }
 
@@ -174,6 +330,17 @@ GLuint ImportObj::load_mesh_geometry(const aiMesh &mesh)
         // 前面已经指定要对面进行三角化，因此这里可以直接读取 mIndices[0, 1, 2]
         combine(indices, {mesh.mFaces[i].mIndices[0], mesh.mFaces[i].mIndices[1],
                           mesh.mFaces[i].mIndices[2]});
+
+    /// 三角形足够多时划分 meshlet，索引按 meshlet 重排，每个 meshlet 是 EBO 中连续的一段
+    if (face_cnt >= MESHLET_MIN_MESH_TRIANGLES)
+    {
+        std::vector<glm::vec3> positions(vertex_cnt);
+        for (size_t i = 0; i < vertex_cnt; ++i)
+            positions[i] = {positon[3 * i], positon[3 * i + 1], positon[3 * i + 2]};
+        _meshlets[vao] = std::make_shared<const std::vector<Meshlet>>(
+                build_meshlets(positions, indices));
+    }
+
     GLuint ebo;
     glGenBuffers(1, &ebo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
@@ -182,6 +349,9 @@ GLuint ImportObj::load_mesh_geometry(const aiMesh &mesh)
 
     glBindVertexArray(0);
     CHECK_GL_ERROR();
+
+    _geometry->vaos.push_back(vao);
+    _geometry->buffers.insert(_geometry->buffers.end(), {vbo, ebo});
     return vao;
 }
 
@@ -202,29 +372,34 @@ Material ImportObj::load_material(const aiMaterial &ai_mat)
     ai_mat.Get(AI_MATKEY_COLOR_DIFFUSE, temp_color);
     mat.metallic_roughness.base_color = {temp_color[0], temp_color[1], temp_color[2], 1.f};
 
+    mat.update_features();
     return mat;
 }
 
 
-Mesh2 ImportObj::load_mesh(const aiMesh &mesh)
+Mesh2 ImportObj::load_mesh(const aiMesh &mesh, GLuint vao, const AABB &aabb)
 {
     return Mesh2{
-            .vao            = load_mesh_geometry(mesh),
+            .vao            = vao,
             .primitive_mode = GL_TRIANGLES,
             // TODO 暂时只能创建三角形
             .index_cnt            = mesh.mNumFaces * 3,
             .index_component_type = GL_UNSIGNED_INT,
             .index_offset         = 0,
             .mat                  = load_material(*_scene->mMaterials[mesh.mMaterialIndex]),
+            .geometry             = _geometry,
+            .aabb                 = aabb,
+            .sphere               = BoundingSphere::from_aabb(aabb),
+            .meshlets             = _meshlets.contains(vao) ? _meshlets[vao] : nullptr,
     };
 }
 
 
 void ImportObj::process_node(const aiNode &node)
 {
-    // 将当前节点的模型加入到 obj list 中
+    // 收集当前节点的 mesh，之后统一创建 RTObject
     for (int i = 0; i < node.mNumMeshes; ++i)
-        _obj_list.emplace_back(load_mesh(*_scene->mMeshes[node.mMeshes[i]]));
+        _meshes.push_back(_scene->mMeshes[node.mMeshes[i]]);
 
 
     // 递归地处理子节点
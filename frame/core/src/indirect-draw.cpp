@@ -0,0 +1,158 @@
+#include "../indirect-draw.h"
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+
+#include "../frame-arena.h"
+
+
+namespace {
+
+GLuint index_size(GLenum index_type)
+{
+    switch (index_type)
+    {
+        case GL_UNSIGNED_BYTE: return 1;
+        case GL_UNSIGNED_SHORT: return 2;
+        default: return 4;
+    }
+}
+
+}    // namespace
+
+
+void IndirectDrawBuffer::push(const Mesh2 &mesh, uint32_t object_id)
+{
+    const auto index_type = (GLenum) mesh.index_component_type;
+    _draws.push_back({
+            .vao            = mesh.vao,
+            .primitive_mode = (GLenum) mesh.primitive_mode,
+            .index_type     = index_type,
+            .index_cnt      = (GLuint) mesh.index_cnt,
+            .first_index    = (GLuint) (mesh.index_offset / index_size(index_type)),
+            .object_id      = object_id,
+    });
+}
+
+
+size_t IndirectDrawBuffer::draw_indirect()
+{
+    if (_draws.empty())
+        return 0;
+
+    /// 按照 VAO 排序，相同 VAO 的绘制是连续的命令，VAO 相同时保持添加的顺序；
+    /// 排序的是帧内存中的下标，std::stable_sort 每次都会分配临时的缓冲
+    auto key = [](const Draw &d) { return std::tie(d.vao, d.primitive_mode, d.index_type); };
+    FrameVector<uint32_t> order(_draws.size(), &FrameArena::local());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        const auto key_a = key(_draws[a]);
+        const auto key_b = key(_draws[b]);
+        return key_a < key_b || (key_a == key_b && a < b);
+    });
+
+    /// 每个物体一个实例，baseInstance 就是物体的下标
+    uint32_t max_id = 0;
+    _commands.clear();
+    for (uint32_t i: order)
+    {
+        const Draw &d = _draws[i];
+        _commands.push_back({
+                .count         = d.index_cnt,
+                .instance_cnt  = 1,
+                .first_index   = d.first_index,
+                .base_vertex   = 0,
+                .base_instance = d.object_id,
+        });
+        max_id = std::max(max_id, d.object_id);
+    }
+    reserve_ids(max_id + 1);
+
+    /// 上传命令，容量不足时按 2 倍扩容
+    if (!_command_buffer)
+        glGenBuffers(1, &_command_buffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _command_buffer);
+    const auto bytes = (GLsizeiptr) (_commands.size() * sizeof(DrawElementsIndirectCommand));
+    if (_commands.size() > _command_capacity)
+    {
+        _command_capacity = std::max(_commands.size(), 2 * _command_capacity);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER,
+                     (GLsizeiptr) (_command_capacity * sizeof(DrawElementsIndirectCommand)),
+                     nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, bytes, _commands.data());
+
+    const auto multi_draw = GLExtension::multi_draw_elements_indirect();
+    size_t     call_cnt   = 0;
+    for (size_t first = 0; first < order.size();)
+    {
+        const Draw &d    = _draws[order[first]];
+        size_t      last = first + 1;
+        while (last < order.size() && key(_draws[order[last]]) == key(d))
+            ++last;
+
+        /// VAO 是模型共享的，绘制前指定 object_id 属性，绘制后恢复，
+        /// 否则之后使用同一个 VAO 的普通绘制也会带着这个 per-instance 属性
+        glBindVertexArray(d.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, _id_buffer);
+        glEnableVertexAttribArray(VERTEX_ATTRBUTE_SLOT.object_id);
+        glVertexAttribIPointer(VERTEX_ATTRBUTE_SLOT.object_id, 1, GL_UNSIGNED_INT, 0, nullptr);
+        glVertexAttribDivisor(VERTEX_ATTRBUTE_SLOT.object_id, 1);
+
+        multi_draw(d.primitive_mode, d.index_type,
+                   (const void *) (first * sizeof(DrawElementsIndirectCommand)),
+                   (GLsizei) (last - first), 0);
+        glVertexAttribDivisor(VERTEX_ATTRBUTE_SLOT.object_id, 0);
+        glDisableVertexAttribArray(VERTEX_ATTRBUTE_SLOT.object_id);
+        ++call_cnt;
+        first = last;
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+    return call_cnt;
+}
+
+
+size_t IndirectDrawBuffer::draw_loop(Shader2 &shader) const
+{
+    for (const Draw &d: _draws)
+    {
+        shader.set_uniform({{"object_id", (int) d.object_id}});
+        glBindVertexArray(d.vao);
+        glDrawElements(d.primitive_mode, (GLsizei) d.index_cnt, d.index_type,
+                       (const void *) ((size_t) d.first_index * index_size(d.index_type)));
+    }
+    return _draws.size();
+}
+
+
+void IndirectDrawBuffer::reserve_ids(size_t cnt)
+{
+    if (cnt <= _id_capacity)
+        return;
+
+    _id_capacity = std::max(cnt, 2 * _id_capacity);
+    std::vector<uint32_t> ids(_id_capacity);
+    std::iota(ids.begin(), ids.end(), 0u);
+
+    if (!_id_buffer)
+        glGenBuffers(1, &_id_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, _id_buffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) (ids.size() * sizeof(uint32_t)), ids.data(),
+                 GL_STATIC_DRAW);
+}
+
+
+void IndirectDrawBuffer::release()
+{
+    if (_command_buffer)
+        glDeleteBuffers(1, &_command_buffer);
+    if (_id_buffer)
+        glDeleteBuffers(1, &_id_buffer);
+    _command_buffer   = 0;
+    _command_capacity = 0;
+    _id_buffer        = 0;
+    _id_capacity      = 0;
+}
@@ -0,0 +1,456 @@
+#include "../job-system.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+#include "../frame-arena.h"
+#include "../profiler.h"
+
+
+namespace {
+
+/// 当前线程在 JobSystem::_queues 中的下标，-1 表示不是工作线程
+thread_local int queue_idx = -1;
+
+/// 窃取时从不同的队列开始，避免所有线程都去窃取同一个队列
+thread_local uint32_t steal_seed = 0;
+
+/// 没有找到任务时先自旋这么多次，再让出时间片，最后短暂地休眠
+constexpr int SPIN_CNT  = 64;
+constexpr int YIELD_CNT = 256;
+
+}    // namespace
+
+
+std::vector<std::unique_ptr<JobSystem::Queue>> JobSystem::_queues;
+std::vector<std::thread>                       JobSystem::_workers;
+JobSystem::Queue                               JobSystem::_main_jobs;
+
+std::mutex        JobSystem::_init_mutex;
+std::atomic<bool> JobSystem::_running{false};
+std::atomic<bool> JobSystem::_stop{false};
+
+std::mutex              JobSystem::_sleep_mutex;
+std::condition_variable JobSystem::_sleep_cv;
+std::atomic<uint64_t>   JobSystem::_epoch{0};
+std::atomic<int>        JobSystem::_sleeping{0};
+
+/// 静态初始化在程序启动的线程中进行
+const std::thread::id JobSystem::_main_thread = std::this_thread::get_id();
+
+
+namespace {
+
+/// 程序退出时停止工作线程，否则 std::thread 析构时线程仍然可以 join，会调用 std::terminate
+struct ShutdownGuard {
+    ~ShutdownGuard() { JobSystem::shutdown(); }
+} shutdown_guard;
+
+}    // namespace
+
+
+void JobSystem::Queue::push(Job &&job)
+{
+    std::lock_guard lock(mutex);
+    jobs.push_back(std::move(job));
+}
+
+
+bool JobSystem::Queue::pop(Job &job)
+{
+    std::lock_guard lock(mutex);
+    if (jobs.empty())
+        return false;
+    job = std::move(jobs.back());
+    jobs.pop_back();
+    return true;
+}
+
+
+bool JobSystem::Queue::steal(Job &job)
+{
+    std::lock_guard lock(mutex);
+    if (jobs.empty())
+        return false;
+    job = std::move(jobs.front());
+    jobs.pop_front();
+    return true;
+}
+
+
+void JobSystem::init(int thread_cnt)
+{
+    std::lock_guard lock(_init_mutex);
+    start(thread_cnt);
+}
+
+
+void JobSystem::start(int thread_cnt)
+{
+    if (_running.load(std::memory_order_acquire))
+    {
+        _stop.store(true);
+        {
+            std::lock_guard lock(_sleep_mutex);
+        }
+        _sleep_cv.notify_all();
+        for (auto &worker: _workers)
+            worker.join();
+        _workers.clear();
+    }
+
+    if (thread_cnt <= 0)
+        thread_cnt = (int) std::max(1u, std::thread::hardware_concurrency());
+
+    _queues.clear();
+    for (int i = 0; i < thread_cnt + 1; ++i)
+        _queues.push_back(std::make_unique<Queue>());
+
+    _stop.store(false);
+    for (int i = 1; i < thread_cnt; ++i)
+        _workers.emplace_back(&JobSystem::worker_loop, i);
+    _running.store(true, std::memory_order_release);
+    SPDLOG_INFO("job system: {} threads", thread_cnt);
+}
+
+
+void JobSystem::shutdown()
+{
+    std::lock_guard lock(_init_mutex);
+    if (!_running.load(std::memory_order_acquire))
+        return;
+
+    _stop.store(true);
+    {
+        std::lock_guard sleep_lock(_sleep_mutex);
+    }
+    _sleep_cv.notify_all();
+    for (auto &worker: _workers)
+        worker.join();
+    _workers.clear();
+    _queues.clear();
+    _running.store(false, std::memory_order_release);
+}
+
+
+int JobSystem::thread_cnt()
+{
+    ensure_init();
+    return (int) _workers.size() + 1;
+}
+
+
+bool JobSystem::is_main_thread()
+{
+    return std::this_thread::get_id() == _main_thread;
+}
+
+
+void JobSystem::ensure_init()
+{
+    if (_running.load(std::memory_order_acquire))
+        return;
+    std::lock_guard lock(_init_mutex);
+    if (!_running.load(std::memory_order_acquire))
+        start(0);
+}
+
+
+JobSystem::Queue &JobSystem::local_queue()
+{
+    if (queue_idx >= 0)
+        return *_queues[queue_idx];
+    if (is_main_thread())
+        return *_queues[0];
+    return *_queues.back();
+}
+
+
+void JobSystem::submit(Job &&job)
+{
+    ensure_init();
+    local_queue().push(std::move(job));
+
+    /// 和 worker_loop 中的 _sleeping、_epoch 配合：要么提交方看到有线程在休眠，
+    /// 要么休眠的线程在等待之前看到 _epoch 已经变化
+    _epoch.fetch_add(1);
+    if (_sleeping.load() > 0)
+    {
+        {
+            std::lock_guard lock(_sleep_mutex);
+        }
+        _sleep_cv.notify_one();
+    }
+}
+
+
+void JobSystem::submit_main(Job &&job)
+{
+    _main_jobs.push(std::move(job));
+}
+
+
+size_t JobSystem::run_main_jobs()
+{
+    size_t cnt = 0;
+    Job    job;
+    while (_main_jobs.steal(job))
+    {
+        execute(job);
+        ++cnt;
+    }
+    return cnt;
+}
+
+
+bool JobSystem::find_job(Job &job)
+{
+    if (local_queue().pop(job))
+        return true;
+
+    /// 共享队列没有所属的线程，和其他队列一样从头部取
+    const auto cnt   = (uint32_t) _queues.size();
+    const auto start = steal_seed++;
+    for (uint32_t i = 0; i < cnt; ++i)
+    {
+        Queue &queue = *_queues[(start + i) % cnt];
+        if (&queue != &local_queue() && queue.steal(job))
+            return true;
+    }
+    return false;
+}
+
+
+bool JobSystem::run_one()
+{
+    ensure_init();
+    Job job;
+    if ((is_main_thread() && _main_jobs.steal(job)) || find_job(job))
+    {
+        execute(job);
+        return true;
+    }
+    return false;
+}
+
+
+void JobSystem::execute(Job &job)
+{
+    TaskGroup *group = job.group;
+
+    /// 任务中从 FrameArena 分配的内存在任务结束时释放，嵌套执行的任务满足栈的顺序
+    std::exception_ptr error;
+    try
+    {
+        FrameArena::Scope arena_scope;
+        if (group && group->_profile_id != UINT32_MAX)
+        {
+            ProfileScope scope(group->_profile_id, false);
+            job.func();
+        } else
+            job.func();
+    } catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    /// 任务持有的资源在 finish 之前释放，finish 之后 group 可能已经被销毁
+    job.func = nullptr;
+    if (group)
+        group->finish(job, error);
+}
+
+
+void JobSystem::worker_loop(int index)
+{
+    queue_idx  = index;
+    steal_seed = (uint32_t) index;
+
+    int idle = 0;
+    while (!_stop.load(std::memory_order_relaxed))
+    {
+        Job job;
+        if (find_job(job))
+        {
+            execute(job);
+            idle = 0;
+            continue;
+        }
+
+        if (++idle < SPIN_CNT)
+            continue;
+        if (idle < YIELD_CNT)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        /// 先记下 _epoch 再检查一次，之后提交的任务一定会唤醒这个线程
+        const uint64_t epoch = _epoch.load();
+        if (find_job(job))
+        {
+            execute(job);
+            idle = 0;
+            continue;
+        }
+        std::unique_lock lock(_sleep_mutex);
+        _sleeping.fetch_add(1);
+        _sleep_cv.wait(lock, [epoch] { return _stop.load() || _epoch.load() != epoch; });
+        _sleeping.fetch_sub(1);
+        idle = 0;
+    }
+    queue_idx = -1;
+}
+
+
+/// ==================================================================
+
+
+TaskGroup::TaskGroup(const char *profile_name)
+{
+    if (profile_name)
+        _profile_id = Profiler::name_id(profile_name);
+}
+
+
+TaskGroup::~TaskGroup()
+{
+    try
+    {
+        wait();
+    } catch (std::exception &e)
+    {
+        SPDLOG_ERROR("exception in task group: {}", e.what());
+    } catch (...)
+    {
+        SPDLOG_ERROR("exception in task group.");
+    }
+}
+
+
+void TaskGroup::run(std::function<void()> func)
+{
+    _pending.fetch_add(1, std::memory_order_relaxed);
+    JobSystem::submit({.func = std::move(func), .group = this});
+}
+
+
+void TaskGroup::run_on_main(std::function<void()> func)
+{
+    _pending.fetch_add(1, std::memory_order_relaxed);
+    JobSystem::submit_main({.func = std::move(func), .group = this});
+}
+
+
+void TaskGroup::then(std::function<void()> func)
+{
+    {
+        std::lock_guard lock(_mutex);
+        _cont_pending.fetch_add(1, std::memory_order_relaxed);
+        if (_pending.load(std::memory_order_acquire) > 0)
+        {
+            _continuations.push_back(std::move(func));
+            return;
+        }
+    }
+    JobSystem::submit({.func = std::move(func), .group = this, .continuation = true});
+}
+
+
+void TaskGroup::wait()
+{
+    int idle = 0;
+    while (busy())
+    {
+        if (JobSystem::run_one())
+        {
+            idle = 0;
+            continue;
+        }
+        if (++idle < SPIN_CNT)
+            continue;
+        if (idle < YIELD_CNT)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    /// 最后一个任务在锁内修改计数，拿到锁之后它一定不会再访问这个对象
+    std::lock_guard lock(_mutex);
+    if (_error)
+        std::rethrow_exception(std::exchange(_error, nullptr));
+}
+
+
+void TaskGroup::finish(const JobSystem::Job &job, std::exception_ptr error)
+{
+    /// 不是最后一个任务、也没有异常时只修改计数，不需要加锁
+    if (!job.continuation && !error)
+    {
+        size_t cnt = _pending.load(std::memory_order_relaxed);
+        while (cnt > 1)
+            if (_pending.compare_exchange_weak(cnt, cnt - 1, std::memory_order_acq_rel))
+                return;
+    }
+
+    /// 计数归零之后 wait 可能马上返回并销毁这个对象，因此在锁内修改计数，解锁之后不再访问成员；
+    /// 后续任务被计入 _cont_pending，在它们完成之前这个对象不会被销毁
+    std::vector<std::function<void()>> continuations;
+    {
+        std::lock_guard lock(_mutex);
+        if (error && !_error)
+            _error = error;
+        if (job.continuation)
+            _cont_pending.fetch_sub(1, std::memory_order_acq_rel);
+        else if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            continuations.swap(_continuations);
+    }
+    for (auto &func: continuations)
+        JobSystem::submit({.func = std::move(func), .group = this, .continuation = true});
+}
+
+
+/// ==================================================================
+
+
+void parallel_for_range(size_t first, size_t last, size_t grain,
+                        const std::function<void(size_t, size_t)> &func, const char *profile_name)
+{
+    if (first >= last)
+        return;
+    grain = std::max<size_t>(grain, 1);
+
+    const uint32_t profile_id = profile_name ? Profiler::name_id(profile_name) : UINT32_MAX;
+    auto           call       = [&](size_t begin, size_t end) {
+        if (profile_id != UINT32_MAX)
+        {
+            ProfileScope scope(profile_id, false);
+            func(begin, end);
+        } else
+            func(begin, end);
+    };
+
+    /// 只有一个线程或者只有一段时不需要创建任务
+    if (last - first <= grain || JobSystem::thread_cnt() == 1)
+    {
+        for (size_t begin = first; begin < last; begin += grain)
+            call(begin, std::min(begin + grain, last));
+        return;
+    }
+
+    TaskGroup                          group;
+    std::function<void(size_t, size_t)> split = [&](size_t begin, size_t end) {
+        while (end - begin > grain)
+        {
+            const size_t mid = begin + (end - begin) / 2;
+            group.run([&split, mid, end] { split(mid, end); });
+            end = mid;
+        }
+        call(begin, end);
+    };
+    split(first, last);
+    group.wait();
+}
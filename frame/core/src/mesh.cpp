@@ -1,9 +1,81 @@
 #include "../mesh.h"
 
+#include <algorithm>
+#include <cstddef>
+
 
 void Mesh2::draw() const
 {
     glBindVertexArray(vao);
     glDrawElements(primitive_mode, (GLsizei) index_cnt, index_component_type,
                    (void *) index_offset);
-}
\ No newline at end of file
+}
+
+
+void Mesh2::draw_instanced(GLsizei instance_cnt) const
+{
+    glBindVertexArray(vao);
+    glDrawElementsInstanced(primitive_mode, (GLsizei) index_cnt, index_component_type,
+                            (void *) index_offset, instance_cnt);
+}
+
+
+void GLGeometry::release()
+{
+    if (!vaos.empty())
+        glDeleteVertexArrays((GLsizei) vaos.size(), vaos.data());
+    if (!buffers.empty())
+        glDeleteBuffers((GLsizei) buffers.size(), buffers.data());
+    vaos.clear();
+    buffers.clear();
+}
+
+
+void InstanceBuffer::upload(const std::vector<InstanceData> &instances)
+{
+    if (!_buffer)
+        glGenBuffers(1, &_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+
+    /// 容量足够时只更新数据，否则按 2 倍扩容
+    if (instances.size() > _capacity)
+    {
+        _capacity = std::max(instances.size(), 2 * _capacity);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) (_capacity * sizeof(InstanceData)), nullptr,
+                     GL_DYNAMIC_DRAW);
+    }
+    if (!instances.empty())
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr) (instances.size() * sizeof(InstanceData)),
+                        instances.data());
+}
+
+
+void InstanceBuffer::bind(GLuint vao, size_t first_instance) const
+{
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+
+    const size_t base   = first_instance * sizeof(InstanceData);
+    const auto   stride = (GLsizei) sizeof(InstanceData);
+    auto         attrib = [&](GLuint slot, size_t offset) {
+        glEnableVertexAttribArray(slot);
+        glVertexAttribPointer(slot, 4, GL_FLOAT, GL_FALSE, stride, (void *) (base + offset));
+        glVertexAttribDivisor(slot, 1);
+    };
+
+    /// mat4 按列占用 4 个连续的 slot
+    for (GLuint col = 0; col < 4; ++col)
+        attrib(VERTEX_ATTRBUTE_SLOT.instance_model + col,
+               offsetof(InstanceData, model) + col * sizeof(glm::vec4));
+    attrib(VERTEX_ATTRBUTE_SLOT.instance_color, offsetof(InstanceData, base_color));
+    attrib(VERTEX_ATTRBUTE_SLOT.instance_params, offsetof(InstanceData, params));
+}
+
+
+void InstanceBuffer::release()
+{
+    if (_buffer)
+        glDeleteBuffers(1, &_buffer);
+    _buffer   = 0;
+    _capacity = 0;
+}
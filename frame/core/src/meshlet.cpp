@@ -0,0 +1,219 @@
+#include "../meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+
+namespace {
+
+/// 选择下一个三角形时，法线和 meshlet 平均法线的偏差所占的权重
+constexpr float CONE_WEIGHT = 0.5f;
+
+
+/**
+ * 计算 meshlet 的包围球和法线锥
+ * @param tri_normals 每个三角形的单位法线，退化的三角形为 0
+ */
+void compute_bounds(Meshlet &meshlet, const std::vector<glm::vec3> &positions,
+                    const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &tri_normals)
+{
+    const uint32_t first_tri = meshlet.first_index / 3;
+
+    /// 包围球：中心取包围盒的中心，半径取最远的顶点
+    AABB aabb;
+    for (uint32_t i = 0; i < meshlet.triangle_cnt * 3; ++i)
+        aabb.expand(positions[indices[meshlet.first_index + i]]);
+    const glm::vec3 center = aabb.center();
+    float           radius = 0.f;
+    for (uint32_t i = 0; i < meshlet.triangle_cnt * 3; ++i)
+    {
+        const glm::vec3 &p = positions[indices[meshlet.first_index + i]];
+        radius             = std::max(radius, glm::length(p - center));
+    }
+    meshlet.sphere = {.center = center, .radius = radius};
+
+    /// 法线锥的轴：法线的平均方向
+    glm::vec3 axis(0.f);
+    for (uint32_t t = 0; t < meshlet.triangle_cnt; ++t)
+        axis += tri_normals[first_tri + t];
+    if (glm::dot(axis, axis) < 1e-12f)
+        return;
+    axis = glm::normalize(axis);
+
+    /// 和轴夹角最大的法线，决定锥的张角；张角太大时剔除的效果很差，不再计算
+    float min_dp = 1.f;
+    for (uint32_t t = 0; t < meshlet.triangle_cnt; ++t)
+    {
+        const glm::vec3 &n = tri_normals[first_tri + t];
+        if (n != glm::vec3(0.f))
+            min_dp = std::min(min_dp, glm::dot(n, axis));
+    }
+    if (min_dp <= 0.1f)
+        return;
+
+    /// 锥的顶点：沿着轴向后移动，直到所有三角形所在的平面都在顶点的前方
+    float max_t = 0.f;
+    for (uint32_t t = 0; t < meshlet.triangle_cnt; ++t)
+    {
+        const glm::vec3 &n = tri_normals[first_tri + t];
+        if (n == glm::vec3(0.f))
+            continue;
+        const glm::vec3 &p0 = positions[indices[(first_tri + t) * 3]];
+        max_t               = std::max(max_t, glm::dot(center - p0, n) / glm::dot(axis, n));
+    }
+
+    meshlet.cone_apex   = center - axis * max_t;
+    meshlet.cone_axis   = axis;
+    meshlet.cone_cutoff = std::sqrt(1.f - min_dp * min_dp);
+}
+
+}    // namespace
+
+
+std::vector<Meshlet> build_meshlets(const std::vector<glm::vec3> &positions,
+                                    std::vector<uint32_t>        &indices)
+{
+    const size_t tri_cnt = indices.size() / 3;
+
+    std::vector<glm::vec3> tri_normals(tri_cnt, glm::vec3(0.f));
+    std::vector<glm::vec3> tri_centers(tri_cnt);
+    for (size_t t = 0; t < tri_cnt; ++t)
+    {
+        const glm::vec3 &p0 = positions[indices[t * 3]];
+        const glm::vec3 &p1 = positions[indices[t * 3 + 1]];
+        const glm::vec3 &p2 = positions[indices[t * 3 + 2]];
+        const glm::vec3  n  = glm::cross(p1 - p0, p2 - p0);
+        const float      len = glm::length(n);
+        if (len > 0.f)
+            tri_normals[t] = n / len;
+        tri_centers[t] = (p0 + p1 + p2) / 3.f;
+    }
+
+    /// 位置相同的顶点（uv 或法线的接缝处）在邻接关系中视为同一个顶点
+    std::vector<uint32_t> weld(positions.size());
+    {
+        std::vector<uint32_t> sorted(positions.size());
+        for (uint32_t v = 0; v < positions.size(); ++v)
+            sorted[v] = v;
+        auto less = [&](uint32_t a, uint32_t b) {
+            const glm::vec3 &pa = positions[a], &pb = positions[b];
+            return std::tie(pa.x, pa.y, pa.z) < std::tie(pb.x, pb.y, pb.z);
+        };
+        std::sort(sorted.begin(), sorted.end(), less);
+        for (size_t i = 0; i < sorted.size(); ++i)
+            weld[sorted[i]] = (i > 0 && positions[sorted[i]] == positions[sorted[i - 1]])
+                                    ? weld[sorted[i - 1]]
+                                    : sorted[i];
+    }
+
+    /// 顶点到三角形的邻接表（CSR）
+    std::vector<uint32_t> adj_offset(positions.size() + 1, 0);
+    for (uint32_t v: indices)
+        adj_offset[weld[v] + 1]++;
+    for (size_t v = 0; v < positions.size(); ++v)
+        adj_offset[v + 1] += adj_offset[v];
+    std::vector<uint32_t> adj_tris(indices.size());
+    {
+        std::vector<uint32_t> fill(adj_offset.begin(), adj_offset.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i)
+            adj_tris[fill[weld[indices[i]]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    /// 每个顶点最后一次被哪个 meshlet 引用，用于统计 meshlet 中不同顶点的数量
+    std::vector<uint32_t> vertex_owner(positions.size(), UINT32_MAX);
+    std::vector<bool>     tri_used(tri_cnt, false);
+    std::vector<uint32_t> order;    // 按 meshlet 排列之后的三角形
+    order.reserve(tri_cnt);
+
+    std::vector<Meshlet>  meshlets;
+    std::vector<uint32_t> cur_vertices;
+    size_t                seed = 0;    // 下一个还没有使用的三角形，用于开始新的 meshlet
+    while (order.size() < tri_cnt)
+    {
+        while (tri_used[seed])
+            ++seed;
+
+        const auto id = static_cast<uint32_t>(meshlets.size());
+        Meshlet    cur{.first_index = static_cast<uint32_t>(order.size() * 3)};
+        glm::vec3  center_sum(0.f), normal_sum(0.f);
+        cur_vertices.clear();
+
+        auto new_vertex_cnt = [&](uint32_t t) {
+            uint32_t cnt = 0;
+            for (int k = 0; k < 3; ++k)
+                cnt += vertex_owner[indices[t * 3 + k]] != id;
+            return cnt;
+        };
+        auto append = [&](uint32_t t) {
+            for (int k = 0; k < 3; ++k)
+            {
+                const uint32_t v = indices[t * 3 + k];
+                if (vertex_owner[v] != id)
+                {
+                    vertex_owner[v] = id;
+                    cur_vertices.push_back(v);
+                }
+            }
+            tri_used[t] = true;
+            order.push_back(t);
+            center_sum += tri_centers[t];
+            normal_sum += tri_normals[t];
+            cur.triangle_cnt++;
+        };
+
+        /// 从种子开始，每次从和 meshlet 共享顶点的三角形中选择一个：
+        /// 优先新增顶点少的，其次离 meshlet 中心近且法线接近的
+        append(static_cast<uint32_t>(seed));
+        while (cur.triangle_cnt < MESHLET_MAX_TRIANGLES)
+        {
+            const glm::vec3 center = center_sum / (float) cur.triangle_cnt;
+            const float     n_len  = glm::length(normal_sum);
+            const glm::vec3 axis   = n_len > 0.f ? normal_sum / n_len : glm::vec3(0.f);
+
+            uint32_t best       = UINT32_MAX;
+            uint32_t best_new   = 4;
+            float    best_score = 0.f;
+            for (uint32_t v: cur_vertices)
+                for (uint32_t a = adj_offset[weld[v]]; a < adj_offset[weld[v] + 1]; ++a)
+                {
+                    const uint32_t t = adj_tris[a];
+                    if (tri_used[t])
+                        continue;
+                    const uint32_t new_cnt = new_vertex_cnt(t);
+                    if (cur_vertices.size() + new_cnt > MESHLET_MAX_VERTICES || new_cnt > best_new)
+                        continue;
+                    const float spread = 1.f - glm::dot(tri_normals[t], axis);
+                    const float score  = glm::length(tri_centers[t] - center) *
+                                         (1.f + CONE_WEIGHT * spread);
+                    if (new_cnt < best_new || score < best_score)
+                    {
+                        best       = t;
+                        best_new   = new_cnt;
+                        best_score = score;
+                    }
+                }
+            if (best == UINT32_MAX)
+                break;
+            append(best);
+        }
+
+        cur.vertex_cnt = static_cast<uint32_t>(cur_vertices.size());
+        meshlets.push_back(cur);
+    }
+
+    /// 按 meshlet 的顺序重排索引，每个 meshlet 是索引中连续的一段
+    std::vector<uint32_t> reordered(indices.size());
+    std::vector<glm::vec3> reordered_normals(tri_cnt);
+    for (size_t i = 0; i < tri_cnt; ++i)
+    {
+        for (int k = 0; k < 3; ++k)
+            reordered[i * 3 + k] = indices[order[i] * 3 + k];
+        reordered_normals[i] = tri_normals[order[i]];
+    }
+    indices.swap(reordered);
+
+    for (auto &meshlet: meshlets)
+        compute_bounds(meshlet, positions, indices, reordered_normals);
+    return meshlets;
+}
@@ -0,0 +1,50 @@
+#include "../model-manager.h"
+
+#include <filesystem>
+
+
+const std::vector<RTObject> &ModelManager::load(const std::string &file_path,
+                                                unsigned int       import_flags)
+{
+    /// 同一个文件可能通过不同的相对路径引用，因此使用规范化的路径
+    const std::filesystem::path path    = std::filesystem::weakly_canonical(file_path);
+    const bool                  is_gltf = path.extension() == ".gltf";
+
+    auto key = std::make_pair(path.string(), is_gltf ? 0u : import_flags);
+
+    auto iter = m.find(key);
+    if (iter != m.end())
+        return iter->second.obj_list;
+
+    Entry entry;
+    entry.obj_list = is_gltf ? ImportGLTF::load_gltf(file_path)
+                             : ImportObj::load_obj(file_path, import_flags);
+    if (!entry.obj_list.empty())
+        entry.geometry = entry.obj_list.front().mesh.geometry;
+
+    return m.emplace(std::move(key), std::move(entry)).first->second.obj_list;
+}
+
+
+size_t ModelManager::release_unused()
+{
+    size_t release_cnt = 0;
+    for (auto iter = m.begin(); iter != m.end();)
+    {
+        /// entry 自身持有 1 + obj_list.size() 个引用，多出来的就是外部的拷贝
+        const Entry &entry = iter->second;
+        if (entry.geometry && entry.geometry.use_count() > (long) (1 + entry.obj_list.size()))
+        {
+            ++iter;
+            continue;
+        }
+
+        if (entry.geometry)
+            entry.geometry->release();
+        iter = m.erase(iter);
+        ++release_cnt;
+    }
+
+    SPDLOG_INFO("release unused models: {}, remain: {}", release_cnt, m.size());
+    return release_cnt;
+}
@@ -0,0 +1,163 @@
+#include "../object-buffer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "../misc.h"
+
+
+void ObjectDataBuffer::resize(size_t cnt)
+{
+    const size_t old_cnt = _data.size();
+    _data.resize(cnt, InstanceData::from(glm::mat4(1.f), Material{}));
+    _dirty.resize((cnt + 63) / 64, 0);
+
+    /// 新增的物体需要上传；多余的位要清掉，避免之后 resize 变大时残留
+    for (size_t i = old_cnt; i < cnt; ++i)
+        mark_dirty(static_cast<uint32_t>(i));
+    if (cnt % 64 != 0)
+        _dirty.back() &= (1ull << (cnt % 64)) - 1;
+}
+
+
+size_t ObjectDataBuffer::max_objects()
+{
+    static const size_t max_cnt = [] {
+        GLint max_texels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+        return (size_t) max_texels / TEXELS_PER_OBJECT;
+    }();
+    return max_cnt;
+}
+
+
+void ObjectDataBuffer::set(uint32_t id, const InstanceData &data)
+{
+    if (std::memcmp(&_data[id], &data, sizeof(InstanceData)) == 0)
+        return;
+    _data[id] = data;
+    mark_dirty(id);
+}
+
+
+void ObjectDataBuffer::set_matrix(uint32_t id, const glm::mat4 &matrix)
+{
+    if (_data[id].model == matrix)
+        return;
+    _data[id].model = matrix;
+    mark_dirty(id);
+}
+
+
+void ObjectDataBuffer::set_material(uint32_t id, const Material &mat)
+{
+    const InstanceData data = InstanceData::from(_data[id].model, mat);
+    set(id, data);
+}
+
+
+void ObjectDataBuffer::sync(const SceneView &scene)
+{
+    resize(scene.size());
+    for (size_t i = 0; i < scene.size(); ++i)
+        set(static_cast<uint32_t>(i), InstanceData::from(scene.matrices[i], scene.material(i)));
+}
+
+
+void ObjectDataBuffer::sync(const std::vector<RTObject> &objs)
+{
+    resize(objs.size());
+    for (size_t i = 0; i < objs.size(); ++i)
+        set(static_cast<uint32_t>(i), InstanceData::from(objs[i].matrix(), objs[i].mesh.mat));
+}
+
+
+size_t ObjectDataBuffer::upload()
+{
+    _last_ranges = 0;
+    if (!_any_dirty || _data.empty())
+        return 0;
+
+    if (!_buffer)
+    {
+        glGenBuffers(1, &_buffer);
+        glGenTextures(1, &_texture);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, _buffer);
+
+    size_t bytes = 0;
+    if (_data.size() > _capacity)
+    {
+        /// 容量不足：按 2 倍扩容，上传全部数据；超过 texel 上限的部分着色器读不到
+        const size_t max_cnt = max_objects();
+        if (_data.size() > max_cnt)
+            LOG_AND_THROW("too many objects for the object data buffer: {}, "
+                          "GL_MAX_TEXTURE_BUFFER_SIZE allows {}",
+                          _data.size(), max_cnt);
+        _capacity = std::min(std::max(_data.size(), 2 * _capacity), max_cnt);
+        glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr) (_capacity * sizeof(InstanceData)), nullptr,
+                     GL_DYNAMIC_DRAW);
+        bytes = _data.size() * sizeof(InstanceData);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, (GLsizeiptr) bytes, _data.data());
+        _last_ranges = 1;
+
+        glBindTexture(GL_TEXTURE_BUFFER, _texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, _buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    } else
+    {
+        /// 找出连续的脏物体 [first, last)，每个区间上传一次
+        const size_t cnt   = _data.size();
+        size_t       first = 0;
+        while (first < cnt)
+        {
+            /// 跳过干净的 64 位
+            const size_t   word = first / 64;
+            const uint64_t bits = _dirty[word] >> (first % 64);
+            if (bits == 0)
+            {
+                first = (word + 1) * 64;
+                continue;
+            }
+            first += std::countr_zero(bits);
+
+            size_t last = first;
+            while (last < cnt && (_dirty[last / 64] >> (last % 64) & 1ull))
+                ++last;
+
+            const size_t offset = first * sizeof(InstanceData);
+            const size_t size   = (last - first) * sizeof(InstanceData);
+            glBufferSubData(GL_TEXTURE_BUFFER, (GLintptr) offset, (GLsizeiptr) size, &_data[first]);
+            bytes += size;
+            ++_last_ranges;
+            first = last;
+        }
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    std::fill(_dirty.begin(), _dirty.end(), 0);
+    _any_dirty = false;
+    return bytes;
+}
+
+
+void ObjectDataBuffer::bind(int texture_unit) const
+{
+    glBindTexture_(GL_TEXTURE_BUFFER, texture_unit, _texture);
+}
+
+
+void ObjectDataBuffer::release()
+{
+    if (_texture)
+        glDeleteTextures(1, &_texture);
+    if (_buffer)
+        glDeleteBuffers(1, &_buffer);
+    _texture  = 0;
+    _buffer   = 0;
+    _capacity = 0;
+
+    /// 重新创建缓冲时需要上传全部数据
+    _any_dirty = true;
+}
@@ -0,0 +1,363 @@
+#include "../occlusion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "../import-obj.h"
+#include "../simd.h"
+
+
+void Occluder::simplify(size_t max_triangles)
+{
+    const size_t tri_cnt = triangle_cnt();
+    if (max_triangles == 0 || tri_cnt <= max_triangles)
+        return;
+
+    std::vector<float> areas(tri_cnt);
+    for (size_t i = 0; i < tri_cnt; ++i)
+    {
+        const glm::vec3 &p0 = positions[indices[3 * i]];
+        const glm::vec3 &p1 = positions[indices[3 * i + 1]];
+        const glm::vec3 &p2 = positions[indices[3 * i + 2]];
+        areas[i]            = glm::length(glm::cross(p1 - p0, p2 - p0));
+    }
+
+    std::vector<uint32_t> order(tri_cnt);
+    std::iota(order.begin(), order.end(), 0);
+    std::nth_element(order.begin(), order.begin() + (ptrdiff_t) max_triangles, order.end(),
+                     [&](uint32_t a, uint32_t b) { return areas[a] > areas[b]; });
+    order.resize(max_triangles);
+
+    std::vector<uint32_t> new_indices;
+    new_indices.reserve(3 * max_triangles);
+    for (uint32_t tri: order)
+        new_indices.insert(new_indices.end(),
+                           {indices[3 * tri], indices[3 * tri + 1], indices[3 * tri + 2]});
+    indices = std::move(new_indices);
+}
+
+
+Occluder Occluder::from_obj(const std::string &path, size_t max_triangles)
+{
+    constexpr size_t STRIDE = 8;    // pos, normal, uv，和 ImportObj 的顶点格式一致
+
+    Occluder occluder;
+    for (const auto &data: read_obj(path))
+    {
+        const auto base = (uint32_t) occluder.positions.size();
+        for (size_t i = 0; i + STRIDE <= data.vertices.size(); i += STRIDE)
+            occluder.positions.emplace_back(data.vertices[i], data.vertices[i + 1],
+                                            data.vertices[i + 2]);
+        for (auto idx: data.faces)
+            occluder.indices.push_back(base + idx);
+    }
+    occluder.simplify(max_triangles);
+    return occluder;
+}
+
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+    : _width((width + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE),
+      _height((height + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE),
+      _tile_cols(_width / TILE_SIZE),
+      _tile_rows(_height / TILE_SIZE),
+      _depth((size_t) _width * _height, 1.f),
+      _hiz((size_t) _tile_cols * _tile_rows, 1.f)
+{}
+
+
+OcclusionCuller::~OcclusionCuller()
+{
+    /// 任务使用其他成员，需要在成员析构之前完成；这时任务中的异常已经没有办法处理
+    try
+    {
+        _task.wait();
+    } catch (...)
+    {
+    }
+}
+
+
+void OcclusionCuller::clear(const glm::mat4 &vp)
+{
+    _vp = vp;
+    std::fill(_depth.begin(), _depth.end(), 1.f);
+    std::fill(_hiz.begin(), _hiz.end(), 1.f);
+}
+
+
+void OcclusionCuller::rasterize(const Occluder &occluder)
+{
+    const glm::mat4 mvp = _vp * occluder.model;
+
+    std::vector<glm::vec4> clip(occluder.positions.size());
+    for (size_t i = 0; i < clip.size(); ++i)
+        clip[i] = mvp * glm::vec4(occluder.positions[i], 1.f);
+
+    /// 裁剪空间 -> 屏幕空间：x, y 以像素为单位，深度映射到 [0, 1]
+    auto to_screen = [&](const glm::vec4 &c) {
+        const float inv_w = 1.f / c.w;
+        return glm::vec3((c.x * inv_w * 0.5f + 0.5f) * (float) _width,
+                         (c.y * inv_w * 0.5f + 0.5f) * (float) _height, c.z * inv_w * 0.5f + 0.5f);
+    };
+
+    for (size_t t = 0; t + 2 < occluder.indices.size(); t += 3)
+    {
+        const glm::vec4 tri[3] = {clip[occluder.indices[t]], clip[occluder.indices[t + 1]],
+                                  clip[occluder.indices[t + 2]]};
+
+        /// 三个顶点都在同一个裁剪平面之外，直接跳过
+        bool outside = false;
+        for (int axis = 0; axis < 2 && !outside; ++axis)
+            outside = (tri[0][axis] > tri[0].w && tri[1][axis] > tri[1].w &&
+                       tri[2][axis] > tri[2].w) ||
+                      (tri[0][axis] < -tri[0].w && tri[1][axis] < -tri[1].w &&
+                       tri[2][axis] < -tri[2].w);
+        if (outside)
+            continue;
+
+        /// 和近平面 z = -w 裁剪（Sutherland-Hodgman），最多得到 4 个顶点
+        glm::vec4 poly[4];
+        int       poly_cnt = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            const glm::vec4 &a  = tri[i];
+            const glm::vec4 &b  = tri[(i + 1) % 3];
+            const float      da = a.z + a.w;
+            const float      db = b.z + b.w;
+            if (da >= 0.f)
+                poly[poly_cnt++] = a;
+            if ((da >= 0.f) != (db >= 0.f))
+                poly[poly_cnt++] = a + (b - a) * (da / (da - db));
+        }
+        if (poly_cnt < 3)
+            continue;
+
+        const glm::vec3 v0 = to_screen(poly[0]);
+        for (int i = 1; i + 1 < poly_cnt; ++i)
+            rasterize_triangle(v0, to_screen(poly[i]), to_screen(poly[i + 1]));
+    }
+}
+
+
+void OcclusionCuller::rasterize_triangle(const glm::vec3 &v0, const glm::vec3 &v1_,
+                                         const glm::vec3 &v2_)
+{
+    /// 统一为逆时针，遮挡物不做背面剔除
+    glm::vec3 v1 = v1_, v2 = v2_;
+    float     area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+    if (std::abs(area) < 1e-8f)
+        return;
+    if (area < 0.f)
+    {
+        std::swap(v1, v2);
+        area = -area;
+    }
+
+    /// 包围矩形，x 方向对齐到 4 个像素
+    int min_x = std::max(0, (int) std::floor(std::min({v0.x, v1.x, v2.x})));
+    int max_x = std::min(_width - 1, (int) std::ceil(std::max({v0.x, v1.x, v2.x})));
+    int min_y = std::max(0, (int) std::floor(std::min({v0.y, v1.y, v2.y})));
+    int max_y = std::min(_height - 1, (int) std::ceil(std::max({v0.y, v1.y, v2.y})));
+    if (min_x > max_x || min_y > max_y)
+        return;
+    min_x &= ~(f32x4::WIDTH - 1);
+
+    /**
+     * 边函数 E(p) = A * p.x + B * p.y + C，三角形内部的点三个边函数都不小于 0
+     * 第 i 条边的对面是第 i 个顶点，E_i / area 就是这个顶点的重心坐标
+     */
+    struct Edge {
+        float a, b, c;
+    };
+    auto make_edge = [](const glm::vec3 &p, const glm::vec3 &q) {
+        const float a = -(q.y - p.y);
+        const float b = q.x - p.x;
+        return Edge{a, b, -(a * p.x + b * p.y)};
+    };
+    const Edge e0 = make_edge(v1, v2);
+    const Edge e1 = make_edge(v2, v0);
+    const Edge e2 = make_edge(v0, v1);
+
+    /// 深度在屏幕空间中是线性的：z = za * x + zb * y + zc
+    const float inv_area = 1.f / area;
+    const float za       = (e0.a * v0.z + e1.a * v1.z + e2.a * v2.z) * inv_area;
+    const float zb       = (e0.b * v0.z + e1.b * v1.z + e2.b * v2.z) * inv_area;
+    const float zc       = (e0.c * v0.z + e1.c * v1.z + e2.c * v2.z) * inv_area;
+
+    const float offsets[4] = {0.5f, 1.5f, 2.5f, 3.5f};    // 像素中心
+    const f32x4 zero       = f32x4::broadcast(0.f);
+    const f32x4 e0_a = f32x4::broadcast(e0.a), e1_a = f32x4::broadcast(e1.a);
+    const f32x4 e2_a = f32x4::broadcast(e2.a), z_a = f32x4::broadcast(za);
+
+    for (int y = min_y; y <= max_y; ++y)
+    {
+        const float py  = (float) y + 0.5f;
+        const f32x4 e0_c = f32x4::broadcast(e0.b * py + e0.c);
+        const f32x4 e1_c = f32x4::broadcast(e1.b * py + e1.c);
+        const f32x4 e2_c = f32x4::broadcast(e2.b * py + e2.c);
+        const f32x4 z_c  = f32x4::broadcast(zb * py + zc);
+        float      *row  = _depth.data() + (size_t) y * _width;
+
+        for (int x = min_x; x <= max_x; x += f32x4::WIDTH)
+        {
+            const f32x4 px = f32x4::load(offsets) + f32x4::broadcast((float) x);
+            const f32x4 inside =
+                    f32x4::cmp_ge(f32x4::fmadd(e0_a, px, e0_c), zero) &
+                    f32x4::cmp_ge(f32x4::fmadd(e1_a, px, e1_c), zero) &
+                    f32x4::cmp_ge(f32x4::fmadd(e2_a, px, e2_c), zero);
+            if (inside.movemask() == 0)
+                continue;
+
+            const f32x4 z   = f32x4::fmadd(z_a, px, z_c);
+            const f32x4 cur = f32x4::load(row + x);
+            f32x4::select(inside, f32x4::min(z, cur), cur).store(row + x);
+        }
+    }
+}
+
+
+void OcclusionCuller::build_hiz()
+{
+    for (int ty = 0; ty < _tile_rows; ++ty)
+        for (int tx = 0; tx < _tile_cols; ++tx)
+        {
+            f32x4 m = f32x4::broadcast(0.f);
+            for (int y = ty * TILE_SIZE; y < (ty + 1) * TILE_SIZE; ++y)
+                for (int x = tx * TILE_SIZE; x < (tx + 1) * TILE_SIZE; x += f32x4::WIDTH)
+                    m = f32x4::max(m, f32x4::load(_depth.data() + (size_t) y * _width + x));
+            _hiz[(size_t) ty * _tile_cols + tx] = m.hmax();
+        }
+}
+
+
+bool OcclusionCuller::test(const AABB &world_aabb) const
+{
+    if (!world_aabb.valid())
+        return true;
+
+    /// 投影 8 个顶点，得到屏幕空间的矩形和最近的深度
+    glm::vec2 s_min{FLT_MAX}, s_max{-FLT_MAX};
+    float     z_min = FLT_MAX;
+    for (int i = 0; i < 8; ++i)
+    {
+        const glm::vec3 corner = {(i & 1) ? world_aabb.max.x : world_aabb.min.x,
+                                  (i & 2) ? world_aabb.max.y : world_aabb.min.y,
+                                  (i & 4) ? world_aabb.max.z : world_aabb.min.z};
+        const glm::vec4 c      = _vp * glm::vec4(corner, 1.f);
+
+        /// 和近平面相交，保守地认为可见
+        if (c.w <= 1e-6f || c.z < -c.w)
+            return true;
+
+        const float inv_w = 1.f / c.w;
+        const float sx    = (c.x * inv_w * 0.5f + 0.5f) * (float) _width;
+        const float sy    = (c.y * inv_w * 0.5f + 0.5f) * (float) _height;
+        s_min             = {std::min(s_min.x, sx), std::min(s_min.y, sy)};
+        s_max             = {std::max(s_max.x, sx), std::max(s_max.y, sy)};
+        z_min             = std::min(z_min, c.z * inv_w * 0.5f + 0.5f);
+    }
+
+    const int x0 = std::max(0, (int) std::floor(s_min.x));
+    const int x1 = std::min(_width - 1, (int) std::ceil(s_max.x) - 1);
+    const int y0 = std::max(0, (int) std::floor(s_min.y));
+    const int y1 = std::min(_height - 1, (int) std::ceil(s_max.y) - 1);
+    if (x0 > x1 || y0 > y1 || z_min > 1.f)
+        return true;
+
+    const f32x4 z_min4     = f32x4::broadcast(z_min);
+    const float lanes[4]   = {0.f, 1.f, 2.f, 3.f};
+    const f32x4 lane_index = f32x4::load(lanes);
+    for (int ty = y0 / TILE_SIZE; ty <= y1 / TILE_SIZE; ++ty)
+        for (int tx = x0 / TILE_SIZE; tx <= x1 / TILE_SIZE; ++tx)
+        {
+            /// tile 中最远的深度都比包围盒近，整个 tile 都遮挡住了包围盒
+            if (z_min > _hiz[(size_t) ty * _tile_cols + tx])
+                continue;
+
+            /// 逐像素比较，只考虑落在矩形中的像素
+            const int   px0 = std::max(x0, tx * TILE_SIZE), px1 = std::min(x1, tx * TILE_SIZE + 7);
+            const int   py0 = std::max(y0, ty * TILE_SIZE), py1 = std::min(y1, ty * TILE_SIZE + 7);
+            const f32x4 lo  = f32x4::broadcast((float) px0);
+            const f32x4 hi  = f32x4::broadcast((float) px1);
+            for (int y = py0; y <= py1; ++y)
+                for (int x = px0 & ~(f32x4::WIDTH - 1); x <= px1; x += f32x4::WIDTH)
+                {
+                    const f32x4 px    = lane_index + f32x4::broadcast((float) x);
+                    const f32x4 in    = f32x4::cmp_ge(px, lo) & f32x4::cmp_le(px, hi);
+                    const f32x4 depth = f32x4::load(_depth.data() + (size_t) y * _width + x);
+                    if ((f32x4::cmp_ge(depth, z_min4) & in).movemask() != 0)
+                        return true;
+                }
+        }
+    return false;
+}
+
+
+CullStats OcclusionCuller::filter(const std::vector<RTObject> &objs,
+                                  std::vector<uint32_t> &visible) const
+{
+    const size_t total = visible.size();
+    visible.erase(std::remove_if(visible.begin(), visible.end(),
+                                 [&](uint32_t idx) { return !test(objs[idx].world_aabb()); }),
+                  visible.end());
+    return {.visible = visible.size(), .culled = total - visible.size()};
+}
+
+
+CullStats OcclusionCuller::filter(std::span<const AABB>  world_bounds,
+                                  std::vector<uint32_t> &visible) const
+{
+    const size_t total = visible.size();
+    visible.erase(std::remove_if(visible.begin(), visible.end(),
+                                 [&](uint32_t idx) { return !test(world_bounds[idx]); }),
+                  visible.end());
+    return {.visible = visible.size(), .culled = total - visible.size()};
+}
+
+
+void OcclusionCuller::cull_async(const glm::mat4 &vp, const std::vector<Occluder> &occluders,
+                                 const std::vector<RTObject> &objs,
+                                 std::vector<uint32_t>        candidates)
+{
+    launch(vp, occluders, std::move(candidates),
+           [this, &objs](std::vector<uint32_t> &visible) { return filter(objs, visible); });
+}
+
+
+void OcclusionCuller::cull_async(const glm::mat4 &vp, const std::vector<Occluder> &occluders,
+                                 std::span<const AABB> world_bounds,
+                                 std::vector<uint32_t> candidates)
+{
+    launch(vp, occluders, std::move(candidates),
+           [this, world_bounds](std::vector<uint32_t> &visible) {
+               return filter(world_bounds, visible);
+           });
+}
+
+
+void OcclusionCuller::launch(const glm::mat4 &vp, const std::vector<Occluder> &occluders,
+                             std::vector<uint32_t>                             candidates,
+                             std::function<CullStats(std::vector<uint32_t> &)> filter_func)
+{
+    _task.wait();
+
+    _async_visible = std::move(candidates);
+    _async_filter  = std::move(filter_func);
+    _task.run([this, vp, &occluders] {
+        clear(vp);
+        for (const auto &occluder: occluders)
+            rasterize(occluder);
+        build_hiz();
+        _async_stats = _async_filter(_async_visible);
+    });
+}
+
+
+CullStats OcclusionCuller::wait(std::vector<uint32_t> &visible)
+{
+    _task.wait();
+    visible = _async_visible;
+    return _async_stats;
+}
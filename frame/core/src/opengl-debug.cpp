@@ -0,0 +1,147 @@
+#include "../opengl-debug.h"
+
+#include <mutex>
+#include <unordered_map>
+
+#include <spdlog/spdlog.h>
+
+#include "../opengl-ext.h"
+
+
+namespace {
+
+/// 回调函数可能在驱动的线程中执行，因此重复计数需要加锁
+std::mutex                      repeat_mutex;
+std::unordered_map<GLuint, int> repeat_cnt;
+
+
+const char *source_str(GLenum source)
+{
+    switch (source)
+    {
+        case GL_DEBUG_SOURCE_API: return "api";
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+        case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+        case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+        case GL_DEBUG_SOURCE_APPLICATION: return "application";
+        default: return "other";
+    }
+}
+
+
+const char *type_str(GLenum type)
+{
+    switch (type)
+    {
+        case GL_DEBUG_TYPE_ERROR: return "error";
+        case GL_DEBUG_TYPE_DEPRECATED: return "deprecated";
+        case GL_DEBUG_TYPE_UNDEFINED: return "undefined behavior";
+        case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+        case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+        case GL_DEBUG_TYPE_MARKER: return "marker";
+        default: return "other";
+    }
+}
+
+}    // namespace
+
+
+bool GLDebug::init(bool synchronous)
+{
+    if (!GLExtension::debug_output())
+    {
+        SPDLOG_INFO("debug output is not supported, use glGetError.");
+        return false;
+    }
+
+    glEnable(GL_DEBUG_OUTPUT);
+    GLExtension::debug_message_callback()(callback, nullptr);
+
+    /// notification 通常是缓冲区放在显存中之类的信息，数量很多
+    GLExtension::debug_message_control()(GL_DONT_CARE, GL_DONT_CARE,
+                                         GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+    glGetIntegerv(GL_MAX_LABEL_LENGTH, &_max_label_length);
+
+    GLint flags = 0;
+    glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+
+    _enabled = true;
+    set_synchronous(synchronous);
+    SPDLOG_INFO("debug output: enabled, debug context: {}, synchronous: {}",
+                (flags & GL_CONTEXT_FLAG_DEBUG_BIT) != 0, synchronous);
+    return true;
+}
+
+
+void GLDebug::set_synchronous(bool synchronous)
+{
+    if (!_enabled)
+        return;
+    if (synchronous)
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    else
+        glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    _synchronous = synchronous;
+}
+
+
+void GLDebug::ignore(GLuint id)
+{
+    if (!_enabled)
+        return;
+    GLExtension::debug_message_control()(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 1, &id,
+                                         GL_FALSE);
+}
+
+
+void GLDebug::label(GLenum identifier, GLuint name, const std::string &label)
+{
+    if (!_enabled || name == 0 || _max_label_length <= 1)
+        return;
+
+    /// 名称通常是文件路径，末尾的部分更有用
+    const size_t max_len = (size_t) _max_label_length - 1;
+    const size_t offset  = label.size() > max_len ? label.size() - max_len : 0;
+    GLExtension::object_label()(identifier, name, (GLsizei) (label.size() - offset),
+                                label.c_str() + offset);
+}
+
+
+void APIENTRY GLDebug::callback(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                GLsizei length, const GLchar *message, const void *)
+{
+    if (type == GL_DEBUG_TYPE_PUSH_GROUP || type == GL_DEBUG_TYPE_POP_GROUP)
+        return;
+    if (type == GL_DEBUG_TYPE_ERROR)
+        _error_cnt.fetch_add(1, std::memory_order_relaxed);
+
+    int repeat;
+    {
+        std::lock_guard lock(repeat_mutex);
+        repeat = ++repeat_cnt[id];
+    }
+    if (repeat > MAX_REPEAT)
+        return;
+
+    /// 同步模式下回调函数在出错的调用中执行，最近一次 CHECK_GL_ERROR 就在这次调用之前
+    std::string location;
+    if (_synchronous && _file)
+        location = fmt::format(", after {}:{}", _file, _line);
+    const std::string msg  = length < 0 ? std::string(message) : std::string(message, length);
+    const std::string last = repeat == MAX_REPEAT ? " (repeated, muted)" : "";
+
+    switch (severity)
+    {
+        case GL_DEBUG_SEVERITY_HIGH:
+            SPDLOG_ERROR("OpenGL {} {} #{}: {}{}{}", source_str(source), type_str(type), id, msg,
+                         location, last);
+            break;
+        case GL_DEBUG_SEVERITY_MEDIUM:
+            SPDLOG_WARN("OpenGL {} {} #{}: {}{}{}", source_str(source), type_str(type), id, msg,
+                        location, last);
+            break;
+        default:
+            SPDLOG_INFO("OpenGL {} {} #{}: {}{}{}", source_str(source), type_str(type), id, msg,
+                        location, last);
+    }
+}
@@ -0,0 +1,75 @@
+#include "../opengl-ext.h"
+
+#include <spdlog/spdlog.h>
+
+
+void GLExtension::init(GLADloadproc loader)
+{
+    _loader = loader;
+
+    /// 读取扩展列表，3.0 之后只能通过 glGetStringi 逐个读取
+    GLint ext_cnt = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &ext_cnt);
+    _extensions.clear();
+    for (GLint i = 0; i < ext_cnt; ++i)
+        _extensions.emplace(reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i)));
+
+    /// parallel shader compile：KHR 和 ARB 版本的接口是相同的，只是函数名称不同
+    {
+        PFNGLMAXSHADERCOMPILERTHREADSKHRPROC max_compiler_threads = nullptr;
+        if (is_supported("GL_KHR_parallel_shader_compile"))
+            max_compiler_threads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) loader(
+                    "glMaxShaderCompilerThreadsKHR");
+        else if (is_supported("GL_ARB_parallel_shader_compile"))
+            max_compiler_threads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) loader(
+                    "glMaxShaderCompilerThreadsARB");
+
+        _parallel_shader_compile = max_compiler_threads != nullptr;
+        if (_parallel_shader_compile)
+        {
+            /// 0xFFFFFFFF 表示由驱动决定使用多少个线程
+            max_compiler_threads(0xFFFFFFFF);
+        }
+    }
+
+    /// multi draw indirect：4.3 的核心功能，或者同时支持两个 ARB 扩展
+    {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        const bool core_43 = major > 4 || (major == 4 && minor >= 3);
+        const bool arb     = is_supported("GL_ARB_multi_draw_indirect") &&
+                             is_supported("GL_ARB_base_instance");
+
+        _multi_draw_elements_indirect = nullptr;
+        if (core_43 || arb)
+            _multi_draw_elements_indirect =
+                    (PFNGLMULTIDRAWELEMENTSINDIRECTPROC) loader("glMultiDrawElementsIndirect");
+    }
+
+    /// KHR_debug：4.3 的核心功能使用没有后缀的函数名，扩展版本在 core profile 下也没有后缀
+    {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        const bool core_43 = major > 4 || (major == 4 && minor >= 3);
+
+        _debug_message_callback = nullptr;
+        _debug_message_control  = nullptr;
+        _object_label           = nullptr;
+        if (core_43 || is_supported("GL_KHR_debug"))
+        {
+            _debug_message_callback =
+                    (PFNGLDEBUGMESSAGECALLBACKPROC) loader("glDebugMessageCallback");
+            _debug_message_control = (PFNGLDEBUGMESSAGECONTROLPROC) loader("glDebugMessageControl");
+            _object_label          = (PFNGLOBJECTLABELPROC) loader("glObjectLabel");
+            if (!_debug_message_control || !_object_label)
+                _debug_message_callback = nullptr;
+        }
+    }
+
+    SPDLOG_INFO("OpenGL: {}, extensions: {}, parallel shader compile: {}, multi draw indirect: {}, "
+                "debug output: {}",
+                reinterpret_cast<const char *>(glGetString(GL_VERSION)), ext_cnt,
+                _parallel_shader_compile, multi_draw_indirect(), debug_output());
+}
@@ -5,12 +5,26 @@
 #include <sstream>
 #include <fstream>
 
+#include <regex>
+#include <unordered_set>
+
 #include <glad/glad.h>
 #include <spdlog/spdlog.h>
 
+#include "frame-config.hpp"
+#include "../frame-arena.h"
+#include "../opengl-debug.h"
+#include "../startup-trace.h"
+
 
 void check_gl_error(const char *file, int line)
 {
+    if (GLDebug::enabled())
+    {
+        GLDebug::checkpoint(file, line);
+        return;
+    }
+
     GLenum error_code;
     /// 可能会设置多个 error flags，因此需要循环调用，直到返回 GL_NO_ERROR。每调用一次就清除一个 error flag
     while ((error_code = glGetError()) != GL_NO_ERROR)
@@ -47,7 +61,8 @@ void framebuffer_bind(GLuint framebuffer, GLuint depth_buffer,
 
     /// color attachments
     size_t              color_attachment_cnt = color_attachment_list.size();
-    std::vector<GLenum> frag_out_layout;
+    FrameVector<GLenum> frag_out_layout(&FrameArena::local());
+    frag_out_layout.reserve(color_attachment_cnt);
     for (size_t i = 0; i < color_attachment_cnt; ++i)
     {
         glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, color_attachment_list[i], 0);
@@ -159,6 +174,31 @@ GLuint vao(const std::vector<float> &data, const std::vector<unsigned int> &indi
 }
 
 
+/**
+ * 上传的像素数据中每个像素的字节数，用于启动分析，不认识的格式返回 0
+ */
+static size_t pixel_bytes(GLenum format, GLenum type)
+{
+    size_t channels;
+    switch (format)
+    {
+        case GL_RED:
+        case GL_DEPTH_COMPONENT: channels = 1; break;
+        case GL_RG: channels = 2; break;
+        case GL_RGB: channels = 3; break;
+        case GL_RGBA: channels = 4; break;
+        default: return 0;
+    }
+    switch (type)
+    {
+        case GL_UNSIGNED_BYTE: return channels;
+        case GL_HALF_FLOAT: return channels * 2;
+        case GL_FLOAT: return channels * 4;
+        default: return 0;
+    }
+}
+
+
 GLuint new_tex2d(const Tex2DInfo &info)
 {
     GLuint texture_id;
@@ -177,8 +217,14 @@ GLuint new_tex2d(const Tex2DInfo &info)
         external_type   = external_format_iter->second.type;
     }
 
-    glTexImage2D(GL_TEXTURE_2D, 0, info.internal_format, info.width, info.height, 0,
-                 external_format, external_type, info.data);
+    {
+        StartupScope scope("upload");
+        if (info.data)
+            scope.add_bytes((size_t) info.width * info.height *
+                            pixel_bytes(external_format, external_type));
+        glTexImage2D(GL_TEXTURE_2D, 0, info.internal_format, info.width, info.height, 0,
+                     external_format, external_type, info.data);
+    }
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, info.wrap_s);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, info.wrap_t);
@@ -187,7 +233,10 @@ GLuint new_tex2d(const Tex2DInfo &info)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, info.filter_mag);
 
     if (info.mipmap)
+    {
+        StartupScope scope("mipmap");
         glGenerateMipmap(GL_TEXTURE_2D);
+    }
 
     glBindTexture(GL_TEXTURE_2D, 0);
     CHECK_GL_ERROR();
@@ -218,6 +267,10 @@ GLuint new_cubemap(const TexCubeInfo &info)
     // order: +x, -x, +y, -y, +z, -z
     for (int i = 0; i < 6; ++i)
     {
+        StartupScope scope("upload");
+        if (info.data[i])
+            scope.add_bytes((size_t) info.size * info.size *
+                            pixel_bytes(info.external_format, info.external_type));
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, info.internal_format, info.size,
                      info.size, 0, info.external_format, info.external_type, info.data[i]);
     }
@@ -228,7 +281,10 @@ GLuint new_cubemap(const TexCubeInfo &info)
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, info.mag_filter);
 
     if (info.mip_map)
+    {
+        StartupScope scope("mipmap");
         glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    }
 
     glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
     CHECK_GL_ERROR();
@@ -238,61 +294,195 @@ GLuint new_cubemap(const TexCubeInfo &info)
 
 GLuint shader_compile(const std::string &file_path, GLenum shader_type)
 {
-    // read file
-    std::fstream      fs;
-    std::stringstream ss;
-    fs.open(file_path, std::ios::in);
+    GLuint shader_id = shader_compile_submit(file_path, shader_type);
+    shader_check_compile(shader_id, file_path);
+    return shader_id;
+}
+
+
+GLuint shader_link(GLuint vertex, GLuint fragment, GLuint geometry)
+{
+    GLuint program_id = shader_link_submit(vertex, fragment, geometry);
+    shader_check_link(program_id, "");
+    return program_id;
+}
+
+
+/**
+ * 读取整个文本文件
+ * @return 文件无法打开时返回 false
+ */
+static bool read_text_file(const std::string &file_path, std::string &text)
+{
+    std::fstream fs(file_path, std::ios::in);
     if (!fs.is_open())
-    {
-        SPDLOG_ERROR("fail to open file: {}", file_path);
-        throw(std::exception());
-    }
+        return false;
+    std::stringstream ss;
     for (std::string str; std::getline(fs, str); ss << str << '\n')
         ;
-    fs.close();
-    std::string shader_str   = ss.str();
-    auto        shader_c_str = shader_str.c_str();
+    text = ss.str();
+    return true;
+}
+
+
+/**
+ * 递归地展开 include
+ * @param included 已经展开过的文件，避免重复展开和循环 include
+ */
+static void glsl_expand_include(const std::string &file_path, std::stringstream &out,
+                                std::unordered_set<std::string> &included, int depth)
+{
+    if (depth > 16)
+        LOG_AND_THROW("glsl include too deep: {}", file_path);
+
+    std::string text;
+    if (!read_text_file(file_path, text))
+        LOG_AND_THROW("fail to open file: {}", file_path);
+
+    /// #include "file" 或者 include(file)
+    static const std::regex include_regex(R"(^\s*(?:#\s*include\s*[<"]([^>"]+)[>"]|include\(([^)]+)\))\s*$)");
+
+    const std::string dir_path = file_path.substr(0, file_path.find_last_of('/') + 1);
+
+    std::istringstream is(text);
+    std::smatch        match;
+    for (std::string line; std::getline(is, line);)
+    {
+        if (!std::regex_match(line, match, include_regex))
+        {
+            out << line << '\n';
+            continue;
+        }
+
+        /// 依次在当前目录，frame/shader 中查找
+        const std::string name = match[1].matched ? match[1].str() : match[2].str();
+        std::string       include_path;
+        for (const std::string &dir: {dir_path, SHADER})
+        {
+            if (std::fstream(dir + name, std::ios::in).is_open())
+            {
+                include_path = dir + name;
+                break;
+            }
+        }
+        if (include_path.empty())
+            LOG_AND_THROW("can not find include file: {}, in: {}", name, file_path);
+
+        if (included.insert(include_path).second)
+            glsl_expand_include(include_path, out, included, depth + 1);
+    }
+}
+
+
+std::string glsl_preprocess(const std::string &file_path, const ShaderDefines &defines)
+{
+    StartupScope                    scope("file read");
+    std::stringstream               ss;
+    std::unordered_set<std::string> included = {file_path};
+    glsl_expand_include(file_path, ss, included, 0);
+    std::string source = ss.str();
+    scope.add_bytes(source.size());
+
+    if (defines.empty())
+        return source;
+
+    /// 宏定义必须在 #version 之后
+    std::string define_str;
+    for (const auto &[name, value]: defines)
+        define_str += "#define " + name + " " + value + "\n";
+
+    size_t version_pos = source.find("#version");
+    if (version_pos == std::string::npos)
+        return define_str + source;
+    size_t line_end = source.find('\n', version_pos);
+    if (line_end == std::string::npos)
+        return source + "\n" + define_str;
+    return source.insert(line_end + 1, define_str);
+}
+
+
+GLuint shader_compile_submit(const std::string &file_path, GLenum shader_type,
+                             const ShaderDefines &defines)
+{
+    return shader_compile_source_submit(glsl_preprocess(file_path, defines), shader_type);
+}
+
+
+GLuint shader_compile_source_submit(const std::string &source, GLenum shader_type)
+{
+    StartupScope scope("compile");
+    scope.add_bytes(source.size());
+    auto shader_c_str = source.c_str();
 
-    // compile shader
+    // compile shader，这里不查询编译状态，驱动可以在后台编译
     GLuint shader_id = glCreateShader(shader_type);
     glShaderSource(shader_id, 1, &shader_c_str, nullptr);
     glCompileShader(shader_id);
 
-    // check
+    CHECK_GL_ERROR();
+    return shader_id;
+}
+
+
+void shader_check_compile(GLuint shader_id, const std::string &name)
+{
     int  success;
     char info[512];
     glGetShaderiv(shader_id, GL_COMPILE_STATUS, &success);
     if (!success)
     {
         glGetShaderInfoLog(shader_id, 512, nullptr, info);
-        SPDLOG_ERROR("shader compile error: {}, info: \n{}", file_path, info);
+        SPDLOG_ERROR("shader compile error: {}, info: \n{}", name, info);
         throw(std::exception());
     }
-
-    CHECK_GL_ERROR();
-    return shader_id;
 }
 
 
-GLuint shader_link(GLuint vertex, GLuint fragment, GLuint geometry)
+/// 创建过的 program 数量，用于统计
+static size_t g_program_cnt = 0;
+
+
+size_t shader_program_cnt() { return g_program_cnt; }
+
+
+GLuint shader_link_submit(GLuint vertex, GLuint fragment, GLuint geometry)
 {
-    GLuint program_id = glCreateProgram();
+    StartupScope scope("link");
+    GLuint       program_id = glCreateProgram();
+    ++g_program_cnt;
     glAttachShader(program_id, vertex);
     glAttachShader(program_id, fragment);
     if (geometry)
         glAttachShader(program_id, geometry);
     glLinkProgram(program_id);
 
-    // check
-    int  success;
-    char info[512];
-    glGetProgramiv(program_id, GL_LINK_STATUS, &success);
-    if (!success)
-    {
-        glGetProgramInfoLog(program_id, 512, nullptr, info);
-        SPDLOG_ERROR("shader link error, info: {}", info);
-        throw(std::exception());
-    }
+    /// 着色器仍然 attach 在 program 上，这里只是标记删除，之后依然可以查询编译状态
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    if (geometry)
+        glDeleteShader(geometry);
+
     CHECK_GL_ERROR();
     return program_id;
 }
+
+
+void shader_check_link(GLuint program_id, const std::string &name)
+{
+    int success;
+    glGetProgramiv(program_id, GL_LINK_STATUS, &success);
+    if (success)
+        return;
+
+    /// 链接失败，可能是某个着色器编译失败了，先检查各个着色器
+    GLuint  shaders[3];
+    GLsizei shader_cnt = 0;
+    glGetAttachedShaders(program_id, 3, &shader_cnt, shaders);
+    for (GLsizei i = 0; i < shader_cnt; ++i)
+        shader_check_compile(shaders[i], name);
+
+    char info[512];
+    glGetProgramInfoLog(program_id, 512, nullptr, info);
+    SPDLOG_ERROR("shader link error: {}, info: {}", name, info);
+    throw(std::exception());
+}
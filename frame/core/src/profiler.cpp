@@ -0,0 +1,395 @@
+#include "../profiler.h"
+
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+
+#include <imgui.h>
+#include <spdlog/spdlog.h>
+
+
+namespace {
+
+thread_local uint32_t scope_depth = 0;
+thread_local uint32_t scope_seq   = 0;
+
+/// Chrome trace 中 GPU 测量所在的线程
+constexpr uint32_t GPU_TRACE_TID = 1000;
+
+
+struct NameRegistry {
+    std::mutex                                mutex;
+    std::deque<std::string>                   names;
+    std::unordered_map<std::string, uint32_t> lut;
+};
+
+NameRegistry &name_registry()
+{
+    static NameRegistry registry;
+    return registry;
+}
+
+
+/**
+ * 窗口中前 cnt 个元素的百分位数，cnt 超过窗口大小时使用整个窗口
+ */
+template<size_t N>
+Profiler::Percentiles percentiles(const std::array<float, N> &window, size_t cnt)
+{
+    cnt = std::min(cnt, N);
+    if (cnt == 0)
+        return {};
+    std::vector<float> v(window.begin(), window.begin() + (long) cnt);
+    auto at = [&](float p) {
+        auto iter = v.begin() + (long) std::min(cnt - 1, (size_t) (p * (float) cnt));
+        std::nth_element(v.begin(), iter, v.end());
+        return *iter;
+    };
+    return {at(0.50f), at(0.95f), at(0.99f)};
+}
+
+
+std::string json_escape(const std::string &str)
+{
+    std::string res;
+    for (char c: str)
+    {
+        if (c == '"' || c == '\\')
+            res += '\\';
+        res += c;
+    }
+    return res;
+}
+
+}    // namespace
+
+
+std::array<Profiler::FrameQueries, Profiler::QUERY_LATENCY> Profiler::_frame_queries;
+std::vector<Profiler::Rolling>                             Profiler::_rollings;
+
+
+uint32_t Profiler::name_id(const char *name)
+{
+    NameRegistry               &registry = name_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    auto iter = registry.lut.find(name);
+    if (iter != registry.lut.end())
+        return iter->second;
+    const auto id = (uint32_t) registry.names.size();
+    registry.names.emplace_back(name);
+    registry.lut.emplace(name, id);
+    return id;
+}
+
+
+std::string Profiler::name(uint32_t id)
+{
+    NameRegistry               &registry = name_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return id < registry.names.size() ? registry.names[id] : std::string();
+}
+
+
+uint32_t Profiler::thread_index()
+{
+    static std::atomic<uint32_t> thread_cnt{0};
+    thread_local const uint32_t  idx = thread_cnt.fetch_add(1, std::memory_order_relaxed);
+    return idx;
+}
+
+
+double Profiler::now_us()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+            .count();
+}
+
+
+int Profiler::begin_gpu_query()
+{
+    if (_gpu_supported < 0)
+    {
+        GLint bits = 0;
+        glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+        _gpu_supported = bits > 0 ? 1 : 0;
+        SPDLOG_INFO("profiler: gpu timestamp bits: {}", bits);
+    }
+    if (_gpu_supported == 0)
+        return -1;
+
+    FrameQueries &fq = _frame_queries[frame() % QUERY_LATENCY];
+    if (fq.query_cnt == 0)
+    {
+        /// 这一帧的第一个查询，记录 GPU 和 CPU 时间的对应关系
+        fq.frame = frame();
+        glGetInteger64v(GL_TIMESTAMP, &fq.gpu_ref);
+        fq.cpu_ref = now_us();
+    }
+    if (fq.query_cnt + 2 > fq.queries.size())
+    {
+        const size_t old_size = fq.queries.size();
+        fq.queries.resize(std::max(old_size * 2, (size_t) 32));
+        glGenQueries((GLsizei) (fq.queries.size() - old_size), fq.queries.data() + old_size);
+    }
+
+    const auto idx = (int) fq.query_cnt;
+    glQueryCounter(fq.queries[idx], GL_TIMESTAMP);
+    fq.query_cnt += 2;
+    return idx;
+}
+
+
+void Profiler::end_scope(const ProfileSample &sample, int query_begin)
+{
+    if (query_begin < 0)
+    {
+        _ring.push(sample);
+        return;
+    }
+
+    FrameQueries &fq = _frame_queries[sample.frame % QUERY_LATENCY];
+    glQueryCounter(fq.queries[query_begin + 1], GL_TIMESTAMP);
+    fq.pending.push_back(sample);
+    fq.pending_queries.push_back(query_begin);
+}
+
+
+void Profiler::resolve(FrameQueries &fq)
+{
+    /// 逐个检查挂起的测量：外层 scope 的结束查询在内层之后发出，没有结束的 scope 甚至没有发出，
+    /// 不能用某一个查询代表全部；只读取已经可用的结果，GL_QUERY_RESULT 不会等待
+    for (size_t i = 0; i < fq.pending.size(); ++i)
+    {
+        ProfileSample sample    = fq.pending[i];
+        const GLuint  begin_q   = fq.queries[fq.pending_queries[i]];
+        const GLuint  end_q     = fq.queries[fq.pending_queries[i] + 1];
+        GLint         available = 0;
+        glGetQueryObjectiv(end_q, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+            glGetQueryObjectiv(begin_q, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(begin_q, GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(end_q, GL_QUERY_RESULT, &end);
+            sample.gpu_time  = (double) (end - begin) / 1000.0;
+            sample.gpu_begin = (double) ((int64_t) begin - fq.gpu_ref) / 1000.0 + fq.cpu_ref;
+        } else
+            _dropped_gpu_cnt.fetch_add(1, std::memory_order_relaxed);
+        _ring.push(sample);
+    }
+
+    fq.query_cnt = 0;
+    fq.pending.clear();
+    fq.pending_queries.clear();
+}
+
+
+void Profiler::begin_frame()
+{
+    const uint64_t f = _frame.fetch_add(1, std::memory_order_relaxed) + 1;
+    scope_seq        = 0;
+
+    /// 这一组查询上一次使用是在 QUERY_LATENCY 帧之前
+    resolve(_frame_queries[f % QUERY_LATENCY]);
+}
+
+
+void Profiler::end_frame()
+{
+    static std::unordered_map<uint64_t, size_t> lut;    // (thread, name_id) -> _rollings 的下标
+    static std::vector<ProfileSample>           samples;
+
+    samples.clear();
+    _read_pos = _ring.read(_read_pos, samples);
+    for (const ProfileSample &s: samples)
+    {
+        const uint64_t key  = (uint64_t) s.thread << 32 | s.name_id;
+        auto           iter = lut.find(key);
+        if (iter == lut.end())
+        {
+            iter = lut.emplace(key, _rollings.size()).first;
+            _rollings.emplace_back();
+            _rollings.back().stats.name_id = s.name_id;
+            _rollings.back().stats.thread  = s.thread;
+        }
+
+        Rolling &r = _rollings[iter->second];
+        r.cpu[r.stats.cnt++ % WINDOW_SIZE] = (float) (s.cpu_time / 1000.0);
+        if (s.has_gpu())
+            r.gpu[r.gpu_cnt++ % WINDOW_SIZE] = (float) (s.gpu_time / 1000.0);
+        r.stats.depth = s.depth;
+        r.stats.order = (s.frame == 0 ? 0 : 1ull << 32) | s.seq;
+    }
+}
+
+
+std::vector<Profiler::Stats> Profiler::stats()
+{
+    std::vector<Stats> res;
+    for (const Rolling &r: _rollings)
+    {
+        Stats s = r.stats;
+        s.cpu   = percentiles(r.cpu, r.stats.cnt);
+        s.gpu   = percentiles(r.gpu, r.gpu_cnt);
+        res.push_back(s);
+    }
+
+    std::sort(res.begin(), res.end(), [](const Stats &a, const Stats &b) {
+        return std::tie(a.thread, a.order) < std::tie(b.thread, b.order);
+    });
+    return res;
+}
+
+
+void Profiler::draw_gui()
+{
+    ImGui::Begin("profiler");
+    ImGui::Text("frame %llu, dropped gpu results: %zu", (unsigned long long) frame(),
+                dropped_gpu_cnt());
+
+    const ImGuiTableFlags flags =
+            ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit;
+    if (ImGui::BeginTable("scopes", 7, flags))
+    {
+        for (const char *header: {"scope (ms)", "cpu p50", "cpu p95", "cpu p99", "gpu p50",
+                                  "gpu p95", "gpu p99"})
+            ImGui::TableSetupColumn(header);
+        ImGui::TableHeadersRow();
+
+        for (const Stats &s: stats())
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%*s%s", (int) s.depth * 2, "", name(s.name_id).c_str());
+            for (float v: {s.cpu.p50, s.cpu.p95, s.cpu.p99})
+            {
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", v);
+            }
+            for (float v: {s.gpu.p50, s.gpu.p95, s.gpu.p99})
+            {
+                ImGui::TableNextColumn();
+                if (s.gpu.p99 > 0.f)
+                    ImGui::Text("%.3f", v);
+                else
+                    ImGui::TextUnformatted("-");
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    static char path[256] = "profile";
+    ImGui::InputText("file", path, sizeof(path));
+    if (ImGui::Button("export trace"))
+        export_chrome_trace(std::string(path) + ".json");
+    ImGui::SameLine();
+    if (ImGui::Button("export csv"))
+        export_csv(std::string(path) + ".csv");
+
+    ImGui::End();
+}
+
+
+bool Profiler::export_chrome_trace(const std::string &path)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        SPDLOG_ERROR("fail to open file: {}", path);
+        return false;
+    }
+
+    std::vector<ProfileSample> samples;
+    _ring.read(0, samples);
+
+    uint32_t thread_cnt = 0;
+    file << R"({"displayTimeUnit":"ms","traceEvents":[)" << '\n';
+    file << R"({"name":"thread_name","ph":"M","pid":0,"tid":)" << GPU_TRACE_TID
+         << R"(,"args":{"name":"GPU"}})";
+    for (const ProfileSample &s: samples)
+    {
+        const std::string n = json_escape(name(s.name_id));
+        file << fmt::format(",\n{{\"name\":\"{}\",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":{:.3f},"
+                            "\"dur\":{:.3f},\"pid\":0,\"tid\":{},\"args\":{{\"frame\":{}}}}}",
+                            n, s.cpu_begin, s.cpu_time, s.thread, s.frame);
+        if (s.has_gpu())
+            file << fmt::format(",\n{{\"name\":\"{}\",\"cat\":\"gpu\",\"ph\":\"X\",\"ts\":{:.3f},"
+                                "\"dur\":{:.3f},\"pid\":0,\"tid\":{},\"args\":{{\"frame\":{}}}}}",
+                                n, s.gpu_begin, s.gpu_time, GPU_TRACE_TID, s.frame);
+        thread_cnt = std::max(thread_cnt, s.thread + 1);
+    }
+    for (uint32_t t = 0; t < thread_cnt; ++t)
+        file << fmt::format(",\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":{},"
+                            "\"args\":{{\"name\":\"{}\"}}}}",
+                            t, t == 0 ? std::string("main") : fmt::format("worker {}", t));
+    file << "\n]}\n";
+
+    SPDLOG_INFO("export chrome trace: {}, samples: {}", path, samples.size());
+    return true;
+}
+
+
+bool Profiler::export_csv(const std::string &path)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        SPDLOG_ERROR("fail to open file: {}", path);
+        return false;
+    }
+
+    std::vector<ProfileSample> samples;
+    _ring.read(0, samples);
+    std::sort(samples.begin(), samples.end(), [](const ProfileSample &a, const ProfileSample &b) {
+        return a.cpu_begin < b.cpu_begin;
+    });
+
+    file << "frame,thread,depth,name,cpu_begin_us,cpu_us,gpu_begin_us,gpu_us\n";
+    for (const ProfileSample &s: samples)
+    {
+        file << fmt::format("{},{},{},\"{}\",{:.3f},{:.3f},", s.frame, s.thread, s.depth,
+                            name(s.name_id), s.cpu_begin, s.cpu_time);
+        if (s.has_gpu())
+            file << fmt::format("{:.3f},{:.3f}\n", s.gpu_begin, s.gpu_time);
+        else
+            file << ",\n";
+    }
+
+    SPDLOG_INFO("export csv: {}, samples: {}", path, samples.size());
+    return true;
+}
+
+
+ProfileScope::ProfileScope(uint32_t name_id, bool gpu)
+{
+    if (!Profiler::enabled())
+        return;
+
+    _active          = true;
+    _sample.name_id  = name_id;
+    _sample.depth    = scope_depth++;
+    _sample.thread   = Profiler::thread_index();
+    _sample.seq      = scope_seq++;
+    _sample.frame    = Profiler::frame();
+    _sample.gpu_time = -1.0;
+    if (gpu)
+        _query_begin = Profiler::begin_gpu_query();
+    _sample.cpu_begin = Profiler::now_us();
+}
+
+
+ProfileScope::~ProfileScope()
+{
+    if (!_active)
+        return;
+
+    _sample.cpu_time = Profiler::now_us() - _sample.cpu_begin;
+    --scope_depth;
+    Profiler::end_scope(_sample, _query_begin);
+}
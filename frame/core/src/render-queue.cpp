@@ -0,0 +1,59 @@
+#include "../render-queue.h"
+
+#include <algorithm>
+
+
+void RenderQueue::push(Shader2 &shader, const RTObject &obj)
+{
+    auto shader_idx = _shader_idx.try_emplace(&shader, (uint16_t) _shader_idx.size()).first->second;
+
+    const Material &mat = obj.mesh.mat;
+    const auto      tex = mat.has_tex_basecolor() ? (uint32_t) mat.metallic_roughness.tex_base_color
+                                                  : 0u;
+
+    uint64_t key = ((uint64_t) shader_idx << 48) | ((uint64_t) (mat.features & 0xFFFF) << 32) |
+                   ((uint64_t) (tex & 0xFFFF) << 16) | (obj.mesh.vao & 0xFFFF);
+    _items.push_back({.sort_key = key, .shader = &shader, .obj = &obj});
+}
+
+
+void RenderQueue::sort()
+{
+    std::stable_sort(_items.begin(), _items.end(),
+                     [](const RenderItem &a, const RenderItem &b) { return a.sort_key < b.sort_key; });
+}
+
+
+/**
+ * 两次绘制能否合并成一次实例化绘制
+ */
+static bool can_batch(const RenderItem &a, const RenderItem &b)
+{
+    const Mesh2 &ma = a.obj->mesh;
+    const Mesh2 &mb = b.obj->mesh;
+    return a.shader == b.shader && ma.vao == mb.vao && ma.index_offset == mb.index_offset &&
+           ma.index_cnt == mb.index_cnt && ma.primitive_mode == mb.primitive_mode &&
+           ma.mat.features == mb.mat.features &&
+           ma.mat.metallic_roughness.tex_base_color == mb.mat.metallic_roughness.tex_base_color;
+}
+
+
+void RenderQueue::build_batches()
+{
+    _batches.clear();
+    _instances.clear();
+    _instances.reserve(_items.size());
+
+    for (size_t i = 0; i < _items.size(); ++i)
+    {
+        const RenderItem &item = _items[i];
+        if (_batches.empty() || !can_batch(_items[i - 1], item))
+            _batches.push_back({.shader         = item.shader,
+                                .obj            = item.obj,
+                                .first_instance = (uint32_t) _instances.size(),
+                                .instance_cnt   = 0});
+        _batches.back().instance_cnt++;
+
+        _instances.push_back(InstanceData::from(item.obj->matrix(), item.obj->mesh.mat));
+    }
+}
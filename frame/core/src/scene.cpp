@@ -0,0 +1,198 @@
+#include "../scene.h"
+
+#include <functional>
+
+
+namespace {
+
+/**
+ * 两个材质的内容是否相同，导入同一个模型多次时，material 会被完整地复制多份
+ */
+bool same_material(const Material &a, const Material &b)
+{
+    const auto &mr_a = a.metallic_roughness;
+    const auto &mr_b = b.metallic_roughness;
+    return a.name == b.name && a.double_side == b.double_side && mr_a.metallic == mr_b.metallic &&
+           mr_a.roughness == mr_b.roughness && mr_a.base_color == mr_b.base_color &&
+           mr_a.tex_metallic_roughness == mr_b.tex_metallic_roughness &&
+           mr_a.tex_base_color == mr_b.tex_base_color && a.normal_scale == b.normal_scale &&
+           a.tex_normal == b.tex_normal && a.occusion_strength == b.occusion_strength &&
+           a.tex_occlusion == b.tex_occlusion && a.emissive == b.emissive &&
+           a.tex_emissive == b.tex_emissive && a.features == b.features;
+}
+
+
+/**
+ * 材质内容的 hash，和 same_material 比较的字段一致
+ */
+size_t material_hash(const Material &mat)
+{
+    const auto &mr   = mat.metallic_roughness;
+    size_t      seed = std::hash<std::string>{}(mat.name);
+    auto        mix  = [&seed](auto value) {
+        seed ^= std::hash<decltype(value)>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+    mix(mr.metallic);
+    mix(mr.roughness);
+    for (int i = 0; i < 4; ++i)
+        mix(mr.base_color[i]);
+    mix(mr.tex_base_color);
+    mix(mr.tex_metallic_roughness);
+    mix(mat.tex_normal);
+    mix(mat.tex_occlusion);
+    mix(mat.tex_emissive);
+    mix(mat.features);
+    return seed;
+}
+
+}    // namespace
+
+
+SceneHandle Scene::add(const Mesh2 &mesh, const glm::mat4 &matrix)
+{
+    return add(mesh, intern_material(mesh.mat), matrix);
+}
+
+
+SceneHandle Scene::add(const Mesh2 &mesh, MaterialId material, const glm::mat4 &matrix)
+{
+    /// 优先复用空闲的 slot
+    uint32_t slot;
+    if (!_free_slots.empty())
+    {
+        slot = _free_slots.back();
+        _free_slots.pop_back();
+    } else
+    {
+        slot = static_cast<uint32_t>(_slots.size());
+        _slots.emplace_back();
+    }
+
+    const MeshId mesh_id = intern_mesh(mesh);
+
+    _slots[slot].dense = static_cast<uint32_t>(_matrices.size());
+    _dense_to_slot.push_back(slot);
+    _matrices.push_back(matrix);
+    _mesh_ids.push_back(mesh_id);
+    _material_ids.push_back(material);
+    _bounds.push_back(_meshes[mesh_id].aabb.transform(matrix));
+
+    return {slot, _slots[slot].generation};
+}
+
+
+std::vector<SceneHandle> Scene::add(const std::vector<RTObject> &objs)
+{
+    std::vector<SceneHandle> handles;
+    handles.reserve(objs.size());
+    for (const auto &obj: objs)
+        handles.push_back(add(obj));
+    return handles;
+}
+
+
+void Scene::remove(SceneHandle handle)
+{
+    if (!contains(handle))
+        return;
+
+    /// 用最后一个物体填补空位
+    const uint32_t dense = _slots[handle.slot].dense;
+    const uint32_t last  = static_cast<uint32_t>(_matrices.size()) - 1;
+    if (dense != last)
+    {
+        _matrices[dense]     = _matrices[last];
+        _mesh_ids[dense]     = _mesh_ids[last];
+        _material_ids[dense] = _material_ids[last];
+        _bounds[dense]       = _bounds[last];
+
+        _dense_to_slot[dense]               = _dense_to_slot[last];
+        _slots[_dense_to_slot[dense]].dense = dense;
+    }
+    _matrices.pop_back();
+    _mesh_ids.pop_back();
+    _material_ids.pop_back();
+    _bounds.pop_back();
+    _dense_to_slot.pop_back();
+
+    _slots[handle.slot].dense = UINT32_MAX;
+    ++_slots[handle.slot].generation;
+    _free_slots.push_back(handle.slot);
+}
+
+
+void Scene::clear()
+{
+    for (uint32_t slot: _dense_to_slot)
+    {
+        _slots[slot].dense = UINT32_MAX;
+        ++_slots[slot].generation;
+        _free_slots.push_back(slot);
+    }
+    _dense_to_slot.clear();
+    _matrices.clear();
+    _mesh_ids.clear();
+    _material_ids.clear();
+    _bounds.clear();
+}
+
+
+void Scene::set_matrix(SceneHandle handle, const glm::mat4 &matrix)
+{
+    const uint32_t i = index(handle);
+    _matrices[i]     = matrix;
+    _bounds[i]       = _meshes[_mesh_ids[i]].aabb.transform(matrix);
+}
+
+
+size_t Scene::memory_usage() const
+{
+    size_t bytes = _slots.capacity() * sizeof(Slot) +
+                   (_free_slots.capacity() + _dense_to_slot.capacity()) * sizeof(uint32_t) +
+                   _matrices.capacity() * sizeof(glm::mat4) +
+                   _mesh_ids.capacity() * sizeof(MeshId) +
+                   _material_ids.capacity() * sizeof(MaterialId) +
+                   _bounds.capacity() * sizeof(AABB) + _meshes.capacity() * sizeof(Mesh2) +
+                   _materials.capacity() * sizeof(Material);
+    for (const auto &mesh: _meshes)
+        bytes += mesh.name.capacity();
+    for (const auto &mat: _materials)
+        bytes += mat.name.capacity();
+    return bytes;
+}
+
+
+MeshId Scene::intern_mesh(const Mesh2 &mesh)
+{
+    const auto key = std::make_tuple(mesh.vao, mesh.index_offset, mesh.index_cnt,
+                                     mesh.primitive_mode);
+    auto       res = _mesh_table.find(key);
+    if (res != _mesh_table.end())
+        return res->second;
+
+    /// material 单独存放
+    Mesh2 geometry_only = mesh;
+    geometry_only.mat   = {};
+
+    const auto id = static_cast<MeshId>(_meshes.size());
+    _meshes.push_back(std::move(geometry_only));
+    _mesh_table[key] = id;
+    return id;
+}
+
+
+MaterialId Scene::intern_material(const Material &mat)
+{
+    /// 通过 hash 找到候选，只和 hash 相同的材质比较内容
+    const size_t hash = material_hash(mat);
+
+    const auto [first, last] = _material_table.equal_range(hash);
+    for (auto iter = first; iter != last; ++iter)
+        if (same_material(_materials[iter->second], mat))
+            return iter->second;
+
+    const auto id = static_cast<MaterialId>(_materials.size());
+    _materials.push_back(mat);
+    _material_table.emplace(hash, id);
+    return id;
+}
@@ -0,0 +1,87 @@
+#include "../shader-lib.h"
+
+#include <algorithm>
+#include <functional>
+
+
+/// boost::hash_combine 的做法
+static void hash_combine(size_t &seed, const std::string &str)
+{
+    seed ^= std::hash<std::string>{}(str) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+
+size_t ShaderLib::SourceKeyHash::operator()(const SourceKey &key) const
+{
+    size_t seed = 0;
+    hash_combine(seed, key.first);
+    hash_combine(seed, key.second);
+    return seed;
+}
+
+
+size_t ShaderLib::VariantKeyHash::operator()(const VariantKey &key) const
+{
+    size_t seed = 0;
+    hash_combine(seed, key.vert);
+    hash_combine(seed, key.frag);
+    for (const auto &[name, value]: key.defines)
+    {
+        hash_combine(seed, name);
+        hash_combine(seed, value);
+    }
+    return seed;
+}
+
+
+Shader2 &ShaderLib::get(const std::string &vert, const std::string &frag,
+                        const ShaderDefines &defines)
+{
+    /// defines 排序之后作为 key 的一部分，顺序不同的同一组宏定义是同一个变体
+    VariantKey variant_key{vert, frag, defines};
+    std::sort(variant_key.defines.begin(), variant_key.defines.end());
+    if (auto iter = _variant_lut.find(variant_key); iter != _variant_lut.end())
+        return *iter->second;
+
+    /// 以预处理之后的源码作为 key，内容相同的着色器共享同一个 program
+    SourceKey source_key{glsl_preprocess(vert, defines), glsl_preprocess(frag, defines)};
+
+    auto iter = m.find(source_key);
+    if (iter == m.end())
+    {
+        SPDLOG_INFO("compile shader variant: {}, defines: {}", frag, defines.size());
+        Shader2 shader =
+                Shader2::from_source(vert + " | " + frag, source_key.first, source_key.second);
+        iter = m.emplace(std::move(source_key), std::move(shader)).first;
+    }
+    _variant_lut.emplace(std::move(variant_key), &iter->second);
+    return iter->second;
+}
+
+
+ShaderDefines ShaderLib::feature_defines(MaterialFeatures features)
+{
+    static const std::pair<MaterialFeature, const char *> feature_names[] = {
+            {MAT_TEX_BASECOLOR, "HAS_TEX_BASECOLOR"},
+            {MAT_TEX_METALLIC_ROUGHNESS, "HAS_TEX_METALLIC_ROUGHNESS"},
+            {MAT_TEX_NORMAL, "HAS_TEX_NORMAL"},
+            {MAT_TEX_OCCLUSION, "HAS_TEX_OCCLUSION"},
+            {MAT_TEX_EMISSIVE, "HAS_TEX_EMISSIVE"},
+            {MAT_DOUBLE_SIDE, "DOUBLE_SIDE"},
+    };
+
+    ShaderDefines defines;
+    for (const auto &[feature, name]: feature_names)
+        if (features & feature)
+            defines.emplace_back(name, "");
+    return defines;
+}
+
+
+Shader2 &ShaderLib::get_for_material(const std::string &vert, const std::string &frag,
+                                     MaterialFeatures features, const ShaderDefines &extra)
+{
+    ShaderDefines defines = feature_defines(features);
+    defines.insert(defines.end(), extra.begin(), extra.end());
+    return get(vert, frag, defines);
+}
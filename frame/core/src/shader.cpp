@@ -24,12 +24,75 @@ void UniformAttribute2::init_uni_attr_func_list()
     uni_attr_func_list[UniAttrType::VEC4] = [](GLint l, UniAttrValue v) {
         glUniform4fv(l, 1, glm::value_ptr(v._vec4));
     };
+    uni_attr_func_list[UniAttrType::VEC2] = [](GLint l, UniAttrValue v) {
+        glUniform2fv(l, 1, glm::value_ptr(v._vec2));
+    };
+}
+
+
+bool Shader2::is_ready() const
+{
+    if (_resolved || !GLExtension::parallel_shader_compile())
+        return true;
+
+    GLint completed = GL_FALSE;
+    glGetProgramiv(program_id, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed == GL_TRUE;
+}
+
+
+Shader2 Shader2::from_source(const std::string &name, const std::string &vert_source,
+                             const std::string &frag_source)
+{
+    StartupScope scope("shader", name);
+    Shader2      shader;
+    shader._name      = name;
+    shader.program_id = shader_link_submit(
+            shader_compile_source_submit(vert_source, GL_VERTEX_SHADER),
+            shader_compile_source_submit(frag_source, GL_FRAGMENT_SHADER));
+    GLDebug::label(GL_PROGRAM, shader.program_id, name);
+    return shader;
+}
+
+
+void Shader2::resolve() const
+{
+    if (_resolved)
+        return;
+    StartupScope scope("resolve", _name);
+    shader_check_link(program_id, _name);
+    _resolved = true;
+
+    /// 反射所有 active uniform 的 location
+    GLint uniform_cnt = 0, max_name_len = 0;
+    glGetProgramiv(program_id, GL_ACTIVE_UNIFORMS, &uniform_cnt);
+    glGetProgramiv(program_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_len);
+    std::string name_buf((size_t) max_name_len, '\0');
+    for (GLint i = 0; i < uniform_cnt; ++i)
+    {
+        GLsizei name_len = 0;
+        GLint   size;
+        GLenum  type;
+        glGetActiveUniform(program_id, (GLuint) i, max_name_len, &name_len, &size, &type,
+                           name_buf.data());
+        std::string name(name_buf.data(), name_len);
+
+        /// uniform block 中的成员没有 location
+        GLint location = glGetUniformLocation(program_id, name.c_str());
+        if (location == -1)
+            continue;
+        uniform_location_lut.emplace(name, location);
+
+        /// 数组的名称形如 arr[0]，同时记录 arr
+        if (name.ends_with("[0]"))
+            uniform_location_lut.emplace(name.substr(0, name.size() - 3), location);
+    }
 }
 
 
-void Shader2::set_uniform(const std::vector<UniformAttribute2> &attrs)
+void Shader2::set_uniform(std::span<const UniformAttribute2> attrs)
 {
-    glUseProgram(program_id);
+    use();    // 同时完成了 uniform 的反射
 
     for (auto &attr: attrs)
     {
@@ -39,6 +102,7 @@ void Shader2::set_uniform(const std::vector<UniformAttribute2> &attrs)
             auto location_ptr = uniform_location_lut.find(attr.name);
             if (location_ptr == uniform_location_lut.end())
             {
+                /// 反射只记录了数组的第一个元素，其他元素需要单独查询
                 location = glGetUniformLocation(program_id, attr.name.c_str());
                 if (location == -1)
                     LOG_AND_THROW("no uniform attribute named: {} was found.", attr.name);
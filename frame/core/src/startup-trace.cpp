@@ -0,0 +1,255 @@
+#include "../startup-trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+#include <json.hpp>
+#include <spdlog/spdlog.h>
+
+
+namespace {
+
+thread_local StartupScope *current_scope = nullptr;
+
+
+std::string format_bytes(size_t bytes)
+{
+    if (bytes == 0)
+        return "-";
+    if (bytes < 1024 * 1024)
+        return fmt::format("{:.1f} KB", (double) bytes / 1024.0);
+    return fmt::format("{:.1f} MB", (double) bytes / (1024.0 * 1024.0));
+}
+
+
+/**
+ * 路径中的文件名，用于缩短汇总表；着色器的名称是 "vert | frag"，两个路径分别处理
+ */
+std::string short_name(const std::string &path)
+{
+    const size_t sep = path.find(" | ");
+    if (sep != std::string::npos)
+        return short_name(path.substr(0, sep)) + " | " + short_name(path.substr(sep + 3));
+
+    const size_t pos = path.find_last_of("/\\");
+    return pos == std::string::npos ? path : path.substr(pos + 1);
+}
+
+}    // namespace
+
+
+std::vector<StartupSpan> StartupTrace::_spans;
+
+
+void StartupTrace::begin()
+{
+    std::lock_guard lock(_mutex);
+    _spans.clear();
+    now_us();
+    _active.store(true, std::memory_order_relaxed);
+}
+
+
+void StartupTrace::finish(double total_ms, const std::string &trace_path)
+{
+    if (!_active.exchange(false, std::memory_order_relaxed))
+        return;
+    print_summary(total_ms);
+    if (!trace_path.empty())
+        export_chrome_trace(trace_path);
+}
+
+
+std::vector<StartupSpan> StartupTrace::spans()
+{
+    std::lock_guard lock(_mutex);
+    return _spans;
+}
+
+
+double StartupTrace::now_us()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+            .count();
+}
+
+
+uint32_t StartupTrace::thread_index()
+{
+    static std::atomic<uint32_t> thread_cnt{0};
+    thread_local const uint32_t  idx = thread_cnt.fetch_add(1, std::memory_order_relaxed);
+    return idx;
+}
+
+
+void StartupTrace::print_summary(double total_ms)
+{
+    const std::vector<StartupSpan> all = spans();
+
+    /// 每个阶段自身的耗时（去掉嵌套的 scope），避免重复统计
+    struct PhaseStats {
+        double self_ms = 0.0;
+        size_t bytes   = 0;
+        size_t cnt     = 0;
+    };
+    std::map<std::string, PhaseStats> phases;
+
+    /// 每个资源：最外层 scope 的耗时，以及各个阶段自身的耗时
+    struct AssetStats {
+        double                        ms = 0.0;
+        std::map<std::string, double> phase_ms;
+    };
+    std::map<std::string, AssetStats> assets;
+
+    double covered_ms = 0.0;
+    for (const StartupSpan &s: all)
+    {
+        const double self_ms = (s.time - s.child_time) / 1000.0;
+        PhaseStats  &phase   = phases[s.phase];
+        phase.self_ms += self_ms;
+        phase.bytes += s.bytes;
+        phase.cnt += 1;
+
+        if (!s.asset.empty())
+        {
+            assets[s.asset].phase_ms[s.phase] += self_ms;
+            if (s.asset_root)
+                assets[s.asset].ms += s.time / 1000.0;
+        }
+        if (s.depth == 0 && s.thread == 0)
+            covered_ms += s.time / 1000.0;
+    }
+
+    auto share = [&](double ms) { return total_ms > 0.0 ? ms / total_ms * 100.0 : 0.0; };
+
+    std::vector<std::pair<std::string, PhaseStats>> phase_list(phases.begin(), phases.end());
+    std::sort(phase_list.begin(), phase_list.end(),
+              [](const auto &a, const auto &b) { return a.second.self_ms > b.second.self_ms; });
+    SPDLOG_INFO("startup phases (self time), total: {:.1f} ms, not traced: {:.1f} ms", total_ms,
+                std::max(total_ms - covered_ms, 0.0));
+    for (const auto &[name, p]: phase_list)
+        SPDLOG_INFO("  {:<14} {:>9.1f} ms {:>5.1f}% {:>10} x{}", name, p.self_ms, share(p.self_ms),
+                    format_bytes(p.bytes), p.cnt);
+
+    /// 资源按照耗时排序，只打印最慢的一部分
+    constexpr size_t MAX_ASSETS = 16;
+
+    std::vector<std::pair<std::string, AssetStats>> asset_list(assets.begin(), assets.end());
+    std::sort(asset_list.begin(), asset_list.end(),
+              [](const auto &a, const auto &b) { return a.second.ms > b.second.ms; });
+    if (!asset_list.empty())
+        SPDLOG_INFO("startup assets: {}, slowest:", asset_list.size());
+    for (size_t i = 0; i < std::min(asset_list.size(), MAX_ASSETS); ++i)
+    {
+        const auto &[name, a] = asset_list[i];
+
+        std::vector<std::pair<std::string, double>> breakdown(a.phase_ms.begin(),
+                                                              a.phase_ms.end());
+        std::sort(breakdown.begin(), breakdown.end(),
+                  [](const auto &x, const auto &y) { return x.second > y.second; });
+        std::string breakdown_str;
+        for (const auto &[phase, ms]: breakdown)
+            breakdown_str += fmt::format("{}{} {:.1f}", breakdown_str.empty() ? "" : ", ", phase,
+                                         ms);
+
+        SPDLOG_INFO("  {:>9.1f} ms {:>5.1f}%  {:<32} [{}]", a.ms, share(a.ms), short_name(name),
+                    breakdown_str);
+    }
+}
+
+
+bool StartupTrace::export_chrome_trace(const std::string &path)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        SPDLOG_ERROR("fail to open file: {}", path);
+        return false;
+    }
+
+    const std::vector<StartupSpan> all = spans();
+
+    nlohmann::json events = nlohmann::json::array();
+    uint32_t       thread_cnt = 0;
+    for (const StartupSpan &s: all)
+    {
+        events.push_back({
+                {"name", s.asset.empty() ? s.phase : s.phase + ": " + short_name(s.asset)},
+                {"cat", s.phase},
+                {"ph", "X"},
+                {"ts", s.begin},
+                {"dur", s.time},
+                {"pid", 0},
+                {"tid", s.thread},
+                {"args", {{"asset", s.asset}, {"bytes", s.bytes}}},
+        });
+        thread_cnt = std::max(thread_cnt, s.thread + 1);
+    }
+    for (uint32_t t = 0; t < thread_cnt; ++t)
+        events.push_back({
+                {"name", "thread_name"},
+                {"ph", "M"},
+                {"pid", 0},
+                {"tid", t},
+                {"args", {{"name", t == 0 ? std::string("main") : fmt::format("worker {}", t)}}},
+        });
+
+    file << nlohmann::json{{"displayTimeUnit", "ms"}, {"traceEvents", events}}.dump() << '\n';
+    SPDLOG_INFO("export startup trace: {}, spans: {}", path, all.size());
+    return true;
+}
+
+
+/// ==================================================================
+
+
+StartupScope::StartupScope(const char *phase, const std::string &asset)
+{
+    if (!StartupTrace::active())
+        return;
+    _active = true;
+    _parent = current_scope;
+
+    _span.phase  = phase;
+    _span.thread = StartupTrace::thread_index();
+    _span.depth  = _parent ? _parent->_span.depth + 1 : 0;
+    if (asset.empty())
+        _span.asset = _parent ? _parent->_span.asset : std::string();
+    else
+    {
+        _span.asset      = asset;
+        _span.asset_root = !_parent || _parent->_span.asset != asset;
+    }
+
+    current_scope = this;
+    _span.begin   = StartupTrace::now_us();
+}
+
+
+void StartupScope::add_file_bytes(const std::string &path)
+{
+    if (!_active)
+        return;
+    std::error_code ec;
+    const auto      size = std::filesystem::file_size(path, ec);
+    if (!ec)
+        _span.bytes += size;
+}
+
+
+StartupScope::~StartupScope()
+{
+    if (!_active)
+        return;
+    _span.time    = StartupTrace::now_us() - _span.begin;
+    current_scope = _parent;
+    if (_parent)
+        _parent->_span.child_time += _span.time;
+
+    std::lock_guard lock(StartupTrace::_mutex);
+    StartupTrace::_spans.push_back(std::move(_span));
+}
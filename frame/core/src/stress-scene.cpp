@@ -0,0 +1,249 @@
+#include "../stress-scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+
+#include "../opengl-misc.h"
+
+
+namespace {
+
+/// 均匀分布的单位向量
+glm::vec3 random_direction(std::mt19937 &rng)
+{
+    std::normal_distribution<float> normal;
+    const glm::vec3                 v(normal(rng), normal(rng), normal(rng));
+    const float                     len = glm::length(v);
+    return len > 1e-6f ? v / len : glm::vec3(0.f, 1.f, 0.f);
+}
+
+
+/**
+ * 创建一个 8x8 的棋盘格纹理，两种颜色分别是 color 和 color 的一半
+ */
+GLuint new_checker_texture(const glm::vec3 &color)
+{
+    constexpr int        SIZE = 8;
+    std::vector<uint8_t> pixels(SIZE * SIZE * 4);
+    for (int y = 0; y < SIZE; ++y)
+        for (int x = 0; x < SIZE; ++x)
+        {
+            const float     k = (x + y) % 2 == 0 ? 1.f : 0.5f;
+            const glm::vec3 c = glm::clamp(color * k, 0.f, 1.f) * 255.f;
+            uint8_t        *p = &pixels[(y * SIZE + x) * 4];
+            p[0]              = (uint8_t) c.x;
+            p[1]              = (uint8_t) c.y;
+            p[2]              = (uint8_t) c.z;
+            p[3]              = 255;
+        }
+    return new_tex2d({
+            .width           = SIZE,
+            .height          = SIZE,
+            .internal_format = GL_RGBA8,
+            .external_format = GL_RGBA,
+            .external_type   = GL_UNSIGNED_BYTE,
+            .wrap_s          = GL_REPEAT,
+            .wrap_t          = GL_REPEAT,
+            .filter_min      = GL_NEAREST,
+            .filter_mag      = GL_NEAREST,
+            .data            = pixels.data(),
+    });
+}
+
+}    // namespace
+
+
+std::vector<Material> StressScene::make_materials(const StressSceneDesc &desc,
+                                                  const Material        &base)
+{
+    const int             cnt = std::max(desc.material_cnt, 1);
+    std::vector<Material> materials(cnt, base);
+    for (int i = 0; i < cnt; ++i)
+    {
+        /// 色相均匀分布，metallic 和 roughness 交替变化
+        const float     hue   = (float) i / (float) cnt;
+        const glm::vec3 k     = glm::mod(hue * 6.f + glm::vec3(0.f, 4.f, 2.f), 6.f);
+        const glm::vec3 color = glm::clamp(glm::abs(k - 3.f) - 1.f, 0.f, 1.f);
+
+        auto &mr      = materials[i].metallic_roughness;
+        mr.base_color = glm::vec4(0.2f + 0.8f * color, 1.f);
+        mr.metallic   = (i % 2 == 0) ? 0.0 : 1.0;
+        mr.roughness  = 0.2 + 0.6 * (double) (i % 4) / 3.0;
+        if (i < desc.texture_cnt)
+            mr.tex_base_color = (int) _textures[i];
+        materials[i].name = base.name + "#" + std::to_string(i);
+        materials[i].update_features();
+    }
+    return materials;
+}
+
+
+void StressScene::generate(const StressSceneDesc &desc, const std::vector<RTObject> &assets)
+{
+    if (assets.empty())
+        LOG_AND_THROW("stress scene needs at least one asset.");
+
+    release();
+    _scene      = Scene{};
+    _transforms = TransformTree{};
+    _bounds     = AABB{};
+    _handles.clear();
+    _asset_ids.clear();
+    _dynamic.clear();
+    _moving.clear();
+
+    std::mt19937                          rng(desc.seed);
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+
+    /// 纹理：每个带纹理的材质一张，颜色和材质的 base color 无关
+    for (int i = 0; i < std::min(desc.texture_cnt, std::max(desc.material_cnt, 1)); ++i)
+    {
+        const float r = uniform(rng), g = uniform(rng), b = uniform(rng);
+        _textures.push_back(new_checker_texture({r, g, b}));
+    }
+
+    /// 每个资源归一化到原点附近、边长为 1，并生成所有材质的变体，材质只在这里去重一次
+    _asset_matrices.clear();
+    std::vector<std::vector<MaterialId>> variants;
+    for (const auto &asset: assets)
+    {
+        const AABB  aabb = asset.world_aabb();
+        const float size = 2.f * std::max({aabb.extent().x, aabb.extent().y, aabb.extent().z});
+        const float s    = size > 0.f ? 1.f / size : 1.f;
+        _asset_matrices.push_back(glm::scale(glm::mat4(1.f), glm::vec3(s)) *
+                                  glm::translate(glm::mat4(1.f), -aabb.center()) * asset.matrix());
+
+        auto &mat_ids = variants.emplace_back();
+        for (const auto &mat: make_materials(desc, asset.mesh.mat))
+            mat_ids.push_back(_scene.add_material(mat));
+    }
+
+    /// 节点的局部变换
+    const size_t n    = desc.object_cnt;
+    const float  side = desc.spacing * std::cbrt((float) n);
+    switch (desc.layout)
+    {
+        case StressLayout::Grid: {
+            const auto dim = (size_t) std::ceil(std::cbrt((double) n));
+            for (size_t i = 0; i < n; ++i)
+            {
+                const glm::vec3 cell((float) (i % dim), (float) (i / dim % dim),
+                                     (float) (i / dim / dim));
+                _transforms.add(INVALID_TRANSFORM,
+                                (cell - 0.5f * (float) (dim - 1)) * desc.spacing);
+            }
+            break;
+        }
+        case StressLayout::Scatter: {
+            for (size_t i = 0; i < n; ++i)
+            {
+                const float     x     = uniform(rng), y = uniform(rng), z = uniform(rng);
+                const float     angle = uniform(rng) * glm::radians(360.f);
+                const glm::quat rot   = glm::angleAxis(angle, random_direction(rng));
+                const float     scale = 0.5f + uniform(rng);
+                _transforms.add(INVALID_TRANSFORM, side * (glm::vec3(x, y, z) - 0.5f), rot,
+                                glm::vec3(scale));
+            }
+            break;
+        }
+        case StressLayout::Hierarchy: {
+            /// 节点 k 的父节点是 (k - 1) / fanout，先求出每个节点的深度
+            const size_t        fanout = std::max(desc.hierarchy_fanout, 1);
+            std::vector<size_t> depth(n, 0);
+            for (size_t k = 1; k < n; ++k)
+                depth[k] = depth[(k - 1) / fanout] + 1;
+            const size_t levels = n > 0 ? depth[n - 1] : 0;
+
+            /// 从最深的一层开始，第 d 层的圆环要能容纳 fanout 个第 d + 1 层的子树
+            std::vector<float> radius(levels + 2, 0.f);
+            for (size_t d = levels; d >= 1; --d)
+            {
+                const float circumference = (float) fanout * 2.f * (radius[d + 1] + desc.spacing);
+                radius[d] = std::max(desc.spacing, circumference / glm::radians(360.f));
+            }
+
+            const float step = glm::radians(360.f) / (float) fanout;
+            for (size_t k = 0; k < n; ++k)
+            {
+                if (k == 0)
+                {
+                    _transforms.add(INVALID_TRANSFORM);
+                    continue;
+                }
+                const size_t parent = (k - 1) / fanout;
+                const float  angle  = step * (float) ((k - 1) % fanout);
+                const glm::vec3 offset =
+                        radius[depth[k]] * glm::vec3(std::cos(angle), 0.f, std::sin(angle));
+                _transforms.add((TransformId) parent, offset);
+            }
+            break;
+        }
+    }
+    _transforms.update();
+
+    /// 添加物体，资源轮流使用，材质随机选择
+    const auto mat_cnt = (uint32_t) std::max(desc.material_cnt, 1);
+    _handles.reserve(n);
+    _asset_ids.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const auto asset = (uint32_t) (i % assets.size());
+        const auto mat   = (uint32_t) (rng() % mat_cnt);
+        _asset_ids.push_back(asset);
+        _handles.push_back(_scene.add(assets[asset].mesh, variants[asset][mat],
+                                      _transforms.world((TransformId) i) * _asset_matrices[asset]));
+    }
+    for (const auto &aabb: _scene.bounds())
+        _bounds.expand(aabb);
+
+    /// 动态物体
+    for (size_t i = 0; i < n; ++i)
+        if (uniform(rng) < desc.dynamic_fraction)
+            _dynamic.push_back({
+                    .node  = (TransformId) i,
+                    .base  = _transforms.rotation((TransformId) i),
+                    .axis  = random_direction(rng),
+                    .speed = 0.5f + 1.5f * uniform(rng),
+            });
+
+    /// 动态物体以及它们的子树，节点按照拓扑顺序存放，父节点先于子节点被标记
+    std::vector<uint8_t> moving(n, 0);
+    for (const auto &d: _dynamic)
+        moving[d.node] = 1;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const TransformId parent = _transforms.parent((TransformId) i);
+        if (parent != INVALID_TRANSFORM && moving[parent])
+            moving[i] = 1;
+        if (moving[i])
+            _moving.push_back(_scene.index(_handles[i]));
+    }
+
+    SPDLOG_INFO("stress scene: {} objects, {} meshes, {} materials, {} dynamic, {} moving",
+                _scene.size(), _scene.mesh_cnt(), _scene.material_cnt(), _dynamic.size(),
+                _moving.size());
+}
+
+
+size_t StressScene::update(float time)
+{
+    for (const auto &d: _dynamic)
+        _transforms.set_rotation(d.node, glm::angleAxis(d.speed * time, d.axis) * d.base);
+    _transforms.update();
+
+    for (TransformId id: _transforms.changed())
+        _scene.set_matrix(_handles[id], _transforms.world(id) * _asset_matrices[_asset_ids[id]]);
+    return _transforms.changed().size();
+}
+
+
+void StressScene::release()
+{
+    if (!_textures.empty())
+        glDeleteTextures((GLsizei) _textures.size(), _textures.data());
+    _textures.clear();
+}
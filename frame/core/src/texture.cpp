@@ -1,17 +1,25 @@
 #include "../texture.h"
+#include "../opengl-debug.h"
 #include "../opengl-misc.h"
+#include "../startup-trace.h"
 
 
 GLuint TextureManager::load_texture(const std::string &file_path, bool sRGB)
 {
     SPDLOG_INFO("load texture: {}...", file_path);
+    StartupScope texture_scope("texture", file_path);
 
     /// read file
-    int width, height, channels;
+    int            width, height, channels;
+    unsigned char *data;
 
     /// flip verticla 可以使得 data[0] 是图片的左下角，这样左下角就对应 texcoord 的 [0, 0]
-    stbi_set_flip_vertically_on_load(true);
-    auto data = stbi_load(file_path.c_str(), &width, &height, &channels, 0);
+    {
+        StartupScope scope("decode");
+        scope.add_file_bytes(file_path);
+        stbi_set_flip_vertically_on_load(true);
+        data = stbi_load(file_path.c_str(), &width, &height, &channels, 0);
+    }
     if (!data)
         SPDLOG_ERROR("error on load texture.");
 
@@ -37,6 +45,7 @@ GLuint TextureManager::load_texture(const std::string &file_path, bool sRGB)
         default: LOG_AND_THROW("bad texture channes: {}", channels);
     }
     GLuint tex_id = new_tex2d(info);
+    GLDebug::label(GL_TEXTURE, tex_id, file_path);
 
     stbi_image_free(data);
     return tex_id;
@@ -46,6 +55,7 @@ GLuint TextureManager::load_texture(const std::string &file_path, bool sRGB)
 GLuint load_cube_map(const CubeMapPath &tex_path, bool sRGB)
 {
     SPDLOG_INFO("load cube map texture: {}", tex_path.pos_x);
+    StartupScope cube_map_scope("cube map", tex_path.pos_x);
 
     // cubemap 比较特殊，不需要竖直反转，所以 data[0] 是图片的左上角
     stbi_set_flip_vertically_on_load(false);
@@ -69,7 +79,11 @@ GLuint load_cube_map(const CubeMapPath &tex_path, bool sRGB)
     for (int i = 0; i < 6; ++i)
     {
         int width, height, channels;
-        data[i] = stbi_load(path_list[i].c_str(), &width, &height, &channels, 0);
+        {
+            StartupScope scope("decode");
+            scope.add_file_bytes(path_list[i]);
+            data[i] = stbi_load(path_list[i].c_str(), &width, &height, &channels, 0);
+        }
 
         if (i == 0)
             size_all = width, channels_all = channels;
@@ -101,6 +115,7 @@ GLuint load_cube_map(const CubeMapPath &tex_path, bool sRGB)
 
     /// 创建纹理对象
     GLuint cube_map = new_cubemap(info);
+    GLDebug::label(GL_TEXTURE, cube_map, tex_path.pos_x);
 
     free_resource();
     return cube_map;
@@ -0,0 +1,259 @@
+#include "../transform.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../misc.h"
+#include "../simd.h"
+
+
+namespace {
+
+/// out = a * b，矩阵按列存放，每一列是一个 f32x4
+void mat4_mul(const glm::mat4 &a, const glm::mat4 &b, glm::mat4 &out)
+{
+    const f32x4 a0 = f32x4::load(&a[0][0]);
+    const f32x4 a1 = f32x4::load(&a[1][0]);
+    const f32x4 a2 = f32x4::load(&a[2][0]);
+    const f32x4 a3 = f32x4::load(&a[3][0]);
+
+    for (int c = 0; c < 4; ++c)
+    {
+        f32x4 r = a0 * f32x4::broadcast(b[c][0]);
+        r       = f32x4::fmadd(a1, f32x4::broadcast(b[c][1]), r);
+        r       = f32x4::fmadd(a2, f32x4::broadcast(b[c][2]), r);
+        r       = f32x4::fmadd(a3, f32x4::broadcast(b[c][3]), r);
+        r.store(&out[c][0]);
+    }
+}
+
+}    // namespace
+
+
+TransformId TransformTree::add(TransformId parent, const glm::vec3 &translation,
+                               const glm::quat &rotation, const glm::vec3 &scale)
+{
+    const auto id = static_cast<TransformId>(_parent.size());
+    if (parent != INVALID_TRANSFORM && parent >= id)
+        LOG_AND_THROW("parent {} of transform {} does not exist", parent, id);
+
+    _parent.push_back(parent);
+    _tx.push_back(translation.x);
+    _ty.push_back(translation.y);
+    _tz.push_back(translation.z);
+    _qx.push_back(rotation.x);
+    _qy.push_back(rotation.y);
+    _qz.push_back(rotation.z);
+    _qw.push_back(rotation.w);
+    _sx.push_back(scale.x);
+    _sy.push_back(scale.y);
+    _sz.push_back(scale.z);
+    _raw.push_back(INVALID_RAW);
+    _world.emplace_back(1.f);
+    _dirty.push_back(0);
+    _world_dirty.push_back(0);
+
+    mark_dirty(id);
+    return id;
+}
+
+
+TransformId TransformTree::add(TransformId parent, const glm::mat4 &local)
+{
+    constexpr float EPS = 1e-4f;
+
+    const glm::vec3 translation{local[3]};
+
+    const glm::mat3 RS{local};    // 旋转和缩放的矩阵
+    glm::vec3       scale{glm::length(RS[0]), glm::length(RS[1]), glm::length(RS[2])};
+
+    /// 镜像：行列式为负，把一个轴的 scale 取负数，剩下的部分才是旋转
+    if (glm::dot(glm::cross(RS[0], RS[1]), RS[2]) < 0.f)
+        scale.x = -scale.x;
+
+    /// 某个轴的 scale 为 0 时没有旋转可言，保留原始矩阵；TRS 部分只保留平移和 scale
+    const bool degenerate = scale.x == 0.f || scale.y == 0.f || scale.z == 0.f ||
+                            !std::isfinite(scale.x) || !std::isfinite(scale.y) ||
+                            !std::isfinite(scale.z);
+    glm::quat rotation(1.f, glm::vec3(0.f));
+    bool      is_trs = !degenerate;
+    if (!degenerate)
+    {
+        const glm::mat3 R = {RS[0] / scale.x, RS[1] / scale.y, RS[2] / scale.z};
+        rotation          = glm::quat_cast(R);
+
+        /// 切变或者投影：去掉 scale 之后不是正交矩阵，同样保留原始矩阵
+        is_trs = std::abs(glm::dot(R[0], R[1])) < EPS && std::abs(glm::dot(R[0], R[2])) < EPS &&
+                 std::abs(glm::dot(R[1], R[2])) < EPS && local[0][3] == 0.f &&
+                 local[1][3] == 0.f && local[2][3] == 0.f && local[3][3] == 1.f;
+    }
+
+    const TransformId id = add(parent, translation, rotation, scale);
+    if (!is_trs)
+    {
+        _raw[id] = static_cast<uint32_t>(_raw_locals.size());
+        _raw_locals.push_back(local);
+    }
+    return id;
+}
+
+
+void TransformTree::set_translation(TransformId id, const glm::vec3 &translation)
+{
+    _tx[id] = translation.x;
+    _ty[id] = translation.y;
+    _tz[id] = translation.z;
+
+    _raw[id] = INVALID_RAW;
+    mark_dirty(id);
+}
+
+
+void TransformTree::set_rotation(TransformId id, const glm::quat &rotation)
+{
+    _qx[id] = rotation.x;
+    _qy[id] = rotation.y;
+    _qz[id] = rotation.z;
+    _qw[id] = rotation.w;
+
+    _raw[id] = INVALID_RAW;
+    mark_dirty(id);
+}
+
+
+void TransformTree::set_scale(TransformId id, const glm::vec3 &scale)
+{
+    _sx[id] = scale.x;
+    _sy[id] = scale.y;
+    _sz[id] = scale.z;
+
+    _raw[id] = INVALID_RAW;
+    mark_dirty(id);
+}
+
+
+glm::vec3 TransformTree::translation(TransformId id) const
+{
+    return {_tx[id], _ty[id], _tz[id]};
+}
+
+
+glm::quat TransformTree::rotation(TransformId id) const
+{
+    return glm::quat(_qw[id], _qx[id], _qy[id], _qz[id]);
+}
+
+
+glm::vec3 TransformTree::scale(TransformId id) const
+{
+    return {_sx[id], _sy[id], _sz[id]};
+}
+
+
+size_t TransformTree::update()
+{
+    _changed.clear();
+    if (!_any_dirty)
+        return 0;
+
+    /// 父节点总是在子节点之前，一次遍历就可以把脏标记传播到整棵子树
+    const size_t n = _parent.size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        const TransformId p = _parent[i];
+        _world_dirty[i]     = _dirty[i] || (p != INVALID_TRANSFORM && _world_dirty[p]);
+        if (_world_dirty[i])
+            _changed.push_back(static_cast<TransformId>(i));
+    }
+
+    compose_local();
+
+    for (size_t k = 0; k < _changed.size(); ++k)
+    {
+        const TransformId id = _changed[k];
+        const TransformId p  = _parent[id];
+        if (p == INVALID_TRANSFORM)
+            _world[id] = _local_cache[k];
+        else
+            mat4_mul(_world[p], _local_cache[k], _world[id]);
+    }
+
+    for (TransformId id: _changed)
+    {
+        _dirty[id]       = 0;
+        _world_dirty[id] = 0;
+    }
+    _any_dirty = false;
+
+    return _changed.size();
+}
+
+
+void TransformTree::compose_local()
+{
+    const size_t cnt = _changed.size();
+    _local_cache.resize(cnt);
+
+    for (size_t base = 0; base < cnt; base += f32x4::WIDTH)
+    {
+        /// 把 4 个节点的 TRS 收集到一起，不足 4 个时用单位变换补齐
+        float tx[4] = {}, ty[4] = {}, tz[4] = {};
+        float qx[4] = {}, qy[4] = {}, qz[4] = {}, qw[4] = {1.f, 1.f, 1.f, 1.f};
+        float sx[4] = {1.f, 1.f, 1.f, 1.f}, sy[4] = {1.f, 1.f, 1.f, 1.f};
+        float sz[4] = {1.f, 1.f, 1.f, 1.f};
+
+        const size_t lanes = std::min<size_t>(f32x4::WIDTH, cnt - base);
+        for (size_t j = 0; j < lanes; ++j)
+        {
+            const TransformId id = _changed[base + j];
+
+            tx[j] = _tx[id];
+            ty[j] = _ty[id];
+            tz[j] = _tz[id];
+            qx[j] = _qx[id];
+            qy[j] = _qy[id];
+            qz[j] = _qz[id];
+            qw[j] = _qw[id];
+            sx[j] = _sx[id];
+            sy[j] = _sy[id];
+            sz[j] = _sz[id];
+        }
+
+        const f32x4 x = f32x4::load(qx), y = f32x4::load(qy);
+        const f32x4 z = f32x4::load(qz), w = f32x4::load(qw);
+        const f32x4 one = f32x4::broadcast(1.f), two = f32x4::broadcast(2.f);
+
+        const f32x4 xx = x * x, yy = y * y, zz = z * z;
+        const f32x4 xy = x * y, xz = x * z, yz = y * z;
+        const f32x4 wx = w * x, wy = w * y, wz = w * z;
+
+        /// 和 glm::mat4_cast 相同的公式，再把第 c 列乘上 scale 的第 c 个分量
+        const f32x4 s_x = f32x4::load(sx), s_y = f32x4::load(sy), s_z = f32x4::load(sz);
+
+        f32x4 m[9];
+        m[0] = (one - two * (yy + zz)) * s_x;
+        m[1] = two * (xy + wz) * s_x;
+        m[2] = two * (xz - wy) * s_x;
+        m[3] = two * (xy - wz) * s_y;
+        m[4] = (one - two * (xx + zz)) * s_y;
+        m[5] = two * (yz + wx) * s_y;
+        m[6] = two * (xz + wy) * s_z;
+        m[7] = two * (yz - wx) * s_z;
+        m[8] = (one - two * (xx + yy)) * s_z;
+
+        float rs[9][4];
+        for (int e = 0; e < 9; ++e)
+            m[e].store(rs[e]);
+
+        for (size_t j = 0; j < lanes; ++j)
+        {
+            glm::mat4 &local = _local_cache[base + j];
+            for (int c = 0; c < 3; ++c)
+                local[c] = glm::vec4(rs[c * 3][j], rs[c * 3 + 1][j], rs[c * 3 + 2][j], 0.f);
+            local[3] = glm::vec4(tx[j], ty[j], tz[j], 1.f);
+
+            if (const uint32_t raw = _raw[_changed[base + j]]; raw != INVALID_RAW)
+                local = _raw_locals[raw];
+        }
+    }
+}
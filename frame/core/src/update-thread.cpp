@@ -0,0 +1,88 @@
+#include "../update-thread.h"
+
+#include <chrono>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+#include "../frame-arena.h"
+#include "../profiler.h"
+
+
+UpdateThread::UpdateThread(std::function<void()> update)
+    : _update(std::move(update))
+{
+    _thread = std::thread(&UpdateThread::thread_loop, this);
+}
+
+
+UpdateThread::~UpdateThread()
+{
+    {
+        std::unique_lock lock(_mutex);
+        _cv.wait(lock, [this] { return !_pending; });
+        _stop = true;
+    }
+    _cv.notify_all();
+    _thread.join();
+}
+
+
+void UpdateThread::kick()
+{
+    {
+        std::lock_guard lock(_mutex);
+        _pending = true;
+    }
+    _cv.notify_all();
+}
+
+
+void UpdateThread::wait()
+{
+    const auto begin = std::chrono::steady_clock::now();
+    {
+        std::unique_lock lock(_mutex);
+        _cv.wait(lock, [this] { return !_pending; });
+        _last_wait_ms = std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - begin)
+                                .count();
+        if (_error)
+            std::rethrow_exception(std::exchange(_error, nullptr));
+    }
+}
+
+
+void UpdateThread::thread_loop()
+{
+    while (true)
+    {
+        {
+            std::unique_lock lock(_mutex);
+            _cv.wait(lock, [this] { return _pending || _stop; });
+            if (_stop)
+                return;
+        }
+
+        std::exception_ptr error;
+        const uint64_t     alloc_begin = AllocCounter::count();
+        try
+        {
+            PROFILE_CPU_SCOPE("update");
+            _update();
+        } catch (...)
+        {
+            SPDLOG_ERROR("exception occurs in update thread.");
+            error = std::current_exception();
+        }
+        FrameArena::local().reset();
+
+        {
+            std::lock_guard lock(_mutex);
+            _pending        = false;
+            _error          = error;
+            _last_alloc_cnt = AllocCounter::count() - alloc_begin;
+        }
+        _cv.notify_all();
+    }
+}
@@ -0,0 +1,216 @@
+/**
+ * Window 的 headless 模式：没有窗口，通过 EGL 创建 OpenGL 上下文，渲染到离屏 FBO
+ */
+#include <glad/glad.h>
+
+#include "../window.h"
+
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+#ifdef FRAME_HAS_EGL
+/// 不需要 X11 的头文件，避免引入 None、Bool 等宏
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+
+namespace {
+
+GLuint offscreen_fbo;
+GLuint offscreen_color;    // GL_RGBA8 的 renderbuffer
+GLuint offscreen_depth;    // GL_DEPTH24_STENCIL8 的 renderbuffer
+
+/// glad 加载的 glBindFramebuffer，绑定 framebuffer 0 时改为绑定离屏 FBO
+PFNGLBINDFRAMEBUFFERPROC gl_bind_framebuffer;
+
+void APIENTRY bind_framebuffer_offscreen(GLenum target, GLuint framebuffer)
+{
+    gl_bind_framebuffer(target, framebuffer == 0 ? offscreen_fbo : framebuffer);
+}
+
+
+void alloc_offscreen_storage(int width, int height)
+{
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreen_color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreen_depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+}
+
+
+#ifdef FRAME_HAS_EGL
+EGLDisplay egl_display = EGL_NO_DISPLAY;
+EGLContext egl_context = EGL_NO_CONTEXT;
+
+
+bool has_extension(const char *extensions, const char *name)
+{
+    return extensions != nullptr && std::strstr(extensions, name) != nullptr;
+}
+
+
+/**
+ * 优先使用 Mesa 的 surfaceless 平台，不需要任何显示服务；否则使用默认的 display
+ */
+EGLDisplay get_display()
+{
+    const char *client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto        get_platform_display =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (get_platform_display &&
+        has_extension(client_extensions, "EGL_MESA_platform_surfaceless"))
+    {
+        EGLDisplay display =
+                get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY)
+            return display;
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+#endif
+
+}    // namespace
+
+
+bool Window::init_headless(int width, int height)
+{
+#ifdef FRAME_HAS_EGL
+    egl_display = get_display();
+    EGLint major, minor;
+    if (egl_display == EGL_NO_DISPLAY || !eglInitialize(egl_display, &major, &minor))
+    {
+        SPDLOG_ERROR("fail to init egl display.");
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        SPDLOG_ERROR("egl does not support desktop OpenGL.");
+        return false;
+    }
+
+    /// 不需要 surface，因此对 surface 的类型没有要求
+    const EGLint config_attribs[] = {
+            EGL_SURFACE_TYPE, 0, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE,
+    };
+    EGLConfig config     = nullptr;
+    EGLint    config_cnt = 0;
+    if (!eglChooseConfig(egl_display, config_attribs, &config, 1, &config_cnt) || config_cnt == 0)
+    {
+        if (!has_extension(eglQueryString(egl_display, EGL_EXTENSIONS),
+                           "EGL_KHR_no_config_context"))
+        {
+            SPDLOG_ERROR("no egl config for OpenGL.");
+            return false;
+        }
+        config = EGL_NO_CONFIG_KHR;
+    }
+
+    /// 和窗口模式相同，使用 3.3 core profile
+    const EGLint context_attribs[] = {
+            EGL_CONTEXT_MAJOR_VERSION,
+            3,
+            EGL_CONTEXT_MINOR_VERSION,
+            3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK,
+            EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE,
+    };
+    egl_context = eglCreateContext(egl_display, config, EGL_NO_CONTEXT, context_attribs);
+    if (egl_context == EGL_NO_CONTEXT)
+    {
+        SPDLOG_ERROR("fail to create egl context: 0x{:x}.", eglGetError());
+        return false;
+    }
+    if (!eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context))
+    {
+        SPDLOG_ERROR("fail to make egl context current: 0x{:x}.", eglGetError());
+        return false;
+    }
+
+    _headless           = true;
+    _framebuffer_width  = width;
+    _framebuffer_height = height;
+    SPDLOG_INFO("headless: EGL {}.{}, {} x {}.", major, minor, width, height);
+    return true;
+#else
+    (void) width;
+    (void) height;
+    SPDLOG_ERROR("headless mode needs EGL, which is not found at build time.");
+    return false;
+#endif
+}
+
+
+void Window::init_offscreen_framebuffer()
+{
+    glGenRenderbuffers(1, &offscreen_color);
+    glGenRenderbuffers(1, &offscreen_depth);
+    alloc_offscreen_storage(_framebuffer_width, _framebuffer_height);
+
+    glGenFramebuffers(1, &offscreen_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, offscreen_fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                              offscreen_color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER,
+                              offscreen_depth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        SPDLOG_ERROR("offscreen framebuffer is not complete.");
+
+    /// 没有 surface 时 viewport 的初始值是 0，需要手动设置
+    glViewport(0, 0, _framebuffer_width, _framebuffer_height);
+
+    gl_bind_framebuffer    = glad_glBindFramebuffer;
+    glad_glBindFramebuffer = bind_framebuffer_offscreen;
+}
+
+
+Window::ProcLoader Window::proc_loader()
+{
+#ifdef FRAME_HAS_EGL
+    if (_headless)
+        return (ProcLoader) eglGetProcAddress;
+#endif
+    return (ProcLoader) glfwGetProcAddress;
+}
+
+
+unsigned int Window::offscreen_framebuffer()
+{
+    return offscreen_fbo;
+}
+
+
+void Window::swap_offscreen()
+{
+    glFinish();
+}
+
+
+void Window::resize_offscreen(int width, int height)
+{
+    alloc_offscreen_storage(width, height);
+}
+
+
+void Window::terminate_headless()
+{
+    if (gl_bind_framebuffer)
+        glad_glBindFramebuffer = gl_bind_framebuffer;
+    glDeleteFramebuffers(1, &offscreen_fbo);
+    glDeleteRenderbuffers(1, &offscreen_color);
+    glDeleteRenderbuffers(1, &offscreen_depth);
+    offscreen_fbo = offscreen_color = offscreen_depth = 0;
+
+#ifdef FRAME_HAS_EGL
+    eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(egl_display, egl_context);
+    eglTerminate(egl_display);
+    egl_context = EGL_NO_CONTEXT;
+    egl_display = EGL_NO_DISPLAY;
+#endif
+    _headless = false;
+}
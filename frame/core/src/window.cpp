@@ -17,6 +17,10 @@ bool Window::init()
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+#ifndef NDEBUG
+    /// 调试上下文中驱动会报告更多的消息，见 GLDebug
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+#endif
 
     /// 创建窗口
 #ifdef __APPLE__
@@ -24,7 +28,8 @@ bool Window::init()
     _window = glfwCreateWindow(_framebuffer_width / 2, _framebuffer_height / 2, window_title,
                                nullptr, nullptr);
 #else
-    window = glfwCreateWindow(_window_width, _window_height, window_title, nullptr, nullptr);
+    _window = glfwCreateWindow(_framebuffer_width, _framebuffer_height, window_title, nullptr,
+                               nullptr);
 #endif
     if (_window == nullptr)
         return false;
@@ -37,6 +42,8 @@ bool Window::init()
     glfwSetMouseButtonCallback(_window, callback_mouse_button);
     glfwSetFramebufferSizeCallback(_window, callback_framebuffer_size);
     glfwSetKeyCallback(_window, callback_keyboard);
+    glfwSetScrollCallback(_window, callback_scroll);
+    glfwSetWindowRefreshCallback(_window, callback_refresh);
 
     return true;
 }
@@ -44,31 +51,63 @@ bool Window::init()
 
 void Window::terminate()
 {
+    if (_headless)
+    {
+        terminate_headless();
+        return;
+    }
     glfwDestroyWindow(_window);
     glfwTerminate();
 }
 
 
+void Window::swap_framebuffer()
+{
+    if (_headless)
+        swap_offscreen();
+    else
+        glfwSwapBuffers(_window);
+}
+
+
+void Window::set_vsync(bool enabled)
+{
+    if (!_headless)
+        glfwSwapInterval(enabled ? 1 : 0);
+}
+
+
 void Window::set_framebuffer_size(int width, int height)
 {
     _framebuffer_width  = width;
     _framebuffer_height = height;
 
+    if (_headless)
+    {
+        resize_offscreen(width, height);
+        return;
+    }
+
 #ifdef __APPLE__
     /// 与 glfw 相关的操作，window 尺寸是 framebuffer 尺寸的 1/2
     glfwSetWindowSize(_window, width / 2, height / 2);
-#elif
-    glfwSetWindowSize(window.ptr, width, height);
+#else
+    glfwSetWindowSize(_window, width, height);
 #endif
 }
 
 
-void Window::tick_window_event()
+void Window::tick_window_event(double wait_timeout)
 {
     _current_key_actions.clear();
+    if (_headless)
+        return;
 
     /// 读取「事件队列」，触发回调函数
-    glfwPollEvents();
+    if (wait_timeout > 0.0)
+        glfwWaitEventsTimeout(wait_timeout);
+    else
+        glfwPollEvents();
 
     /// 检查是否需要关闭窗口
     if (key_has_action(GLFW_KEY_ESCAPE, GLFW_PRESS))
@@ -89,22 +128,38 @@ void Window::callback_cursor_pos(GLFWwindow *, double xpos, double ypos)
 {
     _cursor_pos_x = xpos;
     _cursor_pos_y = ypos;
+    ++_event_cnt;
 }
 
 
 void Window::callback_mouse_button(GLFWwindow *, int button, int action, int)
 {
     _current_key_actions.emplace_back(button, action);
+    ++_event_cnt;
 }
 
 
 void Window::callback_framebuffer_size(GLFWwindow *, int width, int height)
 {
     std::fprintf(stdout, "framebuffer size: %d, %d\n", width, height);
+    ++_event_cnt;
+}
+
+
+void Window::callback_scroll(GLFWwindow *, double, double)
+{
+    ++_event_cnt;
+}
+
+
+void Window::callback_refresh(GLFWwindow *)
+{
+    ++_event_cnt;
 }
 
 
 void Window::callback_keyboard(GLFWwindow *, int key, int, int action, int)
 {
     _current_key_actions.emplace_back(key, action);
+    ++_event_cnt;
 }
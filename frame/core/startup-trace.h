@@ -0,0 +1,106 @@
+/**
+ * 启动分析：从 Engine 创建到第一帧结束，每个资源在每个阶段（读取、解析、后处理、解码、
+ * 生成 mipmap、上传、着色器编译和链接）花费的时间和处理的字节数\n
+ * 结果输出为按耗时排序的汇总表，也可以导出为 Chrome trace，用于跟踪首帧时间的变化
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+/**
+ * 一个阶段的一次测量，时间的单位是微秒，起点是 StartupTrace::begin 的时刻
+ */
+struct StartupSpan {
+    std::string phase;
+    std::string asset;         // 资源的路径，为空时继承外层 scope 的资源
+    bool        asset_root;    // 是否是这个资源最外层的 scope，资源的耗时只统计最外层
+    uint32_t    depth;         // 同一个线程内的嵌套深度，0 是最外层
+    uint32_t    thread;        // 线程的编号，按照第一次记录的顺序分配
+
+    double begin;
+    double time;
+    double child_time;    // 直接嵌套在内的 scope 的总耗时，用于计算自身的耗时
+    size_t bytes;
+};
+
+
+/**
+ * @brief 启动过程的分析器，通过静态成员管理，和 Profiler 类似
+ * 只在 begin 和 finish 之间记录，finish 之后 StartupScope 只检查一次 active；
+ * 启动阶段的测量数量不多，直接用互斥锁保护
+ */
+class StartupTrace
+{
+public:
+    /**
+     * 开始记录，Engine 创建时调用
+     */
+    static void begin();
+
+    /**
+     * 停止记录，打印汇总表，trace_path 不为空时导出 Chrome trace；Engine 在第一帧结束后调用
+     * @param total_ms 首帧时间，用于计算没有被任何 scope 覆盖的部分
+     */
+    static void finish(double total_ms, const std::string &trace_path);
+
+    [[nodiscard]] static bool active() { return _active.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] static std::vector<StartupSpan> spans();
+
+    /**
+     * 导出为 Chrome trace，每个 span 的 args 中包含资源路径和字节数
+     * @return 是否成功写入文件
+     */
+    static bool export_chrome_trace(const std::string &path);
+
+private:
+    friend class StartupScope;
+
+    StartupTrace() = default;
+
+    static double   now_us();
+    static uint32_t thread_index();
+
+    static inline std::atomic<bool> _active{false};
+    static inline std::mutex        _mutex;
+
+    static std::vector<StartupSpan> _spans;
+
+    /**
+     * 打印每个阶段、每个资源的耗时，按照耗时从大到小排序
+     */
+    static void print_summary(double total_ms);
+};
+
+
+/**
+ * @brief 测量所在作用域的耗时，例如：
+ * StartupScope scope("decode", file_path); ...; scope.add_bytes(size);\n
+ * 没有指定资源时使用外层 scope 的资源，因此 new_tex2d 中的上传会归属到正在加载的纹理
+ */
+class StartupScope
+{
+public:
+    explicit StartupScope(const char *phase, const std::string &asset = {});
+    ~StartupScope();
+
+    StartupScope(const StartupScope &)            = delete;
+    StartupScope &operator=(const StartupScope &) = delete;
+
+    void add_bytes(size_t bytes) { _span.bytes += bytes; }
+
+    /**
+     * 把文件的大小计入字节数，文件不存在时忽略
+     */
+    void add_file_bytes(const std::string &path);
+
+private:
+    StartupSpan   _span{};
+    StartupScope *_parent = nullptr;
+    bool          _active = false;
+};
@@ -0,0 +1,105 @@
+/**
+ * 压力测试场景：用少量资源生成任意数量的物体，用于测量各个阶段随物体数量的变化
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "./rt-object.h"
+#include "./scene.h"
+#include "./transform.h"
+
+
+/// 物体的排列方式
+enum class StressLayout {
+    Grid,         // 立方体网格
+    Scatter,      // 在立方体中随机分布，随机旋转和缩放
+    Hierarchy,    // 层级结构，每个物体围绕父物体排成一圈，父物体运动时子物体跟随
+};
+
+
+struct StressSceneDesc {
+    size_t       object_cnt = 1000;
+    StressLayout layout     = StressLayout::Grid;
+    float        spacing    = 2.f;    // 相邻物体的平均距离，每个物体被缩放到边长为 1
+
+    int material_cnt = 1;    // 不同材质的数量，base color、metallic、roughness 各不相同
+    int texture_cnt  = 0;    // 其中使用 base color 纹理的材质数量，不超过 material_cnt
+
+    float dynamic_fraction = 0.f;    // 每帧运动的物体所占的比例
+    int   hierarchy_fanout = 8;      // Hierarchy：每个物体的子物体数量
+
+    uint32_t seed = 1;
+};
+
+
+/**
+ * @brief 生成并驱动压力测试场景
+ * 每个物体对应 TransformTree 中的一个节点，场景中的位姿由节点的世界矩阵得到；
+ * 动态物体每帧绕自己的轴旋转，update 只把位姿发生变化的物体写回 Scene\n
+ * 生成的物体从 assets 中轮流选择几何，每个资源先被归一化到原点附近、边长为 1
+ */
+class StressScene
+{
+public:
+    /**
+     * 生成场景，之前生成的内容会被清空
+     * @param assets 可以使用的几何，例如 ModelManager::load(MODEL_BUNNY) 的结果
+     * @note texture_cnt 大于 0 时会创建纹理，需要 OpenGL 上下文；否则可以在没有上下文时使用
+     */
+    void generate(const StressSceneDesc &desc, const std::vector<RTObject> &assets);
+
+    /**
+     * 更新动态物体的位姿，并写回 Scene
+     * @param time 秒
+     * @return 位姿发生变化的物体数量
+     */
+    size_t update(float time);
+
+    [[nodiscard]] const Scene         &scene() const { return _scene; }
+    [[nodiscard]] const TransformTree &transforms() const { return _transforms; }
+    [[nodiscard]] const AABB          &bounds() const { return _bounds; }
+    [[nodiscard]] size_t               dynamic_cnt() const { return _dynamic.size(); }
+
+    /**
+     * 位姿可能变化的物体（动态物体以及它们的子树）在 Scene 中的下标，按照拓扑顺序排列\n
+     * 只有这些物体的位姿和包围盒会被 update 修改，其余的数据在下一次 generate 之前不变，
+     * 因此另一个线程 update 时，渲染线程可以读取 Scene 中其余的数据
+     */
+    [[nodiscard]] const std::vector<uint32_t> &moving() const { return _moving; }
+
+    /**
+     * 释放生成的纹理，需要在 OpenGL 上下文有效时调用
+     */
+    void release();
+
+private:
+    Scene         _scene;
+    TransformTree _transforms;
+    AABB          _bounds;    // 生成时所有物体的包围盒
+
+    /// 以节点的下标索引
+    std::vector<SceneHandle> _handles;
+    std::vector<uint32_t>    _asset_ids;
+
+    /// 每个资源的归一化矩阵
+    std::vector<glm::mat4> _asset_matrices;
+
+    /// 动态物体的节点、旋转轴和角速度
+    struct Dynamic {
+        TransformId node;
+        glm::quat   base;    // 生成时的旋转
+        glm::vec3   axis;
+        float       speed;
+    };
+    std::vector<Dynamic>  _dynamic;
+    std::vector<uint32_t> _moving;
+
+    std::vector<GLuint> _textures;
+
+    std::vector<Material> make_materials(const StressSceneDesc &desc, const Material &base);
+};
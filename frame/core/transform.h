@@ -0,0 +1,109 @@
+/**
+ * 层级变换：节点按照拓扑顺序存放（父节点的下标总是小于子节点），
+ * 局部的 TRS 以 SoA 的方式存放，只更新发生变化的子树
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+
+/// 节点在 TransformTree 中的下标
+using TransformId = uint32_t;
+
+constexpr TransformId INVALID_TRANSFORM = UINT32_MAX;
+
+
+/**
+ * @brief 变换的层级结构
+ * 修改局部的 TRS 只会标记脏节点，update() 时先沿着拓扑顺序传播脏标记，
+ * 再用 SIMD 每次组合 4 个节点的局部矩阵，最后按顺序乘上父节点的世界矩阵
+ */
+class TransformTree
+{
+public:
+    /**
+     * 添加一个节点
+     * @param parent 父节点，必须已经存在，INVALID_TRANSFORM 表示根节点
+     */
+    TransformId add(TransformId parent, const glm::vec3 &translation = glm::vec3(0.f),
+                    const glm::quat &rotation = glm::quat(1.f, glm::vec3(0.f)),
+                    const glm::vec3 &scale = glm::vec3(1.f));
+
+    /**
+     * 以局部矩阵的形式添加节点，分解为 TRS；行列式为负（镜像）时 x 轴的 scale 取负数\n
+     * 无法表示为 TRS 的矩阵（某个轴的 scale 为 0、有切变、不是仿射变换）直接保存原始矩阵，
+     * 渲染结果和矩阵乘法相同
+     */
+    TransformId add(TransformId parent, const glm::mat4 &local);
+
+    /**
+     * 修改 TRS 的任何一个分量时，保存的原始矩阵被丢弃，之后使用 TRS；
+     * 原始矩阵的节点的 TRS 是尽可能分解出来的近似值
+     */
+    void set_translation(TransformId id, const glm::vec3 &translation);
+    void set_rotation(TransformId id, const glm::quat &rotation);
+    void set_scale(TransformId id, const glm::vec3 &scale);
+
+    [[nodiscard]] glm::vec3   translation(TransformId id) const;
+    [[nodiscard]] glm::quat   rotation(TransformId id) const;
+    [[nodiscard]] glm::vec3   scale(TransformId id) const;
+    [[nodiscard]] TransformId parent(TransformId id) const { return _parent[id]; }
+
+    /**
+     * 世界坐标系下的矩阵
+     * @note 修改之后需要先调用 update()
+     */
+    [[nodiscard]] const glm::mat4 &world(TransformId id) const { return _world[id]; }
+
+    [[nodiscard]] const std::vector<glm::mat4> &world_matrices() const { return _world; }
+
+    /**
+     * 更新脏节点以及它们的子树的世界矩阵
+     * @return 更新的节点数量
+     */
+    size_t update();
+
+    [[nodiscard]] size_t size() const { return _parent.size(); }
+
+    /**
+     * 上一次 update() 中世界矩阵发生变化的节点，按照拓扑顺序排列
+     */
+    [[nodiscard]] const std::vector<TransformId> &changed() const { return _changed; }
+
+private:
+    std::vector<TransformId> _parent;
+
+    /// 局部的 TRS，SoA
+    std::vector<float> _tx, _ty, _tz;
+    std::vector<float> _qx, _qy, _qz, _qw;
+    std::vector<float> _sx, _sy, _sz;
+
+    /// 无法分解为 TRS 的局部矩阵：_raw[id] 是 _raw_locals 中的下标，INVALID_RAW 表示使用 TRS
+    static constexpr uint32_t INVALID_RAW = UINT32_MAX;
+    std::vector<uint32_t>     _raw;
+    std::vector<glm::mat4>    _raw_locals;
+
+    std::vector<glm::mat4> _world;
+
+    std::vector<uint8_t>     _dirty;          // 局部的 TRS 是否被修改
+    bool                     _any_dirty{};    // 是否有节点被修改，用于快速跳过 update
+    std::vector<uint8_t>     _world_dirty;    // update 时使用：世界矩阵是否需要更新
+    std::vector<TransformId> _changed;        // update 时使用：需要更新的节点
+    std::vector<glm::mat4>   _local_cache;    // update 时使用：需要更新的节点的局部矩阵
+
+    void mark_dirty(TransformId id)
+    {
+        _dirty[id] = 1;
+        _any_dirty = true;
+    }
+
+    /**
+     * 用 SIMD 计算 _changed 中所有节点的局部矩阵，写入 _local_cache；
+     * 有原始矩阵的节点直接使用原始矩阵
+     */
+    void compose_local();
+};
@@ -0,0 +1,65 @@
+/**
+ * 三缓冲：一个线程写入、一个线程读取，双方都不需要等待对方
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+
+/**
+ * @brief 单生产者、单消费者的三缓冲
+ * 三个缓冲分别由写入方、读取方持有，剩下一个放在共享的位置上；
+ * publish 把写好的缓冲和共享的缓冲交换，update 在共享的缓冲是新的时候把它和读取的缓冲交换\n
+ * 读取方总是拿到最新发布的内容，中间的版本可能被跳过，因此每次发布的内容应该是完整的，
+ * 而不是相对于上一次的增量。缓冲会被反复复用，其中的 vector 等容器不需要每帧重新分配
+ * @tparam T 需要可以默认构造
+ */
+template<typename T>
+class TripleBuffer
+{
+public:
+    /**
+     * 写入方持有的缓冲，其中是之前某次发布的旧内容
+     */
+    T &write_buffer() { return _buffers[_write]; }
+
+    /**
+     * 发布写入方的缓冲，之后 write_buffer() 返回另一个缓冲
+     */
+    void publish()
+    {
+        const uint8_t prev = _shared.exchange(_write | FRESH, std::memory_order_acq_rel);
+        _write             = prev & INDEX_MASK;
+    }
+
+    /**
+     * 取得最新发布的内容
+     * @return 是否有新的内容；没有时 read() 仍然是上一次的内容
+     */
+    bool update()
+    {
+        if (!(_shared.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        const uint8_t prev = _shared.exchange(_read, std::memory_order_acq_rel);
+        _read              = prev & INDEX_MASK;
+        return true;
+    }
+
+    /**
+     * 读取方持有的缓冲，在下一次 update() 之前不会被修改；还没有发布过时是默认构造的值
+     */
+    [[nodiscard]] const T &read() const { return _buffers[_read]; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH      = 0x4;    // 共享的缓冲是否是新发布的
+
+    std::array<T, 3> _buffers{};
+
+    /// 写入方和读取方各自使用的下标放在不同的 cache line，避免伪共享
+    alignas(64) uint8_t _write = 0;
+    alignas(64) uint8_t _read  = 1;
+    alignas(64) std::atomic<uint8_t> _shared{2};
+};
@@ -0,0 +1,64 @@
+/**
+ * 更新线程：每帧的更新逻辑在单独的线程中执行，和渲染线程提交 OpenGL 命令的过程重叠
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+
+/**
+ * @brief 每次 kick 执行一次更新函数的工作线程
+ * 渲染线程每帧先 wait 上一次更新，再 kick 下一次，因此更新最多比渲染提前一帧；
+ * wait 和 kick 之间更新线程是空闲的，渲染线程可以修改更新函数使用的数据\n
+ * 两个线程之间传递的数据通过 TripleBuffer 发布；每次更新结束之后重置更新线程的 FrameArena
+ */
+class UpdateThread
+{
+public:
+    explicit UpdateThread(std::function<void()> update);
+
+    /**
+     * 等待正在进行的更新完成，之后退出线程
+     */
+    ~UpdateThread();
+
+    UpdateThread(const UpdateThread &)            = delete;
+    UpdateThread &operator=(const UpdateThread &) = delete;
+
+    /**
+     * 开始一次更新，上一次更新必须已经 wait 过
+     */
+    void kick();
+
+    /**
+     * 等待当前的更新完成，没有进行中的更新时直接返回
+     * @note 更新函数抛出的异常会在这里重新抛出
+     */
+    void wait();
+
+    /// 最近一次 wait 实际等待的毫秒数，即更新比渲染慢的部分
+    [[nodiscard]] double last_wait_ms() const { return _last_wait_ms; }
+
+    /// 最近一次 wait 等到的更新中，更新线程分配内存的次数，见 AllocCounter
+    [[nodiscard]] uint64_t last_alloc_cnt() const { return _last_alloc_cnt; }
+
+private:
+    std::function<void()> _update;
+
+    std::thread             _thread;
+    std::mutex              _mutex;
+    std::condition_variable _cv;
+    bool                    _pending = false;    // kick 之后、更新完成之前为 true
+    bool                    _stop    = false;
+    std::exception_ptr      _error;
+
+    double   _last_wait_ms   = 0.0;
+    uint64_t _last_alloc_cnt = 0;    // 由 _mutex 保护
+
+    void thread_loop();
+};
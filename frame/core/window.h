@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <vector>
 
 #include <GLFW/glfw3.h>
@@ -9,26 +10,61 @@
 struct Window {
     static inline const char *window_title = "RTR";
 
+    /// 用于加载 OpenGL 函数，和 GLADloadproc 的类型相同
+    using ProcLoader = void *(*) (const char *);
+
     /**
      * 初始化 glfw，创建窗口，设置 OpenGL 上下文，设置回调函数
      * @return 操作是否成功
      */
     static bool init();
 
+    /**
+     * 不创建窗口，通过 EGL 创建一个没有 surface 的 OpenGL 上下文（例如 Mesa 的 llvmpipe），
+     * 用于没有显示器、没有 GPU 的机器\n
+     * 默认 framebuffer 由一个 width x height 的离屏 FBO 代替，见 init_offscreen_framebuffer
+     * @return 操作是否成功，编译时没有找到 EGL 则总是失败
+     */
+    static bool init_headless(int width, int height);
+
+    /**
+     * 创建离屏 FBO，之后所有绑定 framebuffer 0 的操作都会绑定到这个 FBO，
+     * 因此项目中的代码不需要修改\n
+     * 只在 headless 模式下使用，需要在 glad 初始化之后调用
+     */
+    static void init_offscreen_framebuffer();
+
+    /**
+     * 加载 OpenGL 函数的方式，headless 模式下是 eglGetProcAddress，否则是 glfwGetProcAddress
+     */
+    static ProcLoader proc_loader();
+
+    static bool headless() { return _headless; }
+
+    /**
+     * headless 模式下代替默认 framebuffer 的 FBO，否则为 0
+     */
+    static unsigned int offscreen_framebuffer();
+
     /**
      * 窗口关闭，释放资源
      */
     static void terminate();
 
     /**
-     * 交换双缓冲
+     * 交换双缓冲；headless 模式下等待这一帧的渲染完成
+     */
+    static void swap_framebuffer();
+
+    /**
+     * 是否等待垂直同步，性能测试时需要关闭；headless 模式下没有影响
      */
-    static void swap_framebuffer() { glfwSwapBuffers(_window); }
+    static void set_vsync(bool enabled);
 
     /**
-     * 是否应该关闭窗口
+     * 是否应该关闭窗口，headless 模式下总是 false
      */
-    static bool should_close() { return glfwWindowShouldClose(_window); }
+    static bool should_close() { return !_headless && glfwWindowShouldClose(_window); }
 
     /**
      * 改变窗口内的 framebuffer 的大小
@@ -37,8 +73,15 @@ struct Window {
 
     /**
      * 清除之前缓存的按键状态，处理新的按键
+     * @param wait_timeout 大于 0 时，没有事件则最多等待这么多秒，用于画面静止时降低 CPU 占用
+     */
+    static void tick_window_event(double wait_timeout = 0.0);
+
+    /**
+     * 收到的输入和窗口事件的数量（鼠标、键盘、滚轮、窗口尺寸、窗口需要重绘），
+     * 和上一帧不同说明画面可能需要更新
      */
-    static void tick_window_event();
+    static uint64_t event_cnt() { return _event_cnt; }
 
     static GLFWwindow *window() { return _window; }
 
@@ -62,17 +105,24 @@ struct Window {
      * 键盘按键的最后一个动作，也就是按键当前的状态
      * @return 只能是 GLFW_PRESS, GLFW_RELEASE
      */
-    static int keyboard_last_action(int key) { return glfwGetKey(_window, key); }
+    static int keyboard_last_action(int key)
+    {
+        return _headless ? GLFW_RELEASE : glfwGetKey(_window, key);
+    }
 
     /**
      * 鼠标按键的最后一个动作，也就是按键当前的状态
      * @return 只能是 GLFW_PRESS, GLFW_RELEASE
      */
-    static int mouse_button_last_action(int button) { return glfwGetMouseButton(_window, button); }
+    static int mouse_button_last_action(int button)
+    {
+        return _headless ? GLFW_RELEASE : glfwGetMouseButton(_window, button);
+    }
 
 
 private:
     static inline GLFWwindow *_window;
+    static inline bool        _headless = false;
 
     static inline int _framebuffer_width  = 1600;
     static inline int _framebuffer_height = 1600;
@@ -86,6 +136,15 @@ private:
      */
     static inline std::vector<std::pair<int, int>> _current_key_actions;
 
+    static inline uint64_t _event_cnt = 0;
+
+    /**
+     * headless 模式下的实现，见 window-headless.cpp
+     */
+    static void swap_offscreen();
+    static void resize_offscreen(int width, int height);
+    static void terminate_headless();
+
     /**
      * 鼠标位置改变的回调。左上角是 (0, 0)，鼠标位置基于 window 的尺寸
      * @note 在 APPLE 中，framebuffer 是 window 大小的 2 倍
@@ -104,6 +163,16 @@ private:
      */
     static void callback_framebuffer_size(GLFWwindow *, int width, int height);
 
+    /**
+     * 鼠标滚轮的回调，只用于统计事件
+     */
+    static void callback_scroll(GLFWwindow *, double, double);
+
+    /**
+     * 窗口的内容需要重绘时的回调，例如被遮挡的部分重新显示，只用于统计事件
+     */
+    static void callback_refresh(GLFWwindow *);
+
     /**
      * 键盘按键操作的回调
      * @param key 键盘的按键
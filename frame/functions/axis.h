@@ -7,6 +7,7 @@
 
 #include "frame-config.hpp"
 #include "core/shader.h"
+#include "core/shader-lib.h"
 
 
 class Axis
@@ -20,7 +21,7 @@ private:
     static GLuint get_axis_vao();
 
 private:
-    Shader2 shader_line = Shader2(SHADER + "line.vert", SHADER + "line.frag");
+    Shader2 &shader_line = ShaderLib::get(SHADER + "line.vert", SHADER + "line.frag");
 
     GLuint vao;
 
@@ -45,8 +46,15 @@ private:
 /// ==================================================================
 
 
+/**
+ * 所有 Axis 对象共享同一个 VAO
+ */
 inline GLuint Axis::get_axis_vao()
 {
+    static GLuint shared_vao = 0;
+    if (shared_vao)
+        return shared_vao;
+
     GLuint VAO;
     glGenVertexArrays(1, &VAO);
     glBindVertexArray(VAO);
@@ -64,6 +72,7 @@ inline GLuint Axis::get_axis_vao()
     /// unbind
     glBindVertexArray(0);
 
+    shared_vao = VAO;
     return VAO;
 }
 
@@ -1,5 +1,23 @@
 #pragma once
 
+#include <cstdint>
+
+
+/**
+ * 材质的特性，每个特性占一位\n
+ * 导入模型时计算，用于选择着色器变体，以及作为渲染排序的 key，
+ * 这样着色器中就不需要对缺失的纹理进行分支和采样
+ */
+enum MaterialFeature : uint32_t {
+    MAT_TEX_BASECOLOR          = 1u << 0,
+    MAT_TEX_METALLIC_ROUGHNESS = 1u << 1,
+    MAT_TEX_NORMAL             = 1u << 2,
+    MAT_TEX_OCCLUSION          = 1u << 3,
+    MAT_TEX_EMISSIVE           = 1u << 4,
+    MAT_DOUBLE_SIDE            = 1u << 5,
+};
+using MaterialFeatures = uint32_t;
+
 
 // TODO 按照 gltf2.0 的标准来做，例如：basecolor 要求是 sRGB 的，之后按照 basecolor-factor 加权
 struct Material {
@@ -35,4 +53,19 @@ struct Material {
     [[nodiscard]] bool has_tex_occlusion() const { return tex_occlusion != -1; }
     [[nodiscard]] bool has_tex_normal() const { return tex_normal != -1; }
     [[nodiscard]] bool has_tex_emissive() const { return tex_emissive != -1; }
+
+    MaterialFeatures features{0};    // 由 update_features() 计算
+
+    /**
+     * 根据纹理等信息计算 features，修改材质后需要重新调用
+     */
+    void update_features()
+    {
+        features = (has_tex_basecolor() ? MAT_TEX_BASECOLOR : 0u) |
+                   (has_tex_metallic_roughness() ? MAT_TEX_METALLIC_ROUGHNESS : 0u) |
+                   (has_tex_normal() ? MAT_TEX_NORMAL : 0u) |
+                   (has_tex_occlusion() ? MAT_TEX_OCCLUSION : 0u) |
+                   (has_tex_emissive() ? MAT_TEX_EMISSIVE : 0u) |
+                   (double_side ? MAT_DOUBLE_SIDE : 0u);
+    }
 };
\ No newline at end of file
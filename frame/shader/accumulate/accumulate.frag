@@ -0,0 +1,10 @@
+#version 330 core
+
+out vec4 FragColor;
+
+uniform sampler2D tex_current;  // 这一帧的颜色
+
+/// 和历史的混合由 glBlendColor 的 alpha 决定：history = mix(history, current, alpha)
+void main() {
+    FragColor = vec4(texelFetch(tex_current, ivec2(gl_FragCoord.xy), 0).rgb, 1.0);
+}
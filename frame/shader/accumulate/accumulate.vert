@@ -0,0 +1,7 @@
+#version 330 core
+
+/// 不需要顶点数据：3 个顶点组成覆盖整个屏幕的三角形
+void main() {
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(pos * 2.0 - 1.0, 0, 1);
+}
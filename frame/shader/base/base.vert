@@ -10,12 +10,19 @@ out VS_FS {
     vec3 pos_world;
 } vs_fs;
 
+#ifdef INSTANCED
+/// per-instance 的属性，见 InstanceData
+layout (location = 4) in mat4 in_instance_model;
+#define MODEL_MATRIX in_instance_model
+#else
 uniform mat4 u_model;
+#define MODEL_MATRIX u_model
+#endif
 uniform mat4 u_vp;
 
 
 void main() {
-    vec4 temp = u_model * vec4(in_pos, 1.0);
+    vec4 temp = MODEL_MATRIX * vec4(in_pos, 1.0);
     gl_Position = u_vp * temp;
 
     vs_fs.normal = in_normal;
@@ -6,9 +6,14 @@ in vec2 TexCoord;
 
 out vec4 FragColor;
 
-uniform bool has_diffuse;
+#ifdef HAS_TEX_BASECOLOR
 uniform sampler2D tex_diffuse;
+#elif defined(INSTANCED)
+flat in vec3 InstanceKd;
+#define kd InstanceKd
+#else
 uniform vec3 kd;
+#endif
 uniform vec3 ks;
 uniform vec3 camera_pos;
 uniform vec3 light_pos;
@@ -16,7 +21,11 @@ uniform float light_indensity;
 
 void main() {
     // color from texture, gamma correct
-    vec3 color = has_diffuse ? pow(texture(tex_diffuse, TexCoord).rgb, vec3(2.2)) : kd;
+#ifdef HAS_TEX_BASECOLOR
+    vec3 color = pow(texture(tex_diffuse, TexCoord).rgb, vec3(2.2));
+#else
+    vec3 color = kd;
+#endif
 
     // ambient
     vec3 ambient = 0.15 * color;
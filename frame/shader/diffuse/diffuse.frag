@@ -6,10 +6,19 @@ in vec2 TexCoord;
 
 out vec4 FragColor;
 
-uniform bool has_diffuse;
+#ifdef HAS_TEX_BASECOLOR
 uniform sampler2D tex_diffuse;
+#elif defined(INSTANCED)
+flat in vec3 InstanceKd;
+#define kd InstanceKd
+#else
 uniform vec3 kd;
+#endif
 
 void main() {
-    FragColor = has_diffuse ? texture(tex_diffuse, TexCoord) : vec4(pow(kd, vec3(1.0/2.2)), 1.0);
+#ifdef HAS_TEX_BASECOLOR
+    FragColor = texture(tex_diffuse, TexCoord);
+#else
+    FragColor = vec4(pow(kd, vec3(1.0/2.2)), 1.0);
+#endif
 }
\ No newline at end of file
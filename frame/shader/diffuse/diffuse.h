@@ -5,28 +5,105 @@
 
 #include "frame-config.hpp"
 #include "core/shader.h"
+#include "core/shader-lib.h"
 #include "core/rt-object.h"
+#include "core/render-queue.h"
 
 class ShaderDiffuse
 {
 public:
-    Shader2 shader = {SHADER + "diffuse/diffuse.vert", SHADER + "diffuse/diffuse.frag"};
+    /// 着色器只用到了 basecolor 纹理，其他特性不产生新的变体
+    static constexpr MaterialFeatures FEATURE_MASK = MAT_TEX_BASECOLOR;
 
-    void init(const glm::mat4 &proj) { shader.set_uniform({{"m_proj", proj}}); }
+    /// 所有可能的变体，per-frame 的 uniform 需要对每个变体都设置
+    static constexpr MaterialFeatures VARIANTS[] = {0, MAT_TEX_BASECOLOR};
 
-    void update_per_fame(const glm::mat4 &view) { shader.set_uniform({{"m_view", view}}); }
+    /**
+     * 获取材质特性对应的着色器变体，只在第一次使用时查找 ShaderLib
+     */
+    static Shader2 &shader(MaterialFeatures features = 0)
+    {
+        static ShaderVariants variants(SHADER + "diffuse/diffuse.vert",
+                                       SHADER + "diffuse/diffuse.frag", FEATURE_MASK);
+        return variants.get(features);
+    }
+
+    /**
+     * 实例化绘制用的变体，m_model 和 kd 来自 InstanceData
+     */
+    static Shader2 &shader_instanced(MaterialFeatures features = 0)
+    {
+        static ShaderVariants variants(SHADER + "diffuse/diffuse.vert",
+                                       SHADER + "diffuse/diffuse.frag", FEATURE_MASK,
+                                       {{"INSTANCED", ""}});
+        return variants.get(features);
+    }
+
+    void init(const glm::mat4 &proj)
+    {
+        _proj = proj;
+        for (MaterialFeatures f: VARIANTS)
+            shader(f).set_uniform({{"m_proj", proj}});
+    }
+
+    void update_per_fame(const glm::mat4 &view)
+    {
+        _view = view;
+        for (MaterialFeatures f: VARIANTS)
+            shader(f).set_uniform({{"m_view", view}});
+    }
 
     void draw(const RTObject &obj)
     {
         const Material &mat = obj.mesh.mat;
         if (mat.has_tex_basecolor())
+        {
             glBindTexture_(GL_TEXTURE_2D, 0, mat.metallic_roughness.tex_base_color);
-        shader.set_uniform({
-                {"m_model", obj.matrix()},
-                {"kd", glm::vec3(mat.metallic_roughness.base_color)},
-                {"has_diffuse", mat.has_tex_basecolor()},
-                {"tex_diffuse", 0},
-        });
+            shader(mat.features).set_uniform({
+                    {"m_model", obj.matrix()},
+                    {"tex_diffuse", 0},
+            });
+        } else
+            shader(mat.features).set_uniform({
+                    {"m_model", obj.matrix()},
+                    {"kd", glm::vec3(mat.metallic_roughness.base_color)},
+            });
         obj.mesh.draw();
     }
+
+    /**
+     * 实例化绘制：几何、纹理相同的物体合并成一次 draw call
+     * @return draw call 的数量
+     */
+    size_t draw_instanced(const std::vector<RTObject> &objs)
+    {
+        _queue.clear();
+        for (const auto &obj: objs)
+            _queue.push(shader_instanced(obj.mesh.mat.features), obj);
+        _queue.sort();
+        _queue.build_batches();
+        _instance_buffer.upload(_queue.instances());
+
+        for (const auto &batch: _queue.batches())
+        {
+            const Material &mat = batch.obj->mesh.mat;
+            batch.shader->set_uniform({{"m_proj", _proj}, {"m_view", _view}});
+            if (mat.has_tex_basecolor())
+            {
+                glBindTexture_(GL_TEXTURE_2D, 0, mat.metallic_roughness.tex_base_color);
+                batch.shader->set_uniform({{"tex_diffuse", 0}});
+            }
+            _instance_buffer.bind(batch.obj->mesh.vao, batch.first_instance);
+            batch.obj->mesh.draw_instanced((GLsizei) batch.instance_cnt);
+        }
+        return _queue.batches().size();
+    }
+
+private:
+    /// 实例化的变体在第一次使用时才编译，因此 per-frame 的 uniform 先记录下来
+    glm::mat4 _proj{1.f};
+    glm::mat4 _view{1.f};
+
+    RenderQueue    _queue;
+    InstanceBuffer _instance_buffer;
 };
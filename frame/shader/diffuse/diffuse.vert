@@ -8,15 +8,28 @@ out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
 
+#ifdef INSTANCED
+/// per-instance 的属性，见 InstanceData
+layout (location = 4) in mat4 instance_model;
+layout (location = 8) in vec4 instance_color;
+
+flat out vec3 InstanceKd;
+#define MODEL_MATRIX instance_model
+#else
 uniform mat4 m_model;
+#define MODEL_MATRIX m_model
+#endif
 uniform mat4 m_view;
 uniform mat4 m_proj;
 
 
 void main() {
-    gl_Position = m_proj * m_view * m_model * vec4(aPos, 1.0f);
+    gl_Position = m_proj * m_view * MODEL_MATRIX * vec4(aPos, 1.0f);
 
-    FragPos = vec3(m_model * vec4(aPos, 1.0f));
-    Normal = transpose(inverse(mat3(m_model))) * aNormal;
+    FragPos = vec3(MODEL_MATRIX * vec4(aPos, 1.0f));
+    Normal = transpose(inverse(mat3(MODEL_MATRIX))) * aNormal;
     TexCoord = aTexCoord;
+#ifdef INSTANCED
+    InstanceKd = instance_color.rgb;
+#endif
 }
\ No newline at end of file
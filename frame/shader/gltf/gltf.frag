@@ -1,70 +1,80 @@
 #version 330 core
 
 /// gltf 的材质系统
+/// 材质有哪些纹理，通过宏定义选择：HAS_TEX_BASECOLOR, HAS_TEX_OCCLUSION, HAS_TEX_EMISSIVE, HAS_TEX_NORMAL
 
 in VS_FS {
     vec3 pos_view;
     vec3 normal_view;
     vec2 texcoord_0;
+#ifdef HAS_TEX_NORMAL
     mat3 TBN_view;
+#endif
 } vs_fs;
 
 out vec4 out_color;
 
 /// basecolor 
-uniform vec4 u_basecolor;
-uniform bool u_has_basecolor;
+#ifdef HAS_TEX_BASECOLOR
 uniform sampler2D u_tex_basecolor;
+#else
+uniform vec4 u_basecolor;
+#endif
 
 /// occlusion
+#ifdef HAS_TEX_OCCLUSION
 uniform float u_occlusion_strength;
-uniform bool u_has_occlusion;
 uniform sampler2D u_tex_occlusion;
+#endif
 
 /// emissive
-uniform vec3 u_emissive;
-uniform bool u_has_emissive;
+#ifdef HAS_TEX_EMISSIVE
 uniform sampler2D u_tex_emissive;
+#else
+uniform vec3 u_emissive;
+#endif
 
 /// point light 
 uniform vec3 u_light_pos;
 uniform vec3 u_light_color;
 
 /// N map 
-uniform bool u_has_normal;
+#ifdef HAS_TEX_NORMAL
 uniform sampler2D u_tex_normal;
 uniform float u_normal_scale;
+#endif
 
 
 void main()
 {
     /// basecolor 
+#ifdef HAS_TEX_BASECOLOR
+    vec4 basecolor = texture(u_tex_basecolor, vs_fs.texcoord_0);
+#else
     vec4 basecolor = u_basecolor;
-    if (u_has_basecolor) {
-        basecolor = texture(u_tex_basecolor, vs_fs.texcoord_0);
-    }
+#endif
 
     /// occlused basecolor 
-    if (u_has_occlusion) {
-        float occlusion = texture(u_tex_occlusion, vs_fs.texcoord_0).r;
-        basecolor.rgb = mix(basecolor.rgb, basecolor.rgb * occlusion, u_occlusion_strength);
-    }
+#ifdef HAS_TEX_OCCLUSION
+    float occlusion = texture(u_tex_occlusion, vs_fs.texcoord_0).r;
+    basecolor.rgb = mix(basecolor.rgb, basecolor.rgb * occlusion, u_occlusion_strength);
+#endif
 
     /// emissive 
+#ifdef HAS_TEX_EMISSIVE
+    vec3 emissive = texture(u_tex_emissive, vs_fs.texcoord_0).rgb;
+#else
     vec3 emissive = u_emissive;
-    if (u_has_emissive) {
-        emissive = texture(u_tex_emissive, vs_fs.texcoord_0).rgb;
-    }
+#endif
 
     /// normal 
-    vec3 N;
-    if (u_has_normal) {
-        vec3 normal_tangent = texture(u_tex_normal, vs_fs.texcoord_0).xyz * 2.0 - 1.0;
-        normal_tangent = normalize(normal_tangent * vec3(u_normal_scale, u_normal_scale, 1.0));
-        N = vs_fs.TBN_view * normal_tangent;
-    }
-    else 
-        N = normalize(vs_fs.normal_view);
+#ifdef HAS_TEX_NORMAL
+    vec3 normal_tangent = texture(u_tex_normal, vs_fs.texcoord_0).xyz * 2.0 - 1.0;
+    normal_tangent = normalize(normal_tangent * vec3(u_normal_scale, u_normal_scale, 1.0));
+    vec3 N = vs_fs.TBN_view * normal_tangent;
+#else
+    vec3 N = normalize(vs_fs.normal_view);
+#endif
 
     /// blinn-phong
     vec3 phong_color;
@@ -82,4 +92,4 @@ void main()
     /// 丢弃透明的
     if (basecolor.a < 0.1) discard;
     out_color = vec4(phong_color + emissive, basecolor.a);
-}
\ No newline at end of file
+}
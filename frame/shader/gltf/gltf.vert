@@ -12,7 +12,9 @@ out VS_FS {
     vec3 pos_view;
     vec3 normal_view;
     vec2 texcoord_0;
+#ifdef HAS_TEX_NORMAL
     mat3 TBN_view;
+#endif
 } vs_fs;
 
 uniform mat4 u_model_view;
@@ -28,7 +30,10 @@ void main() {
     vs_fs.normal_view = normalize(matrix_mv_it * in_normal);
     vs_fs.texcoord_0 = in_texcoord_0;
 
+    /// 只有 normal map 需要 TBN
+#ifdef HAS_TEX_NORMAL
     vec3 tangent = normalize(matrix_mv_it * in_tangent.xyz);
     vec3 bit_tangent = cross(vs_fs.normal_view, tangent) * in_tangent.w;  // w 分量是 -1 或 1
     vs_fs.TBN_view = mat3(tangent, bit_tangent, vs_fs.normal_view);
+#endif
 }
@@ -0,0 +1,42 @@
+#ifndef OBJECT_DATA
+#define OBJECT_DATA
+/**
+ * 从 ObjectDataBuffer 中读取物体的数据，布局和 InstanceData 相同：
+ * 每个物体 6 个 texel，0-3 是模型矩阵的 4 列，4 是 base color，5 是 params
+ */
+
+#define OBJECT_TEXELS 6
+
+uniform samplerBuffer object_data;
+
+/**
+ * 物体的下标：逐个绘制时通过 uniform 设置；
+ * 定义了 OBJECT_ID_ATTRIBUTE 时来自 per-instance 的顶点属性，由间接绘制命令的 baseInstance 决定，
+ * 这时只能在 vertex shader 中使用
+ */
+#ifdef OBJECT_ID_ATTRIBUTE
+layout (location = 10) in uint object_id_attribute;
+#define object_id int(object_id_attribute)
+#else
+uniform int object_id;
+#endif
+
+mat4 object_model()
+{
+    int base = object_id * OBJECT_TEXELS;
+    return mat4(texelFetch(object_data, base), texelFetch(object_data, base + 1),
+                texelFetch(object_data, base + 2), texelFetch(object_data, base + 3));
+}
+
+vec4 object_base_color()
+{
+    return texelFetch(object_data, object_id * OBJECT_TEXELS + 4);
+}
+
+// x: metallic, y: roughness, z: 是否有 base color 纹理
+vec4 object_params()
+{
+    return texelFetch(object_data, object_id * OBJECT_TEXELS + 5);
+}
+
+#endif
@@ -5,12 +5,13 @@
 
 #include "frame-config.hpp"
 #include "core/shader.h"
+#include "core/shader-lib.h"
 
 
 class ShaderSky
 {
 public:
-    Shader2 shader = {SHADER + "skybox/sky.vert", SHADER + "skybox/sky.frag"};
+    Shader2 &shader = ShaderLib::get(SHADER + "skybox/sky.vert", SHADER + "skybox/sky.frag");
 
     void init(const glm::mat4 &proj)
     {
@@ -1,22 +1,37 @@
 #pragma once
 
 #include "frame-config.hpp"
+#include "core/model-manager.h"
 #include "./sky.h"
 
 
+/**
+ * 绘制天空盒用到的立方体，所有对象共享同一份
+ */
+inline const RTObject &skybox_cube()
+{
+    static const RTObject cube = ModelManager::load(MODEL_CUBE)[0];
+    return cube;
+}
+
+
 class SkyBox
 {
     ShaderSky shader_sky;
-    RTObject  model_cube = ImportObj::load_obj(MODEL_CUBE)[0];
 
-    GLuint default_sky_cubemap = load_cube_map({
-            .pos_x = TEX_SKY + "sky_Right.png",
-            .neg_x = TEX_SKY + "sky_Left.png",
-            .pos_y = TEX_SKY + "sky_Up.png",
-            .neg_y = TEX_SKY + "sky_Down.png",
-            .pos_z = TEX_SKY + "sky_Back.png",
-            .neg_z = TEX_SKY + "sky_Front.png",
-    });
+    /// 默认的天空 cubemap，所有对象共享同一份
+    static GLuint default_sky_cubemap()
+    {
+        static GLuint cubemap = load_cube_map({
+                .pos_x = TEX_SKY + "sky_Right.png",
+                .neg_x = TEX_SKY + "sky_Left.png",
+                .pos_y = TEX_SKY + "sky_Up.png",
+                .neg_y = TEX_SKY + "sky_Down.png",
+                .pos_z = TEX_SKY + "sky_Back.png",
+                .neg_z = TEX_SKY + "sky_Front.png",
+        });
+        return cubemap;
+    }
 
 public:
     // after exec, DEPTH_TEST will be enabled
@@ -24,8 +39,8 @@ public:
     {
         glDisable(GL_DEPTH_TEST);
         shader_sky.init(proj);
-        shader_sky.udpate_per_frame(view, default_sky_cubemap);
-        ShaderSky::draw(model_cube);
+        shader_sky.udpate_per_frame(view, default_sky_cubemap());
+        ShaderSky::draw(skybox_cube());
         glEnable(GL_DEPTH_TEST);
     }
 };
@@ -34,7 +49,6 @@ public:
 class CubeMapVisual
 {
     ShaderSky shader_sky;
-    RTObject  model_cube = ImportObj::load_obj(MODEL_CUBE)[0];
 
 public:
     /// after exec, DEPTH_TEST will be enabled
@@ -43,7 +57,7 @@ public:
         glDisable(GL_DEPTH_TEST);
         shader_sky.init(proj);
         shader_sky.udpate_per_frame(view, tex_cube);
-        ShaderSky::draw(model_cube);
+        ShaderSky::draw(skybox_cube());
         glEnable(GL_DEPTH_TEST);
     }
 };
\ No newline at end of file
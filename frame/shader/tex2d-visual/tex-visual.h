@@ -5,14 +5,15 @@
 
 #include "frame-config.hpp"
 #include "core/shader.h"
+#include "core/shader-lib.h"
 #include "core/rt-object.h"
 
 
 class ShaderTexVisual
 {
 public:
-    Shader2 shader = {SHADER + "tex2d-visual/tex-visual.vert",
-                      SHADER + "tex2d-visual/tex-visual.frag"};
+    Shader2 &shader = ShaderLib::get(SHADER + "tex2d-visual/tex-visual.vert",
+                                     SHADER + "tex2d-visual/tex-visual.frag");
 
     /**
      * 纹理可视化